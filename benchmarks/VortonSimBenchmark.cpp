@@ -0,0 +1,509 @@
+/*! \file VortonSimBenchmark.cpp
+
+    \brief Time simulation kernels in isolation, over a range of problem sizes
+
+    Each case builds its input once, then runs one kernel repeatedly and
+    reports minimum, median and mean time per run, and time per item, as
+    CSV or JSON.  Cases that depend on the number of vortons run once per
+    vorton count; cases that depend only on a grid run once per grid size.
+
+    Usage:
+
+    \verbatim
+    vortonsim_benchmark [--vortons 1e3,1e4,...] [--grid 32768,...] [--filter substring]
+                        [--min-time seconds] [--min-reps count] [--format csv|json] [--out path]
+    \endverbatim
+
+    Counts accept exponents, so --vortons 1e7 works.
+ */
+#include "VortonSim.hpp"
+#include "UniformGridMath.hpp"
+#include "Mat3.hpp"
+#include "Rand.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Timing of one kernel at one problem size
+struct Result
+{
+    std::string mKernel     ;   ///< Name of kernel
+    size_t      mVortons    ;   ///< Number of vortons, or 0 when the kernel takes none
+    size_t      mGridPoints ;   ///< Number of gridpoints in the grid the kernel uses
+    size_t      mItems      ;   ///< Units of work per run, e.g. queries or gridpoints
+    size_t      mReps       ;   ///< Number of timed runs
+    double      mMinMs      ;   ///< Least time of one run
+    double      mMedianMs   ;   ///< Median time of one run
+    double      mMeanMs     ;   ///< Mean time of one run
+} ;
+
+/// Command-line options
+struct Options
+{
+    Options() : mMinTime( 0.25 ) , mMinReps( 3 ) , mJson( false ) {}
+
+    std::vector< size_t >   mVortonCounts   ;   ///< Vorton counts at which to run vorton cases
+    std::vector< size_t >   mGridSizes      ;   ///< Gridpoint counts at which to run grid cases
+    std::string             mFilter         ;   ///< Run only kernels whose name contains this
+    double                  mMinTime        ;   ///< Keep repeating a kernel until this many seconds have elapsed...
+    size_t                  mMinReps        ;   ///< ...and it has run at least this many times
+    bool                    mJson           ;   ///< Write JSON instead of CSV
+    std::string             mOutPath        ;   ///< File to write, or empty for standard output
+} ;
+
+double SecondsSince( const std::chrono::steady_clock::time_point & start )
+{
+    return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count() ;
+}
+
+/*! \brief Run a kernel repeatedly and summarize its times
+
+    \param reset - restore the kernel's input before each run.  Not timed.
+
+    \param run - the kernel.
+ */
+Result Measure( const Options & options , const char * kernel , size_t numVortons , size_t numGridPoints , size_t numItems
+              , const std::function< void() > & reset , const std::function< void() > & run )
+{
+    // Run once untimed, to fault in memory and warm caches.
+    reset() ;
+    run() ;
+
+    std::vector< double > samples ;
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now() ;
+    while( ( samples.size() < options.mMinReps ) || ( SecondsSince( begin ) < options.mMinTime ) )
+    {
+        reset() ;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now() ;
+        run() ;
+        samples.push_back( SecondsSince( start ) * 1000.0 ) ;
+    }
+
+    std::sort( samples.begin() , samples.end() ) ;
+    Result result ;
+    result.mKernel      = kernel ;
+    result.mVortons     = numVortons ;
+    result.mGridPoints  = numGridPoints ;
+    result.mItems       = numItems ;
+    result.mReps        = samples.size() ;
+    result.mMinMs       = samples.front() ;
+    const size_t half   = samples.size() / 2 ;
+    result.mMedianMs    = ( samples.size() % 2 ) ? samples[ half ] : 0.5 * ( samples[ half - 1 ] + samples[ half ] ) ;
+    double sum = 0.0 ;
+    for( size_t i = 0 ; i < samples.size() ; ++ i ) sum += samples[ i ] ;
+    result.mMeanMs      = sum / double( samples.size() ) ;
+    return result ;
+}
+
+/// Return a position drawn uniformly from the box [vMin,vMax).
+Vec3 RandomPosition( Rand & rng , const Vec3 & vMin , const Vec3 & vMax )
+{
+    return Vec3( rng.nextFloat( vMin.x , vMax.x ) , rng.nextFloat( vMin.y , vMax.y ) , rng.nextFloat( vMin.z , vMax.z ) ) ;
+}
+
+/*! \brief Return positions strictly inside a grid, where Interpolate and Insert can reach every neighboring gridpoint
+ */
+std::vector< Vec3 > RandomPositionsInGrid( Rand & rng , const UniformGridGeometry & grid , size_t numPositions )
+{
+    // Keep away from the maximal faces, since Interpolate and Insert touch the gridpoint above each position.
+    const Vec3 vMax( grid.GetMinCorner() + 0.999f * grid.GetExtent() ) ;
+    std::vector< Vec3 > positions( numPositions ) ;
+    for( size_t i = 0 ; i < numPositions ; ++ i )
+    {
+        positions[ i ] = RandomPosition( rng , grid.GetMinCorner() , vMax ) ;
+    }
+    return positions ;
+}
+
+/// Fill a grid with a smooth swirling velocity field.
+void AssignSwirl( UniformGrid< Vec3 > & velGrid )
+{
+    const size_t numPoints[3] = { velGrid.GetNumPoints( 0 ) , velGrid.GetNumPoints( 1 ) , velGrid.GetNumPoints( 2 ) } ;
+    size_t idx[3] ;
+    size_t offset = 0 ;
+    for( idx[2] = 0 ; idx[2] < numPoints[2] ; ++ idx[2] )
+    for( idx[1] = 0 ; idx[1] < numPoints[1] ; ++ idx[1] )
+    for( idx[0] = 0 ; idx[0] < numPoints[0] ; ++ idx[0] , ++ offset )
+    {   // For each gridpoint, in memory order...
+        Vec3 vPos ;
+        velGrid.PositionFromIndices( vPos , idx ) ;
+        velGrid[ offset ] = Vec3( - vPos.y , vPos.x , 0.1f * sinf( vPos.x ) ) ;
+    }
+}
+
+volatile float gSink ;  ///< Written by Consume, so the compiler cannot discard kernel results
+
+/// Keep the compiler from discarding results of a kernel.
+void Consume( const Vec3 & v )
+{
+    gSink = v.x + v.y + v.z ;
+}
+
+} // namespace
+
+/*! \brief Benchmark cases for kernels of VortonSim and its grids
+
+    VortonSim declares this class a friend, so it can call private kernels
+    directly, on inputs built here, without running the rest of the
+    simulation.  Kernels that VortonSim runs in parallel (via a *Slice
+    method) are called the same way the simulation calls them; slice
+    methods called directly run on the calling thread.
+ */
+class VortonSimBenchmark
+{
+public:
+    typedef void ( * CaseFunction )( const Options & , size_t , std::vector< Result > & ) ;
+
+    /// Case of the benchmark suite
+    struct Case
+    {
+        const char *    mName       ;   ///< Name of kernel
+        bool            mPerVorton  ;   ///< Whether the size parameter is a number of vortons (else gridpoints)
+        CaseFunction    mFunction   ;   ///< Build input of the given size, measure, append results
+    } ;
+
+    static const Case * GetCases( size_t & numCases )
+    {
+        static const Case cases[] =
+        {
+            { "UniformGrid_Interpolate"         , false , GridInterpolate       } ,
+            { "UniformGrid_Insert"              , false , GridInsert            } ,
+            { "UniformGridMath_ComputeJacobian" , false , ComputeJacobian       } ,
+            { "VORTON_ACCUMULATE_VELOCITY"      , true  , AccumulateVelocity    } ,
+            { "VortonSim_ComputeVelocity"       , true  , ComputeVelocity       } ,
+            { "VortonSim_MakeBaseVortonGrid"    , true  , MakeBaseVortonGrid    } ,
+            { "VortonSim_AggregateClusters"     , true  , AggregateClusters     } ,
+            { "VortonSim_DiffuseVorticityPSE"   , true  , DiffuseVorticityPSE   } ,
+            { "VortonSim_AdvectTracersSlice"    , true  , AdvectTracersSlice    } ,
+        } ;
+        numCases = sizeof( cases ) / sizeof( cases[0] ) ;
+        return cases ;
+    }
+
+private:
+    static const size_t sNumQueries = 1 << 20 ;    ///< Number of positions at which grid cases sample
+
+    /*! \brief Populate a simulation with vortons spread uniformly through a cube, and build its influence tree
+
+        Vortons have random vorticity and radius comparable to their spacing, like vortons made
+        by AssignVorticity, but their number is exact, which keeps cases comparable across sizes.
+     */
+    static void MakeSimulation( VortonSim & sim , size_t numVortons )
+    {
+        Rand rng( 1234u ) ;
+        const Vec3  vMin( -1.0f , -1.0f , -1.0f ) ;
+        const Vec3  vMax(  1.0f ,  1.0f ,  1.0f ) ;
+        const float radius = 0.5f * powf( 8.0f / float( numVortons ) , 1.0f / 3.0f ) ;
+        std::vector< Vorton > & vortons = sim.GetVortons() ;
+        vortons.reserve( numVortons ) ;
+        for( size_t iVorton = 0 ; iVorton < numVortons ; ++ iVorton )
+        {
+            const Vec3 vPos( RandomPosition( rng , vMin , vMax ) ) ;
+            const Vec3 vVort( RandomPosition( rng , vMin , vMax ) ) ;
+            vortons.push_back( Vorton( vPos , vVort , radius ) ) ;
+        }
+        sim.CreateInfluenceTree() ;
+    }
+
+    /// Recreate the empty influence tree, as CreateInfluenceTree does before MakeBaseVortonGrid.
+    static void ResetInfluenceTree( VortonSim & sim )
+    {
+        UniformGrid< Vorton > ugSkeleton ;
+        ugSkeleton.CopyShape( sim.mInfluenceTree[0] ) ;
+        sim.mInfluenceTree.Initialize( ugSkeleton ) ;
+    }
+
+    static void GridInterpolate( const Options & options , size_t numGridPoints , std::vector< Result > & results )
+    {
+        UniformGrid< Vec3 > velGrid ;
+        velGrid.DefineShape( numGridPoints , Vec3( -1.0f , -1.0f , -1.0f ) , Vec3( 1.0f , 1.0f , 1.0f ) , true ) ;
+        velGrid.Init() ;
+        AssignSwirl( velGrid ) ;
+        Rand rng( 5678u ) ;
+        const std::vector< Vec3 > positions( RandomPositionsInGrid( rng , velGrid , sNumQueries ) ) ;
+        Vec3 vSum( 0.0f , 0.0f , 0.0f ) ;
+        results.push_back( Measure( options , "UniformGrid_Interpolate" , 0 , velGrid.GetGridCapacity() , sNumQueries
+            , [](){}
+            , [&](){
+                for( size_t i = 0 ; i < sNumQueries ; ++ i )
+                {
+                    Vec3 vVelocity ;
+                    velGrid.Interpolate( vVelocity , positions[ i ] ) ;
+                    vSum += vVelocity ;
+                }
+            } ) ) ;
+        Consume( vSum ) ;
+    }
+
+    static void GridInsert( const Options & options , size_t numGridPoints , std::vector< Result > & results )
+    {
+        UniformGrid< Vec3 > vortGrid ;
+        vortGrid.DefineShape( numGridPoints , Vec3( -1.0f , -1.0f , -1.0f ) , Vec3( 1.0f , 1.0f , 1.0f ) , true ) ;
+        vortGrid.Init() ;
+        Rand rng( 5678u ) ;
+        const std::vector< Vec3 > positions( RandomPositionsInGrid( rng , vortGrid , sNumQueries ) ) ;
+        const Vec3 vVorticity( 1.0f , 2.0f , 3.0f ) ;
+        results.push_back( Measure( options , "UniformGrid_Insert" , 0 , vortGrid.GetGridCapacity() , sNumQueries
+            , [](){}
+            , [&](){
+                for( size_t i = 0 ; i < sNumQueries ; ++ i )
+                {
+                    vortGrid.Insert( positions[ i ] , vVorticity ) ;
+                }
+            } ) ) ;
+        Consume( vortGrid[ 0 ] ) ;
+    }
+
+    static void ComputeJacobian( const Options & options , size_t numGridPoints , std::vector< Result > & results )
+    {
+        UniformGrid< Vec3 > velGrid ;
+        velGrid.DefineShape( numGridPoints , Vec3( -1.0f , -1.0f , -1.0f ) , Vec3( 1.0f , 1.0f , 1.0f ) , true ) ;
+        velGrid.Init() ;
+        AssignSwirl( velGrid ) ;
+        UniformGrid< Mat3 > jacobian( velGrid ) ;
+        jacobian.Init() ;
+        results.push_back( Measure( options , "UniformGridMath_ComputeJacobian" , 0 , velGrid.GetGridCapacity() , velGrid.GetGridCapacity()
+            , [](){}
+            , [&](){ UniformGridMath::ComputeJacobian( jacobian , velGrid ) ; } ) ) ;
+    }
+
+    /// Direct summation over every vorton, for enough query points to make each run take a while
+    static void AccumulateVelocity( const Options & options , size_t numVortons , std::vector< Result > & results )
+    {
+        VortonSim sim ;
+        MakeSimulation( sim , numVortons ) ;
+        const std::vector< Vorton > & vortons = sim.GetVortons() ;
+        const size_t numQueries = std::max( size_t( 1 ) , std::min( size_t( 1024 ) , ( size_t( 1 ) << 24 ) / numVortons ) ) ;
+        Rand rng( 5678u ) ;
+        std::vector< Vec3 > queries( numQueries ) ;
+        for( size_t i = 0 ; i < numQueries ; ++ i ) queries[ i ] = RandomPosition( rng , sim.mMinCorner , sim.mMaxCorner ) ;
+        Vec3 vSum( 0.0f , 0.0f , 0.0f ) ;
+        results.push_back( Measure( options , "VORTON_ACCUMULATE_VELOCITY" , numVortons , sim.mInfluenceTree[0].GetGridCapacity() , numQueries * numVortons
+            , [](){}
+            , [&](){
+                for( size_t iQuery = 0 ; iQuery < numQueries ; ++ iQuery )
+                {
+                    Vec3 vVelocity( 0.0f , 0.0f , 0.0f ) ;
+                    for( size_t iVorton = 0 ; iVorton < numVortons ; ++ iVorton )
+                    {
+                        VORTON_ACCUMULATE_VELOCITY( vVelocity , queries[ iQuery ] , vortons[ iVorton ] ) ;
+                    }
+                    vSum += vVelocity ;
+                }
+            } ) ) ;
+        Consume( vSum ) ;
+    }
+
+    /// Influence tree traversal, from the root, as ComputeVelocityGridSlice does for each gridpoint
+    static void ComputeVelocity( const Options & options , size_t numVortons , std::vector< Result > & results )
+    {
+        VortonSim sim ;
+        MakeSimulation( sim , numVortons ) ;
+        const size_t numQueries = std::min( numVortons , size_t( 1 ) << 16 ) ;
+        Rand rng( 5678u ) ;
+        std::vector< Vec3 > queries( numQueries ) ;
+        for( size_t i = 0 ; i < numQueries ; ++ i ) queries[ i ] = RandomPosition( rng , sim.mMinCorner , sim.mMaxCorner ) ;
+        const size_t numLayers = sim.mInfluenceTree.GetDepth() ;
+        static const size_t zeros[3] = { 0 , 0 , 0 } ;
+        Vec3 vSum( 0.0f , 0.0f , 0.0f ) ;
+        results.push_back( Measure( options , "VortonSim_ComputeVelocity" , numVortons , sim.mInfluenceTree[0].GetGridCapacity() , numQueries
+            , [](){}
+            , [&](){
+                for( size_t i = 0 ; i < numQueries ; ++ i )
+                {
+                    vSum += sim.ComputeVelocity( queries[ i ] , zeros , numLayers - 1 ) ;
+                }
+            } ) ) ;
+        Consume( vSum ) ;
+    }
+
+    static void MakeBaseVortonGrid( const Options & options , size_t numVortons , std::vector< Result > & results )
+    {
+        VortonSim sim ;
+        MakeSimulation( sim , numVortons ) ;
+        results.push_back( Measure( options , "VortonSim_MakeBaseVortonGrid" , numVortons , sim.mInfluenceTree[0].GetGridCapacity() , numVortons
+            , [&](){ ResetInfluenceTree( sim ) ; }
+            , [&](){ sim.MakeBaseVortonGrid() ; } ) ) ;
+    }
+
+    /// Aggregation of every layer above the base, as CreateInfluenceTree does
+    static void AggregateClusters( const Options & options , size_t numVortons , std::vector< Result > & results )
+    {
+        VortonSim sim ;
+        MakeSimulation( sim , numVortons ) ;
+        const size_t numLayers = sim.mInfluenceTree.GetDepth() ;
+        results.push_back( Measure( options , "VortonSim_AggregateClusters" , numVortons , sim.mInfluenceTree[0].GetGridCapacity() , sim.mInfluenceTree[0].GetGridCapacity()
+            , [&](){ ResetInfluenceTree( sim ) ; sim.MakeBaseVortonGrid() ; }
+            , [&](){
+                for( size_t uParentLayer = 1 ; uParentLayer < numLayers ; ++ uParentLayer )
+                {
+                    sim.AggregateClusters( uParentLayer ) ;
+                }
+            } ) ) ;
+    }
+
+    static void DiffuseVorticityPSE( const Options & options , size_t numVortons , std::vector< Result > & results )
+    {
+        VortonSim sim( 0.05f ) ;
+        MakeSimulation( sim , numVortons ) ;
+        const std::vector< Vorton > original( sim.GetVortons() ) ;
+        const float timeStep = 0.01f ;
+        results.push_back( Measure( options , "VortonSim_DiffuseVorticityPSE" , numVortons , sim.mInfluenceTree[0].GetGridCapacity() , numVortons
+            , [&](){ sim.GetVortons() = original ; }
+            , [&](){ sim.DiffuseVorticityPSE( timeStep , 0 ) ; } ) ) ;
+    }
+
+    /// Advection of one tracer per vorton through a velocity grid shaped like the base layer of the influence tree
+    static void AdvectTracersSlice( const Options & options , size_t numVortons , std::vector< Result > & results )
+    {
+        VortonSim sim ;
+        MakeSimulation( sim , numVortons ) ;
+        sim.mVelGrid.CopyShape( sim.mInfluenceTree[0] ) ;
+        sim.mVelGrid.Init() ;
+        AssignSwirl( sim.mVelGrid ) ;
+        Rand rng( 5678u ) ;
+        const std::vector< Vec3 > positions( RandomPositionsInGrid( rng , sim.mVelGrid , numVortons ) ) ;
+        std::vector< Particle > & tracers = sim.GetTracers() ;
+        tracers.resize( numVortons ) ;
+        const float timeStep = 1.0e-4f ;
+        results.push_back( Measure( options , "VortonSim_AdvectTracersSlice" , numVortons , sim.mVelGrid.GetGridCapacity() , numVortons
+            , [&](){ for( size_t i = 0 ; i < numVortons ; ++ i ) tracers[ i ].mPosition = positions[ i ] ; }
+            , [&](){ sim.AdvectTracersSlice( timeStep , 0 , 0 , numVortons ) ; } ) ) ;
+    }
+} ;
+
+namespace {
+
+/// Parse a comma-separated list of counts, each of which may use an exponent, e.g. "1e3,5e4".
+bool ParseCounts( std::vector< size_t > & counts , const char * text )
+{
+    counts.clear() ;
+    const char * p = text ;
+    while( * p )
+    {
+        char * end ;
+        const double value = strtod( p , & end ) ;
+        if( ( end == p ) || ( value < 1.0 ) ) return false ;
+        counts.push_back( size_t( value + 0.5 ) ) ;
+        p = end ;
+        if( ',' == * p ) ++ p ;
+        else if( * p ) return false ;
+    }
+    return ! counts.empty() ;
+}
+
+bool ParseOptions( Options & options , int argc , char ** argv )
+{
+    const size_t vortonCounts[] = { 1000 , 10000 , 100000 , 1000000 } ;
+    const size_t gridSizes[]    = { 32768 , 262144 , 2097152 } ;    // 32^3, 64^3, 128^3
+    options.mVortonCounts.assign( vortonCounts , vortonCounts + sizeof( vortonCounts ) / sizeof( vortonCounts[0] ) ) ;
+    options.mGridSizes.assign( gridSizes , gridSizes + sizeof( gridSizes ) / sizeof( gridSizes[0] ) ) ;
+
+    for( int iArg = 1 ; iArg < argc ; ++ iArg )
+    {
+        const char * arg   = argv[ iArg ] ;
+        const char * value = ( iArg + 1 < argc ) ? argv[ iArg + 1 ] : nullptr ;
+        if( ! value ) return false ;
+        ++ iArg ;
+        if( 0 == strcmp( arg , "--vortons" ) )
+        {
+            if( ! ParseCounts( options.mVortonCounts , value ) ) return false ;
+        }
+        else if( 0 == strcmp( arg , "--grid" ) )
+        {
+            if( ! ParseCounts( options.mGridSizes , value ) ) return false ;
+        }
+        else if( 0 == strcmp( arg , "--filter" ) )     options.mFilter  = value ;
+        else if( 0 == strcmp( arg , "--min-time" ) )   options.mMinTime = atof( value ) ;
+        else if( 0 == strcmp( arg , "--min-reps" ) )   options.mMinReps = std::max( 1 , atoi( value ) ) ;
+        else if( 0 == strcmp( arg , "--out" ) )        options.mOutPath = value ;
+        else if( 0 == strcmp( arg , "--format" ) )
+        {
+            if(      0 == strcmp( value , "json" ) ) options.mJson = true ;
+            else if( 0 == strcmp( value , "csv" ) )  options.mJson = false ;
+            else return false ;
+        }
+        else return false ;
+    }
+    return true ;
+}
+
+double NanosecondsPerItem( const Result & result )
+{
+    return result.mMedianMs * 1.0e6 / double( std::max( size_t( 1 ) , result.mItems ) ) ;
+}
+
+void WriteCsv( FILE * file , const std::vector< Result > & results )
+{
+    fprintf( file , "kernel,vortons,grid_points,items,reps,min_ms,median_ms,mean_ms,ns_per_item\n" ) ;
+    for( size_t i = 0 ; i < results.size() ; ++ i )
+    {
+        const Result & r = results[ i ] ;
+        fprintf( file , "%s,%zu,%zu,%zu,%zu,%.6f,%.6f,%.6f,%.4f\n"
+            , r.mKernel.c_str() , r.mVortons , r.mGridPoints , r.mItems , r.mReps , r.mMinMs , r.mMedianMs , r.mMeanMs , NanosecondsPerItem( r ) ) ;
+    }
+}
+
+void WriteJson( FILE * file , const Options & options , const std::vector< Result > & results )
+{
+    fprintf( file , "{\n  \"context\": { \"hardware_concurrency\": %u, \"use_tbb\": %d, \"use_profiler\": %d, \"min_time_s\": %g, \"min_reps\": %zu },\n"
+        , std::thread::hardware_concurrency() , int( USE_TBB ) , int( USE_PROFILER ) , options.mMinTime , options.mMinReps ) ;
+    fprintf( file , "  \"benchmarks\": [\n" ) ;
+    for( size_t i = 0 ; i < results.size() ; ++ i )
+    {
+        const Result & r = results[ i ] ;
+        fprintf( file , "    { \"kernel\": \"%s\", \"vortons\": %zu, \"grid_points\": %zu, \"items\": %zu, \"reps\": %zu"
+                        ", \"min_ms\": %.6f, \"median_ms\": %.6f, \"mean_ms\": %.6f, \"ns_per_item\": %.4f }%s\n"
+            , r.mKernel.c_str() , r.mVortons , r.mGridPoints , r.mItems , r.mReps , r.mMinMs , r.mMedianMs , r.mMeanMs , NanosecondsPerItem( r )
+            , ( i + 1 < results.size() ) ? "," : "" ) ;
+    }
+    fprintf( file , "  ]\n}\n" ) ;
+}
+
+} // namespace
+
+int main( int argc , char ** argv )
+{
+    Options options ;
+    if( ! ParseOptions( options , argc , argv ) )
+    {
+        fprintf( stderr , "usage: %s [--vortons 1e3,1e4,...] [--grid 32768,...] [--filter substring]\n"
+                          "       [--min-time seconds] [--min-reps count] [--format csv|json] [--out path]\n" , argv[0] ) ;
+        return 1 ;
+    }
+
+    size_t numCases ;
+    const VortonSimBenchmark::Case * cases = VortonSimBenchmark::GetCases( numCases ) ;
+    std::vector< Result > results ;
+    for( size_t iCase = 0 ; iCase < numCases ; ++ iCase )
+    {   // For each kernel...
+        const VortonSimBenchmark::Case & rCase = cases[ iCase ] ;
+        if( ! options.mFilter.empty() && ( std::string( rCase.mName ).find( options.mFilter ) == std::string::npos ) ) continue ;
+        const std::vector< size_t > & sizes = rCase.mPerVorton ? options.mVortonCounts : options.mGridSizes ;
+        for( size_t iSize = 0 ; iSize < sizes.size() ; ++ iSize )
+        {   // For each problem size...
+            fprintf( stderr , "%s %s=%zu\n" , rCase.mName , rCase.mPerVorton ? "vortons" : "grid" , sizes[ iSize ] ) ;
+            rCase.mFunction( options , sizes[ iSize ] , results ) ;
+        }
+    }
+
+    FILE * file = options.mOutPath.empty() ? stdout : fopen( options.mOutPath.c_str() , "w" ) ;
+    if( ! file )
+    {
+        fprintf( stderr , "cannot open %s\n" , options.mOutPath.c_str() ) ;
+        return 1 ;
+    }
+    if( options.mJson ) WriteJson( file , options , results ) ;
+    else                WriteCsv( file , results ) ;
+    if( file != stdout ) fclose( file ) ;
+    return 0 ;
+}
@@ -0,0 +1,244 @@
+#include "AabbTree.hpp"
+#include <algorithm>
+
+int AabbTree::CreateProxy( const Aabb & box , uint32_t userData )
+{
+    const int iLeaf = AllocateNode() ;
+    mNodes[ iLeaf ].mBox        = box ;
+    mNodes[ iLeaf ].mUserData   = userData ;
+    mNodes[ iLeaf ].mHeight     = 0 ;
+    InsertLeaf( iLeaf ) ;
+    ++ mNumProxies ;
+    return iLeaf ;
+}
+
+void AabbTree::DestroyProxy( int proxy )
+{
+    assert( mNodes[ proxy ].IsLeaf() ) ;
+    RemoveLeaf( proxy ) ;
+    FreeNode( proxy ) ;
+    -- mNumProxies ;
+}
+
+bool AabbTree::MoveProxy( int proxy , const Aabb & tightBox , const Aabb & fatBox )
+{
+    assert( mNodes[ proxy ].IsLeaf() ) ;
+    if( mNodes[ proxy ].mBox.Contains( tightBox ) )
+    {   // Object still lies within its fat box, so tree remains valid.
+        return false ;
+    }
+    RemoveLeaf( proxy ) ;
+    mNodes[ proxy ].mBox = fatBox ;
+    InsertLeaf( proxy ) ;
+    return true ;
+}
+
+int AabbTree::AllocateNode()
+{
+    int iNode ;
+    if( sNull != mFreeList )
+    {   // Reuse a freed node.
+        iNode = mFreeList ;
+        mFreeList = mNodes[ iNode ].mParent ;
+    }
+    else
+    {
+        iNode = int( mNodes.size() ) ;
+        mNodes.push_back( Node() ) ;
+    }
+    Node & rNode = mNodes[ iNode ] ;
+    rNode.mParent   = sNull ;
+    rNode.mChild1   = sNull ;
+    rNode.mChild2   = sNull ;
+    rNode.mHeight   = 0 ;
+    rNode.mUserData = 0 ;
+    return iNode ;
+}
+
+void AabbTree::FreeNode( int iNode )
+{
+    mNodes[ iNode ].mParent = mFreeList ;
+    mNodes[ iNode ].mHeight = -1 ;
+    mFreeList = iNode ;
+}
+
+/// Make iNewChild take the place of iOldChild under iParent, or at the root if iParent is sNull
+void AabbTree::ReplaceChild( int iParent , int iOldChild , int iNewChild )
+{
+    if( sNull == iParent )
+    {
+        mRoot = iNewChild ;
+    }
+    else if( mNodes[ iParent ].mChild1 == iOldChild )
+    {
+        mNodes[ iParent ].mChild1 = iNewChild ;
+    }
+    else
+    {
+        assert( mNodes[ iParent ].mChild2 == iOldChild ) ;
+        mNodes[ iParent ].mChild2 = iNewChild ;
+    }
+}
+
+/*! \brief Insert a leaf next to the sibling that least increases total surface area
+
+    Descending from the root, at each node this compares the cost of
+    pairing the leaf with that whole subtree against the cheapest cost
+    of descending into either child.  Every ancestor of the new parent
+    grows to enclose the leaf, so that growth ("inheritance cost")
+    counts against descending further.
+*/
+void AabbTree::InsertLeaf( int iLeaf )
+{
+    if( sNull == mRoot )
+    {
+        mRoot = iLeaf ;
+        mNodes[ iLeaf ].mParent = sNull ;
+        return ;
+    }
+
+    const Aabb leafBox = mNodes[ iLeaf ].mBox ;
+    int iSibling = mRoot ;
+    while( ! mNodes[ iSibling ].IsLeaf() )
+    {
+        const Node &    rNode           = mNodes[ iSibling ] ;
+        const float     area            = rNode.mBox.SurfaceArea() ;
+        const float     combinedArea    = Aabb::Union( rNode.mBox , leafBox ).SurfaceArea() ;
+        // Cost of creating a new parent for this node and the new leaf.
+        const float     cost            = 2.0f * combinedArea ;
+        // Minimum cost of pushing the leaf further down the tree.
+        const float     inheritanceCost = 2.0f * ( combinedArea - area ) ;
+
+        float childCosts[ 2 ] ;
+        const int children[ 2 ] = { rNode.mChild1 , rNode.mChild2 } ;
+        for( int i = 0 ; i < 2 ; ++ i )
+        {
+            const Node & rChild     = mNodes[ children[ i ] ] ;
+            const float  unionArea  = Aabb::Union( leafBox , rChild.mBox ).SurfaceArea() ;
+            childCosts[ i ] = ( rChild.IsLeaf() ? unionArea : ( unionArea - rChild.mBox.SurfaceArea() ) ) + inheritanceCost ;
+        }
+
+        if( ( cost < childCosts[ 0 ] ) && ( cost < childCosts[ 1 ] ) )
+        {   // Pairing with this node is cheapest.
+            break ;
+        }
+        iSibling = ( childCosts[ 0 ] < childCosts[ 1 ] ) ? children[ 0 ] : children[ 1 ] ;
+    }
+
+    // Create a new parent for the sibling and the leaf.
+    const int iOldParent = mNodes[ iSibling ].mParent ;
+    const int iNewParent = AllocateNode() ;    // Might reallocate mNodes, so access nodes by index only.
+    mNodes[ iNewParent ].mParent    = iOldParent ;
+    mNodes[ iNewParent ].mBox       = Aabb::Union( leafBox , mNodes[ iSibling ].mBox ) ;
+    mNodes[ iNewParent ].mHeight    = mNodes[ iSibling ].mHeight + 1 ;
+    mNodes[ iNewParent ].mChild1    = iSibling ;
+    mNodes[ iNewParent ].mChild2    = iLeaf ;
+    ReplaceChild( iOldParent , iSibling , iNewParent ) ;
+    mNodes[ iSibling ].mParent      = iNewParent ;
+    mNodes[ iLeaf ].mParent         = iNewParent ;
+
+    // Walk back up the tree, rebalancing and refitting boxes and heights.
+    int iNode = mNodes[ iLeaf ].mParent ;
+    while( sNull != iNode )
+    {
+        iNode = Balance( iNode ) ;
+        Node & rNode = mNodes[ iNode ] ;
+        rNode.mHeight   = 1 + std::max( mNodes[ rNode.mChild1 ].mHeight , mNodes[ rNode.mChild2 ].mHeight ) ;
+        rNode.mBox      = Aabb::Union( mNodes[ rNode.mChild1 ].mBox , mNodes[ rNode.mChild2 ].mBox ) ;
+        iNode = rNode.mParent ;
+    }
+}
+
+void AabbTree::RemoveLeaf( int iLeaf )
+{
+    if( iLeaf == mRoot )
+    {
+        mRoot = sNull ;
+        return ;
+    }
+
+    const int iParent       = mNodes[ iLeaf ].mParent ;
+    const int iGrandParent  = mNodes[ iParent ].mParent ;
+    const int iSibling      = ( mNodes[ iParent ].mChild1 == iLeaf ) ? mNodes[ iParent ].mChild2 : mNodes[ iParent ].mChild1 ;
+
+    // Sibling takes the place of parent, which is no longer needed.
+    ReplaceChild( iGrandParent , iParent , iSibling ) ;
+    mNodes[ iSibling ].mParent = iGrandParent ;
+    FreeNode( iParent ) ;
+
+    // Walk back up the tree, rebalancing and refitting boxes and heights.
+    int iNode = iGrandParent ;
+    while( sNull != iNode )
+    {
+        iNode = Balance( iNode ) ;
+        Node & rNode = mNodes[ iNode ] ;
+        rNode.mHeight   = 1 + std::max( mNodes[ rNode.mChild1 ].mHeight , mNodes[ rNode.mChild2 ].mHeight ) ;
+        rNode.mBox      = Aabb::Union( mNodes[ rNode.mChild1 ].mBox , mNodes[ rNode.mChild2 ].mBox ) ;
+        iNode = rNode.mParent ;
+    }
+}
+
+/*! \brief Rotate the taller child of node A up, if A is imbalanced
+
+    \return index of the node that now occupies A's place in the tree.
+
+    If child C is taller than child B by more than 1, C takes A's place,
+    A becomes C's child, and the shorter of C's children (F or G)
+    becomes A's child in place of C.  Likewise with B and C swapped.
+
+             A                C
+            / \              / \
+           B   C     =>     A   F (taller of F, G)
+              / \          / \
+             F   G        B   G (shorter of F, G)
+*/
+int AabbTree::Balance( int iA )
+{
+    if( mNodes[ iA ].IsLeaf() || ( mNodes[ iA ].mHeight < 2 ) )
+    {
+        return iA ;
+    }
+
+    const int iB = mNodes[ iA ].mChild1 ;
+    const int iC = mNodes[ iA ].mChild2 ;
+    const int balance = mNodes[ iC ].mHeight - mNodes[ iB ].mHeight ;
+
+    if( ( balance > 1 ) || ( balance < -1 ) )
+    {
+        // iUp is the taller child, which rotates up.  iStay is the other child, which stays under A.
+        const bool bRotateC = balance > 1 ;
+        const int  iUp      = bRotateC ? iC : iB ;
+        const int  iStay    = bRotateC ? iB : iC ;
+        const int  iF       = mNodes[ iUp ].mChild1 ;
+        const int  iG       = mNodes[ iUp ].mChild2 ;
+
+        // Swap A and Up.
+        mNodes[ iUp ].mChild1 = iA ;
+        mNodes[ iUp ].mParent = mNodes[ iA ].mParent ;
+        mNodes[ iA ].mParent  = iUp ;
+        ReplaceChild( mNodes[ iUp ].mParent , iA , iUp ) ;
+
+        // Taller grandchild stays under Up; shorter one moves under A.
+        const bool bFTaller = mNodes[ iF ].mHeight > mNodes[ iG ].mHeight ;
+        const int  iTall    = bFTaller ? iF : iG ;
+        const int  iShort   = bFTaller ? iG : iF ;
+        mNodes[ iUp ].mChild2 = iTall ;
+        if( bRotateC )
+        {
+            mNodes[ iA ].mChild2 = iShort ;
+        }
+        else
+        {
+            mNodes[ iA ].mChild1 = iShort ;
+        }
+        mNodes[ iShort ].mParent = iA ;
+
+        mNodes[ iA ].mBox       = Aabb::Union( mNodes[ iStay ].mBox , mNodes[ iShort ].mBox ) ;
+        mNodes[ iA ].mHeight    = 1 + std::max( mNodes[ iStay ].mHeight , mNodes[ iShort ].mHeight ) ;
+        mNodes[ iUp ].mBox      = Aabb::Union( mNodes[ iA ].mBox , mNodes[ iTall ].mBox ) ;
+        mNodes[ iUp ].mHeight   = 1 + std::max( mNodes[ iA ].mHeight , mNodes[ iTall ].mHeight ) ;
+        return iUp ;
+    }
+
+    return iA ;
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include "Vec3.hpp"
+
+/// Axis-aligned bounding box
+struct Aabb
+{
+    Aabb() {}
+    Aabb( const Vec3 & vMin , const Vec3 & vMax ) : mMin( vMin ) , mMax( vMax ) {}
+
+    /// Construct box that bounds a sphere
+    static Aabb FromSphere( const Vec3 & vCenter , float radius )
+    {
+        const Vec3 vRadius( radius , radius , radius ) ;
+        return Aabb( vCenter - vRadius , vCenter + vRadius ) ;
+    }
+
+    /// Return smallest box that contains both given boxes
+    static Aabb Union( const Aabb & a , const Aabb & b )
+    {
+        return Aabb( Vec3( std::min( a.mMin.x , b.mMin.x ) , std::min( a.mMin.y , b.mMin.y ) , std::min( a.mMin.z , b.mMin.z ) )
+                   , Vec3( std::max( a.mMax.x , b.mMax.x ) , std::max( a.mMax.y , b.mMax.y ) , std::max( a.mMax.z , b.mMax.z ) ) ) ;
+    }
+
+    bool Overlaps( const Aabb & other ) const
+    {
+        return ( mMin.x <= other.mMax.x ) && ( other.mMin.x <= mMax.x )
+            && ( mMin.y <= other.mMax.y ) && ( other.mMin.y <= mMax.y )
+            && ( mMin.z <= other.mMax.z ) && ( other.mMin.z <= mMax.z ) ;
+    }
+
+    bool Contains( const Aabb & other ) const
+    {
+        return ( mMin.x <= other.mMin.x ) && ( other.mMax.x <= mMax.x )
+            && ( mMin.y <= other.mMin.y ) && ( other.mMax.y <= mMax.y )
+            && ( mMin.z <= other.mMin.z ) && ( other.mMax.z <= mMax.z ) ;
+    }
+
+    float SurfaceArea() const
+    {
+        const Vec3 vExtent( mMax - mMin ) ;
+        return 2.0f * ( vExtent.x * vExtent.y + vExtent.y * vExtent.z + vExtent.z * vExtent.x ) ;
+    }
+
+    Vec3 mMin ;  ///< Minimal corner
+    Vec3 mMax ;  ///< Maximal corner
+} ;
+
+/*! \brief Dynamic bounding volume hierarchy of axis-aligned boxes
+
+ Each leaf ("proxy") holds a box that encloses some object, typically
+ enlarged ("fattened") so the object can move a little without the
+ tree changing.  Each interior node holds the union of its children.
+
+ Leaves get inserted next to the sibling that minimizes the increase
+ in total surface area, and the tree rebalances itself with AVL
+ rotations on the way back up, so its height stays logarithmic in
+ the number of proxies regardless of insertion order.
+
+ Query is const and uses no shared scratch memory, so multiple
+ threads can query the same tree concurrently.
+
+ */
+class AabbTree
+{
+public:
+    static const int sNull = -1 ;   ///< Index meaning "no node"
+
+    AabbTree() : mRoot( sNull ) , mFreeList( sNull ) , mNumProxies( 0 ) {}
+
+    /*! \brief Insert a box into the tree
+
+        \param box - box to insert.  Callers typically fatten it.
+
+        \param userData - value Query reports for this proxy, typically the index of an object.
+
+        \return index of proxy, used to move or destroy it.
+     */
+    int     CreateProxy( const Aabb & box , uint32_t userData ) ;
+
+    /// Remove a proxy from the tree
+    void    DestroyProxy( int proxy ) ;
+
+    /*! \brief Update a proxy whose object moved
+
+        \param proxy - index of proxy, as returned by CreateProxy.
+
+        \param tightBox - box that exactly bounds the object.
+
+        \param fatBox - enlarged box to store if the proxy needs reinserting.
+
+        \return true if the proxy was reinserted, false if its box still contained tightBox.
+     */
+    bool    MoveProxy( int proxy , const Aabb & tightBox , const Aabb & fatBox ) ;
+
+    const Aabb &    GetFatAabb( int proxy ) const   { return mNodes[ proxy ].mBox ; }
+    uint32_t        GetUserData( int proxy ) const  { return mNodes[ proxy ].mUserData ; }
+    size_t          GetNumProxies() const           { return mNumProxies ; }
+    int             GetHeight() const               { return ( sNull == mRoot ) ? 0 : mNodes[ mRoot ].mHeight ; }
+
+    /*! \brief Visit each proxy whose box overlaps the given box
+
+        \param box - query box.
+
+        \param callback - called as callback( userData ) for each overlapping proxy.
+                It returns false to stop the query early, true to continue.
+     */
+    template< class CallbackT > void Query( const Aabb & box , const CallbackT & callback ) const
+    {
+        // Depth-first traversal only ever holds one sibling per level, plus the node
+        // being visited, and the tree stays balanced, so this stack suffices.
+        int stack[ sMaxStack ] ;
+        int stackSize = 0 ;
+        if( sNull != mRoot ) stack[ stackSize ++ ] = mRoot ;
+        while( stackSize > 0 )
+        {
+            const Node & rNode = mNodes[ stack[ -- stackSize ] ] ;
+            if( ! rNode.mBox.Overlaps( box ) ) continue ;
+            if( rNode.IsLeaf() )
+            {
+                if( ! callback( rNode.mUserData ) ) return ;
+            }
+            else
+            {
+                assert( stackSize + 2 <= sMaxStack ) ;
+                stack[ stackSize ++ ] = rNode.mChild1 ;
+                stack[ stackSize ++ ] = rNode.mChild2 ;
+            }
+        }
+    }
+
+    void Clear()
+    {
+        mNodes.clear() ;
+        mRoot       = sNull ;
+        mFreeList   = sNull ;
+        mNumProxies = 0 ;
+    }
+
+private:
+    static const int sMaxStack = 256 ;
+
+    struct Node
+    {
+        bool IsLeaf() const { return sNull == mChild1 ; }
+
+        Aabb        mBox        ;   ///< Fat box of proxy (leaf), or union of children (interior)
+        int         mParent     ;   ///< Index of parent, or next free node when on free list
+        int         mChild1     ;   ///< Index of first child, or sNull for leaves
+        int         mChild2     ;   ///< Index of second child, or sNull for leaves
+        int         mHeight     ;   ///< 0 for leaves, 1 + max child height for interior nodes, -1 when free
+        uint32_t    mUserData   ;   ///< For leaves, value supplied to CreateProxy
+    } ;
+
+    int     AllocateNode() ;
+    void    FreeNode( int iNode ) ;
+    void    InsertLeaf( int iLeaf ) ;
+    void    RemoveLeaf( int iLeaf ) ;
+    int     Balance( int iA ) ;
+    void    ReplaceChild( int iParent , int iOldChild , int iNewChild ) ;
+
+    std::vector< Node > mNodes      ;   ///< Node pool.  Freed nodes form a linked list through mParent.
+    int                 mRoot       ;   ///< Index of root node
+    int                 mFreeList   ;   ///< Index of first free node
+    size_t              mNumProxies ;   ///< Number of leaves
+} ;
@@ -0,0 +1,178 @@
+#include "CellList.hpp"
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+#if USE_TBB
+
+/*! \brief Function object to assign particles to cells using Threading Building Blocks
+ */
+class CellList_AssignCells_TBB
+{
+    CellList *      mCellList   ;   ///< Address of CellList object
+    const Vec3 * mPositions  ;   ///< Address of position of first particle
+    size_t          mStride     ;   ///< Distance, in bytes, between consecutive positions
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Assign subset of particles to cells.
+        mCellList->AssignCellsSlice( mPositions , mStride , r.begin() , r.end() ) ;
+    }
+    CellList_AssignCells_TBB( CellList * pCellList , const Vec3 * pPositions , size_t stride )
+    : mCellList( pCellList )
+    , mPositions( pPositions )
+    , mStride( stride )
+    {}
+} ;
+
+/*! \brief Function object to scatter particle indices into cells using Threading Building Blocks
+ */
+class CellList_Scatter_TBB
+{
+    CellList * mCellList ;  ///< Address of CellList object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Scatter subset of particles.
+        mCellList->ScatterSlice( r.begin() , r.end() ) ;
+    }
+    CellList_Scatter_TBB( CellList * pCellList )
+    : mCellList( pCellList ) {}
+} ;
+
+/*! \brief Function object to sort particle indices within cells using Threading Building Blocks
+ */
+class CellList_SortCells_TBB
+{
+    CellList * mCellList ;  ///< Address of CellList object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Sort subset of cells.
+        mCellList->SortCellsSlice( r.begin() , r.end() ) ;
+    }
+    CellList_SortCells_TBB( CellList * pCellList )
+    : mCellList( pCellList ) {}
+} ;
+#endif
+
+void CellList::Build( const UniformGridGeometry & grid , const Vec3 * pPositions , size_t stride , size_t numParticles )
+{
+    assert( numParticles < size_t( UINT32_MAX ) ) ;
+
+    mGeometry.CopyShape( grid ) ;
+    const size_t numCells = mGeometry.GetGridCapacity() ;
+
+    // Phase 1: Histogram.
+    if( mCountsCapacity < numCells )
+    {   // Grow counter array.  (Atomics are not movable so std::vector cannot hold them.)
+        mCounts.reset( new std::atomic< uint32_t >[ numCells ] ) ;
+        mCountsCapacity = numCells ;
+    }
+    for( size_t uCell = 0 ; uCell < numCells ; ++ uCell )
+    {
+        mCounts[ uCell ].store( 0 , std::memory_order_relaxed ) ;
+    }
+    mCellOfParticle.resize( numParticles ) ;
+
+#if USE_TBB
+    // Estimate grain size based on size of problem and number of processors.
+    const size_t grainSize = std::max( size_t( 1 ) , numParticles / std::thread::hardware_concurrency() ) ;
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numParticles , grainSize ) , CellList_AssignCells_TBB( this , pPositions , stride ) ) ;
+#else
+    AssignCellsSlice( pPositions , stride , 0 , numParticles ) ;
+#endif
+
+    // Phase 2: Exclusive prefix sum of counts yields the start of each cell.
+    // Reuse the counters as scatter cursors.
+    mCellStart.resize( numCells + 1 ) ;
+    uint32_t runningTotal = 0 ;
+    for( size_t uCell = 0 ; uCell < numCells ; ++ uCell )
+    {
+        mCellStart[ uCell ] = runningTotal ;
+        runningTotal += mCounts[ uCell ].load( std::memory_order_relaxed ) ;
+        mCounts[ uCell ].store( mCellStart[ uCell ] , std::memory_order_relaxed ) ;
+    }
+    mCellStart[ numCells ] = runningTotal ;
+
+    // Phase 3: Scatter particle indices into their cells.
+    mIndices.resize( numParticles ) ;
+#if USE_TBB
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numParticles , grainSize ) , CellList_Scatter_TBB( this ) ) ;
+#else
+    ScatterSlice( 0 , numParticles ) ;
+#endif
+
+    // Phase 4: Concurrent scatter leaves indices within each cell in arbitrary order,
+    // so sort each (typically tiny) cell to make the result deterministic.
+#if USE_TBB
+    const size_t grainSizeCells = std::max( size_t( 1 ) , numCells / std::thread::hardware_concurrency() ) ;
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numCells , grainSizeCells ) , CellList_SortCells_TBB( this ) ) ;
+#else
+    SortCellsSlice( 0 , numCells ) ;
+#endif
+}
+
+/*! \brief Compute cell offset of a subset of particles, and tally cell populations
+
+    \param pPositions - address of position of first particle.
+
+    \param stride - distance, in bytes, between positions of consecutive particles.
+
+    \param iBegin - index of first particle to process
+
+    \param iEnd - index one past last particle to process
+*/
+void CellList::AssignCellsSlice( const Vec3 * pPositions , size_t stride , size_t iBegin , size_t iEnd )
+{
+    const Vec3 & vMinCorner      = mGeometry.GetMinCorner() ;
+    const Vec3 & vCellsPerExtent = mGeometry.GetCellsPerExtent() ;
+    const float     maxIndex[3]     = { float( mGeometry.GetNumPoints( 0 ) - 1 ) , float( mGeometry.GetNumPoints( 1 ) - 1 ) , float( mGeometry.GetNumPoints( 2 ) - 1 ) } ;
+    const size_t    numX            = mGeometry.GetNumPoints( 0 ) ;
+    const size_t    numXY           = numX * mGeometry.GetNumPoints( 1 ) ;
+    const char *    pBytes          = reinterpret_cast< const char * >( pPositions ) ;
+
+    for( size_t iParticle = iBegin ; iParticle < iEnd ; ++ iParticle )
+    {   // For each particle in this slice...
+        const Vec3 & vPosition = * reinterpret_cast< const Vec3 * >( pBytes + iParticle * stride ) ;
+        const Vec3      vPosRel( vPosition - vMinCorner ) ;
+        // Clamp before converting to integer, since converting a negative float to unsigned is undefined.
+        const size_t    ix = size_t( std::min( std::max( vPosRel.x * vCellsPerExtent.x , 0.0f ) , maxIndex[0] ) ) ;
+        const size_t    iy = size_t( std::min( std::max( vPosRel.y * vCellsPerExtent.y , 0.0f ) , maxIndex[1] ) ) ;
+        const size_t    iz = size_t( std::min( std::max( vPosRel.z * vCellsPerExtent.z , 0.0f ) , maxIndex[2] ) ) ;
+        const uint32_t  uCell = uint32_t( ix + iy * numX + iz * numXY ) ;
+        mCellOfParticle[ iParticle ] = uCell ;
+        mCounts[ uCell ].fetch_add( 1 , std::memory_order_relaxed ) ;
+    }
+}
+
+/*! \brief Scatter indices of a subset of particles into their cells
+
+    \param iBegin - index of first particle to process
+
+    \param iEnd - index one past last particle to process
+*/
+void CellList::ScatterSlice( size_t iBegin , size_t iEnd )
+{
+    for( size_t iParticle = iBegin ; iParticle < iEnd ; ++ iParticle )
+    {   // For each particle in this slice...
+        const uint32_t slot = mCounts[ mCellOfParticle[ iParticle ] ].fetch_add( 1 , std::memory_order_relaxed ) ;
+        mIndices[ slot ] = uint32_t( iParticle ) ;
+    }
+}
+
+/*! \brief Sort particle indices within a subset of cells
+
+    \param iCellBegin - offset of first cell to process
+
+    \param iCellEnd - offset one past last cell to process
+*/
+void CellList::SortCellsSlice( size_t iCellBegin , size_t iCellEnd )
+{
+    for( size_t uCell = iCellBegin ; uCell < iCellEnd ; ++ uCell )
+    {   // For each cell in this slice...
+        uint32_t * const pBegin = mIndices.data() + mCellStart[ uCell ] ;
+        uint32_t * const pEnd   = mIndices.data() + mCellStart[ uCell + 1 ] ;
+        if( pEnd - pBegin > 1 )
+        {
+            std::sort( pBegin , pEnd ) ;
+        }
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include "Vec3.hpp"
+#include "UniformGridGeometry.hpp"
+#include "TBB_Settings.hpp"
+
+/*! \brief Compressed (CSR) spatial partition of particles by grid cell
+
+ Each grid cell of a UniformGridGeometry owns a contiguous span of
+ one flat array of 32-bit particle indices.  mCellStart holds the
+ offset of the first index of each cell, plus one trailing entry,
+ so the span for cell c is [ mCellStart[c] , mCellStart[c+1] ).
+
+ This replaces UniformGrid< std::vector< size_t > >, which allocated
+ one dynamic array per cell every time it was built.  A CellList
+ retains its arrays between builds, so rebuilding it each frame
+ does not touch the heap once capacity is reached.
+
+ Within each cell, particle indices are sorted in increasing order,
+ so the layout (and any sum taken over it) does not depend on the
+ number of threads used to build it.
+
+ \note Cells are identified with the grid point at their minimal corner,
+        the same way UniformGrid< Vorton > identifies them in the
+        influence tree, so cell offsets range over GetGridCapacity.
+ */
+class CellList
+{
+public:
+    CellList() : mCountsCapacity( 0 ) {}
+
+    /*! \brief Partition particles into cells using a counting sort
+
+        \param grid - geometry of grid whose cells partition space.
+
+        \param pPositions - address of position of first particle.
+
+        \param stride - distance, in bytes, between positions of consecutive particles.
+
+        \param numParticles - number of particles.
+
+        \note Particles outside grid are assigned to the nearest cell on its boundary.
+     */
+    void Build( const UniformGridGeometry & grid , const Vec3 * pPositions , size_t stride , size_t numParticles ) ;
+
+    /// Partition an array of particles that have an mPosition member
+    template< class ParticleT > void Build( const UniformGridGeometry & grid , const std::vector< ParticleT > & particles )
+    {
+        Build( grid , particles.empty() ? nullptr : & particles[0].mPosition , sizeof( ParticleT ) , particles.size() ) ;
+    }
+
+    const UniformGridGeometry & GetGeometry() const { return mGeometry ; }
+
+    /// Get number of cells, which is also the range of cell offsets
+    size_t GetNumCells() const { return mCellStart.empty() ? 0 : mCellStart.size() - 1 ; }
+
+    /// Get number of particles partitioned by this cell list
+    size_t GetNumParticles() const { return mIndices.size() ; }
+
+    /// Get offset into index array of first particle in the given cell
+    const uint32_t & GetCellBegin( size_t uCell ) const { return mCellStart[ uCell ] ; }
+
+    /// Get offset into index array one past last particle in the given cell
+    const uint32_t & GetCellEnd( size_t uCell ) const { return mCellStart[ uCell + 1 ] ; }
+
+    /// Get number of particles in the given cell
+    uint32_t GetCellSize( size_t uCell ) const { return GetCellEnd( uCell ) - GetCellBegin( uCell ) ; }
+
+    /// Get index of particle, given offset into index array
+    const uint32_t & GetIndex( size_t offset ) const { return mIndices[ offset ] ; }
+
+    /// Get address of flat index array, sorted by cell
+    const uint32_t * GetIndices() const { return mIndices.data() ; }
+
+    /// Get offset of cell which contains the given particle, as of the most recent Build
+    const uint32_t & GetCellOfParticle( size_t uParticle ) const { return mCellOfParticle[ uParticle ] ; }
+
+    void Clear()
+    {
+        mCellStart.clear() ;
+        mIndices.clear() ;
+        mCellOfParticle.clear() ;
+    }
+
+private:
+    CellList( const CellList & ) = delete ;
+    CellList & operator=( const CellList & ) = delete ;
+
+    void AssignCellsSlice( const Vec3 * pPositions , size_t stride , size_t iBegin , size_t iEnd ) ;
+    void ScatterSlice( size_t iBegin , size_t iEnd ) ;
+    void SortCellsSlice( size_t iCellBegin , size_t iCellEnd ) ;
+
+    UniformGridGeometry                         mGeometry       ;   ///< Shape of grid used for most recent build
+    std::vector< uint32_t >                     mCellStart      ;   ///< Offset into mIndices of first particle in each cell, plus 1 trailing entry
+    std::vector< uint32_t >                     mIndices        ;   ///< Particle indices, grouped by cell
+    std::vector< uint32_t >                     mCellOfParticle ;   ///< Offset of cell containing each particle
+    std::unique_ptr< std::atomic< uint32_t >[] > mCounts        ;   ///< Per-cell counter used during build: first a histogram, then a scatter cursor
+    size_t                                      mCountsCapacity ;   ///< Number of elements allocated in mCounts
+
+#if USE_TBB
+    friend class CellList_AssignCells_TBB ;
+    friend class CellList_Scatter_TBB ;
+    friend class CellList_SortCells_TBB ;
+#endif
+} ;
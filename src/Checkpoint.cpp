@@ -0,0 +1,286 @@
+#include "Checkpoint.hpp"
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include "FluidSim.hpp"
+#include "MappedFile.hpp"
+
+namespace {
+
+const char sMagic[ 8 ] = { 'V' , 'O' , 'R' , 'T' , 'C' , 'K' , 'P' , 'T' } ;
+
+/// Leading part of a checkpoint file, which says where everything else lies
+struct Header
+{
+    char        mMagic[ 8 ]     ;   ///< Identifies file as a checkpoint
+    uint32_t    mVersion        ;   ///< Checkpoint::sVersion of the writer
+    uint32_t    mVortonSize     ;   ///< sizeof( Vorton ) of the writer
+    uint32_t    mParticleSize   ;   ///< sizeof( Particle ) of the writer
+    uint32_t    mBodySize       ;   ///< sizeof( BodyRecord ) of the writer
+    uint64_t    mFrame          ;   ///< Frame counter to pass to the next update
+    uint64_t    mNumVortons     ;   ///< Number of vortons
+    uint64_t    mNumTracers     ;   ///< Number of tracers
+    uint64_t    mNumSpheres     ;   ///< Number of spherical bodies
+    uint64_t    mNumSdfBodies   ;   ///< Number of signed-distance-field bodies
+    uint64_t    mParamsOffset   ;   ///< Offset, in bytes from start of file, of Parameters
+    uint64_t    mVortonOffset   ;   ///< Offset of vortons
+    uint64_t    mTracerOffset   ;   ///< Offset of tracers
+    uint64_t    mBodyOffset     ;   ///< Offset of body records, spheres then signed-distance-field bodies
+    uint64_t    mFileSize       ;   ///< Total size of file, in bytes
+} ;
+
+/// Simulation parameters and other VortonSim state carried between updates
+struct Parameters
+{
+    Vec3        mCirculationInitial     ;
+    Vec3        mLinearImpulseInitial   ;
+    Vec3        mAverageVorticity       ;
+    float       mViscosity              ;
+    float       mFluidDensity           ;
+    float       mMassPerParticle        ;
+    float       mRemeshThreshold        ;
+    float       mMergeFraction          ;
+    float       mSplitStretchRate       ;
+    uint64_t    mRemeshPeriod           ;
+    uint64_t    mTargetNumVortons       ;
+} ;
+
+/// Rigid body state carried between updates
+struct BodyRecord
+{
+    Vec3        mPosition       ;
+    Vec3        mVelocity       ;
+    Vec3        mOrientation    ;
+    Vec3        mAngVelocity    ;
+    Vec3        mForce          ;
+    Vec3        mTorque         ;
+    Vec3        mMomentum       ;
+    Vec3        mAngMomentum    ;
+    Vec3        mInertiaInv[ 3 ];   ///< Columns of inverse inertia tensor
+    float       mInverseMass    ;
+    float       mRadius         ;   ///< Radius of spheres; unused for other bodies
+} ;
+
+static_assert( std::is_trivially_copyable< Vorton >::value , "Checkpoint copies vortons as raw memory" ) ;
+static_assert( std::is_trivially_copyable< Particle >::value , "Checkpoint copies tracers as raw memory" ) ;
+
+/// Round offset up to a multiple of 16 bytes, so arrays in a mapped file are aligned for Vec3.
+uint64_t AlignUp( uint64_t offset )
+{
+    return ( offset + 15 ) & ~ uint64_t( 15 ) ;
+}
+
+} // namespace
+
+void Checkpoint::Capture( const FluidSim & fluidSim , uint64_t uFrame )
+{
+    const VortonSim &               vortonSim   = fluidSim.mVortonSim ;
+    const std::vector< Vorton > &   vortons     = vortonSim.mVortons ;
+    const std::vector< Particle > & tracers     = vortonSim.mTracers ;
+    const std::vector< RbSphere > & spheres     = fluidSim.mSpheres ;
+    const std::vector< RbSdf > &    sdfBodies   = fluidSim.mSdfBodies ;
+
+    Header header ;
+    memcpy( header.mMagic , sMagic , sizeof( sMagic ) ) ;
+    header.mVersion         = sVersion ;
+    header.mVortonSize      = uint32_t( sizeof( Vorton ) ) ;
+    header.mParticleSize    = uint32_t( sizeof( Particle ) ) ;
+    header.mBodySize        = uint32_t( sizeof( BodyRecord ) ) ;
+    header.mFrame           = uFrame ;
+    header.mNumVortons      = vortons.size() ;
+    header.mNumTracers      = tracers.size() ;
+    header.mNumSpheres      = spheres.size() ;
+    header.mNumSdfBodies    = sdfBodies.size() ;
+    header.mParamsOffset    = AlignUp( sizeof( Header ) ) ;
+    header.mVortonOffset    = AlignUp( header.mParamsOffset + sizeof( Parameters ) ) ;
+    header.mTracerOffset    = AlignUp( header.mVortonOffset + header.mNumVortons * sizeof( Vorton ) ) ;
+    header.mBodyOffset      = AlignUp( header.mTracerOffset + header.mNumTracers * sizeof( Particle ) ) ;
+    header.mFileSize        = header.mBodyOffset + ( header.mNumSpheres + header.mNumSdfBodies ) * sizeof( BodyRecord ) ;
+
+    // Zero-fill so padding in records built here is deterministic.  This reuses capacity from previous captures.
+    mImage.assign( size_t( header.mFileSize ) , 0 ) ;
+    char * pImage = mImage.data() ;
+    memcpy( pImage , & header , sizeof( header ) ) ;
+
+    Parameters & rParams = * new ( pImage + header.mParamsOffset ) Parameters ;
+    rParams.mCirculationInitial     = vortonSim.mCirculationInitial ;
+    rParams.mLinearImpulseInitial   = vortonSim.mLinearImpulseInitial ;
+    rParams.mAverageVorticity       = vortonSim.mAverageVorticity ;
+    rParams.mViscosity              = vortonSim.mViscosity ;
+    rParams.mFluidDensity           = vortonSim.mFluidDensity ;
+    rParams.mMassPerParticle        = vortonSim.mMassPerParticle ;
+    rParams.mRemeshThreshold        = vortonSim.mRemeshThreshold ;
+    rParams.mMergeFraction          = vortonSim.mMergeFraction ;
+    rParams.mSplitStretchRate       = vortonSim.mSplitStretchRate ;
+    rParams.mRemeshPeriod           = vortonSim.mRemeshPeriod ;
+    rParams.mTargetNumVortons       = vortonSim.mTargetNumVortons ;
+
+    if( ! vortons.empty() ) memcpy( pImage + header.mVortonOffset , vortons.data() , vortons.size() * sizeof( Vorton ) ) ;
+    if( ! tracers.empty() ) memcpy( pImage + header.mTracerOffset , tracers.data() , tracers.size() * sizeof( Particle ) ) ;
+
+    BodyRecord * pBodies = reinterpret_cast< BodyRecord * >( pImage + header.mBodyOffset ) ;
+    auto storeBody = [ & ]( const RigidBody & rBody , float radius )
+    {
+        // Construct in place so padding keeps the zeros of the image, which makes files reproducible.
+        BodyRecord & rRecord = * new ( pBodies ++ ) BodyRecord ;
+        rRecord.mPosition       = rBody.mPosition ;
+        rRecord.mVelocity       = rBody.mVelocity ;
+        rRecord.mOrientation    = rBody.mOrientation ;
+        rRecord.mAngVelocity    = rBody.mAngVelocity ;
+        rRecord.mForce          = rBody.mForce ;
+        rRecord.mTorque         = rBody.mTorque ;
+        rRecord.mMomentum       = rBody.mMomentum ;
+        rRecord.mAngMomentum    = rBody.mAngMomentum ;
+        rRecord.mInverseMass    = rBody.mInverseMass ;
+        rRecord.mRadius         = radius ;
+        for( size_t i = 0 ; i < 3 ; ++ i )
+        {
+            rRecord.mInertiaInv[ i ] = rBody.mInertiaInv[ i ] ;
+        }
+    } ;
+    for( const RbSphere & rSphere : spheres )
+    {
+        storeBody( rSphere , rSphere.mRadius ) ;
+    }
+    for( const RbSdf & rBody : sdfBodies )
+    {
+        storeBody( rBody , 0.0f ) ;
+    }
+}
+
+bool Checkpoint::Write( const std::string & path ) const
+{
+    const std::string pathTemp = path + ".tmp" ;
+    FILE * pFile = fopen( pathTemp.c_str() , "wb" ) ;
+    if( ! pFile ) return false ;
+    const bool bWritten = fwrite( mImage.data() , 1 , mImage.size() , pFile ) == mImage.size() ;
+    const bool bClosed  = 0 == fclose( pFile ) ;
+    if( ! ( bWritten && bClosed ) )
+    {
+        remove( pathTemp.c_str() ) ;
+        return false ;
+    }
+#if defined( _WIN32 )
+    remove( path.c_str() ) ;    // rename does not replace existing files on Windows.
+#endif
+    return 0 == rename( pathTemp.c_str() , path.c_str() ) ;
+}
+
+/* static */ bool Checkpoint::Load( FluidSim & fluidSim , uint64_t & uFrame , const std::string & path )
+{
+    MappedFile file( path ) ;
+    const char * pFile = file.GetData() ;
+    if( ( nullptr == pFile ) || ( file.GetSize() < sizeof( Header ) ) ) return false ;
+
+    Header header ;
+    memcpy( & header , pFile , sizeof( header ) ) ;
+    if(     ( 0 != memcmp( header.mMagic , sMagic , sizeof( sMagic ) ) )
+        ||  ( header.mVersion       != sVersion )
+        ||  ( header.mVortonSize    != sizeof( Vorton ) )
+        ||  ( header.mParticleSize  != sizeof( Particle ) )
+        ||  ( header.mBodySize      != sizeof( BodyRecord ) )
+        ||  ( header.mFileSize      != file.GetSize() ) )
+    {   // File is not a checkpoint, or was written by a build with a different layout.
+        return false ;
+    }
+    // Validate layout, so a truncated or corrupt header cannot cause reads beyond the file.
+    // Check that sections lie in order within the mapped file before subtracting offsets,
+    // since the differences are unsigned and would otherwise wrap around to huge counts.
+    if(     ( file.GetSize() < header.mFileSize )
+        ||  ( header.mParamsOffset != AlignUp( sizeof( Header ) ) )
+        ||  ( header.mVortonOffset != AlignUp( header.mParamsOffset + sizeof( Parameters ) ) )
+        ||  ( header.mVortonOffset > header.mTracerOffset )
+        ||  ( header.mTracerOffset > header.mBodyOffset )
+        ||  ( header.mBodyOffset > header.mFileSize ) )
+    {
+        return false ;
+    }
+    const uint64_t maxBodies = ( header.mFileSize - header.mBodyOffset ) / sizeof( BodyRecord ) ;
+    if(     ( header.mNumVortons > ( header.mTracerOffset - header.mVortonOffset ) / sizeof( Vorton ) )
+        ||  ( header.mTracerOffset != AlignUp( header.mVortonOffset + header.mNumVortons * sizeof( Vorton ) ) )
+        ||  ( header.mNumTracers > ( header.mBodyOffset - header.mTracerOffset ) / sizeof( Particle ) )
+        ||  ( header.mBodyOffset != AlignUp( header.mTracerOffset + header.mNumTracers * sizeof( Particle ) ) )
+        ||  ( header.mNumSpheres > maxBodies ) || ( header.mNumSdfBodies > maxBodies - header.mNumSpheres )
+        ||  ( header.mFileSize != header.mBodyOffset + ( header.mNumSpheres + header.mNumSdfBodies ) * sizeof( BodyRecord ) ) )
+    {
+        return false ;
+    }
+    if( header.mNumSdfBodies != fluidSim.mSdfBodies.size() )
+    {   // Shapes of signed-distance-field bodies are not stored, so caller must supply them.
+        return false ;
+    }
+
+    VortonSim & vortonSim = fluidSim.mVortonSim ;
+    const Parameters & rParams = * reinterpret_cast< const Parameters * >( pFile + header.mParamsOffset ) ;
+    vortonSim.mCirculationInitial   = rParams.mCirculationInitial ;
+    vortonSim.mLinearImpulseInitial = rParams.mLinearImpulseInitial ;
+    vortonSim.mAverageVorticity     = rParams.mAverageVorticity ;
+    vortonSim.mViscosity            = rParams.mViscosity ;
+    vortonSim.mFluidDensity         = rParams.mFluidDensity ;
+    vortonSim.mMassPerParticle      = rParams.mMassPerParticle ;
+    vortonSim.mRemeshThreshold      = rParams.mRemeshThreshold ;
+    vortonSim.mMergeFraction        = rParams.mMergeFraction ;
+    vortonSim.mSplitStretchRate     = rParams.mSplitStretchRate ;
+    vortonSim.mRemeshPeriod         = size_t( rParams.mRemeshPeriod ) ;
+    vortonSim.mTargetNumVortons     = size_t( rParams.mTargetNumVortons ) ;
+
+    const Vorton *      pVortons    = reinterpret_cast< const Vorton * >( pFile + header.mVortonOffset ) ;
+    const Particle *    pTracers    = reinterpret_cast< const Particle * >( pFile + header.mTracerOffset ) ;
+    vortonSim.mVortons.assign( pVortons , pVortons + header.mNumVortons ) ;
+    vortonSim.mTracers.assign( pTracers , pTracers + header.mNumTracers ) ;
+    vortonSim.mTracerHistory.Clear() ;
+
+    const BodyRecord * pBodies = reinterpret_cast< const BodyRecord * >( pFile + header.mBodyOffset ) ;
+    auto restoreBody = [ & ]( RigidBody & rBody , const BodyRecord & rRecord )
+    {
+        rBody.mPosition     = rRecord.mPosition ;
+        rBody.mVelocity     = rRecord.mVelocity ;
+        rBody.mOrientation  = rRecord.mOrientation ;
+        rBody.mAngVelocity  = rRecord.mAngVelocity ;
+        rBody.mForce        = rRecord.mForce ;
+        rBody.mTorque       = rRecord.mTorque ;
+        rBody.mMomentum     = rRecord.mMomentum ;
+        rBody.mAngMomentum  = rRecord.mAngMomentum ;
+        rBody.mInverseMass  = rRecord.mInverseMass ;
+        for( size_t i = 0 ; i < 3 ; ++ i )
+        {
+            rBody.mInertiaInv[ i ] = rRecord.mInertiaInv[ i ] ;
+        }
+    } ;
+    fluidSim.mSpheres.resize( size_t( header.mNumSpheres ) ) ;
+    for( RbSphere & rSphere : fluidSim.mSpheres )
+    {
+        restoreBody( rSphere , * pBodies ) ;
+        rSphere.mRadius = pBodies->mRadius ;
+        ++ pBodies ;
+    }
+    for( RbSdf & rBody : fluidSim.mSdfBodies )
+    {
+        restoreBody( rBody , * pBodies ) ;
+        ++ pBodies ;
+    }
+
+    // Bodies may have changed, so rebuild the body tree on next use.
+    fluidSim.mBodyProxies.clear() ;
+
+    uFrame = header.mFrame ;
+    return true ;
+}
+
+bool CheckpointWriter::Save( const FluidSim & fluidSim , uint64_t uFrame , const std::string & path )
+{
+    const bool bPreviousResult = Wait() ;  // Snapshot must not change while being written.
+    mSnapshot.Capture( fluidSim , uFrame ) ;
+    mThread = std::thread( [ this , path ]() { mResult = mSnapshot.Write( path ) ; } ) ;
+    return bPreviousResult ;
+}
+
+bool CheckpointWriter::Wait()
+{
+    if( mThread.joinable() )
+    {
+        mThread.join() ;
+    }
+    return mResult ;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+class FluidSim ;
+
+/*! \brief Binary snapshot of full simulation state, for saving and resuming runs
+
+ A checkpoint holds vortons, tracers, rigid bodies, simulation
+ parameters and the frame counter; everything FluidSim::Update
+ carries from one frame to the next.  Everything else (grids, trees,
+ scratch buffers) gets rebuilt from those at the start of each update,
+ so a run resumed from a checkpoint reproduces the original bit for bit,
+ given the same build, time steps and thread-independent results.
+
+ File layout, all in native byte order:
+
+    Header
+    Parameters
+    Vorton   [ numVortons ]     raw in-memory layout
+    Particle [ numTracers ]     raw in-memory layout
+    BodyRecord [ numSpheres + numSdfBodies ]
+
+ Each array starts at a 16-byte-aligned offset recorded in the header,
+ so a mapped file can be copied straight into the simulation.
+ The header records the format version and element sizes, and Load
+ rejects files whose layout does not match this build.
+
+ Signed-distance-field body shapes are not stored.  To resume a run with
+ such bodies, create the same bodies, with the same shapes, before calling
+ Load, which then restores their motion.
+
+ */
+class Checkpoint
+{
+public:
+    static const uint32_t sVersion = 1 ;    ///< Format version, incremented whenever layout changes
+
+    /*! \brief Copy simulation state into this checkpoint
+
+        Call this between updates.  It copies state into a single
+        contiguous image, so the simulation can carry on while the
+        image gets written.
+
+        \param fluidSim - simulation to copy.
+
+        \param uFrame - frame counter, i.e. the value to pass to the next FluidSim::Update.
+     */
+    void Capture( const FluidSim & fluidSim , uint64_t uFrame ) ;
+
+    /*! \brief Write captured image to a file
+
+        This writes to a temporary file then renames it over path,
+        so a crash while writing leaves any previous checkpoint intact.
+
+        \return true if the file was written, false otherwise.
+     */
+    bool Write( const std::string & path ) const ;
+
+    /*! \brief Restore simulation state from a checkpoint file
+
+        This maps the file into memory, validates it, and copies its
+        contents into fluidSim.  Call this instead of FluidSim::Initialize.
+
+        \param fluidSim - simulation to restore.  Its spheres get replaced.
+                Its signed-distance-field bodies must already match those saved.
+
+        \param uFrame - (output) frame counter to pass to the next FluidSim::Update.
+
+        \param path - checkpoint file to read.
+
+        \return true if state was restored, false if the file could not be
+                read or does not match this build, in which case fluidSim is unchanged.
+     */
+    static bool Load( FluidSim & fluidSim , uint64_t & uFrame , const std::string & path ) ;
+
+    const std::vector< char > & GetImage() const { return mImage ; }
+
+private:
+    std::vector< char > mImage ;    ///< Contents of checkpoint file
+} ;
+
+/*! \brief Write checkpoints on a background thread
+
+ Save captures state on the calling thread, at a frame boundary, then
+ writes that copy on a background thread while the simulation continues.
+ At most one write is in flight: Save waits for the previous one first.
+
+ */
+class CheckpointWriter
+{
+public:
+    CheckpointWriter() : mResult( true ) {}
+    ~CheckpointWriter() { Wait() ; }
+    CheckpointWriter( const CheckpointWriter & ) = delete ;
+    CheckpointWriter & operator=( const CheckpointWriter & ) = delete ;
+
+    /*! \brief Capture simulation state and start writing it to a file
+
+        \return result of the previous write, as from Wait.
+     */
+    bool Save( const FluidSim & fluidSim , uint64_t uFrame , const std::string & path ) ;
+
+    /*! \brief Wait for any write in flight to finish
+
+        \return true if the most recent write succeeded (or none happened).
+     */
+    bool Wait() ;
+
+private:
+    Checkpoint  mSnapshot   ;   ///< State being written
+    std::thread mThread     ;   ///< Thread writing mSnapshot
+    bool        mResult     ;   ///< Whether the most recent write succeeded
+} ;
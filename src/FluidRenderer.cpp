@@ -1,6 +1,7 @@
 #include "FluidRenderer.hpp"
 #include "ofBufferObject.h"
 #include "VorticityDistribution.hpp"
+#include "Profiler.hpp"
 #include "ofMain.h"
 
 float gViscosity = 0.05f;
@@ -15,6 +16,7 @@ FluidRenderer::FluidRenderer() {
 	const std::vector<Particle> & tracers = mFluidSim->GetVortonSim().GetTracers();
 	mBuf->allocate(sizeof(Particle) * tracers.size(), tracers.data(), GL_DYNAMIC_DRAW);
 	mVbo->setVertexBuffer(*mBuf, 3, sizeof(Particle));
+	mNumTracersDrawn = tracers.size();
     
     fRadius = 1.0f;
     fThickness = 10.f;
@@ -25,16 +27,16 @@ FluidRenderer::FluidRenderer() {
 
 	auto & vortons = mFluidSim->GetVortonSim().GetVortons();
     
-//    AssignVorticity( vortons , 0.125f * FLT_EPSILON , 2048 , VortexNoise( ofVec3f( fThickness , fThickness , fThickness ) ) ) ;
+//    AssignVorticity( vortons , 0.125f * FLT_EPSILON , 2048 , VortexNoise( Vec3( fThickness , fThickness , fThickness ) ) ) ;
     
     //Jet vortex ring, velocity in [0,1]
-//    AssignVorticity( vortons , fMagnitude , numVortonsMax , JetRing( fRadius , fThickness , ofVec3f( 1.0f , 0.0f , 0.0f ) ) ) ;
+//    AssignVorticity( vortons , fMagnitude , numVortonsMax , JetRing( fRadius , fThickness , Vec3( 1.0f , 0.0f , 0.0f ) ) ) ;
     
     // 2 orthogonal vortex tubes
 //    AssignVorticity( vortons , fMagnitude , numVortonsMax , VortexTube( fThickness , /* variation */ 0.0f , /* width */ 4.0f * fThickness , 2 , -1 ) ) ;
 //    AssignVorticity( vortons , fMagnitude , numVortonsMax , VortexTube( fThickness , /* variation */ 0.0f , /* width */ 4.0f * fThickness , 2 ,  1 ) ) ;
     
-//    AssignVorticity(vortons, fMagnitude, numVortonsMax, VortexNoise(ofVec3f(5.f)));
+//    AssignVorticity(vortons, fMagnitude, numVortonsMax, VortexNoise(Vec3(5.f)));
     
     //Cool Planet formation!
     AssignVorticity(vortons, fMagnitude, numVortonsMax, VortexTube(fThickness, 0.2f, 4.0f * fThickness, 2, 1));
@@ -44,17 +46,47 @@ FluidRenderer::FluidRenderer() {
 }
 
 void FluidRenderer::Update(float timeStep, size_t uFrame) {
-	mFluidSim->Update(timeStep, uFrame);
+	if (mArchive.IsOpen()) {
+		// Play back recorded frames instead of simulating, and hold the simulation frame counter.
+		mFrameOffset = mNextFrame - uFrame - 1;
+		mArchive.ReadTracers(mPlaybackTracers, mPlaybackFrame);
+		mPlaybackFrame = (mPlaybackFrame + 1) % mArchive.GetNumFrames();
 
-	//Upload particles to GPU
-	const std::vector<Particle> & tracers = mFluidSim->GetVortonSim().GetTracers();
-	mBuf->allocate(sizeof(Particle) * tracers.size(), tracers.data(), GL_DYNAMIC_DRAW);
-	mVbo->setVertexBuffer(*mBuf, 3, sizeof(Particle));
+		mBuf->allocate(sizeof(Vec3) * mPlaybackTracers.size(), mPlaybackTracers.data(), GL_DYNAMIC_DRAW);
+		mVbo->setVertexBuffer(*mBuf, 3, sizeof(Vec3));
+		mNumTracersDrawn = mPlaybackTracers.size();
+		return;
+	}
+
+	mFluidSim->Update(timeStep, uFrame + mFrameOffset);
+	mNextFrame = uFrame + mFrameOffset + 1;
+
+	if (mTracerWriter.IsOpen()) {
+		mTracerWriter.Append(mFluidSim->GetVortonSim().GetTracers(), uFrame + mFrameOffset);
+	}
+	if (mArchiveWriter.IsOpen()) {
+		mArchiveWriter.Append(mFluidSim->GetVortonSim(), uFrame + mFrameOffset);
+	}
+	if (mVolumeExporter.IsStarted()) {
+		mVolumeExporter.Export(mFluidSim->GetVortonSim().GetVelocityGrid(), uFrame + mFrameOffset);
+	}
+
+	{   //Upload particles to GPU
+		PROFILE_SCOPE(FluidRenderer_Upload);
+		const std::vector<Particle> & tracers = mFluidSim->GetVortonSim().GetTracers();
+		mBuf->allocate(sizeof(Particle) * tracers.size(), tracers.data(), GL_DYNAMIC_DRAW);
+		mVbo->setVertexBuffer(*mBuf, 3, sizeof(Particle));
+		mNumTracersDrawn = tracers.size();
+	}
+
+#if USE_PROFILER
+	Profiler::EndFrame(uFrame + mFrameOffset);
+#endif
 }
 
 void FluidRenderer::Draw() {
     ofSetColor(255, 255, 255);
-    mVbo->draw(GL_POINTS, 0, (int)mFluidSim->GetVortonSim().GetTracers().size());
+    mVbo->draw(GL_POINTS, 0, (int)mNumTracersDrawn);
     
 //    ofSetColor(255, 0, 0);
 //    //Draw the vortons for debugging
@@ -70,7 +102,7 @@ void FluidRenderer::KeyPressed( int key ) {
     switch (key) {
         case '1':
             //Jet vortex ring, velocity in [0,1]
-            AssignVorticity( vortons , fMagnitude , numVortonsMax , JetRing( fRadius , fThickness , ofVec3f( 1.0f , 0.0f , 0.0f ) ) ) ;
+            AssignVorticity( vortons , fMagnitude , numVortonsMax , JetRing( fRadius , fThickness , Vec3( 1.0f , 0.0f , 0.0f ) ) ) ;
             break;
             
         case '2':
@@ -95,6 +127,92 @@ void FluidRenderer::KeyPressed( int key ) {
             mFluidSim->Initialize(numTracersPerCubeRoot);
             break;
         }
+        case 'c':
+            // Save checkpoint in the background.
+            mCheckpointWriter.Save(*mFluidSim, mNextFrame, "checkpoint.bin");
+            break;
+
+        case 'l': {
+            // Resume from checkpoint.
+            mCheckpointWriter.Wait();
+            uint64_t uFrame;
+            if (Checkpoint::Load(*mFluidSim, uFrame, "checkpoint.bin")) {
+                mFrameOffset += size_t(uFrame) - mNextFrame;
+                mNextFrame = size_t(uFrame);
+            }
+            break;
+        }
+        case 't':
+            // Start or stop recording tracers.
+            if (mTracerWriter.IsOpen()) {
+                mTracerWriter.Close();
+            } else {
+                mTracerWriter.Open("tracers.trs");
+            }
+            break;
+
+        case 'a':
+            // Start or stop recording an archive for playback.
+            if (mArchiveWriter.IsOpen()) {
+                mArchiveWriter.Close();
+            } else {
+                mArchiveWriter.Open("frames.vta");
+            }
+            break;
+
+        case 'v':
+            // Start or stop exporting velocity and vorticity volumes.
+            if (mVolumeExporter.IsStarted()) {
+                mVolumeExporter.Stop();
+            } else {
+                mVolumeExporter.Start("volume");
+            }
+            break;
+
+        case 'p':
+            // Start or stop playing back the archive.
+            if (mArchive.IsOpen()) {
+                mArchive.Close();
+            } else {
+                mArchiveWriter.Close();
+                if (mArchive.Open("frames.vta") && (mArchive.GetNumFrames() == 0)) {
+                    mArchive.Close();
+                }
+                mPlaybackFrame = 0;
+            }
+            break;
+
+#if USE_PROFILER
+        case 'f':
+            // Start or stop logging per-phase timings each frame, and write a summary when stopping.
+            if (Profiler::IsFrameLogOpen()) {
+                Profiler::CloseFrameLog();
+                Profiler::WriteSummaryJson("profile.json");
+            } else {
+                Profiler::OpenFrameLog("profile.csv");
+            }
+            break;
+
+        case 'e':
+            // Start or stop writing a Chrome trace-event timeline of simulation phases and parallel tasks.
+            if (Profiler::IsTracing()) {
+                Profiler::StopTrace();
+            } else {
+                Profiler::StartTrace("trace.json");
+            }
+            break;
+#endif
+
+        case '[':
+        case ']':
+            // Scrub through the archive by a twentieth of its length.
+            if (mArchive.IsOpen()) {
+                const size_t numFrames = mArchive.GetNumFrames();
+                const size_t step = std::max(size_t(1), numFrames / 20);
+                mPlaybackFrame = (key == ']') ? (mPlaybackFrame + step) % numFrames : (mPlaybackFrame + numFrames - step % numFrames) % numFrames;
+            }
+            break;
+
         default:
             break;
     }
@@ -2,6 +2,10 @@
 
 #include <memory>
 #include "FluidSim.hpp"
+#include "Checkpoint.hpp"
+#include "FrameArchive.hpp"
+#include "TracerStream.hpp"
+#include "VolumeExport.hpp"
 #include "ofVbo.h"
 
 typedef std::unique_ptr<FluidSim> FluidSimRef;
@@ -26,5 +30,16 @@ private:
     size_t     numCellsPerDim = 16;
     size_t     numVortonsMax = numCellsPerDim * numCellsPerDim * numCellsPerDim;
     size_t                numTracersPerCubeRoot = 6;
+
+    CheckpointWriter    mCheckpointWriter;      ///< Writes checkpoints in the background
+    size_t              mFrameOffset = 0;       ///< Added to frame number from app, so resumed runs continue their frame count
+    size_t              mNextFrame = 0;         ///< Frame number the next simulation update will use
+    TracerStreamWriter  mTracerWriter;          ///< Records tracers each frame while open
+    FrameArchiveWriter  mArchiveWriter;         ///< Records vortons and tracers each frame while open
+    VolumeExporter      mVolumeExporter;        ///< Exports velocity and vorticity grids each frame while started
+    FrameArchive        mArchive;               ///< Archive being played back, if open
+    size_t              mPlaybackFrame = 0;     ///< Index of archive frame to draw next
+    std::vector<Vec3>   mPlaybackTracers;       ///< Tracer positions decoded from archive
+    size_t              mNumTracersDrawn = 0;   ///< Number of tracers in the vertex buffer
     
 };
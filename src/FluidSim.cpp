@@ -1,4 +1,7 @@
 #include "FluidSim.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <thread>
 
 /*! \brief Select boundary condition handling scheme
  
@@ -56,6 +59,163 @@
  */
 #define FLOW_AFFECTS_BODY 1
 
+namespace {
+
+/// Number of particles in each chunk of work for SolveBoundaryConditions
+const size_t sContactChunkSize = 256 ;
+
+/*! \brief Partition particles into a grid fitted to their bounding box
+
+    \param cells - (output) partition of particles, by cell.
+
+    \param particles - array of particles, each with an mPosition member.
+
+    \note The grid has about as many cells as there are particles.
+*/
+template< class ParticleT > void PartitionParticles( CellList & cells , const std::vector< ParticleT > & particles )
+{
+    Vec3 vMinCorner( FLT_MAX , FLT_MAX , FLT_MAX ) ;
+    Vec3 vMaxCorner( - vMinCorner ) ;
+    for( const ParticleT & rParticle : particles )
+    {   // For each particle...
+        vMinCorner.x = std::min( vMinCorner.x , rParticle.mPosition.x ) ;
+        vMinCorner.y = std::min( vMinCorner.y , rParticle.mPosition.y ) ;
+        vMinCorner.z = std::min( vMinCorner.z , rParticle.mPosition.z ) ;
+        vMaxCorner.x = std::max( vMaxCorner.x , rParticle.mPosition.x ) ;
+        vMaxCorner.y = std::max( vMaxCorner.y , rParticle.mPosition.y ) ;
+        vMaxCorner.z = std::max( vMaxCorner.z , rParticle.mPosition.z ) ;
+    }
+    if( particles.empty() )
+    {
+        vMinCorner = vMaxCorner = Vec3( 0.0f , 0.0f , 0.0f ) ;
+    }
+    // Slightly enlarge bounding box to allow for round-off errors.
+    const Vec3 nudge( ( vMaxCorner - vMinCorner ) * FLT_EPSILON ) ;
+    UniformGridGeometry grid ;
+    grid.DefineShape( std::max( size_t( 1 ) , particles.size() ) , vMinCorner - nudge , vMaxCorner + nudge , false ) ;
+    cells.Build( grid , particles ) ;
+}
+
+/*! \brief Gather indices of particles in cells that overlap a sphere
+
+    \param candidates - (output) indices of particles that might lie within the sphere, in increasing order.
+
+    \param cells - partition of particles.
+
+    \param vCenter - center of sphere.
+
+    \param radius - radius of sphere.
+
+    \note Particles lie within the box of cells this visits, so this
+            gathers all particles within the sphere, plus some outside it.
+            The caller must still test each candidate exactly.
+*/
+void GatherCandidates( std::vector< uint32_t > & candidates , const CellList & cells , const Vec3 & vCenter , float radius )
+{
+    candidates.clear() ;
+    if( 0 == cells.GetNumParticles() ) return ;
+
+    const UniformGridGeometry & grid            = cells.GetGeometry() ;
+    const Vec3 &                vCellsPerExtent = grid.GetCellsPerExtent() ;
+    const Vec3                  vMinRel( vCenter - Vec3( radius , radius , radius ) - grid.GetMinCorner() ) ;
+    const Vec3                  vMaxRel( vCenter + Vec3( radius , radius , radius ) - grid.GetMinCorner() ) ;
+    size_t idxMin[3] , idxMax[3] ;
+    for( int axis = 0 ; axis < 3 ; ++ axis )
+    {   // Compute range of cells the sphere overlaps, clamped to the grid, since CellList clamps particles the same way.
+        const float maxIndex = float( grid.GetNumPoints( axis ) - 1 ) ;
+        idxMin[ axis ] = size_t( std::min( std::max( vMinRel[ axis ] * vCellsPerExtent[ axis ] , 0.0f ) , maxIndex ) ) ;
+        idxMax[ axis ] = size_t( std::min( std::max( vMaxRel[ axis ] * vCellsPerExtent[ axis ] , 0.0f ) , maxIndex ) ) ;
+    }
+
+    const size_t numX   = grid.GetNumPoints( 0 ) ;
+    const size_t numXY  = numX * grid.GetNumPoints( 1 ) ;
+    for( size_t iz = idxMin[2] ; iz <= idxMax[2] ; ++ iz )
+    for( size_t iy = idxMin[1] ; iy <= idxMax[1] ; ++ iy )
+    {   // For each row of cells overlapping the sphere...
+        // Cells in a row are contiguous so their particles occupy one span of the index array.
+        const size_t offsetRow = iy * numX + iz * numXY ;
+        const uint32_t * pBegin = cells.GetIndices() + cells.GetCellBegin( offsetRow + idxMin[0] ) ;
+        const uint32_t * pEnd   = cells.GetIndices() + cells.GetCellEnd( offsetRow + idxMax[0] ) ;
+        candidates.insert( candidates.end() , pBegin , pEnd ) ;
+    }
+    // Visit particles in the same order a brute-force loop would, so impulses accumulate in that order.
+    std::sort( candidates.begin() , candidates.end() ) ;
+}
+
+/// Return the largest radius of any vorton
+float MaxVortonRadius( const std::vector< Vorton > & vortons )
+{
+    float radiusMax = 0.0f ;
+    for( const Vorton & rVorton : vortons )
+    {
+        radiusMax = std::max( radiusMax , rVorton.mRadius ) ;
+    }
+    return radiusMax ;
+}
+
+/// Return the largest size of any tracer
+float MaxTracerSize( const std::vector< Particle > & tracers )
+{
+    float sizeMax = 0.0f ;
+    for( const Particle & rTracer : tracers )
+    {
+        sizeMax = std::max( sizeMax , rTracer.mSize ) ;
+    }
+    return sizeMax ;
+}
+
+} // namespace
+
+#if USE_TBB
+/*! \brief Function object to collide vortons with a rigid body using Threading Building Blocks
+ */
+class FluidSim_CollideVortons_TBB
+{
+    FluidSim *          mFluidSim   ;   ///< Address of FluidSim object
+    const RigidBody &   mBody       ;   ///< Body to collide with vortons
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Collide subset of chunks of vortons with body.
+        mFluidSim->CollideVortonsSlice( mBody , r.begin() , r.end() ) ;
+    }
+    FluidSim_CollideVortons_TBB( FluidSim * pFluidSim , const RigidBody & rBody )
+    : mFluidSim( pFluidSim )
+    , mBody( rBody )
+    {}
+} ;
+
+/*! \brief Function object to collide tracers with a rigid body using Threading Building Blocks
+ */
+class FluidSim_CollideTracers_TBB
+{
+    FluidSim *          mFluidSim   ;   ///< Address of FluidSim object
+    const RigidBody &   mBody       ;   ///< Body to collide with tracers
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Collide subset of chunks of tracers with body.
+        mFluidSim->CollideTracersSlice( mBody , r.begin() , r.end() ) ;
+    }
+    FluidSim_CollideTracers_TBB( FluidSim * pFluidSim , const RigidBody & rBody )
+    : mFluidSim( pFluidSim )
+    , mBody( rBody )
+    {}
+} ;
+
+/*! \brief Function object to find touching bodies using Threading Building Blocks
+ */
+class FluidSim_FindBodyContacts_TBB
+{
+    FluidSim * mFluidSim ;  ///< Address of FluidSim object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Find contacts for subset of bodies.
+        mFluidSim->FindBodyContactsSlice( r.begin() , r.end() ) ;
+    }
+    FluidSim_FindBodyContacts_TBB( FluidSim * pFluidSim )
+    : mFluidSim( pFluidSim ) {}
+} ;
+#endif
+
 FluidSim::FluidSim(float viscosity, float density) : mVortonSim(viscosity, density)
 {
 }
@@ -80,11 +240,21 @@ void FluidSim::Update(float timeStep, size_t uFrame) {
     // Update fluid, temporarily ignoring rigid bodies and boundary conditions.
     mVortonSim.Update( timeStep , uFrame ) ;
     
-    // Apply boundary conditions and calculate impulses to apply to rigid bodies.
-    SolveBoundaryConditions() ;
+    {   // Apply boundary conditions and calculate impulses to apply to rigid bodies.
+        PROFILE_SCOPE( FluidSim_SolveBoundaryConditions ) ;
+        SolveBoundaryConditions() ;
+    }
+
+    {   // Collide rigid bodies with each other.
+        PROFILE_SCOPE( FluidSim_CollideBodies ) ;
+        CollideBodies() ;
+    }
     
-    // Update rigid bodies.
-    RbSphere::UpdateSystem( mSpheres , timeStep , uFrame ) ;
+    {   // Update rigid bodies.
+        PROFILE_SCOPE( FluidSim_UpdateBodies ) ;
+        RbSphere::UpdateSystem( mSpheres , timeStep , uFrame ) ;
+        RbSdf::UpdateSystem( mSdfBodies , timeStep , uFrame ) ;
+    }
 }
 
 /*! \brief Remove particles within rigid bodies
@@ -99,40 +269,159 @@ void FluidSim::Update(float timeStep, size_t uFrame) {
  
  */
 void FluidSim::RemoveEmbeddedParticles() {
-    const size_t numBodies    = mSpheres.size() ;
-    for( size_t uBody = 0 ; uBody < numBodies ; ++ uBody )
-    {   // For each sphere in the simulation...
-        RbSphere &  rSphere         = mSpheres.at(uBody) ;
-        auto & vortons = mVortonSim.GetVortons();
-        
-        for(auto vortonIt = vortons.begin(); vortonIt != vortons.end(); )
+    UpdateBodyTree() ;
+
+    // Find bodies near each particle using the bounding volume hierarchy, so this costs
+    // O(particles * log(bodies)) instead of O(particles * bodies), and runs in parallel.
+    auto isEmbedded = [ this ]( const Vec3 & vPosition , float radius )
+    {
+        bool bEmbedded = false ;
+        mBodyTree.Query( Aabb::FromSphere( vPosition , radius ) , [ & ]( uint32_t uBody )
         {
-            // For each vorton in the simulation...
-            Vorton & rVorton = *vortonIt;
-            const ofVec3f  vSphereToVorton = rVorton.mPosition - rSphere.mPosition ;   // vector from sphere center to vorton
-            const float fSphereToVorton = vSphereToVorton.length() ;
-            if( fSphereToVorton < ( rVorton.mRadius + rSphere.mRadius ) )
-            {   // Vorton is inside body.
-                // Delete vorton.
-                vortons.erase(vortonIt);
-                // Deleted vorton so now this same index contains a different vorton.
-            } else // Did not delete vorton so skip past it.
-                ++vortonIt;
+            float   distance ;
+            Vec3 vNormal ;
+            bEmbedded = GetBody( uBody ).QuerySurface( distance , vNormal , vPosition ) && ( distance < radius ) ;
+            return ! bEmbedded ;    // Stop at first body that contains the particle.
+        } ) ;
+        return bEmbedded ;
+    } ;
+
+    // Delete embedded particles, preserving the order of the others.
+    mVortonSim.KillParticles( [ & ]( const Vorton & rVorton ) { return isEmbedded( rVorton.mPosition , rVorton.mRadius ) ; }
+                            , [ & ]( const Particle & rTracer ) { return isEmbedded( rTracer.mPosition , rTracer.mSize ) ; } ) ;
+}
+
+/*! \brief Synchronize bounding volume hierarchy with bodies
+
+    Each body has a proxy in mBodyTree whose box is enlarged by a fraction
+    of the body bounding radius, so a body can move a little before its
+    proxy needs reinserting.  If bodies were added or removed since the
+    last call, this rebuilds the tree.
+
+    Proxy user data is the body index, as GetBody takes it.
+*/
+void FluidSim::UpdateBodyTree()
+{
+    static const float sFatFactor = 1.25f ; // Ratio of proxy box radius to body radius.
+    const size_t numBodies = GetNumBodies() ;
+    if( mBodyProxies.size() != numBodies )
+    {   // Number of bodies changed, so rebuild tree.
+        mBodyTree.Clear() ;
+        mBodyProxies.resize( numBodies ) ;
+        for( size_t uBody = 0 ; uBody < numBodies ; ++ uBody )
+        {
+            const RigidBody & rBody = GetBody( uBody ) ;
+            mBodyProxies[ uBody ] = mBodyTree.CreateProxy( Aabb::FromSphere( rBody.mPosition , sFatFactor * rBody.GetBoundingRadius() ) , uint32_t( uBody ) ) ;
         }
-        auto & tracers = mVortonSim.GetTracers();
-        for( size_t iTracer = 0 ; iTracer < tracers.size() ; )
-        {   // For each passive tracer particle in the simulation...
-            Particle & rTracer = tracers.at(iTracer) ;
-            const ofVec3f  vSphereToTracer = rTracer.mPosition - rSphere.mPosition ;   // vector from sphere center to tracer
-            const float fSphereToTracer = vSphereToTracer.length() ;
-            if( fSphereToTracer < ( rTracer.mSize + rSphere.mRadius ) )
-            {   // Tracer particle is inside body.
-                // Delete tracer.
-                mVortonSim.KillTracer( iTracer ) ;
-                // Deleted tracer so now this same index contains a different tracer.
+        return ;
+    }
+    for( size_t uBody = 0 ; uBody < numBodies ; ++ uBody )
+    {   // For each body, update its proxy if it moved outside its fat box.
+        const RigidBody &   rBody   = GetBody( uBody ) ;
+        const float         radius  = rBody.GetBoundingRadius() ;
+        mBodyTree.MoveProxy( mBodyProxies[ uBody ] , Aabb::FromSphere( rBody.mPosition , radius ) , Aabb::FromSphere( rBody.mPosition , sFatFactor * radius ) ) ;
+    }
+}
+
+/*! \brief Find pairs of touching bodies, for a subset of bodies
+
+    \param iBodyBegin - index of first body to process
+
+    \param iBodyEnd - index one past last body to process
+
+    \note For each body i, this stores in mBodyContacts[i], in increasing order,
+            each body j > i that touches it, so each pair appears once.
+*/
+void FluidSim::FindBodyContactsSlice( size_t iBodyBegin , size_t iBodyEnd )
+{
+    for( size_t uBody = iBodyBegin ; uBody < iBodyEnd ; ++ uBody )
+    {   // For each body in this slice...
+        const RbSphere &            rSphere     = mSpheres[ uBody ] ;
+        std::vector< uint32_t > &   rContacts   = mBodyContacts[ uBody ] ;
+        rContacts.clear() ;
+        mBodyTree.Query( Aabb::FromSphere( rSphere.mPosition , rSphere.mRadius ) , [ & ]( uint32_t uOther )
+        {
+            if( ( uOther > uBody ) && ( uOther < mSpheres.size() ) )
+            {   // Other body is a sphere that comes after this one.
+                const RbSphere & rOther = mSpheres[ uOther ] ;
+                const float radiusSum = rSphere.mRadius + rOther.mRadius ;
+                if( ( rOther.mPosition - rSphere.mPosition ).lengthSquared() < radiusSum * radiusSum )
+                {
+                    rContacts.push_back( uOther ) ;
+                }
+            }
+            return true ;
+        } ) ;
+        // Tree traversal order depends on tree shape, so sort to make contact order depend only on body indices.
+        std::sort( rContacts.begin() , rContacts.end() ) ;
+    }
+}
+
+/*! \brief Resolve contacts between bodies
+
+    Touching spheres exchange an impulse along the line between
+    their centers, which removes (a fraction, given by restitution,
+    of) their approaching normal velocity, then get pushed apart
+    to remove most of their overlap, in inverse proportion to mass.
+    Spheres here are frictionless, so contacts exert no torque.
+    Bodies with other shapes (RbSdf) do not collide with other bodies.
+
+    Finding contacts runs in parallel using mBodyTree.  Resolving
+    them runs serially, in order of body indices, over a few sweeps,
+    so that impulses propagate through stacks of touching bodies
+    and results are reproducible.
+*/
+void FluidSim::CollideBodies()
+{
+    static const float  sRestitution        = 0.5f ;    // Fraction of approaching normal speed that becomes separating speed
+    static const float  sPositionCorrection = 0.8f ;    // Fraction of overlap removed per update
+    static const int    sNumSweeps          = 4 ;       // Number of passes over all contacts
+
+    const size_t numBodies = mSpheres.size() ;
+    if( numBodies < 2 ) return ;
+
+    UpdateBodyTree() ;
+
+    mBodyContacts.resize( numBodies ) ;
+#if USE_TBB
+    // Estimate grain size based on size of problem and number of processors.
+    const size_t grainSize = std::max( size_t( 1 ) , numBodies / std::thread::hardware_concurrency() ) ;
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numBodies , grainSize ) , FluidSim_FindBodyContacts_TBB( this ) ) ;
+#else
+    FindBodyContactsSlice( 0 , numBodies ) ;
+#endif
+
+    for( int iSweep = 0 ; iSweep < sNumSweeps ; ++ iSweep )
+    {
+        for( size_t uBody = 0 ; uBody < numBodies ; ++ uBody )
+        {
+            RbSphere & rA = mSpheres[ uBody ] ;
+            for( const uint32_t & uOther : mBodyContacts[ uBody ] )
+            {   // For each body touching this one...
+                RbSphere &      rB              = mSpheres[ uOther ] ;
+                const float     invMassSum      = rA.GetInverseMass() + rB.GetInverseMass() ;
+                const Vec3      vAtoB           = rB.mPosition - rA.mPosition ;
+                const float     distance        = vAtoB.length() ;
+                if( ( invMassSum <= 0.0f ) || ( distance <= FLT_EPSILON ) ) continue ;
+                const Vec3      vNormal         = vAtoB / distance ;
+                const float     normalSpeed     = ( rB.mVelocity - rA.mVelocity ).dot( vNormal ) ;
+                if( normalSpeed < 0.0f )
+                {   // Bodies approach each other.
+                    const Vec3 vImpulse = vNormal * ( - ( 1.0f + sRestitution ) * normalSpeed / invMassSum ) ;
+                    rA.ApplyImpulse( - vImpulse ) ;
+                    rB.ApplyImpulse(   vImpulse ) ;
+                }
+                if( 0 == iSweep )
+                {   // Push bodies apart.
+                    const float overlap = rA.mRadius + rB.mRadius - distance ;
+                    if( overlap > 0.0f )
+                    {
+                        const Vec3 vCorrection = vNormal * ( sPositionCorrection * overlap / invMassSum ) ;
+                        rA.mPosition -= vCorrection * rA.GetInverseMass() ;
+                        rB.mPosition += vCorrection * rB.GetInverseMass() ;
+                    }
+                }
             }
-            else // Did not delete tracer so skip past it.
-                ++ iTracer ;
         }
     }
 }
@@ -178,27 +467,92 @@ void FluidSim::RemoveEmbeddedParticles() {
  
  */
 void FluidSim::SolveBoundaryConditions() {
-    const size_t numBodies        = mSpheres.size() ;
-    const size_t numVortons       = mVortonSim.GetVortons().size() ;
-    const size_t numTracers       = mVortonSim.GetTracers().size() ;
+    const size_t numBodies        = GetNumBodies() ;
     auto & vortons = mVortonSim.GetVortons();
     auto & tracers = mVortonSim.GetTracers();
-    
-#if FLOW_AFFECTS_BODY
-    const float &  rMassPerParticle = mVortonSim.GetMassPerParticle() ;
-#endif
-    
+
+    if( 0 == numBodies ) return ;
+
+    // Broad phase: Partition particles by cell, so each body only visits nearby particles.
+    // Particles a body displaces stay listed in their original cell, which is
+    // harmless since each body only pushes particles to just outside its own surface.
+    PartitionParticles( mVortonCells , vortons ) ;
+    PartitionParticles( mTracerCells , tracers ) ;
+    // Vortons interact with a body when within 1.2 radii of its surface.  See fBndThkFactor in CollideVortonsSlice.
+    const float vortonReach = 1.2f * MaxVortonRadius( vortons ) ;
+    const float tracerReach = MaxTracerSize( tracers ) ;
+
+    // Bodies are processed one at a time, since a particle could touch several.
+    // Particles near each body are processed in parallel, in fixed-size chunks.
+    // During each pass, particles see the body as it was at the start of that pass,
+    // and each chunk accumulates the impulses its particles impart to the body.
+    // Chunk boundaries do not depend on the number of threads, and chunk sums
+    // are applied to the body in chunk order, so results are reproducible.
     for( size_t uBody = 0 ; uBody < numBodies ; ++ uBody )
     {   // For each body in the simulation...
-        RbSphere &  rSphere         = mSpheres.at(uBody) ;
-        
+        RigidBody & rBody           = GetBody( uBody ) ;
+
         // Collide vortons with rigid body.
-        for( size_t uVorton = 0 ; uVorton < numVortons ; ++ uVorton )
-        {   // For each vorton in the simulation...
-            Vorton & rVorton = vortons.at( uVorton ) ;
-            const ofVec3f  vSphereToVorton     = rVorton.mPosition - rSphere.mPosition ;   // vector from body center to vorton
-            const float fSphereToVorton     = vSphereToVorton.length() ;
-            const ofVec3f  vSphereToVortonDir  = vSphereToVorton / fSphereToVorton ;
+        GatherCandidates( mCandidates , mVortonCells , rBody.mPosition , rBody.GetBoundingRadius() + vortonReach ) ;
+        const size_t numVortonChunks = ( mCandidates.size() + sContactChunkSize - 1 ) / sContactChunkSize ;
+        mChunkImpulses.resize( numVortonChunks ) ;
+#if USE_TBB
+        // Estimate grain size based on size of problem and number of processors.
+        const size_t grainSizeVortons = std::max( size_t( 1 ) , numVortonChunks / std::thread::hardware_concurrency() ) ;
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numVortonChunks , grainSizeVortons ) , FluidSim_CollideVortons_TBB( this , rBody ) ) ;
+#else
+        CollideVortonsSlice( rBody , 0 , numVortonChunks ) ;
+#endif
+        ApplyChunkImpulses( rBody , numVortonChunks ) ;
+
+        // Collide tracers with rigid body.
+        GatherCandidates( mCandidates , mTracerCells , rBody.mPosition , rBody.GetBoundingRadius() + tracerReach ) ;
+        const size_t numTracerChunks = ( mCandidates.size() + sContactChunkSize - 1 ) / sContactChunkSize ;
+        mChunkImpulses.resize( numTracerChunks ) ;
+#if USE_TBB
+        const size_t grainSizeTracers = std::max( size_t( 1 ) , numTracerChunks / std::thread::hardware_concurrency() ) ;
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numTracerChunks , grainSizeTracers ) , FluidSim_CollideTracers_TBB( this , rBody ) ) ;
+#else
+        CollideTracersSlice( rBody , 0 , numTracerChunks ) ;
+#endif
+        ApplyChunkImpulses( rBody , numTracerChunks ) ;
+    }
+}
+
+/*! \brief Collide vortons with a rigid body, for a subset of chunks of candidates
+
+    \param rBody - body to collide with vortons.  This routine does not modify it.
+
+    \param iChunkBegin - index of first chunk of mCandidates to process
+
+    \param iChunkEnd - index one past last chunk of mCandidates to process
+
+    \note Each chunk stores the impulse and torque it imparts to the body in mChunkImpulses.
+
+    \see SolveBoundaryConditions, ApplyChunkImpulses
+*/
+void FluidSim::CollideVortonsSlice( const RigidBody & rBody , size_t iChunkBegin , size_t iChunkEnd )
+{
+    auto & vortons = mVortonSim.GetVortons();
+#if FLOW_AFFECTS_BODY
+    const float &  rMassPerParticle = mVortonSim.GetMassPerParticle() ;
+#endif
+
+    for( size_t iChunk = iChunkBegin ; iChunk < iChunkEnd ; ++ iChunk )
+    {   // For each chunk of candidates in this slice...
+        BodyImpulse &   rImpulse        = mChunkImpulses[ iChunk ] ;
+        rImpulse.mLinear = rImpulse.mAngular = Vec3( 0.0f , 0.0f , 0.0f ) ;
+        rImpulse.mNumContacts = 0 ;
+        const size_t    iCandidateEnd   = std::min( ( iChunk + 1 ) * sContactChunkSize , mCandidates.size() ) ;
+        for( size_t iCandidate = iChunk * sContactChunkSize ; iCandidate < iCandidateEnd ; ++ iCandidate )
+        {   // For each vorton near this body...
+            Vorton & rVorton = vortons[ mCandidates[ iCandidate ] ] ;
+            float   fBodySurfToVortCtr ;    // Signed distance from body surface to vorton center
+            Vec3 vSurfNormal ;           // Outward surface normal nearest vorton
+            if( ! rBody.QuerySurface( fBodySurfToVortCtr , vSurfNormal , rVorton.mPosition ) )
+            {   // Vorton is far from body.
+                continue ;
+            }
             // This boundary thickness compensates for low discretization resolution,
             // by spreading the influence of the body surface to just outside the body,
             // deeper into the fluid.  This also has an effect somewhat like
@@ -216,60 +570,58 @@ void FluidSim::SolveBoundaryConditions() {
             // time due to the increased number of vortons involved.
             const float fBndThkFactor       = 1.2f ; // Thickness of boundary, in vorton radii.
             const float fBoundaryThickness  = fBndThkFactor * rVorton.mRadius ; // Thickness of boundary, i.e. region within which body sheds vorticity into fluid.
-            
-            if( fSphereToVorton < ( rSphere.mRadius + fBoundaryThickness ) )
+        
+            if( fBodySurfToVortCtr < fBoundaryThickness )
             {   // Vorton is interacting with body.
-                
+            
                 // Compute "contact" point, near where vorton touched body.
-                const ofVec3f vContactPtRelBody        = vSphereToVortonDir * rSphere.mRadius ;
-                const ofVec3f vContactPtWorld          = vContactPtRelBody + rSphere.mPosition ;
-                
+                const Vec3 vContactPtWorld          = rVorton.mPosition - vSurfNormal * fBodySurfToVortCtr ;
+                const Vec3 vContactPtRelBody        = vContactPtWorld - rBody.mPosition ;
+            
                 // Compute velocity of body at contact point.
-                const ofVec3f vVelDueToRotAtConPt      = rSphere.mAngVelocity ^ vContactPtRelBody ; // linear velocity, of body at contact point, due to its own rotation
-                const ofVec3f vVelBodyAtConPt          = rSphere.mVelocity + vVelDueToRotAtConPt    ; // Total linear velocity of body at contact point
-                
-                const ofVec3f vVorticityOld            = rVorton.mVorticity ;  // Cache to compute change in angular momentum.
-                
+                const Vec3 vVelDueToRotAtConPt      = rBody.mAngVelocity ^ vContactPtRelBody ; // linear velocity, of body at contact point, due to its own rotation
+                const Vec3 vVelBodyAtConPt          = rBody.mVelocity + vVelDueToRotAtConPt    ; // Total linear velocity of body at contact point
+            
+                const Vec3 vVorticityOld            = rVorton.mVorticity ;  // Cache to compute change in angular momentum.
+            
                 // Each scheme below projects this vorton to the body surface,
                 // but the exact location depends on the scheme.
-                
+            
 #if ! BOUNDARY_NO_SLIP_NO_THRU   // Assign vorticity to spin like the object.
                                  // Place vorton tangent to body surface along surface normal.
-                const float distRescale         = ( rSphere.mRadius + rVorton.mRadius ) * ( 1.0f + FLT_EPSILON ) ;
-                const ofVec3f  vDisplacementNew    = vSphereToVortonDir * distRescale ;
-                rVorton.mPosition               = rSphere.mPosition + vDisplacementNew ;
-                const ofVec3f  vAngVelDiff         = rVorton.mVorticity - rSphere.mAngVelocity ;   // (negative of) change in angular velocity applied to vorton
-                rVorton.mVorticity              = rSphere.mAngVelocity ;                        // Assign vorticity of vorton at its new position.
-                
+                rVorton.mPosition               = vContactPtWorld + vSurfNormal * ( rVorton.mRadius * ( 1.0f + FLT_EPSILON ) ) ;
+                const Vec3     vAngVelDiff         = rVorton.mVorticity - rBody.mAngVelocity ;     // (negative of) change in angular velocity applied to vorton
+                rVorton.mVorticity              = rBody.mAngVelocity ;                          // Assign vorticity of vorton at its new position.
+            
 #else // BOUNDARY_NO_SLIP_NO_THRU:
 #if ! BOUNDARY_RESPECTS_AMBIENT_FLOW
                 // This assigns a vorticity such that the fluid velocity,
                 // relative to the body velocity at the contact point, is zero.
                 // NOTE: This neglects the ambient flow due to other vortons.
-                const ofVec3f   velFlowRelBodyAtColPt = - vVelBodyAtConPt ;
-                
+                const Vec3      velFlowRelBodyAtColPt = - vVelBodyAtConPt ;
+            
 #else // BOUNDARY_RESPECTS_AMBIENT_FLOW
       // Make relative fluid velocity at body nearest this vorton,
       // due to "ambient" flow, to be zero.
       // Interpolate ambient velocity at that point on the sphere.
-                ofVec3f velAmbientAtContactPt ; // Velocity due to entire vorton field at collision point.
+                Vec3 velAmbientAtContactPt ; // Velocity due to entire vorton field at collision point.
                 mVortonSim.GetVelocityGrid().Interpolate( velAmbientAtContactPt , vContactPtWorld ) ;
-                
+            
 #if ! BOUNDARY_AMBIENT_FLOW_OMITS_VORTON_OLD_POSITION
                 // Compute relative velocity between body (at contact point) and ambient flow.
                 // NOTE: This neglects the fact that the ambient flow in mVelGrid also includes the
                 //       influence of this same vorton, at its previous position.  If this interaction
                 //       did not displace this vorton much, that could be a significant omission.
-                const ofVec3f velFlowRelBodyAtColPt( velAmbientAtContactPt - vVelBodyAtConPt ) ;
-                
+                const Vec3 velFlowRelBodyAtColPt( velAmbientAtContactPt - vVelBodyAtConPt ) ;
+            
 #else // BOUNDARY_AMBIENT_FLOW_OMITS_VORTON_OLD_POSITION
       // Compute velocity induced by this vorton, from its old location, at contact point.
-                ofVec3f    velDueToVort( 0.0f , 0.0f , 0.0f ) ;
+                Vec3       velDueToVort( 0.0f , 0.0f , 0.0f ) ;
                 rVorton.AccumulateVelocity( velDueToVort , vContactPtWorld ) ;
-                
+            
                 // Compute relative velocity between body at contact point and ambient flow,
                 // subtracting the influence due to the vorton from the interpolated velocity.
-                const ofVec3f velFlowRelBodyAtColPt( velAmbientAtContactPt - velDueToVort - vVelBodyAtConPt ) ;
+                const Vec3 velFlowRelBodyAtColPt( velAmbientAtContactPt - velDueToVort - vVelBodyAtConPt ) ;
 #endif
 #endif
                 // Place vorton tangent to body surface along a "bend" (b),
@@ -300,17 +652,15 @@ void FluidSim::SolveBoundaryConditions() {
                 // is assigned to the vorton such that the flow field
                 // satisfies no-through and no-slip boundary conditions
                 // at the contact point.
-                const ofVec3f  vSurfNormal         = vSphereToVorton.getNormalized() ;
-                const ofVec3f  vVelDir             = velFlowRelBodyAtColPt.getNormalized() ;
-                const ofVec3f  vVortDir            = vSurfNormal ^ vVelDir ;
-                ofVec3f  vBendDir                  = vVortDir ^ vVelDir ;
+                const Vec3     vVelDir             = velFlowRelBodyAtColPt.getNormalized() ;
+                const Vec3     vVortDir            = vSurfNormal ^ vVelDir ;
+                Vec3           vBendDir            = vVortDir ^ vVelDir ;
                 vBendDir.normalize();
-                const float fBodySurfToVortCtr  = fSphereToVorton - rSphere.mRadius ;
                 // If vorton was inside body, push it outside body, otherwise just pivot vorton about contact point.
                 const float fBendDist           = fBodySurfToVortCtr < rVorton.mRadius ? rVorton.mRadius : fBodySurfToVortCtr ;
-                const ofVec3f  vBend               = fBendDist * vBendDir ;
+                const Vec3     vBend               = fBendDist * vBendDir ;
                 rVorton.mPosition               = vContactPtWorld - vBend ;
-                
+            
                 {
                     // Assign the vorticity of that vorton at its new position.
                     // This assigns a vorticity such that the fluid velocity (relative
@@ -338,24 +688,24 @@ void FluidSim::SolveBoundaryConditions() {
                     // localized diffusion, in that it keeps vorticity smoother.
                     //
                     // If fGain is too small then vortices might not shed fast enough.
-                    
+                
                     const float fGain         = 0.1f ;
                     const float fOneMinusGain = 1.0f - fGain ;
                     rVorton.mVorticity = fGain * rVorton.mVorticity + fOneMinusGain * vVorticityOld ;
 #endif
                 }
-                
-                const ofVec3f  vAngVelDiff     = rVorton.mVorticity - vVorticityOld ;   // Change in angular velocity applied to vorton
+            
+                const Vec3     vAngVelDiff     = rVorton.mVorticity - vVorticityOld ;   // Change in angular velocity applied to vorton
 #endif
-                
+            
                 // Transfer angular momentum from vorton to body.
                 // Unlike with the linear momentum exchange above, this
                 // exactly preserves angular momentum at each time step.
 #if FLOW_AFFECTS_BODY
                 const float fMomentOfInertialVorton = 0.3f * rMassPerParticle ;
-                rSphere.ApplyImpulsiveTorque( vAngVelDiff * fMomentOfInertialVorton ) ;  // Apply angular impulse (impulsive torque) to body
+                rImpulse.mAngular += vAngVelDiff * fMomentOfInertialVorton ;  // Accumulate angular impulse (impulsive torque) to apply to body
 #endif
-                
+            
                 // Transfer linear momentum between vorton and body.
                 // Note that this does not strictly conserve linear momentum, in the sense
                 // that this "transaction" of linear momentum has no bearing on the fluid
@@ -367,37 +717,97 @@ void FluidSim::SolveBoundaryConditions() {
                 // move, so absorb momentum indefinitely, but again, the fluid never loses
                 // that linear momentum (directly anyway), so no harm there.
                 {
-                    const ofVec3f  vVelChange          = rVorton.mVelocity - vVelBodyAtConPt ; // (negative of) total linear velocity change applied to vorton
+                    const Vec3     vVelChange          = rVorton.mVelocity - vVelBodyAtConPt ; // (negative of) total linear velocity change applied to vorton
 #if FLOW_AFFECTS_BODY
-                    rSphere.ApplyImpulse( vVelChange * rMassPerParticle ) ;                 // Apply linear impulse to body
+                    rImpulse.mLinear += vVelChange * rMassPerParticle ;                     // Accumulate linear impulse to apply to body
+                    ++ rImpulse.mNumContacts ;
 #endif
                     rVorton.mVelocity = vVelBodyAtConPt ;  // If same vorton is involved in another contact before advection, this will conserve linear momentum within this phase.
                 }
             }
         }
-        
-        // Collide tracers with rigid body.
-        for( size_t uTracer = 0 ; uTracer < numTracers ; ++ uTracer )
-        {   // For each tracer in the simulation...
-            Particle & rTracer = mVortonSim.GetTracers()[ uTracer ] ;
-            const ofVec3f  vSphereToTracer = rTracer.mPosition - rSphere.mPosition ;   // vector from body center to tracer
-            const float fSphereToTracer = vSphereToTracer.length() ;
-            if( fSphereToTracer < ( rTracer.mSize + rSphere.mRadius ) )
+    }
+}
+
+/*! \brief Collide tracers with a rigid body, for a subset of chunks of candidates
+
+    \param rBody - body to collide with tracers.  This routine does not modify it.
+
+    \param iChunkBegin - index of first chunk of mCandidates to process
+
+    \param iChunkEnd - index one past last chunk of mCandidates to process
+
+    \see SolveBoundaryConditions, ApplyChunkImpulses
+*/
+void FluidSim::CollideTracersSlice( const RigidBody & rBody , size_t iChunkBegin , size_t iChunkEnd )
+{
+    auto & tracers = mVortonSim.GetTracers();
+#if FLOW_AFFECTS_BODY
+    const float &  rMassPerParticle = mVortonSim.GetMassPerParticle() ;
+#endif
+
+    for( size_t iChunk = iChunkBegin ; iChunk < iChunkEnd ; ++ iChunk )
+    {   // For each chunk of candidates in this slice...
+        BodyImpulse &   rImpulse        = mChunkImpulses[ iChunk ] ;
+        rImpulse.mLinear = rImpulse.mAngular = Vec3( 0.0f , 0.0f , 0.0f ) ;
+        rImpulse.mNumContacts = 0 ;
+        const size_t    iCandidateEnd   = std::min( ( iChunk + 1 ) * sContactChunkSize , mCandidates.size() ) ;
+        for( size_t iCandidate = iChunk * sContactChunkSize ; iCandidate < iCandidateEnd ; ++ iCandidate )
+        {   // For each tracer near this body...
+            Particle & rTracer = tracers[ mCandidates[ iCandidate ] ] ;
+            float   fBodySurfToTracer ; // Signed distance from body surface to tracer center
+            Vec3 vSurfNormal ;       // Outward surface normal nearest tracer
+            if( rBody.QuerySurface( fBodySurfToTracer , vSurfNormal , rTracer.mPosition ) && ( fBodySurfToTracer < rTracer.mSize ) )
             {   // Tracer is colliding with body.
                 // Project tracer to outside of body.
                 // This places the particle on the body surface.
-                const float distRescale         = ( rSphere.mRadius + rTracer.mSize ) * ( 1.0f + FLT_EPSILON ) / fSphereToTracer ;
-                const ofVec3f  vDisplacementNew    = vSphereToTracer * distRescale ;
-                rTracer.mPosition = rSphere.mPosition + vDisplacementNew ;
+                const Vec3     vContactPtRelBody   = rTracer.mPosition - vSurfNormal * fBodySurfToTracer - rBody.mPosition ;
+                const Vec3     vDisplacementNew    = vContactPtRelBody + vSurfNormal * ( rTracer.mSize * ( 1.0f + FLT_EPSILON ) ) ;
+                rTracer.mPosition = rBody.mPosition + vDisplacementNew ;
                 // Transfer linear momentum between vorton and body.
-                const ofVec3f  vVelDueToRotation   = rSphere.mAngVelocity ^ vDisplacementNew ; // linear velocity, at vorton new position, due to body rotation
-                const ofVec3f  vVelNew             = rSphere.mVelocity + vVelDueToRotation ;   // Total linear velocity of vorton at its new position, due to sticking to body
-                const ofVec3f  vVelChange          = rTracer.mVelocity - vVelNew ;             // (negative of) total linear velocity change applied to vorton
+                const Vec3     vVelDueToRotation   = rBody.mAngVelocity ^ vDisplacementNew ;   // linear velocity, at vorton new position, due to body rotation
+                const Vec3     vVelNew             = rBody.mVelocity + vVelDueToRotation ;     // Total linear velocity of vorton at its new position, due to sticking to body
+                const Vec3     vVelChange          = rTracer.mVelocity - vVelNew ;             // (negative of) total linear velocity change applied to vorton
 #if FLOW_AFFECTS_BODY
-                rSphere.ApplyImpulse( vVelChange * rMassPerParticle ) ;                     // Apply linear impulse to body
+                rImpulse.mLinear += vVelChange * rMassPerParticle ;                         // Accumulate linear impulse to apply to body
+                ++ rImpulse.mNumContacts ;
 #endif
                 rTracer.mVelocity = vVelNew ;   // If same tracer is involved in another contact before advection, this will conserve momentum.
             }
         }
     }
 }
+
+/*! \brief Apply impulses accumulated by chunks of candidates to a body, in chunk order
+
+    Particles computed their impulses against the body velocity from before
+    any of them touched it.  Applied naively, their sum would overshoot:
+    A serial loop would let the body speed up as each particle pushed it,
+    so later particles would push less.  The state that loop tends toward
+    has every contacting particle moving with the body, which is an
+    inelastic collision between the body and n particles each of mass m:
+        M dV = Sum m ( v_i - V0 - dV ) = J - n m dV
+    so dV = J / ( M + n m ), i.e. the summed impulse J scaled by
+    1 / ( 1 + n m / M ).  Apply the linear impulse scaled that way.
+
+    \see CollideVortonsSlice, CollideTracersSlice
+*/
+void FluidSim::ApplyChunkImpulses( RigidBody & rBody , size_t numChunks )
+{
+#if FLOW_AFFECTS_BODY
+    Vec3 vImpulse( 0.0f , 0.0f , 0.0f ) ;
+    Vec3 vImpulsiveTorque( 0.0f , 0.0f , 0.0f ) ;
+    size_t  numContacts = 0 ;
+    for( size_t iChunk = 0 ; iChunk < numChunks ; ++ iChunk )
+    {   // For each chunk, in order...
+        vImpulse            += mChunkImpulses[ iChunk ].mLinear ;
+        vImpulsiveTorque    += mChunkImpulses[ iChunk ].mAngular ;
+        numContacts         += mChunkImpulses[ iChunk ].mNumContacts ;
+    }
+    const float massRatio = float( numContacts ) * mVortonSim.GetMassPerParticle() * rBody.GetInverseMass() ;
+    rBody.ApplyImpulsiveTorque( vImpulsiveTorque ) ;                // Apply angular impulse (impulsive torque) to body
+    rBody.ApplyImpulse( vImpulse / ( 1.0f + massRatio ) ) ;         // Apply linear impulse to body
+#else
+    (void) rBody ; (void) numChunks ;
+#endif
+}
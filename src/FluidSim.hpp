@@ -3,6 +3,9 @@
 #include <vector>
 #include "VortonSim.hpp"
 #include "RbSphere.hpp"
+#include "RbSdf.hpp"
+#include "CellList.hpp"
+#include "AabbTree.hpp"
 
 class FluidSim
 {
@@ -17,11 +20,48 @@ public:
 	VortonSim &             GetVortonSim() { return mVortonSim; }
 	void                    Clear() { mVortonSim.Clear(); }
     std::vector<RbSphere> & GetSpheres() { return mSpheres; }
+    std::vector<RbSdf> &    GetSdfBodies() { return mSdfBodies; }
+
+    /// Return total number of rigid bodies, of all shapes
+    size_t                  GetNumBodies() const { return mSpheres.size() + mSdfBodies.size(); }
+
+    /// Return rigid body by index: spheres first, then signed-distance-field bodies
+    RigidBody &             GetBody(size_t uBody) { return ( uBody < mSpheres.size() ) ? static_cast<RigidBody &>( mSpheres[ uBody ] ) : mSdfBodies[ uBody - mSpheres.size() ]; }
+    const RigidBody &       GetBody(size_t uBody) const { return ( uBody < mSpheres.size() ) ? static_cast<const RigidBody &>( mSpheres[ uBody ] ) : mSdfBodies[ uBody - mSpheres.size() ]; }
 
 private:
 	void RemoveEmbeddedParticles();
 	void SolveBoundaryConditions();
+	void CollideVortonsSlice( const RigidBody & rBody , size_t iChunkBegin , size_t iChunkEnd );
+	void CollideTracersSlice( const RigidBody & rBody , size_t iChunkBegin , size_t iChunkEnd );
+	void ApplyChunkImpulses( RigidBody & rBody , size_t numChunks );
+	void UpdateBodyTree();
+	void CollideBodies();
+	void FindBodyContactsSlice( size_t iBodyBegin , size_t iBodyEnd );
+
+    /// Linear and angular impulse that a chunk of particles imparts to a body
+    struct BodyImpulse
+    {
+        Vec3 mLinear;    ///< Linear impulse
+        Vec3 mAngular;   ///< Angular impulse (impulsive torque)
+        size_t  mNumContacts; ///< Number of particles that contributed linear impulse
+    };
 
 	VortonSim               mVortonSim;
     std::vector<RbSphere>   mSpheres;
+    std::vector<RbSdf>      mSdfBodies;     ///< Rigid bodies whose shapes are signed distance fields
+    CellList                mVortonCells;   ///< Broad phase for fluid-body interaction: vortons partitioned by cell
+    CellList                mTracerCells;   ///< Broad phase for fluid-body interaction: tracers partitioned by cell
+    std::vector<uint32_t>   mCandidates;    ///< Indices of particles near the body being processed
+    std::vector<BodyImpulse> mChunkImpulses; ///< Impulse imparted to the body being processed, per chunk of mCandidates
+    AabbTree                mBodyTree;      ///< Bounding volume hierarchy over bodies
+    std::vector<int>        mBodyProxies;   ///< Proxy in mBodyTree of each body
+    std::vector< std::vector<uint32_t> > mBodyContacts; ///< For each sphere, higher-indexed spheres touching it
+
+    friend class Checkpoint;
+#if USE_TBB
+    friend class FluidSim_CollideVortons_TBB;
+    friend class FluidSim_CollideTracers_TBB;
+    friend class FluidSim_FindBodyContacts_TBB;
+#endif
 };
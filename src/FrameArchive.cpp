@@ -0,0 +1,526 @@
+#include "FrameArchive.hpp"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include "TracerStream.hpp"
+#include "VortonSim.hpp"
+
+namespace {
+
+const char sArchiveMagic[ 8 ] = { 'V' , 'O' , 'R' , 'T' , 'A' , 'R' , 'C' , 'H' } ;
+const uint32_t sArchiveVersion = 1 ;
+
+/// Leading part of an archive file
+struct Header
+{
+    char        mMagic[ 8 ] ;   ///< Identifies file as a frame archive
+    uint32_t    mVersion    ;   ///< sArchiveVersion of the writer
+    uint32_t    mPad        ;   ///< Zero; keeps frame contents 16-byte aligned
+} ;
+
+/// Final part of an archive file, which says where the index lies
+struct Trailer
+{
+    uint64_t    mFrameTableOffset   ;   ///< Offset, in bytes from start of file, of ArchiveFrame table
+    uint64_t    mNumFrames          ;   ///< Number of frames
+    uint64_t    mChunkTableOffset   ;   ///< Offset of ArchiveChunk table
+    uint64_t    mNumChunks          ;   ///< Number of chunks, over all frames
+    uint32_t    mVersion            ;   ///< sArchiveVersion of the writer
+    uint32_t    mFrameSize          ;   ///< sizeof( ArchiveFrame ) of the writer
+    uint32_t    mChunkSize          ;   ///< sizeof( ArchiveChunk ) of the writer
+    uint32_t    mVortonRecordSize   ;   ///< sizeof( VortonRecord ) of the writer
+    char        mMagic[ 8 ]         ;   ///< Identifies file as a complete frame archive
+} ;
+
+/// Contents of a vorton chunk, per vorton
+struct VortonRecord
+{
+    float   mPosition[ 3 ]  ;
+    float   mVorticity[ 3 ] ;
+    float   mRadius         ;
+} ;
+
+/// Size, in bytes, of contents of a tracer chunk, per tracer: 16-bit quantized position.
+const size_t sTracerRecordSize = 3 * sizeof( uint16_t ) ;
+
+/// Round offset up to a multiple of 16 bytes, so chunks in a mapped file are aligned.
+uint64_t AlignUp( uint64_t offset )
+{
+    return ( offset + 15 ) & ~ uint64_t( 15 ) ;
+}
+
+void ExpandBox( Vec3 & vMin , Vec3 & vMax , const Vec3 & vBoxMin , const Vec3 & vBoxMax )
+{
+    vMin = Vec3( std::min( vMin.x , vBoxMin.x ) , std::min( vMin.y , vBoxMin.y ) , std::min( vMin.z , vBoxMin.z ) ) ;
+    vMax = Vec3( std::max( vMax.x , vBoxMax.x ) , std::max( vMax.y , vBoxMax.y ) , std::max( vMax.z , vBoxMax.z ) ) ;
+}
+
+} // namespace
+
+#if USE_TBB
+/*! \brief Function object to compute per-block bounding boxes of particles using Threading Building Blocks
+ */
+class FrameArchiveWriter_ComputeBounds_TBB
+{
+    FrameArchiveWriter * mWriter ;  ///< Address of FrameArchiveWriter object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Compute bounds of subset of blocks.
+        mWriter->ComputeBoundsSlice( r.begin() , r.end() ) ;
+    }
+    FrameArchiveWriter_ComputeBounds_TBB( FrameArchiveWriter * pWriter )
+    : mWriter( pWriter ) {}
+} ;
+
+/*! \brief Function object to fill chunks using Threading Building Blocks
+ */
+class FrameArchiveWriter_EncodeChunks_TBB
+{
+    FrameArchiveWriter * mWriter ;  ///< Address of FrameArchiveWriter object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Fill subset of chunks.
+        mWriter->EncodeChunksSlice( r.begin() , r.end() ) ;
+    }
+    FrameArchiveWriter_EncodeChunks_TBB( FrameArchiveWriter * pWriter )
+    : mWriter( pWriter ) {}
+} ;
+
+/*! \brief Function object to decode tracer chunks using Threading Building Blocks
+ */
+class FrameArchive_DecodeTracers_TBB
+{
+    FrameArchive * mArchive ;   ///< Address of FrameArchive object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Decode subset of chunks.
+        mArchive->DecodeTracersSlice( r.begin() , r.end() ) ;
+    }
+    FrameArchive_DecodeTracers_TBB( FrameArchive * pArchive )
+    : mArchive( pArchive ) {}
+} ;
+#endif
+
+FrameArchiveWriter::FrameArchiveWriter()
+    : mFileOffset( 0 )
+    , mNumDroppedFrames( 0 )
+    , mPositions( nullptr )
+    , mStride( 0 )
+    , mNumParticles( 0 )
+    , mVortons( nullptr )
+    , mFirstNewChunk( 0 )
+{
+}
+
+bool FrameArchiveWriter::Open( const std::string & path , size_t maxQueuedFrames )
+{
+    Close() ;
+    if( ! mWriter.Open( path , maxQueuedFrames ) ) return false ;
+
+    Header header ;
+    memset( & header , 0 , sizeof( header ) ) ;
+    memcpy( header.mMagic , sArchiveMagic , sizeof( sArchiveMagic ) ) ;
+    header.mVersion = sArchiveVersion ;
+    mWriter.Reserve( mRecord , true ) ;
+    mRecord.assign( reinterpret_cast< const char * >( & header ) , reinterpret_cast< const char * >( & header + 1 ) ) ;
+    mWriter.Push( mRecord ) ;
+
+    mFileOffset         = sizeof( Header ) ;
+    mNumDroppedFrames   = 0 ;
+    mFrames.clear() ;
+    mChunks.clear() ;
+    return true ;
+}
+
+void FrameArchiveWriter::ComputeBoundsSlice( size_t iBlockStart , size_t iBlockEnd )
+{
+    for( size_t iBlock = iBlockStart ; iBlock < iBlockEnd ; ++ iBlock )
+    {   // For each block in this slice...
+        const size_t    iBegin  = iBlock * sParticlesPerChunk ;
+        const size_t    iEnd    = std::min( iBegin + sParticlesPerChunk , mNumParticles ) ;
+        Vec3 &          vMin    = mBlockBounds[ 2 * iBlock ] ;
+        Vec3 &          vMax    = mBlockBounds[ 2 * iBlock + 1 ] ;
+        vMin = vMax = * reinterpret_cast< const Vec3 * >( mPositions + iBegin * mStride ) ;
+        for( size_t iParticle = iBegin + 1 ; iParticle < iEnd ; ++ iParticle )
+        {
+            const Vec3 & vPosition = * reinterpret_cast< const Vec3 * >( mPositions + iParticle * mStride ) ;
+            ExpandBox( vMin , vMax , vPosition , vPosition ) ;
+        }
+    }
+}
+
+void FrameArchiveWriter::EncodeChunksSlice( size_t iChunkStart , size_t iChunkEnd )
+{
+    for( size_t iChunk = iChunkStart ; iChunk < iChunkEnd ; ++ iChunk )
+    {   // For each chunk in this slice...
+        ArchiveChunk &  rChunk  = mChunks[ mFirstNewChunk + iChunk ] ;
+        const uint32_t  uCell   = mChunkCells[ iChunk ] ;
+        const size_t    begin   = mCells.GetCellBegin( uCell ) ;
+        const size_t    end     = mCells.GetCellEnd( uCell ) ;
+        char *          pOut    = mRecord.data() + ( rChunk.mOffset - mFileOffset ) ;
+
+        // Find bounding box of chunk, which is tighter than its grid cell.
+        rChunk.mMin = rChunk.mMax = * reinterpret_cast< const Vec3 * >( mPositions + mCells.GetIndex( begin ) * mStride ) ;
+        for( size_t offset = begin + 1 ; offset < end ; ++ offset )
+        {
+            const Vec3 & vPosition = * reinterpret_cast< const Vec3 * >( mPositions + mCells.GetIndex( offset ) * mStride ) ;
+            ExpandBox( rChunk.mMin , rChunk.mMax , vPosition , vPosition ) ;
+        }
+
+        if( mVortons )
+        {   // Store vortons as floats.
+            VortonRecord * pRecords = reinterpret_cast< VortonRecord * >( pOut ) ;
+            for( size_t offset = begin ; offset < end ; ++ offset )
+            {
+                const Vorton &  rVorton = mVortons[ mCells.GetIndex( offset ) ] ;
+                VortonRecord &  rRecord = * pRecords ++ ;
+                for( int axis = 0 ; axis < 3 ; ++ axis )
+                {
+                    rRecord.mPosition[ axis ]   = rVorton.mPosition[ axis ] ;
+                    rRecord.mVorticity[ axis ]  = rVorton.mVorticity[ axis ] ;
+                }
+                rRecord.mRadius = rVorton.mRadius ;
+            }
+        }
+        else
+        {   // Quantize tracer positions relative to chunk bounding box.
+            const TracerQuantizer   quantizer( rChunk.mMin , rChunk.mMax ) ;
+            uint16_t *              pLevels = reinterpret_cast< uint16_t * >( pOut ) ;
+            for( size_t offset = begin ; offset < end ; ++ offset )
+            {
+                const Vec3 & vPosition = * reinterpret_cast< const Vec3 * >( mPositions + mCells.GetIndex( offset ) * mStride ) ;
+                for( int axis = 0 ; axis < 3 ; ++ axis )
+                {
+                    * pLevels ++ = uint16_t( quantizer.Quantize( vPosition[ axis ] , axis ) ) ;
+                }
+            }
+        }
+    }
+}
+
+/*! \brief Partition particles spatially and append a chunk for each nonempty grid cell to mRecord
+
+    \param pPositions - address of position of first particle.
+
+    \param stride - distance, in bytes, between positions of consecutive particles.
+
+    \param numParticles - number of particles.
+
+    \param pVortons - address of first vorton if particles are vortons, or nullptr if they are tracers.
+
+    \return number of chunks appended.
+*/
+size_t FrameArchiveWriter::AppendChunks( const Vec3 * pPositions , size_t stride , size_t numParticles , const Vorton * pVortons )
+{
+    if( 0 == numParticles ) return 0 ;
+    mPositions      = reinterpret_cast< const char * >( pPositions ) ;
+    mStride         = stride ;
+    mNumParticles   = numParticles ;
+    mVortons        = pVortons ;
+
+    // Find bounding box of particles, to place the grid that partitions them.
+    const size_t numBlocks = ( numParticles + sParticlesPerChunk - 1 ) / sParticlesPerChunk ;
+    mBlockBounds.resize( 2 * numBlocks ) ;
+#if USE_TBB
+    {
+        const size_t grainSize = std::max( size_t( 1 ) , numBlocks / std::thread::hardware_concurrency() ) ;
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numBlocks , grainSize ) , FrameArchiveWriter_ComputeBounds_TBB( this ) ) ;
+    }
+#else
+    ComputeBoundsSlice( 0 , numBlocks ) ;
+#endif
+    Vec3 vMin( mBlockBounds[ 0 ] ) ;
+    Vec3 vMax( mBlockBounds[ 1 ] ) ;
+    for( size_t iBlock = 1 ; iBlock < numBlocks ; ++ iBlock )
+    {
+        ExpandBox( vMin , vMax , mBlockBounds[ 2 * iBlock ] , mBlockBounds[ 2 * iBlock + 1 ] ) ;
+    }
+    if( vMin == vMax )
+    {   // Grid needs a region with some extent.
+        vMax += Vec3( 1.0f , 1.0f , 1.0f ) ;
+    }
+    const UniformGridGeometry grid( std::max( size_t( 1 ) , numParticles / sParticlesPerChunk ) , vMin , vMax , false ) ;
+    mCells.Build( grid , pPositions , stride , numParticles ) ;
+
+    // Each nonempty cell becomes a chunk.  Lay out chunks, each aligned, after what mRecord already holds.
+    const size_t elementSize = pVortons ? sizeof( VortonRecord ) : sTracerRecordSize ;
+    size_t recordSize = mRecord.size() ;
+    mFirstNewChunk = mChunks.size() ;
+    mChunkCells.clear() ;
+    for( size_t uCell = 0 ; uCell < mCells.GetNumCells() ; ++ uCell )
+    {
+        const uint32_t cellSize = mCells.GetCellSize( uCell ) ;
+        if( 0 == cellSize ) continue ;
+        ArchiveChunk chunk ;
+        chunk.mOffset   = mFileOffset + recordSize ;
+        chunk.mCount    = cellSize ;
+        mChunks.push_back( chunk ) ;
+        mChunkCells.push_back( uint32_t( uCell ) ) ;
+        recordSize = size_t( AlignUp( recordSize + cellSize * elementSize ) ) ;
+    }
+    mRecord.resize( recordSize ) ;  // Zero-fills padding.
+
+    const size_t numNewChunks = mChunkCells.size() ;
+#if USE_TBB
+    {
+        const size_t grainSize = std::max( size_t( 1 ) , numNewChunks / std::thread::hardware_concurrency() ) ;
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numNewChunks , grainSize ) , FrameArchiveWriter_EncodeChunks_TBB( this ) ) ;
+    }
+#else
+    EncodeChunksSlice( 0 , numNewChunks ) ;
+#endif
+    return numNewChunks ;
+}
+
+bool FrameArchiveWriter::Append( const VortonSim & vortonSim , uint64_t uFrame )
+{
+    if( ! mWriter.IsOpen() ) return false ;
+    if( ! mWriter.Reserve( mRecord , false ) )
+    {   // Writer has fallen behind, or failed.  Drop this frame rather than wait.
+        ++ mNumDroppedFrames ;
+        return false ;
+    }
+
+    const std::vector< Vorton > &   vortons = vortonSim.GetVortons() ;
+    const std::vector< Particle > & tracers = vortonSim.GetTracers() ;
+    ArchiveFrame frame ;
+    frame.mFrame            = uFrame ;
+    frame.mFirstChunk       = mChunks.size() ;
+    frame.mNumVortons       = vortons.size() ;
+    frame.mNumTracers       = tracers.size() ;
+    frame.mNumVortonChunks  = AppendChunks( vortons.empty() ? nullptr : & vortons[ 0 ].mPosition , sizeof( Vorton ) , vortons.size() , vortons.data() ) ;
+    frame.mNumTracerChunks  = AppendChunks( tracers.empty() ? nullptr : & tracers[ 0 ].mPosition , sizeof( Particle ) , tracers.size() , nullptr ) ;
+    for( size_t iChunk = size_t( frame.mFirstChunk ) ; iChunk < mChunks.size() ; ++ iChunk )
+    {
+        if( iChunk == frame.mFirstChunk )
+        {
+            frame.mMin = mChunks[ iChunk ].mMin ;
+            frame.mMax = mChunks[ iChunk ].mMax ;
+        }
+        else
+        {
+            ExpandBox( frame.mMin , frame.mMax , mChunks[ iChunk ].mMin , mChunks[ iChunk ].mMax ) ;
+        }
+    }
+    mFrames.push_back( frame ) ;
+
+    mFileOffset += mRecord.size() ;
+    mWriter.Push( mRecord ) ;
+    return true ;
+}
+
+bool FrameArchiveWriter::Close()
+{
+    if( ! mWriter.IsOpen() ) return mWriter.Close() ;
+
+    // Append index.  Wait for room, since losing the index would lose the archive.
+    Trailer trailer ;
+    memset( & trailer , 0 , sizeof( trailer ) ) ;
+    trailer.mFrameTableOffset   = mFileOffset ;
+    trailer.mNumFrames          = mFrames.size() ;
+    trailer.mChunkTableOffset   = trailer.mFrameTableOffset + mFrames.size() * sizeof( ArchiveFrame ) ;
+    trailer.mNumChunks          = mChunks.size() ;
+    trailer.mVersion            = sArchiveVersion ;
+    trailer.mFrameSize          = uint32_t( sizeof( ArchiveFrame ) ) ;
+    trailer.mChunkSize          = uint32_t( sizeof( ArchiveChunk ) ) ;
+    trailer.mVortonRecordSize   = uint32_t( sizeof( VortonRecord ) ) ;
+    memcpy( trailer.mMagic , sArchiveMagic , sizeof( sArchiveMagic ) ) ;
+    if( mWriter.Reserve( mRecord , true ) )
+    {
+        const char * pFrames    = reinterpret_cast< const char * >( mFrames.data() ) ;
+        const char * pChunks    = reinterpret_cast< const char * >( mChunks.data() ) ;
+        const char * pTrailer   = reinterpret_cast< const char * >( & trailer ) ;
+        mRecord.insert( mRecord.end() , pFrames , pFrames + mFrames.size() * sizeof( ArchiveFrame ) ) ;
+        mRecord.insert( mRecord.end() , pChunks , pChunks + mChunks.size() * sizeof( ArchiveChunk ) ) ;
+        mRecord.insert( mRecord.end() , pTrailer , pTrailer + sizeof( trailer ) ) ;
+        mWriter.Push( mRecord ) ;
+    }
+    mFrames.clear() ;
+    mChunks.clear() ;
+    return mWriter.Close() ;
+}
+
+FrameArchive::FrameArchive()
+    : mFrames( nullptr )
+    , mNumFrames( 0 )
+    , mChunks( nullptr )
+    , mOutput( nullptr )
+{
+}
+
+bool FrameArchive::Open( const std::string & path )
+{
+    Close() ;
+    // Players seek, so do not ask the system to read ahead sequentially.
+    std::unique_ptr< MappedFile > pFile( new MappedFile( path , false ) ) ;
+    const char *    pData   = pFile->GetData() ;
+    const size_t    size    = pFile->GetSize() ;
+    if( ( nullptr == pData ) || ( size < sizeof( Header ) + sizeof( Trailer ) ) ) return false ;
+
+    Header header ;
+    Trailer trailer ;
+    memcpy( & header , pData , sizeof( header ) ) ;
+    memcpy( & trailer , pData + size - sizeof( trailer ) , sizeof( trailer ) ) ;
+    if(     ( 0 != memcmp( header.mMagic , sArchiveMagic , sizeof( sArchiveMagic ) ) )
+        ||  ( header.mVersion != sArchiveVersion )
+        ||  ( 0 != memcmp( trailer.mMagic , sArchiveMagic , sizeof( sArchiveMagic ) ) )
+        ||  ( trailer.mVersion != sArchiveVersion )
+        ||  ( trailer.mFrameSize != sizeof( ArchiveFrame ) )
+        ||  ( trailer.mChunkSize != sizeof( ArchiveChunk ) )
+        ||  ( trailer.mVortonRecordSize != sizeof( VortonRecord ) ) )
+    {   // File is not an archive, was never closed, or was written by a build with a different layout.
+        return false ;
+    }
+    // Validate index, so a corrupt one cannot cause reads beyond the file.
+    const uint64_t tableEnd = size - sizeof( Trailer ) ;
+    if(     ( trailer.mFrameTableOffset < sizeof( Header ) )
+        ||  ( trailer.mFrameTableOffset != AlignUp( trailer.mFrameTableOffset ) )
+        ||  ( trailer.mNumFrames > ( tableEnd - trailer.mFrameTableOffset ) / sizeof( ArchiveFrame ) )
+        ||  ( trailer.mChunkTableOffset != trailer.mFrameTableOffset + trailer.mNumFrames * sizeof( ArchiveFrame ) )
+        ||  ( trailer.mNumChunks > ( tableEnd - trailer.mChunkTableOffset ) / sizeof( ArchiveChunk ) )
+        ||  ( tableEnd != trailer.mChunkTableOffset + trailer.mNumChunks * sizeof( ArchiveChunk ) ) )
+    {
+        return false ;
+    }
+    const ArchiveFrame * pFrames = reinterpret_cast< const ArchiveFrame * >( pData + trailer.mFrameTableOffset ) ;
+    const ArchiveChunk * pChunks = reinterpret_cast< const ArchiveChunk * >( pData + trailer.mChunkTableOffset ) ;
+    for( size_t iFrame = 0 ; iFrame < trailer.mNumFrames ; ++ iFrame )
+    {
+        const ArchiveFrame & rFrame = pFrames[ iFrame ] ;
+        if(     ( rFrame.mFirstChunk > trailer.mNumChunks )
+            ||  ( rFrame.mNumVortonChunks > trailer.mNumChunks - rFrame.mFirstChunk )
+            ||  ( rFrame.mNumTracerChunks > trailer.mNumChunks - rFrame.mFirstChunk - rFrame.mNumVortonChunks ) )
+        {
+            return false ;
+        }
+        uint64_t numParticles[ 2 ] = { 0 , 0 } ;
+        const uint64_t elementSize[ 2 ] = { sizeof( VortonRecord ) , sTracerRecordSize } ;
+        const uint64_t numChunks = rFrame.mNumVortonChunks + rFrame.mNumTracerChunks ;
+        for( uint64_t iChunk = 0 ; iChunk < numChunks ; ++ iChunk )
+        {
+            const ArchiveChunk &    rChunk  = pChunks[ rFrame.mFirstChunk + iChunk ] ;
+            const size_t            kind    = ( iChunk < rFrame.mNumVortonChunks ) ? 0 : 1 ;
+            if(     ( rChunk.mOffset < sizeof( Header ) )
+                ||  ( rChunk.mOffset > trailer.mFrameTableOffset )
+                ||  ( rChunk.mOffset != AlignUp( rChunk.mOffset ) )
+                ||  ( rChunk.mCount > ( trailer.mFrameTableOffset - rChunk.mOffset ) / elementSize[ kind ] ) )
+            {
+                return false ;
+            }
+            numParticles[ kind ] += rChunk.mCount ;
+        }
+        if( ( numParticles[ 0 ] != rFrame.mNumVortons ) || ( numParticles[ 1 ] != rFrame.mNumTracers ) ) return false ;
+    }
+
+    mFile       = std::move( pFile ) ;
+    mFrames     = pFrames ;
+    mNumFrames  = size_t( trailer.mNumFrames ) ;
+    mChunks     = pChunks ;
+    return true ;
+}
+
+void FrameArchive::Close()
+{
+    mFile.reset() ;
+    mFrames     = nullptr ;
+    mNumFrames  = 0 ;
+    mChunks     = nullptr ;
+}
+
+size_t FrameArchive::FindFrame( uint64_t uFrame ) const
+{
+    // Frames go in the order they were appended, which is increasing for a single run.
+    const ArchiveFrame * pAfter = std::upper_bound( mFrames , mFrames + mNumFrames , uFrame
+        , []( uint64_t frame , const ArchiveFrame & rFrame ) { return frame < rFrame.mFrame ; } ) ;
+    return ( pAfter == mFrames ) ? 0 : size_t( pAfter - mFrames ) - 1 ;
+}
+
+void FrameArchive::DecodeTracersSlice( size_t iChunkStart , size_t iChunkEnd )
+{
+    for( size_t iChunk = iChunkStart ; iChunk < iChunkEnd ; ++ iChunk )
+    {   // For each chunk in this slice...
+        const ArchiveChunk &    rChunk      = * mSelectedChunks[ iChunk ] ;
+        const TracerQuantizer   quantizer( rChunk.mMin , rChunk.mMax ) ;
+        const uint16_t *        pLevels     = reinterpret_cast< const uint16_t * >( mFile->GetData() + rChunk.mOffset ) ;
+        Vec3 *                  pPositions  = mOutput + mSelectedStarts[ iChunk ] ;
+        for( size_t iTracer = 0 ; iTracer < rChunk.mCount ; ++ iTracer )
+        {
+            pPositions[ iTracer ] = Vec3( quantizer.Dequantize( pLevels[ 0 ] , 0 )
+                                        , quantizer.Dequantize( pLevels[ 1 ] , 1 )
+                                        , quantizer.Dequantize( pLevels[ 2 ] , 2 ) ) ;
+            pLevels += 3 ;
+        }
+    }
+}
+
+/// Decode tracer chunks listed in mSelectedChunks into positions.
+void FrameArchive::DecodeTracers( std::vector< Vec3 > & positions )
+{
+    const size_t numChunks = mSelectedChunks.size() ;
+    mSelectedStarts.resize( numChunks ) ;
+    size_t numTracers = 0 ;
+    for( size_t iChunk = 0 ; iChunk < numChunks ; ++ iChunk )
+    {
+        mSelectedStarts[ iChunk ] = numTracers ;
+        numTracers += size_t( mSelectedChunks[ iChunk ]->mCount ) ;
+    }
+    positions.resize( numTracers ) ;
+    mOutput = positions.data() ;
+#if USE_TBB
+    const size_t grainSize = std::max( size_t( 1 ) , numChunks / std::thread::hardware_concurrency() ) ;
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numChunks , grainSize ) , FrameArchive_DecodeTracers_TBB( this ) ) ;
+#else
+    DecodeTracersSlice( 0 , numChunks ) ;
+#endif
+    mOutput = nullptr ;
+}
+
+void FrameArchive::ReadTracers( std::vector< Vec3 > & positions , size_t iFrame )
+{
+    const ArchiveFrame & rFrame  = mFrames[ iFrame ] ;
+    const ArchiveChunk * pChunks = GetChunks( iFrame ) + rFrame.mNumVortonChunks ;
+    mSelectedChunks.clear() ;
+    for( size_t iChunk = 0 ; iChunk < rFrame.mNumTracerChunks ; ++ iChunk )
+    {
+        mSelectedChunks.push_back( pChunks + iChunk ) ;
+    }
+    DecodeTracers( positions ) ;
+}
+
+void FrameArchive::ReadTracers( std::vector< Vec3 > & positions , size_t iFrame , const Vec3 & vMin , const Vec3 & vMax )
+{
+    const ArchiveFrame & rFrame  = mFrames[ iFrame ] ;
+    const ArchiveChunk * pChunks = GetChunks( iFrame ) + rFrame.mNumVortonChunks ;
+    mSelectedChunks.clear() ;
+    for( size_t iChunk = 0 ; iChunk < rFrame.mNumTracerChunks ; ++ iChunk )
+    {
+        const ArchiveChunk & rChunk = pChunks[ iChunk ] ;
+        if(     ( rChunk.mMin.x <= vMax.x ) && ( rChunk.mMax.x >= vMin.x )
+            &&  ( rChunk.mMin.y <= vMax.y ) && ( rChunk.mMax.y >= vMin.y )
+            &&  ( rChunk.mMin.z <= vMax.z ) && ( rChunk.mMax.z >= vMin.z ) )
+        {   // Chunk overlaps region.
+            mSelectedChunks.push_back( & rChunk ) ;
+        }
+    }
+    DecodeTracers( positions ) ;
+}
+
+void FrameArchive::ReadVortons( std::vector< Vorton > & vortons , size_t iFrame ) const
+{
+    const ArchiveFrame & rFrame  = mFrames[ iFrame ] ;
+    const ArchiveChunk * pChunks = GetChunks( iFrame ) ;
+    vortons.clear() ;
+    vortons.reserve( size_t( rFrame.mNumVortons ) ) ;
+    for( size_t iChunk = 0 ; iChunk < rFrame.mNumVortonChunks ; ++ iChunk )
+    {
+        const ArchiveChunk & rChunk   = pChunks[ iChunk ] ;
+        const VortonRecord * pRecords = reinterpret_cast< const VortonRecord * >( mFile->GetData() + rChunk.mOffset ) ;
+        for( size_t iVorton = 0 ; iVorton < rChunk.mCount ; ++ iVorton )
+        {
+            const VortonRecord & rRecord = pRecords[ iVorton ] ;
+            vortons.push_back( Vorton( Vec3( rRecord.mPosition[ 0 ] , rRecord.mPosition[ 1 ] , rRecord.mPosition[ 2 ] )
+                                     , Vec3( rRecord.mVorticity[ 0 ] , rRecord.mVorticity[ 1 ] , rRecord.mVorticity[ 2 ] )
+                                     , rRecord.mRadius ) ) ;
+        }
+    }
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "CellList.hpp"
+#include "MappedFile.hpp"
+#include "RecordWriter.hpp"
+#include "Vorton.hpp"
+#include "TBB_Settings.hpp"
+
+class VortonSim ;
+
+/*! \brief Index entry for one spatial chunk of one frame in a FrameArchive
+ */
+struct ArchiveChunk
+{
+    uint64_t    mOffset ;   ///< Offset, in bytes from start of file, of chunk contents
+    uint64_t    mCount  ;   ///< Number of particles in chunk
+    Vec3        mMin    ;   ///< Minimal corner of bounding box of particle positions
+    Vec3        mMax    ;   ///< Maximal corner of bounding box of particle positions
+} ;
+
+/*! \brief Index entry for one frame in a FrameArchive
+ */
+struct ArchiveFrame
+{
+    uint64_t    mFrame              ;   ///< Frame counter passed to FluidSim::Update
+    uint64_t    mFirstChunk         ;   ///< Index of first chunk of this frame; vorton chunks come first, then tracer chunks
+    uint64_t    mNumVortonChunks    ;   ///< Number of chunks holding vortons
+    uint64_t    mNumTracerChunks    ;   ///< Number of chunks holding tracers
+    uint64_t    mNumVortons         ;   ///< Number of vortons
+    uint64_t    mNumTracers         ;   ///< Number of tracers
+    Vec3        mMin                ;   ///< Minimal corner of bounding box of all chunks
+    Vec3        mMax                ;   ///< Maximal corner of bounding box of all chunks
+} ;
+
+/*! \brief Write vorton and tracer frames into a seekable archive, on a background thread
+
+ Each frame gets partitioned spatially, by a uniform grid over its
+ bounding box, into chunks of roughly sParticlesPerChunk particles.
+ Each tracer chunk stores positions quantized to 16 bits per component
+ relative to the bounding box of that chunk, so precision improves as
+ chunks shrink.  Vorton chunks store position, vorticity and radius
+ as floats.  Unlike a tracer stream, no frame depends on another,
+ so a reader can start anywhere.
+
+ An index of frames and chunks, with their bounding boxes, goes at the
+ end of the file when Close runs.  A file that was never closed has no
+ index and cannot be read.
+
+ File layout, all in native byte order:
+
+    Header
+    for each frame, for each chunk: contents, padded to 16 bytes
+    ArchiveFrame [ numFrames ]
+    ArchiveChunk [ numChunks ]
+    Trailer
+
+ Within a frame, particles are ordered by chunk, so the index of a
+ tracer does not identify it across frames.
+
+ */
+class FrameArchiveWriter
+{
+public:
+    static const size_t sParticlesPerChunk = 16384 ;   ///< Target number of particles per chunk
+
+    FrameArchiveWriter() ;
+    ~FrameArchiveWriter() { Close() ; }
+    FrameArchiveWriter( const FrameArchiveWriter & ) = delete ;
+    FrameArchiveWriter & operator=( const FrameArchiveWriter & ) = delete ;
+
+    /*! \brief Create an archive file and start its writer thread
+
+        \param path - file to create.  Any existing file gets replaced.
+
+        \param maxQueuedFrames - number of frames that can wait to be written.
+
+        \return true if the file was created.
+    */
+    bool Open( const std::string & path , size_t maxQueuedFrames = 4 ) ;
+
+    /*! \brief Partition vortons and tracers into chunks and queue them to be written
+
+        \return true if the frame was queued, false if it was discarded
+                because the queue was full, a write failed, or no archive is open.
+    */
+    bool Append( const VortonSim & vortonSim , uint64_t uFrame ) ;
+
+    /*! \brief Write queued frames and the index, then close the file
+
+        \return true if the whole archive was written.
+    */
+    bool Close() ;
+
+    bool    IsOpen() const                  { return mWriter.IsOpen() ; }
+    size_t  GetNumDroppedFrames() const     { return mNumDroppedFrames ; }
+
+private:
+    #if USE_TBB
+        friend class FrameArchiveWriter_ComputeBounds_TBB ;
+        friend class FrameArchiveWriter_EncodeChunks_TBB ;
+    #endif
+
+    size_t AppendChunks( const Vec3 * pPositions , size_t stride , size_t numParticles , const Vorton * pVortons ) ;
+    void ComputeBoundsSlice( size_t iBlockStart , size_t iBlockEnd ) ;
+    void EncodeChunksSlice( size_t iChunkStart , size_t iChunkEnd ) ;
+
+    RecordWriter                mWriter             ;   ///< Writes frames on a background thread
+    std::vector< char >         mRecord             ;   ///< Contents of frame being built
+    uint64_t                    mFileOffset         ;   ///< Offset in file where mRecord will go
+    std::vector< ArchiveFrame > mFrames             ;   ///< Index of frames written so far
+    std::vector< ArchiveChunk > mChunks             ;   ///< Index of chunks written so far
+    size_t                      mNumDroppedFrames   ;   ///< Frames discarded because the queue was full
+    CellList                    mCells              ;   ///< Spatial partition of particles being chunked
+    std::vector< uint32_t >     mChunkCells         ;   ///< Cell of each chunk being built
+    std::vector< Vec3 >         mBlockBounds        ;   ///< Per-block minimum and maximum of positions
+    const char *                mPositions          ;   ///< Address of position of first particle being chunked
+    size_t                      mStride             ;   ///< Distance, in bytes, between consecutive positions
+    size_t                      mNumParticles       ;   ///< Number of particles being chunked
+    const Vorton *              mVortons            ;   ///< Vortons being chunked, or nullptr when chunking tracers
+    size_t                      mFirstNewChunk      ;   ///< Index in mChunks of first chunk being built
+} ;
+
+/*! \brief Read frames from an archive made by FrameArchiveWriter
+
+ Open maps the file and validates its index, without reading frame
+ contents.  Reading a frame touches only the pages of its chunks, so
+ seeking is as cheap as reading the frame.  Reading a region of a frame
+ touches only chunks whose bounding boxes overlap it.
+
+ */
+class FrameArchive
+{
+public:
+    FrameArchive() ;
+
+    /*! \brief Map an archive file and validate its index
+
+        \return true if the file is a complete archive made by a build with the same layout.
+    */
+    bool Open( const std::string & path ) ;
+
+    void Close() ;
+
+    bool                    IsOpen() const                      { return nullptr != mFile ; }
+    size_t                  GetNumFrames() const                { return mNumFrames ; }
+    const ArchiveFrame &    GetFrame( size_t iFrame ) const     { return mFrames[ iFrame ] ; }
+
+    /// Return chunks of the given frame: GetFrame( iFrame ).mNumVortonChunks vorton chunks, then tracer chunks.
+    const ArchiveChunk *    GetChunks( size_t iFrame ) const    { return mChunks + mFrames[ iFrame ].mFirstChunk ; }
+
+    /// Return index of last frame whose frame counter does not exceed uFrame, or 0 if there is none.
+    size_t FindFrame( uint64_t uFrame ) const ;
+
+    /// Decode positions of all tracers in a frame.
+    void ReadTracers( std::vector< Vec3 > & positions , size_t iFrame ) ;
+
+    /*! \brief Decode positions of tracers in chunks that overlap a region
+
+        \note This can return tracers outside the region, from chunks that straddle it.
+    */
+    void ReadTracers( std::vector< Vec3 > & positions , size_t iFrame , const Vec3 & vMin , const Vec3 & vMax ) ;
+
+    /// Decode all vortons in a frame.  Vorton velocities are not stored, so come back zero.
+    void ReadVortons( std::vector< Vorton > & vortons , size_t iFrame ) const ;
+
+private:
+    #if USE_TBB
+        friend class FrameArchive_DecodeTracers_TBB ;
+    #endif
+
+    void DecodeTracers( std::vector< Vec3 > & positions ) ;
+    void DecodeTracersSlice( size_t iChunkStart , size_t iChunkEnd ) ;
+
+    std::unique_ptr< MappedFile >           mFile               ;   ///< Archive contents
+    const ArchiveFrame *                    mFrames             ;   ///< Frame index, within mFile
+    size_t                                  mNumFrames          ;   ///< Number of frames in archive
+    const ArchiveChunk *                    mChunks             ;   ///< Chunk index, within mFile
+    std::vector< const ArchiveChunk * >     mSelectedChunks     ;   ///< Tracer chunks being decoded
+    std::vector< size_t >                   mSelectedStarts     ;   ///< Offset in output of first tracer of each selected chunk
+    Vec3 *                                  mOutput             ;   ///< Positions being decoded
+} ;
@@ -0,0 +1,539 @@
+#include "LineIntegralConvolution.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include "Rand.hpp"
+
+#if USE_TBB
+
+/*! \brief Function object to render tiles of a LIC image using Threading Building Blocks
+ */
+class LineIntegralConvolution_RenderTiles_TBB
+{
+    LineIntegralConvolution * mLic ;    ///< Address of LineIntegralConvolution object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Render subset of tiles.
+        mLic->RenderTilesSlice( r.begin() , r.end() ) ;
+    }
+    LineIntegralConvolution_RenderTiles_TBB( LineIntegralConvolution * pLic )
+    : mLic( pLic ) {}
+} ;
+
+/*! \brief Function object to sample in-plane velocity at rows of pixels using Threading Building Blocks
+ */
+class LineIntegralConvolution_SampleFlow_TBB
+{
+    LineIntegralConvolution * mLic ;    ///< Address of LineIntegralConvolution object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Sample subset of rows.
+        mLic->SampleFlowSlice( r.begin() , r.end() ) ;
+    }
+    LineIntegralConvolution_SampleFlow_TBB( LineIntegralConvolution * pLic )
+    : mLic( pLic ) {}
+} ;
+
+/*! \brief Function object to advect rows of an animated LIC texture using Threading Building Blocks
+ */
+class LineIntegralConvolution_AdvectTexture_TBB
+{
+    LineIntegralConvolution * mLic ;    ///< Address of LineIntegralConvolution object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Advect subset of rows.
+        mLic->AdvectTextureSlice( r.begin() , r.end() ) ;
+    }
+    LineIntegralConvolution_AdvectTexture_TBB( LineIntegralConvolution * pLic )
+    : mLic( pLic ) {}
+} ;
+#endif
+
+/* static */ LicPlane LicPlane::FromGrid( const UniformGridGeometry & grid , int normalAxis , float fraction )
+{
+    const int   axisU   = ( normalAxis + 1 ) % 3 ;
+    const int   axisV   = ( normalAxis + 2 ) % 3 ;
+    // Stay within the part of the grid Interpolate can sample.
+    const float extent  = grid.GetExtent()[ normalAxis ] * ( 1.0f - FLT_EPSILON ) ;
+    LicPlane    plane ;
+    plane.mOrigin                   = grid.GetMinCorner() ;
+    plane.mOrigin[ normalAxis ]    += extent * std::min( std::max( fraction , 0.0f ) , 1.0f - FLT_EPSILON ) ;
+    plane.mAxisU[ axisU ]           = grid.GetExtent()[ axisU ] ;
+    plane.mAxisV[ axisV ]           = grid.GetExtent()[ axisV ] ;
+    return plane ;
+}
+
+LineIntegralConvolution::LineIntegralConvolution( uint32_t noiseSeed )
+    : mNoiseSeed( noiseSeed )
+    , mKernelLength( 10.0f )
+    , mStepSize( 0.5f )
+    , mMethod( METHOD_FAST_LIC )
+    , mLineExtension( 40.0f )
+    , mMinHits( 2 )
+    , mMaxHits( 8 )
+    , mTileSize( sTileSize )
+    , mWidth( 0 )
+    , mHeight( 0 )
+    , mNumTilesX( 0 )
+    , mInput( nullptr )
+    , mNoiseBlend( 0.1f )
+    , mTimeStep( 0.0f )
+    , mFrame( 0 )
+    , mVelGrid( nullptr )
+{
+}
+
+void LineIntegralConvolution::SetHitRange( unsigned minHits , unsigned maxHits )
+{
+    mMinHits = std::min( std::max( 1u , minHits ) , unsigned( UINT16_MAX - 1 ) ) ;
+    mMaxHits = std::min( std::max( mMinHits , maxHits ) , unsigned( UINT16_MAX - 1 ) ) ;   // Seed pixel can take one more.
+}
+
+/*! \brief Set up image, noise and plane mapping for rendering
+ */
+void LineIntegralConvolution::PrepareImage( const UniformGrid< Vec3 > & velGrid , const LicPlane & plane , size_t width , size_t height )
+{
+    if( ( width != mWidth ) || ( height != mHeight ) )
+    {   // Resolution changed so make new noise.
+        mWidth  = width ;
+        mHeight = height ;
+        mNoise.resize( width * height ) ;
+        Rand rng( mNoiseSeed ) ;
+        for( float & rNoise : mNoise )
+        {
+            rNoise = rng.nextFloat() ;
+        }
+    }
+    mImage.assign( width * height , 0.0f ) ;
+    if( METHOD_FAST_LIC == mMethod )
+    {
+        mSums.assign( width * height , 0.0f ) ;
+        mHits.assign( width * height , 0 ) ;
+        mTileSize = sFastTileSize ;
+    }
+    else
+    {
+        mTileSize = sTileSize ;
+    }
+    mNumTilesX  = ( width + mTileSize - 1 ) / mTileSize ;
+    mVelGrid    = & velGrid ;
+    mPlane      = plane ;
+    mPixelU     = plane.mAxisU / float( width ) ;
+    mPixelV     = plane.mAxisV / float( height ) ;
+    // Project world velocity onto each image axis, then scale from world units to pixels.
+    const float uLenSq = plane.mAxisU.lengthSquared() ;
+    const float vLenSq = plane.mAxisV.lengthSquared() ;
+    mVelocityToU = ( uLenSq > 0.0f ) ? plane.mAxisU * ( float( width ) / uLenSq ) : Vec3( 0.0f ) ;
+    mVelocityToV = ( vLenSq > 0.0f ) ? plane.mAxisV * ( float( height ) / vLenSq ) : Vec3( 0.0f ) ;
+
+    // Sample velocity once per pixel, so streamlines step through a 2D field rather than the 3D grid.
+    mFlow.resize( width * height ) ;
+    mInGrid.resize( width * height ) ;
+    if( 0 == velGrid.Size() ) return ;
+#if USE_TBB
+    // Estimate grain size based on size of problem and number of processors.
+    const size_t grainSize = std::max( size_t( 1 ) , height / std::thread::hardware_concurrency() ) ;
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0 , height , grainSize ) , LineIntegralConvolution_SampleFlow_TBB( this ) ) ;
+#else
+    SampleFlowSlice( 0 , height ) ;
+#endif
+}
+
+/*! \brief Sample in-plane velocity, in pixels per unit time, at centers of a subset of rows of pixels
+
+    \param iyStart - index of first row to sample
+
+    \param iyEnd - index past last row to sample
+*/
+void LineIntegralConvolution::SampleFlowSlice( size_t iyStart , size_t iyEnd )
+{
+    for( size_t iy = iyStart ; iy < iyEnd ; ++ iy )
+    {
+        for( size_t ix = 0 ; ix < mWidth ; ++ ix )
+        {
+            const size_t    iPixel  = iy * mWidth + ix ;
+            const Vec3      vPos( mPlane.mOrigin + mPixelU * ( float( ix ) + 0.5f ) + mPixelV * ( float( iy ) + 0.5f ) ) ;
+            mInGrid[ iPixel ] = mVelGrid->Encloses( vPos ) ;
+            if( mInGrid[ iPixel ] )
+            {
+                Vec3 velocity ;
+                mVelGrid->Interpolate( velocity , vPos ) ;
+                mFlow[ iPixel ] = Vec2( velocity.dot( mVelocityToU ) , velocity.dot( mVelocityToV ) ) ;
+            }
+            else
+            {
+                mFlow[ iPixel ] = Vec2( 0.0f , 0.0f ) ;
+            }
+        }
+    }
+}
+
+/*! \brief Interpolate in-plane velocity, in pixels per unit time, between pixel centers
+
+    \return false if the point lies outside the image, or any pixel around it lies outside the velocity grid.
+*/
+bool LineIntegralConvolution::ComputeFlow( float & vx , float & vy , float x , float y ) const
+{
+    if( ( x < 0.0f ) || ( x >= float( mWidth ) ) || ( y < 0.0f ) || ( y >= float( mHeight ) ) ) return false ;
+    // Clamp to centers of border pixels.
+    const float     u       = std::min( std::max( x - 0.5f , 0.0f ) , float( mWidth - 1 ) ) ;
+    const float     v       = std::min( std::max( y - 0.5f , 0.0f ) , float( mHeight - 1 ) ) ;
+    const size_t    ix0     = std::min( size_t( u ) , mWidth - 1 ) ;
+    const size_t    iy0     = std::min( size_t( v ) , mHeight - 1 ) ;
+    const size_t    i00     = iy0 * mWidth + ix0 ;
+    const size_t    i10     = i00 + ( ( ix0 + 1 < mWidth ) ? 1 : 0 ) ;
+    const size_t    i01     = i00 + ( ( iy0 + 1 < mHeight ) ? mWidth : 0 ) ;
+    const size_t    i11     = i01 + ( i10 - i00 ) ;
+    if( ! ( mInGrid[ i00 ] && mInGrid[ i10 ] && mInGrid[ i01 ] && mInGrid[ i11 ] ) ) return false ;
+    const float     tx      = u - float( ix0 ) ;
+    const float     ty      = v - float( iy0 ) ;
+    const Vec2 flow =   ( mFlow[ i00 ] * ( 1.0f - tx ) + mFlow[ i10 ] * tx ) * ( 1.0f - ty )
+                    +   ( mFlow[ i01 ] * ( 1.0f - tx ) + mFlow[ i11 ] * tx ) * ty ;
+    vx = flow.x ;
+    vy = flow.y ;
+    return true ;
+}
+
+/*! \brief Compute unit direction, in pixel coordinates, of in-plane velocity at a point in the image
+
+    \return false if the point lies outside the velocity grid or in-plane velocity vanishes there.
+*/
+bool LineIntegralConvolution::ComputeDirection( float & dx , float & dy , float x , float y ) const
+{
+    if( ! ComputeFlow( dx , dy , x , y ) ) return false ;
+    const float speedSq = dx * dx + dy * dy ;
+    if( speedSq < FLT_MIN ) return false ;
+    const float oneOverSpeed = 1.0f / sqrtf( speedSq ) ;
+    dx *= oneOverSpeed ;
+    dy *= oneOverSpeed ;
+    return true ;
+}
+
+/*! \brief Advance a point along its streamline using the midpoint rule
+
+    \param step - signed distance, in pixels, to advance.  Negative steps trace upstream.
+
+    \return false if the streamline ended, in which case x and y are unspecified.
+*/
+bool LineIntegralConvolution::StepStreamline( float & x , float & y , float step ) const
+{
+    float dx , dy ;
+    if( ! ComputeDirection( dx , dy , x , y ) ) return false ;
+    float dxMid , dyMid ;
+    if( ! ComputeDirection( dxMid , dyMid , x + 0.5f * step * dx , y + 0.5f * step * dy ) ) return false ;
+    x += step * dxMid ;
+    y += step * dyMid ;
+    return ( x >= 0.0f ) && ( x < float( mWidth ) ) && ( y >= 0.0f ) && ( y < float( mHeight ) ) ;
+}
+
+/*! \brief Return noise at the pixel containing a point in the image
+ */
+float LineIntegralConvolution::Noise( float x , float y ) const
+{
+    const size_t ix = std::min( size_t( x ) , mWidth - 1 ) ;
+    const size_t iy = std::min( size_t( y ) , mHeight - 1 ) ;
+    return mInput[ iy * mWidth + ix ] ;
+}
+
+/*! \brief Average noise along the streamline through the center of a pixel
+ */
+float LineIntegralConvolution::ConvolvePixel( size_t ix , size_t iy ) const
+{
+    const float xCenter = float( ix ) + 0.5f ;
+    const float yCenter = float( iy ) + 0.5f ;
+    if( ! mInGrid[ iy * mWidth + ix ] ) return 0.0f ;
+
+    const int   numSteps    = std::max( 1 , int( mKernelLength / mStepSize + 0.5f ) ) ;
+    float       sum         = mInput[ iy * mWidth + ix ] ;
+    int         numSamples  = 1 ;
+    for( float step : { mStepSize , - mStepSize } )
+    {   // Trace downstream then upstream.
+        float x = xCenter ;
+        float y = yCenter ;
+        for( int iStep = 0 ; ( iStep < numSteps ) && StepStreamline( x , y , step ) ; ++ iStep )
+        {
+            sum += Noise( x , y ) ;
+            ++ numSamples ;
+        }
+    }
+    return sum / float( numSamples ) ;
+}
+
+/*! \brief Render one image tile using FastLIC
+
+    \param iTile - index of tile to render
+
+    \param samples - scratch space for positions along a streamline
+
+    \param noise - scratch space for noise at each sample
+*/
+void LineIntegralConvolution::RenderFastTile( size_t iTile , std::vector< Vec2 > & samples , std::vector< float > & noise )
+{
+    const size_t    ixBegin         = ( iTile % mNumTilesX ) * mTileSize ;
+    const size_t    iyBegin         = ( iTile / mNumTilesX ) * mTileSize ;
+    const size_t    ixEnd           = std::min( ixBegin + mTileSize , mWidth ) ;
+    const size_t    iyEnd           = std::min( iyBegin + mTileSize , mHeight ) ;
+    const size_t    numKernelSteps  = std::max( 1 , int( mKernelLength / mStepSize + 0.5f ) ) ;
+    const size_t    numTraceSteps   = numKernelSteps + std::max( 0 , int( mLineExtension / mStepSize + 0.5f ) ) ;
+
+    for( size_t iyCenter = iyBegin ; iyCenter < iyEnd ; ++ iyCenter )
+    {
+        for( size_t ixCenter = ixBegin ; ixCenter < ixEnd ; ++ ixCenter )
+        {
+            if( mHits[ iyCenter * mWidth + ixCenter ] >= mMinHits ) continue ;
+            const float xCenter = float( ixCenter ) + 0.5f ;
+            const float yCenter = float( iyCenter ) + 0.5f ;
+            if( ! mInGrid[ iyCenter * mWidth + ixCenter ] ) continue ;
+
+            // Trace upstream, reverse, then trace downstream, so samples run in flow order.
+            samples.clear() ;
+            float x = xCenter ;
+            float y = yCenter ;
+            while( ( samples.size() < numTraceSteps ) && StepStreamline( x , y , - mStepSize ) )
+            {
+                samples.push_back( Vec2( x , y ) ) ;
+            }
+            const bool bUpstreamEnded = samples.size() < numTraceSteps ;
+            std::reverse( samples.begin() , samples.end() ) ;
+            const size_t iSeed = samples.size() ;
+            samples.push_back( Vec2( xCenter , yCenter ) ) ;
+            x = xCenter ;
+            y = yCenter ;
+            while( ( samples.size() - iSeed <= numTraceSteps ) && StepStreamline( x , y , mStepSize ) )
+            {
+                samples.push_back( Vec2( x , y ) ) ;
+            }
+            const bool      bDownstreamEnded    = samples.size() - iSeed <= numTraceSteps ;
+            const size_t    numSamples          = samples.size() ;
+            noise.resize( numSamples ) ;
+            for( size_t iSample = 0 ; iSample < numSamples ; ++ iSample )
+            {
+                noise[ iSample ] = Noise( samples[ iSample ].x , samples[ iSample ].y ) ;
+            }
+
+            // Slide box kernel along streamline, keeping a running sum over window [ iLow , iHigh ).
+            // Only deposit where the window is whole, or truncated because the streamline itself ended,
+            // so results match what tracing from that sample would give.
+            const size_t iFirst = bUpstreamEnded    ? 0             : std::min( numKernelSteps , iSeed ) ;
+            const size_t iLast  = bDownstreamEnded  ? numSamples    : std::max( numSamples - numKernelSteps , iSeed + 1 ) ;
+            size_t  iLow    = 0 ;
+            size_t  iHigh   = 0 ;
+            float   sum     = 0.0f ;
+            for( size_t iSample = iFirst ; iSample < iLast ; ++ iSample )
+            {
+                for( const size_t iHighNew = std::min( numSamples , iSample + numKernelSteps + 1 ) ; iHigh < iHighNew ; ++ iHigh )
+                {
+                    sum += noise[ iHigh ] ;
+                }
+                for( const size_t iLowNew = ( iSample > numKernelSteps ) ? iSample - numKernelSteps : 0 ; iLow < iLowNew ; ++ iLow )
+                {
+                    sum -= noise[ iLow ] ;
+                }
+                const size_t ix = size_t( samples[ iSample ].x ) ;
+                const size_t iy = size_t( samples[ iSample ].y ) ;
+                if( ( ix < ixBegin ) || ( ix >= ixEnd ) || ( iy < iyBegin ) || ( iy >= iyEnd ) ) continue ;
+                const size_t iPixel = iy * mWidth + ix ;
+                if( ( mHits[ iPixel ] < mMaxHits ) || ( iSample == iSeed ) )
+                {   // Seed pixel always takes its own result, so seeding always makes progress.
+                    mSums[ iPixel ] += sum / float( iHigh - iLow ) ;
+                    ++ mHits[ iPixel ] ;
+                }
+            }
+        }
+    }
+
+    for( size_t iy = iyBegin ; iy < iyEnd ; ++ iy )
+    {
+        for( size_t ix = ixBegin ; ix < ixEnd ; ++ ix )
+        {
+            const size_t iPixel = iy * mWidth + ix ;
+            mImage[ iPixel ] = ( mHits[ iPixel ] > 0 ) ? mSums[ iPixel ] / float( mHits[ iPixel ] ) : 0.0f ;
+        }
+    }
+}
+
+/*! \brief Render a subset of image tiles
+
+    \param iTileStart - index of first tile to render
+
+    \param iTileEnd - index past last tile to render
+*/
+void LineIntegralConvolution::RenderTilesSlice( size_t iTileStart , size_t iTileEnd )
+{
+    if( METHOD_FAST_LIC == mMethod )
+    {
+        std::vector< Vec2 >     samples ;
+        std::vector< float >    noise ;
+        for( size_t iTile = iTileStart ; iTile < iTileEnd ; ++ iTile )
+        {
+            RenderFastTile( iTile , samples , noise ) ;
+        }
+        return ;
+    }
+
+    for( size_t iTile = iTileStart ; iTile < iTileEnd ; ++ iTile )
+    {
+        const size_t ixBegin    = ( iTile % mNumTilesX ) * mTileSize ;
+        const size_t iyBegin    = ( iTile / mNumTilesX ) * mTileSize ;
+        const size_t ixEnd      = std::min( ixBegin + mTileSize , mWidth ) ;
+        const size_t iyEnd      = std::min( iyBegin + mTileSize , mHeight ) ;
+        for( size_t iy = iyBegin ; iy < iyEnd ; ++ iy )
+        {
+            for( size_t ix = ixBegin ; ix < ixEnd ; ++ ix )
+            {
+                mImage[ iy * mWidth + ix ] = ConvolvePixel( ix , iy ) ;
+            }
+        }
+    }
+}
+
+/*! \brief Convolve a texture along streamlines into mImage
+
+    \param input - texture to convolve, one value per pixel.
+*/
+void LineIntegralConvolution::Convolve( const std::vector< float > & input )
+{
+    mInput = input.data() ;
+    const size_t numTiles = mNumTilesX * ( ( mHeight + mTileSize - 1 ) / mTileSize ) ;
+#if USE_TBB
+    // Estimate grain size based on size of problem and number of processors.
+    const size_t grainSize = std::max( size_t( 1 ) , numTiles / std::thread::hardware_concurrency() ) ;
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numTiles , grainSize ) , LineIntegralConvolution_RenderTiles_TBB( this ) ) ;
+#else
+    RenderTilesSlice( 0 , numTiles ) ;
+#endif
+}
+
+void LineIntegralConvolution::Render( const UniformGrid< Vec3 > & velGrid , const LicPlane & plane , size_t width , size_t height )
+{
+    PrepareImage( velGrid , plane , width , height ) ;
+    if( ( 0 == width ) || ( 0 == height ) || ( 0 == velGrid.Size() ) ) return ;
+    Convolve( mNoise ) ;
+}
+
+/*! \brief Compute displacement, in pixels, of in-plane flow over mTimeStep, arriving at a point in the image
+
+    \return false if the path leaves the velocity grid.
+*/
+bool LineIntegralConvolution::ComputeDisplacement( float & dx , float & dy , float x , float y ) const
+{   // Trace backward with the midpoint rule.
+    float vx , vy ;
+    if( ! ComputeFlow( vx , vy , x , y ) ) return false ;
+    const float halfStep = 0.5f * mTimeStep ;
+    if( ! ComputeFlow( vx , vy , x - vx * halfStep , y - vy * halfStep ) ) return false ;
+    dx = vx * mTimeStep ;
+    dy = vy * mTimeStep ;
+    return true ;
+}
+
+/*! \brief Advect a subset of rows of the animated texture, and blend in new noise
+
+    \param iyStart - index of first row to advect
+
+    \param iyEnd - index past last row to advect
+*/
+void LineIntegralConvolution::AdvectTextureSlice( size_t iyStart , size_t iyEnd )
+{
+    for( size_t iy = iyStart ; iy < iyEnd ; ++ iy )
+    {
+        for( size_t ix = 0 ; ix < mWidth ; ++ ix )
+        {
+            const size_t    iPixel  = iy * mWidth + ix ;
+            // Injected noise cycles smoothly in time, each pixel with its own phase, so frames do not flicker.
+            const float     phase   = mNoise[ iPixel ] + float( mFrame % sNoisePeriod ) * ( 1.0f / float( sNoisePeriod ) ) ;
+            const float     noise   = fabsf( 2.0f * ( phase - floorf( phase ) ) - 1.0f ) ;
+            const float     x       = float( ix ) + 0.5f ;
+            const float     y       = float( iy ) + 0.5f ;
+            float           dx , dy ;
+            float           value   = mTexturePrev[ iPixel ] ;   // Texture stays put where flow cannot be traced.
+            if( ComputeDisplacement( dx , dy , x , y ) )
+            {   // Fetch texture from where flow came from, interpolating bilinearly between pixel centers.
+                // The plane can move between frames, so go through world space to find the previous pixel.
+                const Vec3  vFrom( mPlane.mOrigin + mPixelU * ( x - dx ) + mPixelV * ( y - dy ) - mTexturePlane.mOrigin ) ;
+                const float xFrom = vFrom.dot( mTextureToU ) - 0.5f ;
+                const float yFrom = vFrom.dot( mTextureToV ) - 0.5f ;
+                if( ( xFrom < 0.0f ) || ( xFrom > float( mWidth - 1 ) ) || ( yFrom < 0.0f ) || ( yFrom > float( mHeight - 1 ) ) )
+                {   // Flow came from outside image, so bring in uniform gray, which injected noise then textures.
+                    value = 0.5f ;
+                }
+                else
+                {
+                    const size_t    ix0     = std::min( size_t( xFrom ) , mWidth - 1 ) ;
+                    const size_t    iy0     = std::min( size_t( yFrom ) , mHeight - 1 ) ;
+                    const size_t    ix1     = std::min( ix0 + 1 , mWidth - 1 ) ;
+                    const size_t    iy1     = std::min( iy0 + 1 , mHeight - 1 ) ;
+                    const float     tx      = xFrom - float( ix0 ) ;
+                    const float     ty      = yFrom - float( iy0 ) ;
+                    const float *   pRow0   = & mTexturePrev[ iy0 * mWidth ] ;
+                    const float *   pRow1   = & mTexturePrev[ iy1 * mWidth ] ;
+                    value =     ( 1.0f - ty ) * ( ( 1.0f - tx ) * pRow0[ ix0 ] + tx * pRow0[ ix1 ] )
+                            +   ty            * ( ( 1.0f - tx ) * pRow1[ ix0 ] + tx * pRow1[ ix1 ] ) ;
+                }
+            }
+            mTexture[ iPixel ] = ( 1.0f - mNoiseBlend ) * value + mNoiseBlend * noise ;
+        }
+    }
+}
+
+void LineIntegralConvolution::Animate( const UniformGrid< Vec3 > & velGrid , const LicPlane & plane , size_t width , size_t height , float timeStep , uint64_t uFrame )
+{
+    const bool bRestart = ( width != mWidth ) || ( height != mHeight ) || ( mTexture.size() != width * height ) ;
+    PrepareImage( velGrid , plane , width , height ) ;
+    if( ( 0 == width ) || ( 0 == height ) || ( 0 == velGrid.Size() ) ) return ;
+
+    if( bRestart )
+    {   // Start from white noise.
+        mTexture        = mNoise ;
+        mTexturePlane   = plane ;
+    }
+    else
+    {
+        mTexturePrev.swap( mTexture ) ;
+        mTexture.resize( width * height ) ;
+        mTimeStep   = timeStep ;
+        mFrame      = uFrame ;
+        const float uLenSq = mTexturePlane.mAxisU.lengthSquared() ;
+        const float vLenSq = mTexturePlane.mAxisV.lengthSquared() ;
+        mTextureToU = ( uLenSq > 0.0f ) ? mTexturePlane.mAxisU * ( float( width ) / uLenSq ) : Vec3( 0.0f ) ;
+        mTextureToV = ( vLenSq > 0.0f ) ? mTexturePlane.mAxisV * ( float( height ) / vLenSq ) : Vec3( 0.0f ) ;
+#if USE_TBB
+        // Estimate grain size based on size of problem and number of processors.
+        const size_t grainSize = std::max( size_t( 1 ) , height / std::thread::hardware_concurrency() ) ;
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0 , height , grainSize ) , LineIntegralConvolution_AdvectTexture_TBB( this ) ) ;
+#else
+        AdvectTextureSlice( 0 , height ) ;
+#endif
+        mTexturePlane = plane ;
+    }
+    Convolve( mTexture ) ;
+}
+
+bool LineIntegralConvolution::WritePgm( const std::string & path ) const
+{
+    if( mImage.empty() ) return false ;
+    // Convolved noise is nearly normally distributed, so stretch by its spread rather than its extremes,
+    // which a few pixels near streamline ends would otherwise dictate.
+    double sum = 0.0 , sumSq = 0.0 ;
+    for( float value : mImage )
+    {
+        sum     += value ;
+        sumSq   += double( value ) * value ;
+    }
+    const double    mean        = sum / double( mImage.size() ) ;
+    const double    stdDev      = sqrt( std::max( 0.0 , sumSq / double( mImage.size() ) - mean * mean ) ) ;
+    const float     minValue    = float( mean - 3.0 * stdDev ) ;
+    const float     scale       = ( stdDev > 0.0 ) ? float( 255.0 / ( 6.0 * stdDev ) ) : 0.0f ;
+    std::vector< unsigned char > pixels( mImage.size() ) ;
+    for( size_t offset = 0 ; offset < mImage.size() ; ++ offset )
+    {
+        pixels[ offset ] = static_cast< unsigned char >( std::min( std::max( ( mImage[ offset ] - minValue ) * scale + 0.5f , 0.0f ) , 255.0f ) ) ;
+    }
+
+    FILE * pFile = fopen( path.c_str() , "wb" ) ;
+    if( ! pFile ) return false ;
+    const bool bWritten =   ( fprintf( pFile , "P5\n%zu %zu\n255\n" , mWidth , mHeight ) > 0 )
+                        &&  ( fwrite( pixels.data() , 1 , pixels.size() , pFile ) == pixels.size() ) ;
+    return ( 0 == fclose( pFile ) ) && bWritten ;
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "UniformGrid.hpp"
+#include "TBB_Settings.hpp"
+
+/*! \brief Rectangle in world space onto which a LIC image maps
+
+    Pixel (0,0) lies at mOrigin and the image spans mAxisU horizontally
+    and mAxisV vertically.  The axes should be perpendicular.
+ */
+struct LicPlane
+{
+    LicPlane() {}
+    LicPlane( const Vec3 & vOrigin , const Vec3 & vAxisU , const Vec3 & vAxisV )
+        : mOrigin( vOrigin ) , mAxisU( vAxisU ) , mAxisV( vAxisV ) {}
+
+    /*! \brief Make a plane that slices a grid perpendicular to one of its axes
+
+        \param grid - grid to slice.
+
+        \param normalAxis - 0, 1 or 2 for a slice perpendicular to x, y or z.
+
+        \param fraction - where the slice lies along normalAxis, from 0 at the minimal corner to 1 at the maximal.
+    */
+    static LicPlane FromGrid( const UniformGridGeometry & grid , int normalAxis , float fraction ) ;
+
+    Vec3    mOrigin ;   ///< World position of image corner at pixel (0,0)
+    Vec3    mAxisU  ;   ///< World displacement spanning image width
+    Vec3    mAxisV  ;   ///< World displacement spanning image height
+} ;
+
+/*! \brief Render Line Integral Convolution images of a velocity grid, on the CPU
+
+ Each output pixel averages a white-noise texture along the streamline
+ through that pixel, traced through the component of velocity that lies
+ in the image plane.  Noise correlates along streamlines and not across
+ them, so the image shows flow direction everywhere at once.
+
+ By default this uses FastLIC: rather than tracing a streamline per pixel,
+ it traces long streamlines and slides the convolution window along
+ each, depositing a result in every pixel the window center passes.
+ Each pixel keeps a running sum and hit count; seeding skips pixels that
+ already have enough hits, and deposits stop once a pixel has plenty,
+ so cost per pixel stays roughly constant as the kernel lengthens.
+ Deposits land at streamline samples rather than pixel centers, so
+ results differ slightly from METHOD_PER_PIXEL, which remains available
+ as a reference.
+
+ Each render first samples in-plane velocity at every pixel center with
+ UniformGrid::Interpolate.  Streamlines then step a fixed distance in
+ pixels using the midpoint rule, interpolating bilinearly between pixel
+ centers, which costs far less than sampling the 3D grid each step.
+ They stop at the image border, the velocity grid border, or where
+ in-plane velocity vanishes.  Pixels whose centers lie outside the velocity grid come out 0.
+
+ Animate renders a sequence that stays coherent from frame to frame, in
+ the spirit of Unsteady Flow LIC.  Rather than convolving fresh noise each
+ frame, it keeps a texture that it advects through the same velocity grid
+ AdvectTracers uses, over the same time step, blending in a little new
+ noise so contrast persists.  Injected noise cycles smoothly in time
+ rather than changing at random, so frames do not flicker.  Advection
+ smears the texture along pathlines, so a kernel of a pixel or two
+ suffices to convolve it, and each frame costs one advection step plus
+ that short convolution.
+
+ Rendering uses only the simulation core, so it runs headless.
+ The image is split into square tiles rendered on separate threads.
+ FastLIC deposits only into pixels of the tile that seeded the
+ streamline, so tiles never write to each other's pixels.
+
+ */
+class LineIntegralConvolution
+{
+public:
+    enum MethodE
+    {
+        METHOD_FAST_LIC ,   ///< Reuse each streamline for every pixel it passes through
+        METHOD_PER_PIXEL ,  ///< Trace a separate streamline for each pixel
+    } ;
+
+    /*! \brief Initialize renderer
+
+        \param noiseSeed - seed for white-noise texture, so images are reproducible.
+    */
+    LineIntegralConvolution( uint32_t noiseSeed = 1 ) ;
+
+    /// Set half-length, in pixels, of the streamline segment averaged for each pixel.
+    void    SetKernelLength( float kernelLength )   { mKernelLength = kernelLength ; }
+    float   GetKernelLength() const                 { return mKernelLength ; }
+
+    /// Set distance, in pixels, between consecutive streamline samples.
+    void    SetStepSize( float stepSize )           { mStepSize = stepSize ; }
+    float   GetStepSize() const                     { return mStepSize ; }
+
+    void    SetMethod( MethodE method )             { mMethod = method ; }
+    MethodE GetMethod() const                       { return mMethod ; }
+
+    /// Set distance, in pixels, FastLIC traces each streamline beyond the kernel, in each direction.
+    void    SetStreamlineExtension( float extension )   { mLineExtension = extension ; }
+    float   GetStreamlineExtension() const              { return mLineExtension ; }
+
+    /*! \brief Set how many results FastLIC averages per pixel
+
+        \param minHits - pixels with fewer hits seed new streamlines.
+
+        \param maxHits - pixels with this many hits take no more deposits.
+    */
+    void    SetHitRange( unsigned minHits , unsigned maxHits ) ;
+
+    /*! \brief Render a LIC image of velocity in a plane
+
+        \param velGrid - velocity grid, for example VortonSim::GetVelocityGrid.
+
+        \param plane - region of space the image covers.
+
+        \param width - number of pixels across image.
+
+        \param height - number of pixels down image.
+    */
+    void Render( const UniformGrid< Vec3 > & velGrid , const LicPlane & plane , size_t width , size_t height ) ;
+
+    /*! \brief Advance animated texture by one frame and render it
+
+        \param velGrid - velocity grid, for example VortonSim::GetVelocityGrid.
+
+        \param plane - region of space the image covers.  It can follow the grid as the grid moves.
+                        Changing the resolution restarts the animation.
+
+        \param width - number of pixels across image.
+
+        \param height - number of pixels down image.
+
+        \param timeStep - time since previous frame, as passed to VortonSim::Update.
+
+        \param uFrame - frame counter, which seeds the noise blended into this frame.
+    */
+    void Animate( const UniformGrid< Vec3 > & velGrid , const LicPlane & plane , size_t width , size_t height , float timeStep , uint64_t uFrame ) ;
+
+    /// Set fraction, in [0,1], of animated texture replaced by new noise each frame.
+    void    SetNoiseBlend( float noiseBlend )       { mNoiseBlend = noiseBlend ; }
+    float   GetNoiseBlend() const                   { return mNoiseBlend ; }
+
+    size_t                          GetWidth() const    { return mWidth ; }
+    size_t                          GetHeight() const   { return mHeight ; }
+
+    /// Return pixel intensities, in [0,1], row by row, starting at pixel (0,0).
+    const std::vector< float > &    GetImage() const    { return mImage ; }
+
+    /*! \brief Write image as an 8-bit binary PGM file, stretching contrast so three standard deviations either side of the mean span the full range
+
+        \return true if the file was written.
+    */
+    bool WritePgm( const std::string & path ) const ;
+
+private:
+    #if USE_TBB
+        friend class LineIntegralConvolution_RenderTiles_TBB ;
+        friend class LineIntegralConvolution_AdvectTexture_TBB ;
+        friend class LineIntegralConvolution_SampleFlow_TBB ;
+    #endif
+
+    static const size_t sTileSize       = 32 ;  ///< Width and height, in pixels, of tiles rendered as one task
+    static const size_t sFastTileSize   = 128 ; ///< Tile size for FastLIC, larger so fewer streamlines leave their tile
+    static const size_t sNoisePeriod    = 32 ;  ///< Number of frames over which noise injected by Animate cycles
+
+    void    PrepareImage( const UniformGrid< Vec3 > & velGrid , const LicPlane & plane , size_t width , size_t height ) ;
+    void    Convolve( const std::vector< float > & input ) ;
+    bool    ComputeDisplacement( float & dx , float & dy , float x , float y ) const ;
+    void    SampleFlowSlice( size_t iyStart , size_t iyEnd ) ;
+    bool    ComputeFlow( float & vx , float & vy , float x , float y ) const ;
+    bool    ComputeDirection( float & dx , float & dy , float x , float y ) const ;
+    bool    StepStreamline( float & x , float & y , float step ) const ;
+    float   Noise( float x , float y ) const ;
+    float   ConvolvePixel( size_t ix , size_t iy ) const ;
+    void    RenderFastTile( size_t iTile , std::vector< Vec2 > & samples , std::vector< float > & noise ) ;
+    void    RenderTilesSlice( size_t iTileStart , size_t iTileEnd ) ;
+    void    AdvectTextureSlice( size_t iyStart , size_t iyEnd ) ;
+
+    uint32_t                    mNoiseSeed      ;   ///< Seed for white-noise texture
+    float                       mKernelLength   ;   ///< Half-length, in pixels, of convolution kernel
+    float                       mStepSize       ;   ///< Distance, in pixels, between streamline samples
+    MethodE                     mMethod         ;   ///< How to compute the convolution
+    float                       mLineExtension  ;   ///< Distance, in pixels, FastLIC traces beyond kernel
+    unsigned                    mMinHits        ;   ///< FastLIC seeds streamlines from pixels with fewer hits
+    unsigned                    mMaxHits        ;   ///< FastLIC deposits into pixels with fewer hits
+    size_t                      mTileSize       ;   ///< Width and height, in pixels, of tiles
+    size_t                      mWidth          ;   ///< Number of pixels across image
+    size_t                      mHeight         ;   ///< Number of pixels down image
+    size_t                      mNumTilesX      ;   ///< Number of tiles across image
+    std::vector< float >        mNoise          ;   ///< White-noise texture, one value per pixel
+    const float *               mInput          ;   ///< Texture being convolved: mNoise or mTexture
+    std::vector< float >        mTexture        ;   ///< Animated texture, advected each frame
+    std::vector< float >        mTexturePrev    ;   ///< Animated texture of previous frame
+    LicPlane                    mTexturePlane   ;   ///< Region of space mTexture covers
+    Vec3                        mTextureToU     ;   ///< Dot with displacement from mTexturePlane.mOrigin to get pixels across
+    Vec3                        mTextureToV     ;   ///< Dot with displacement from mTexturePlane.mOrigin to get pixels down
+    float                       mNoiseBlend     ;   ///< Fraction of animated texture replaced by noise each frame
+    float                       mTimeStep       ;   ///< Time over which to advect animated texture
+    uint64_t                    mFrame          ;   ///< Frame counter of animated texture
+    std::vector< float >        mImage          ;   ///< Convolved image
+    std::vector< float >        mSums           ;   ///< FastLIC sum of convolution results deposited in each pixel
+    std::vector< uint16_t >     mHits           ;   ///< FastLIC number of results deposited in each pixel
+    std::vector< Vec2 >         mFlow           ;   ///< In-plane velocity, in pixels per unit time, at each pixel center
+    std::vector< uint8_t >      mInGrid         ;   ///< Whether each pixel center lies inside the velocity grid
+    const UniformGrid< Vec3 > * mVelGrid        ;   ///< Velocity grid being rendered
+    LicPlane                    mPlane          ;   ///< Region of space being rendered
+    Vec3                        mPixelU         ;   ///< World displacement of one pixel across
+    Vec3                        mPixelV         ;   ///< World displacement of one pixel down
+    Vec3                        mVelocityToU    ;   ///< Dot with world velocity to get pixels across per unit time
+    Vec3                        mVelocityToV    ;   ///< Dot with world velocity to get pixels down per unit time
+} ;
@@ -0,0 +1,50 @@
+#include "MappedFile.hpp"
+
+#if defined( _WIN32 )
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile( const std::string & path , bool bSequential )
+    : mData( nullptr )
+    , mSize( 0 )
+{
+#if defined( _WIN32 )
+    (void) bSequential ;
+    std::ifstream file( path , std::ios::binary | std::ios::ate ) ;
+    if( ! file ) return ;
+    mBuffer.resize( size_t( file.tellg() ) ) ;
+    file.seekg( 0 ) ;
+    if( file.read( mBuffer.data() , mBuffer.size() ) )
+    {
+        mData = mBuffer.data() ;
+        mSize = mBuffer.size() ;
+    }
+#else
+    const int fd = open( path.c_str() , O_RDONLY ) ;
+    if( fd < 0 ) return ;
+    struct stat status ;
+    if( ( 0 == fstat( fd , & status ) ) && ( status.st_size > 0 ) )
+    {
+        void * pAddress = mmap( nullptr , size_t( status.st_size ) , PROT_READ , MAP_PRIVATE , fd , 0 ) ;
+        if( MAP_FAILED != pAddress )
+        {
+            if( bSequential ) madvise( pAddress , size_t( status.st_size ) , MADV_SEQUENTIAL ) ;
+            mData = static_cast< const char * >( pAddress ) ;
+            mSize = size_t( status.st_size ) ;
+        }
+    }
+    close( fd ) ;   // Mapping remains valid after closing.
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#if ! defined( _WIN32 )
+    if( mData ) munmap( const_cast< char * >( mData ) , mSize ) ;
+#endif
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*! \brief Read-only view of a whole file
+
+    Uses mmap where available, so pages load on demand and copying
+    out of the view is the only pass over the data.  Elsewhere, reads
+    the whole file into memory.
+
+    The view starts at a page boundary, so data at an offset aligned
+    within the file is aligned in memory too.
+*/
+class MappedFile
+{
+public:
+    /*! \brief Map a file
+
+        \param path - file to map.
+
+        \param bSequential - whether the caller will read the file from start to end,
+                so the system can read ahead aggressively.  Pass false for random access.
+
+        \note Check GetData to find out whether mapping succeeded.
+    */
+    explicit MappedFile( const std::string & path , bool bSequential = true ) ;
+    ~MappedFile() ;
+
+    MappedFile( const MappedFile & ) = delete ;
+    MappedFile & operator=( const MappedFile & ) = delete ;
+
+    /// Return address of file contents, or nullptr if the file could not be mapped or is empty.
+    const char *    GetData() const { return mData ; }
+    size_t          GetSize() const { return mSize ; }
+
+private:
+#if defined( _WIN32 )
+    std::vector< char > mBuffer ;
+#endif
+    const char *    mData ;
+    size_t          mSize ;
+} ;
@@ -11,7 +11,7 @@ float & Mat3::operator()(size_t row, size_t col) {
 }
 
 const float & Mat3::Get(size_t row, size_t col) const {
-	switch (col) { //ofVec3f doesn't return refs with the [] operator :(
+	switch (col) { //Vec3 doesn't return refs with the [] operator :(
 	case 0:
 		return mData.at(row).x;
 
@@ -23,7 +23,7 @@ const float & Mat3::Get(size_t row, size_t col) const {
 	}
 }
 float & Mat3::Get(size_t row, size_t col) {
-	switch (col) { //ofVec3f doesn't return refs with the [] operator :(
+	switch (col) { //Vec3 doesn't return refs with the [] operator :(
 	case 0:
 		return mData.at(row).x;
 
@@ -35,14 +35,6 @@ float & Mat3::Get(size_t row, size_t col) {
 	}
 }
 
-ofVec3f & Mat3::operator[](size_t i) {
-	return mData.at(i);
-}
-
-const ofVec3f & Mat3::operator[](size_t i) const {
-	return mData.at(i);
-}
-
 //TODO: Optimize with SIMD intrinsics
 Mat3 Mat3::operator+(const Mat3 &B) const {
 	Mat3 result;
@@ -112,12 +104,12 @@ void Mat3::operator*=(float scalar) {
 			Get(j, i) *= scalar;
 }
 
-ofVec3f Mat3::operator*(const ofVec3f & vec) const {
-	ofVec3f result;
+Vec3 Mat3::operator*(const Vec3 & vec) const {
+	Vec3 result;
 	//Iterate over rows
 #pragma omp parallel for
 	for (int i = 0; i < 3; i++) {
-		ofVec3f row(Get(i, 0), Get(i, 1), Get(i, 2));
+		Vec3 row(Get(i, 0), Get(i, 1), Get(i, 2));
 		row *= vec;
 		result[i] = row.x + row.y + row.z;
 	}
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <array>
-#include "ofVec3f.h"
+#include "Vec3.hpp"
 
 class Mat3 {
 public:
@@ -13,8 +13,9 @@ public:
 
 	const float & operator()(size_t row, size_t col) const;
 	float & operator()(size_t row, size_t col);
-	ofVec3f & operator[](size_t i);
-	const ofVec3f & operator[](size_t i) const;
+	/// Column access.  Inline and unchecked so grid stencils can vectorize.
+	Vec3 & operator[](size_t i) { return mData[i]; }
+	const Vec3 & operator[](size_t i) const { return mData[i]; }
 
 	/// \brief Add two matrices
 	Mat3 operator+(const Mat3& B) const;
@@ -41,7 +42,7 @@ public:
 	void operator*=(float scalar);
 
 	/// \brief Multiply this matrix with a vector and return a a vector.
-	ofVec3f operator*(const ofVec3f & vec) const;
+	Vec3 operator*(const Vec3 & vec) const;
 
 	static const Mat3 sIdentity;
 
@@ -60,7 +61,7 @@ private:
 	 [ c f i ]
 	 \verbatim
 	*/
-	std::array<ofVec3f, 3> mData;
+	std::array<Vec3, 3> mData;
 };
 
 inline Mat3 operator*(const float & scalar, const Mat3 & mat) {
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "UniformGrid.hpp"
-#include "ofVec3f.h"
+#include "Vec3.hpp"
 #include <vector>
 #include <array>
 #include <algorithm>
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "ofVec3f.h"
+#include "Vec3.hpp"
 
 class Particle
 {
@@ -15,10 +15,10 @@ public:
         , mBirthTime( 0 )
     {}
 	
-	ofVec3f    mPosition	        ;   ///< Position (in world units) of center of particle
-    ofVec3f    mVelocity	        ;   ///< Velocity of particle
-    ofVec3f    mOrientation	        ;   ///< Orientation of particle, in axis-angle form where angle=|orientation|
-    ofVec3f    mAngularVelocity	    ;   ///< Angular velocity of particle
+	Vec3       mPosition	        ;   ///< Position (in world units) of center of particle
+    Vec3       mVelocity	        ;   ///< Velocity of particle
+    Vec3       mOrientation	        ;   ///< Orientation of particle, in axis-angle form where angle=|orientation|
+    Vec3       mAngularVelocity	    ;   ///< Angular velocity of particle
     float	   mMass               	;   ///< Mass of particle
     float	   mSize		        ;   ///< Size of particle
     int        mBirthTime          	;   ///< Birth time of particle, in "ticks"
@@ -0,0 +1,320 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include "TBB_Settings.hpp"
+
+/*! \brief Remove particles from an array using parallel stream compaction
+
+ Removing particles one at a time, either with vector::erase (which
+ shifts every later element) or by swapping with the last element
+ and popping it, costs either O(N) per removal or serializes the work.
+ Instead, this class first flags dead particles, in parallel, then
+ removes all of them in one parallel pass:
+
+ -  Stable compaction preserves the relative order of survivors.
+    Each block of particles counts its survivors, a prefix sum over
+    blocks yields where each block's survivors go, then each block
+    copies its survivors into a scratch array, which then replaces
+    the original.
+
+ -  Unstable compaction moves only as many particles as died.
+    Survivors in the tail (beyond the new size) fill holes left by
+    dead particles in the head, the k-th such survivor filling the
+    k-th hole, so it works in place.
+
+ Blocks have a fixed size, so the result does not depend on the
+ number of threads.
+
+ After compacting particles, the same flags can compact any number of
+ companion arrays (for example, per-particle attributes stored
+ separately) the same way, so they stay aligned with the particles.
+
+ */
+template< class ParticleT > class ParticleCompaction
+{
+public:
+    ParticleCompaction() : mNumDead( 0 ) , mStable( true ) {}
+
+    /*! \brief Flag particles for which a predicate returns true
+
+        \param particles - array of particles to test.
+
+        \param isDead - predicate, called as isDead( const ParticleT & ), which returns true for particles to remove.
+
+        \return number of particles flagged.
+     */
+    template< class PredicateT > size_t MarkIf( const std::vector< ParticleT > & particles , const PredicateT & isDead )
+    {
+        const size_t numParticles = particles.size() ;
+        mDead.resize( numParticles ) ;
+        const size_t numBlocks = NumBlocks( numParticles ) ;
+        mBlockCounts.resize( numBlocks ) ;
+    #if USE_TBB
+        // Estimate grain size based on size of problem and number of processors.
+        const size_t grainSize = std::max( size_t( 1 ) , numBlocks / std::thread::hardware_concurrency() ) ;
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numBlocks , grainSize ) , MarkIf_TBB< PredicateT >( this , particles , isDead ) ) ;
+    #else
+        MarkIfSlice( particles , isDead , 0 , numBlocks ) ;
+    #endif
+        mNumDead = 0 ;
+        for( size_t iBlock = 0 ; iBlock < numBlocks ; ++ iBlock )
+        {
+            mNumDead += mBlockCounts[ iBlock ] ;
+        }
+        return mNumDead ;
+    }
+
+    /*! \brief Remove particles flagged by the most recent MarkIf
+
+        \param particles - array of particles.  Must be the same array, unchanged, as passed to MarkIf.
+
+        \param bStable - whether to preserve the relative order of surviving particles.
+     */
+    void Compact( std::vector< ParticleT > & particles , bool bStable )
+    {
+        mStable = bStable ;
+        if( 0 == mNumDead ) return ;
+        if( mStable )
+        {
+            PrepareStable() ;
+        }
+        else
+        {
+            PrepareUnstable() ;
+        }
+        CompactCompanion( particles , mScratch ) ;
+    }
+
+    /*! \brief Remove elements of a companion array the same way as the most recent Compact, reusing caller-owned scratch storage
+
+        \param items - array with one element per particle, as of the most recent MarkIf.
+
+        \param scratch - buffer for stable compaction.  Afterward it holds the old storage
+                of items, so passing the same buffer again avoids allocating.
+     */
+    template< class T > void CompactCompanion( std::vector< T > & items , std::vector< T > & scratch )
+    {
+        if( 0 == mNumDead ) return ;
+        const size_t newSize = mDead.size() - mNumDead ;
+        if( mStable )
+        {
+            scratch.resize( newSize ) ;
+            const size_t numBlocks = mBlockCounts.size() ;
+        #if USE_TBB
+            const size_t grainSize = std::max( size_t( 1 ) , numBlocks / std::thread::hardware_concurrency() ) ;
+            tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numBlocks , grainSize ) , CompactStable_TBB< T >( this , items , scratch ) ) ;
+        #else
+            CompactStableSlice( items , scratch , 0 , numBlocks ) ;
+        #endif
+            items.swap( scratch ) ;
+        }
+        else
+        {
+            const size_t numMoves = mHoles.size() ;
+        #if USE_TBB
+            const size_t grainSize = std::max( size_t( 1 ) , numMoves / std::thread::hardware_concurrency() ) ;
+            tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numMoves , grainSize ) , CompactUnstable_TBB< T >( this , items ) ) ;
+        #else
+            CompactUnstableSlice( items , 0 , numMoves ) ;
+        #endif
+            items.resize( newSize ) ;
+        }
+    }
+
+private:
+    static const size_t sBlockSize = 4096 ; ///< Number of particles per block of work.  Fixed, so results do not depend on thread count.
+
+    static size_t NumBlocks( size_t numParticles ) { return ( numParticles + sBlockSize - 1 ) / sBlockSize ; }
+
+    template< class PredicateT > void MarkIfSlice( const std::vector< ParticleT > & particles , const PredicateT & isDead , size_t iBlockBegin , size_t iBlockEnd )
+    {
+        for( size_t iBlock = iBlockBegin ; iBlock < iBlockEnd ; ++ iBlock )
+        {   // For each block in this slice...
+            const size_t iEnd = std::min( ( iBlock + 1 ) * sBlockSize , particles.size() ) ;
+            size_t numDead = 0 ;
+            for( size_t i = iBlock * sBlockSize ; i < iEnd ; ++ i )
+            {   // For each particle in this block...
+                mDead[ i ] = isDead( particles[ i ] ) ? 1 : 0 ;
+                numDead += mDead[ i ] ;
+            }
+            mBlockCounts[ iBlock ] = numDead ;
+        }
+    }
+
+    /// Compute where each block's survivors go, from the dead counts MarkIf left in mBlockCounts
+    void PrepareStable()
+    {
+        const size_t numParticles = mDead.size() ;
+        const size_t numBlocks = mBlockCounts.size() ;
+        mBlockOffsets.resize( numBlocks ) ;
+        size_t numSurvivors = 0 ;
+        for( size_t iBlock = 0 ; iBlock < numBlocks ; ++ iBlock )
+        {   // Exclusive prefix sum of survivors per block.
+            mBlockOffsets[ iBlock ] = numSurvivors ;
+            const size_t blockSize = std::min( sBlockSize , numParticles - iBlock * sBlockSize ) ;
+            numSurvivors += blockSize - mBlockCounts[ iBlock ] ;
+        }
+    }
+
+    /// Pair each hole in the head of the array with a survivor from its tail
+    void PrepareUnstable()
+    {
+        const size_t numParticles = mDead.size() ;
+        const size_t newSize = numParticles - mNumDead ;
+        const size_t numBlocks = mBlockCounts.size() ;
+        // Holes are dead particles below newSize.  Movers are survivors at or above newSize.
+        // Both number the same, namely the count of dead particles below newSize.
+        // Blocks wholly below or above newSize already know their counts,
+        // so only the block straddling newSize needs scanning.
+        mBlockOffsets.resize( numBlocks ) ;
+        mMoverOffsets.resize( numBlocks ) ;
+        size_t numHoles = 0 , numMovers = 0 ;
+        for( size_t iBlock = 0 ; iBlock < numBlocks ; ++ iBlock )
+        {   // Exclusive prefix sums of holes and movers per block.
+            mBlockOffsets[ iBlock ] = numHoles ;
+            mMoverOffsets[ iBlock ] = numMovers ;
+            const size_t iBegin = iBlock * sBlockSize ;
+            const size_t iEnd   = std::min( iBegin + sBlockSize , numParticles ) ;
+            if( iEnd <= newSize )
+            {   // Block lies wholly in head.
+                numHoles += mBlockCounts[ iBlock ] ;
+            }
+            else if( iBegin >= newSize )
+            {   // Block lies wholly in tail.
+                numMovers += ( iEnd - iBegin ) - mBlockCounts[ iBlock ] ;
+            }
+            else
+            {   // Block straddles new end.
+                for( size_t i = iBegin ; i < newSize ; ++ i ) numHoles += mDead[ i ] ;
+                for( size_t i = newSize ; i < iEnd ; ++ i ) numMovers += 1 - mDead[ i ] ;
+            }
+        }
+        mHoles.resize( numHoles ) ;
+        mMovers.resize( numMovers ) ;
+    #if USE_TBB
+        const size_t grainSize = std::max( size_t( 1 ) , numBlocks / std::thread::hardware_concurrency() ) ;
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numBlocks , grainSize ) , GatherMoves_TBB( this ) ) ;
+    #else
+        GatherMovesSlice( 0 , numBlocks ) ;
+    #endif
+    }
+
+    void GatherMovesSlice( size_t iBlockBegin , size_t iBlockEnd )
+    {
+        const size_t numParticles = mDead.size() ;
+        const size_t newSize = numParticles - mNumDead ;
+        for( size_t iBlock = iBlockBegin ; iBlock < iBlockEnd ; ++ iBlock )
+        {   // For each block in this slice...
+            const size_t iBegin = iBlock * sBlockSize ;
+            const size_t iEnd   = std::min( iBegin + sBlockSize , numParticles ) ;
+            const size_t iSplit = std::min( std::max( iBegin , newSize ) , iEnd ) ;
+            size_t iHole = mBlockOffsets[ iBlock ] ;
+            for( size_t i = iBegin ; i < iSplit ; ++ i )
+            {   // For each particle in this block, in head...
+                if( mDead[ i ] ) mHoles[ iHole ++ ] = uint32_t( i ) ;
+            }
+            size_t iMover = mMoverOffsets[ iBlock ] ;
+            for( size_t i = iSplit ; i < iEnd ; ++ i )
+            {   // For each particle in this block, in tail...
+                if( ! mDead[ i ] ) mMovers[ iMover ++ ] = uint32_t( i ) ;
+            }
+        }
+    }
+
+    template< class T > void CompactStableSlice( const std::vector< T > & items , std::vector< T > & scratch , size_t iBlockBegin , size_t iBlockEnd ) const
+    {
+        for( size_t iBlock = iBlockBegin ; iBlock < iBlockEnd ; ++ iBlock )
+        {   // For each block in this slice...
+            const size_t iEnd = std::min( ( iBlock + 1 ) * sBlockSize , items.size() ) ;
+            size_t iDst = mBlockOffsets[ iBlock ] ;
+            for( size_t iSrc = iBlock * sBlockSize ; iSrc < iEnd ; ++ iSrc )
+            {   // For each element in this block...
+                if( ! mDead[ iSrc ] )
+                {
+                    scratch[ iDst ++ ] = items[ iSrc ] ;
+                }
+            }
+        }
+    }
+
+    template< class T > void CompactUnstableSlice( std::vector< T > & items , size_t iMoveBegin , size_t iMoveEnd ) const
+    {
+        for( size_t iMove = iMoveBegin ; iMove < iMoveEnd ; ++ iMove )
+        {   // For each hole in this slice...
+            items[ mHoles[ iMove ] ] = items[ mMovers[ iMove ] ] ;
+        }
+    }
+
+#if USE_TBB
+    /// Function object to flag dead particles using Threading Building Blocks
+    template< class PredicateT > class MarkIf_TBB
+    {
+        ParticleCompaction *                mCompaction ;
+        const std::vector< ParticleT > &    mParticles  ;
+        const PredicateT &                  mIsDead     ;
+    public:
+        void operator() ( const tbb::blocked_range<size_t> & r ) const
+        {   // Flag particles in subset of blocks.
+            mCompaction->MarkIfSlice( mParticles , mIsDead , r.begin() , r.end() ) ;
+        }
+        MarkIf_TBB( ParticleCompaction * pCompaction , const std::vector< ParticleT > & particles , const PredicateT & isDead )
+        : mCompaction( pCompaction ) , mParticles( particles ) , mIsDead( isDead ) {}
+    } ;
+
+    /// Function object to gather holes and movers using Threading Building Blocks
+    class GatherMoves_TBB
+    {
+        ParticleCompaction * mCompaction ;
+    public:
+        void operator() ( const tbb::blocked_range<size_t> & r ) const
+        {   // Gather holes and movers in subset of blocks.
+            mCompaction->GatherMovesSlice( r.begin() , r.end() ) ;
+        }
+        GatherMoves_TBB( ParticleCompaction * pCompaction ) : mCompaction( pCompaction ) {}
+    } ;
+
+    /// Function object to copy survivors to scratch array using Threading Building Blocks
+    template< class T > class CompactStable_TBB
+    {
+        const ParticleCompaction *  mCompaction ;
+        const std::vector< T > &    mItems      ;
+        std::vector< T > &          mScratch    ;
+    public:
+        void operator() ( const tbb::blocked_range<size_t> & r ) const
+        {   // Copy survivors in subset of blocks.
+            mCompaction->CompactStableSlice( mItems , mScratch , r.begin() , r.end() ) ;
+        }
+        CompactStable_TBB( const ParticleCompaction * pCompaction , const std::vector< T > & items , std::vector< T > & scratch )
+        : mCompaction( pCompaction ) , mItems( items ) , mScratch( scratch ) {}
+    } ;
+
+    /// Function object to move survivors into holes using Threading Building Blocks
+    template< class T > class CompactUnstable_TBB
+    {
+        const ParticleCompaction *  mCompaction ;
+        std::vector< T > &          mItems      ;
+    public:
+        void operator() ( const tbb::blocked_range<size_t> & r ) const
+        {   // Fill subset of holes.
+            mCompaction->CompactUnstableSlice( mItems , r.begin() , r.end() ) ;
+        }
+        CompactUnstable_TBB( const ParticleCompaction * pCompaction , std::vector< T > & items )
+        : mCompaction( pCompaction ) , mItems( items ) {}
+    } ;
+#endif
+
+    std::vector< char >         mDead           ;   ///< Per-particle flag: 1 if dead, 0 if alive
+    std::vector< size_t >       mBlockCounts    ;   ///< Number of dead particles in each block
+    std::vector< size_t >       mBlockOffsets   ;   ///< Destination of first survivor (stable) or offset of first hole (unstable) in each block
+    std::vector< size_t >       mMoverOffsets   ;   ///< For unstable compaction, offset of first mover in each block
+    std::vector< uint32_t >     mHoles          ;   ///< For unstable compaction, indices of dead particles below the new size
+    std::vector< uint32_t >     mMovers         ;   ///< For unstable compaction, indices of survivors at or above the new size
+    std::vector< ParticleT >    mScratch        ;   ///< For stable compaction, destination array, retained between calls
+    size_t                      mNumDead        ;   ///< Number of particles flagged by most recent MarkIf
+    bool                        mStable         ;   ///< Whether most recent Compact was stable
+} ;
+
+template< class ParticleT > const size_t ParticleCompaction< ParticleT >::sBlockSize ;
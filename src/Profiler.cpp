@@ -0,0 +1,380 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+/// Marked block recorded while tracing
+struct TraceEvent
+{
+    size_t      mSection    ;   ///< Index of section
+    uint64_t    mStart      ;   ///< Clock reading when block began
+    uint64_t    mEnd        ;   ///< Clock reading when block ended
+    uint64_t    mRangeBegin ;   ///< Start of range of work block covered, or Profiler::sNoRange
+    uint64_t    mRangeEnd   ;   ///< End of range of work block covered
+} ;
+
+/*! \brief Running totals of one thread
+
+    Only the owning thread writes these, so it updates them with plain
+    relaxed loads and stores.  They are atomic so EndFrame can read them
+    concurrently.
+ */
+struct ThreadTally
+{
+    explicit ThreadTally( size_t threadIndex )
+        : mThreadIndex( threadIndex )
+    {
+        for( size_t iSection = 0 ; iSection < Profiler::sMaxSections ; ++ iSection )
+        {
+            mNanoseconds[ iSection ].store( 0 , std::memory_order_relaxed ) ;
+            mCalls[ iSection ].store( 0 , std::memory_order_relaxed ) ;
+        }
+    }
+
+    std::atomic< uint64_t >     mNanoseconds[ Profiler::sMaxSections ]  ;   ///< Time spent in each section
+    std::atomic< uint64_t >     mCalls[ Profiler::sMaxSections ]        ;   ///< Number of times each section ran
+    size_t                      mThreadIndex                            ;   ///< Order in which thread first recorded, used as trace thread id
+    std::vector< TraceEvent >   mEvents                                 ;   ///< Events recorded while tracing, since they were last written
+} ;
+
+/// State shared by all threads, guarded by mMutex except for the thread tallies' counters.
+struct ProfilerState
+{
+    ProfilerState()
+        : mNumSections( 0 )
+        , mWindow( 60 )
+        , mNumFramesInWindow( 0 )
+        , mNextInWindow( 0 )
+        , mFrameLog( nullptr )
+        , mTracing( false )
+        , mTrace( nullptr )
+        , mTraceStart( 0 )
+        , mNumTraceEvents( 0 )
+        , mNumThreadsNamed( 0 )
+    {
+        memset( mPrevNanoseconds , 0 , sizeof( mPrevNanoseconds ) ) ;
+        memset( mPrevCalls , 0 , sizeof( mPrevCalls ) ) ;
+        memset( mLastNanoseconds , 0 , sizeof( mLastNanoseconds ) ) ;
+        mHistory.resize( mWindow * Profiler::sMaxSections ) ;
+    }
+
+    ~ProfilerState()
+    {
+        if( mFrameLog ) fclose( mFrameLog ) ;
+        if( mTrace ) fclose( mTrace ) ;
+    }
+
+    std::mutex                                      mMutex                                      ;   ///< Guards everything but tally counters
+    std::vector< std::unique_ptr< ThreadTally > >   mTallies                                    ;   ///< Tally of each thread that has recorded, kept after the thread exits
+    std::vector< std::string >                      mNames                                      ;   ///< Name of each section
+    size_t                                          mNumSections                                ;   ///< Number of sections registered
+    uint64_t                                        mPrevNanoseconds[ Profiler::sMaxSections ]  ;   ///< Total time of each section as of previous EndFrame
+    uint64_t                                        mPrevCalls[ Profiler::sMaxSections ]        ;   ///< Total calls of each section as of previous EndFrame
+    uint64_t                                        mLastNanoseconds[ Profiler::sMaxSections ]  ;   ///< Time of each section in most recent frame
+    size_t                                          mWindow                                     ;   ///< Number of frames in rolling window
+    size_t                                          mNumFramesInWindow                          ;   ///< Number of frames recorded in rolling window, up to mWindow
+    size_t                                          mNextInWindow                               ;   ///< Index of window slot to fill next
+    std::vector< uint64_t >                         mHistory                                    ;   ///< Per-frame time of each section, mWindow rows of sMaxSections
+    FILE *                                          mFrameLog                                   ;   ///< Per-frame CSV log, or nullptr
+    std::atomic< bool >                             mTracing                                    ;   ///< Whether threads record trace events
+    FILE *                                          mTrace                                      ;   ///< Trace-event JSON file, or nullptr
+    uint64_t                                        mTraceStart                                 ;   ///< Clock reading when trace started
+    size_t                                          mNumTraceEvents                             ;   ///< Number of events written to trace
+    size_t                                          mNumThreadsNamed                            ;   ///< Number of threads whose names were written to trace
+} ;
+
+ProfilerState & GetState()
+{   // Constructed on first use, so sections registered during static initialization find it.
+    static ProfilerState sState ;
+    return sState ;
+}
+
+ThreadTally & GetThreadTally()
+{
+    thread_local ThreadTally * tTally = nullptr ;
+    if( ! tTally )
+    {   // First record from this thread, so add its tally to the list.
+        ProfilerState & state = GetState() ;
+        std::lock_guard< std::mutex > lock( state.mMutex ) ;
+        state.mTallies.emplace_back( new ThreadTally( state.mTallies.size() ) ) ;
+        tTally = state.mTallies.back().get() ;
+    }
+    return * tTally ;
+}
+
+/// Sum totals of all threads.  Caller must hold the state mutex.
+void SumTallies( uint64_t nanoseconds[ Profiler::sMaxSections ] , uint64_t calls[ Profiler::sMaxSections ] )
+{
+    const ProfilerState & state = GetState() ;
+    memset( nanoseconds , 0 , sizeof( uint64_t ) * Profiler::sMaxSections ) ;
+    memset( calls , 0 , sizeof( uint64_t ) * Profiler::sMaxSections ) ;
+    for( const std::unique_ptr< ThreadTally > & pTally : state.mTallies )
+    {
+        for( size_t iSection = 0 ; iSection < state.mNumSections ; ++ iSection )
+        {
+            nanoseconds[ iSection ] += pTally->mNanoseconds[ iSection ].load( std::memory_order_relaxed ) ;
+            calls[ iSection ]       += pTally->mCalls[ iSection ].load( std::memory_order_relaxed ) ;
+        }
+    }
+}
+
+/// Begin a trace event, separating it from the previous one.  Caller must hold the state mutex.
+void BeginTraceEvent()
+{
+    ProfilerState & state = GetState() ;
+    fprintf( state.mTrace , ( state.mNumTraceEvents > 0 ) ? ",\n" : "\n" ) ;
+    ++ state.mNumTraceEvents ;
+}
+
+/// Convert a clock reading to trace time, in microseconds.
+double TraceMicroseconds( uint64_t clock )
+{
+    return 1.0e-3 * double( int64_t( clock - GetState().mTraceStart ) ) ;
+}
+
+/*! \brief Write events buffered by all threads to the trace file
+
+    Caller must hold the state mutex, and no marked block may be running.
+ */
+void WriteTraceEvents()
+{
+    ProfilerState & state = GetState() ;
+    for( ; state.mNumThreadsNamed < state.mTallies.size() ; ++ state.mNumThreadsNamed )
+    {   // Name threads that recorded since last time.
+        BeginTraceEvent() ;
+        fprintf( state.mTrace , "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%llu,\"args\":{\"name\":\"thread %llu\"}}"
+                , (unsigned long long) state.mNumThreadsNamed , (unsigned long long) state.mNumThreadsNamed ) ;
+    }
+    for( const std::unique_ptr< ThreadTally > & pTally : state.mTallies )
+    {
+        for( const TraceEvent & rEvent : pTally->mEvents )
+        {   // Section names come from identifiers, so they need no escaping.
+            BeginTraceEvent() ;
+            fprintf( state.mTrace , "{\"name\":\"%s\",\"cat\":\"vortonsim\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%llu"
+                    , state.mNames[ rEvent.mSection ].c_str() , TraceMicroseconds( rEvent.mStart ) , 1.0e-3 * double( rEvent.mEnd - rEvent.mStart )
+                    , (unsigned long long) pTally->mThreadIndex ) ;
+            if( rEvent.mRangeBegin != Profiler::sNoRange )
+            {
+                fprintf( state.mTrace , ",\"args\":{\"begin\":%llu,\"end\":%llu}" , (unsigned long long) rEvent.mRangeBegin , (unsigned long long) rEvent.mRangeEnd ) ;
+            }
+            fprintf( state.mTrace , "}" ) ;
+        }
+        pTally->mEvents.clear() ;
+    }
+}
+
+/// Compute statistics.  Caller must hold the state mutex.
+void ComputeStats( std::vector< Profiler::SectionStats > & stats )
+{
+    const ProfilerState & state = GetState() ;
+    uint64_t totalNanoseconds[ Profiler::sMaxSections ] ;
+    uint64_t totalCalls[ Profiler::sMaxSections ] ;
+    SumTallies( totalNanoseconds , totalCalls ) ;
+    stats.resize( state.mNumSections ) ;
+    for( size_t iSection = 0 ; iSection < state.mNumSections ; ++ iSection )
+    {
+        Profiler::SectionStats & rStats = stats[ iSection ] ;
+        rStats.mName    = state.mNames[ iSection ] ;
+        rStats.mCalls   = totalCalls[ iSection ] ;
+        rStats.mLastMs  = 1.0e-6 * double( state.mLastNanoseconds[ iSection ] ) ;
+        rStats.mTotalMs = 1.0e-6 * double( totalNanoseconds[ iSection ] ) ;
+        uint64_t sum = 0 , least = UINT64_MAX , most = 0 ;
+        for( size_t iFrame = 0 ; iFrame < state.mNumFramesInWindow ; ++ iFrame )
+        {
+            const uint64_t nanoseconds = state.mHistory[ iFrame * Profiler::sMaxSections + iSection ] ;
+            sum     += nanoseconds ;
+            least   = std::min( least , nanoseconds ) ;
+            most    = std::max( most , nanoseconds ) ;
+        }
+        const bool bAny = state.mNumFramesInWindow > 0 ;
+        rStats.mMeanMs  = bAny ? 1.0e-6 * double( sum ) / double( state.mNumFramesInWindow ) : 0.0 ;
+        rStats.mMinMs   = bAny ? 1.0e-6 * double( least ) : 0.0 ;
+        rStats.mMaxMs   = 1.0e-6 * double( most ) ;
+    }
+}
+
+} // namespace
+
+size_t Profiler::RegisterSection( const char * name )
+{
+    ProfilerState & state = GetState() ;
+    std::lock_guard< std::mutex > lock( state.mMutex ) ;
+    for( size_t iSection = 0 ; iSection < state.mNumSections ; ++ iSection )
+    {   // Markers with the same name share a section.
+        if( state.mNames[ iSection ] == name ) return iSection ;
+    }
+    if( state.mNumSections == sMaxSections ) return sMaxSections ;
+    state.mNames.push_back( name ) ;
+    return state.mNumSections ++ ;
+}
+
+void Profiler::Record( size_t iSection , uint64_t start , uint64_t end , uint64_t rangeBegin , uint64_t rangeEnd )
+{
+    if( iSection >= sMaxSections ) return ;
+    ThreadTally & tally = GetThreadTally() ;
+    // Only this thread writes its tally, so no read-modify-write is needed.
+    tally.mNanoseconds[ iSection ].store( tally.mNanoseconds[ iSection ].load( std::memory_order_relaxed ) + ( end - start ) , std::memory_order_relaxed ) ;
+    tally.mCalls[ iSection ].store( tally.mCalls[ iSection ].load( std::memory_order_relaxed ) + 1 , std::memory_order_relaxed ) ;
+    if( GetState().mTracing.load( std::memory_order_relaxed ) )
+    {   // Buffer event for EndFrame to write.  Capacity persists, so this allocates only while the buffer grows.
+        const TraceEvent event = { iSection , start , end , rangeBegin , rangeEnd } ;
+        tally.mEvents.push_back( event ) ;
+    }
+}
+
+void Profiler::EndFrame( uint64_t uFrame )
+{
+    ProfilerState & state = GetState() ;
+    std::lock_guard< std::mutex > lock( state.mMutex ) ;
+    uint64_t totalNanoseconds[ sMaxSections ] ;
+    uint64_t totalCalls[ sMaxSections ] ;
+    SumTallies( totalNanoseconds , totalCalls ) ;
+    uint64_t * pWindowRow = & state.mHistory[ state.mNextInWindow * sMaxSections ] ;
+    for( size_t iSection = 0 ; iSection < state.mNumSections ; ++ iSection )
+    {
+        const uint64_t nanoseconds  = totalNanoseconds[ iSection ] - state.mPrevNanoseconds[ iSection ] ;
+        const uint64_t calls        = totalCalls[ iSection ] - state.mPrevCalls[ iSection ] ;
+        state.mLastNanoseconds[ iSection ]  = nanoseconds ;
+        state.mPrevNanoseconds[ iSection ]  = totalNanoseconds[ iSection ] ;
+        state.mPrevCalls[ iSection ]        = totalCalls[ iSection ] ;
+        pWindowRow[ iSection ]              = nanoseconds ;
+        if( state.mFrameLog && ( calls > 0 ) )
+        {
+            fprintf( state.mFrameLog , "%llu,%s,%.6f,%llu\n" , (unsigned long long) uFrame , state.mNames[ iSection ].c_str() , 1.0e-6 * double( nanoseconds ) , (unsigned long long) calls ) ;
+        }
+    }
+    state.mNextInWindow         = ( state.mNextInWindow + 1 ) % state.mWindow ;
+    state.mNumFramesInWindow    = std::min( state.mNumFramesInWindow + 1 , state.mWindow ) ;
+
+    if( state.mTrace )
+    {   // Write this frame's events, then mark the frame boundary across all threads.
+        WriteTraceEvents() ;
+        BeginTraceEvent() ;
+        fprintf( state.mTrace , "{\"name\":\"frame %llu\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":0}" , (unsigned long long) uFrame , TraceMicroseconds( Now() ) ) ;
+        fflush( state.mTrace ) ;
+    }
+}
+
+bool Profiler::StartTrace( const std::string & path )
+{
+    ProfilerState & state = GetState() ;
+    std::lock_guard< std::mutex > lock( state.mMutex ) ;
+    if( state.mTrace ) return false ;
+    state.mTrace = fopen( path.c_str() , "w" ) ;
+    if( ! state.mTrace ) return false ;
+    for( const std::unique_ptr< ThreadTally > & pTally : state.mTallies )
+    {   // Discard events left over from a previous trace.
+        pTally->mEvents.clear() ;
+    }
+    fprintf( state.mTrace , "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" ) ;
+    state.mTraceStart       = Now() ;
+    state.mNumTraceEvents   = 0 ;
+    state.mNumThreadsNamed  = 0 ;
+    state.mTracing.store( true , std::memory_order_relaxed ) ;
+    return true ;
+}
+
+void Profiler::StopTrace()
+{
+    ProfilerState & state = GetState() ;
+    std::lock_guard< std::mutex > lock( state.mMutex ) ;
+    if( ! state.mTrace ) return ;
+    state.mTracing.store( false , std::memory_order_relaxed ) ;
+    WriteTraceEvents() ;
+    fprintf( state.mTrace , "\n]}\n" ) ;
+    fclose( state.mTrace ) ;
+    state.mTrace = nullptr ;
+}
+
+bool Profiler::IsTracing()
+{
+    ProfilerState & state = GetState() ;
+    std::lock_guard< std::mutex > lock( state.mMutex ) ;
+    return state.mTrace != nullptr ;
+}
+
+void Profiler::SetWindow( size_t numFrames )
+{
+    ProfilerState & state = GetState() ;
+    std::lock_guard< std::mutex > lock( state.mMutex ) ;
+    state.mWindow               = std::max( size_t( 1 ) , numFrames ) ;
+    state.mNumFramesInWindow    = 0 ;
+    state.mNextInWindow         = 0 ;
+    state.mHistory.assign( state.mWindow * sMaxSections , 0 ) ;
+}
+
+void Profiler::GetStats( std::vector< SectionStats > & stats )
+{
+    std::lock_guard< std::mutex > lock( GetState().mMutex ) ;
+    ComputeStats( stats ) ;
+}
+
+bool Profiler::OpenFrameLog( const std::string & path )
+{
+    ProfilerState & state = GetState() ;
+    std::lock_guard< std::mutex > lock( state.mMutex ) ;
+    if( state.mFrameLog ) fclose( state.mFrameLog ) ;
+    state.mFrameLog = fopen( path.c_str() , "w" ) ;
+    if( ! state.mFrameLog ) return false ;
+    fprintf( state.mFrameLog , "frame,section,ms,calls\n" ) ;
+    return true ;
+}
+
+void Profiler::CloseFrameLog()
+{
+    ProfilerState & state = GetState() ;
+    std::lock_guard< std::mutex > lock( state.mMutex ) ;
+    if( state.mFrameLog ) fclose( state.mFrameLog ) ;
+    state.mFrameLog = nullptr ;
+}
+
+bool Profiler::IsFrameLogOpen()
+{
+    ProfilerState & state = GetState() ;
+    std::lock_guard< std::mutex > lock( state.mMutex ) ;
+    return state.mFrameLog != nullptr ;
+}
+
+bool Profiler::WriteSummaryCsv( const std::string & path )
+{
+    std::vector< SectionStats > stats ;
+    GetStats( stats ) ;
+    FILE * pFile = fopen( path.c_str() , "w" ) ;
+    if( ! pFile ) return false ;
+    fprintf( pFile , "section,calls,last_ms,mean_ms,min_ms,max_ms,total_ms\n" ) ;
+    for( const SectionStats & rStats : stats )
+    {
+        fprintf( pFile , "%s,%llu,%.6f,%.6f,%.6f,%.6f,%.6f\n" , rStats.mName.c_str() , (unsigned long long) rStats.mCalls
+                , rStats.mLastMs , rStats.mMeanMs , rStats.mMinMs , rStats.mMaxMs , rStats.mTotalMs ) ;
+    }
+    return 0 == fclose( pFile ) ;
+}
+
+bool Profiler::WriteSummaryJson( const std::string & path )
+{
+    std::vector< SectionStats > stats ;
+    size_t numFramesInWindow ;
+    {
+        std::lock_guard< std::mutex > lock( GetState().mMutex ) ;
+        ComputeStats( stats ) ;
+        numFramesInWindow = GetState().mNumFramesInWindow ;
+    }
+    FILE * pFile = fopen( path.c_str() , "w" ) ;
+    if( ! pFile ) return false ;
+    // Section names come from identifiers, so they need no escaping.
+    fprintf( pFile , "{\n  \"window_frames\": %llu,\n  \"sections\": [\n" , (unsigned long long) numFramesInWindow ) ;
+    for( size_t iSection = 0 ; iSection < stats.size() ; ++ iSection )
+    {
+        const SectionStats & rStats = stats[ iSection ] ;
+        fprintf( pFile , "    { \"name\": \"%s\", \"calls\": %llu, \"last_ms\": %.6f, \"mean_ms\": %.6f, \"min_ms\": %.6f, \"max_ms\": %.6f, \"total_ms\": %.6f }%s\n"
+                , rStats.mName.c_str() , (unsigned long long) rStats.mCalls , rStats.mLastMs , rStats.mMeanMs , rStats.mMinMs , rStats.mMaxMs , rStats.mTotalMs
+                , ( iSection + 1 < stats.size() ) ? "," : "" ) ;
+    }
+    fprintf( pFile , "  ]\n}\n" ) ;
+    return 0 == fclose( pFile ) ;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Set to 0 to compile PROFILE_SCOPE markers to nothing.
+#ifndef USE_PROFILER
+    #define USE_PROFILER 1
+#endif
+
+/*! \brief Per-phase timing of the simulation, aggregated across threads and frames, optionally traced
+
+ Code marks a phase by placing PROFILE_SCOPE( name ) at the top of a
+ block.  That makes a ProfileScope object, which reads the clock when
+ constructed and again when destroyed, and adds the elapsed time to
+ the section named by the marker.  Sections nest freely, and each
+ reports inclusive time.
+
+ Each thread accumulates into its own table of counters, which only
+ that thread writes, so recording takes no lock and no atomic
+ read-modify-write.  A thread takes a lock once, the first time it
+ records, to add its table to the list EndFrame reads.
+
+ EndFrame, called once per frame by the application, sums the tables
+ of all threads, and the difference from the previous sum gives the
+ time each section took that frame.  Profiler keeps those per-frame
+ times over a rolling window, and can log them to a CSV file every frame.
+ WriteSummaryCsv and WriteSummaryJson report, per section, the latest
+ frame, rolling mean, minimum and maximum, and the running total.
+
+ Between StartTrace and StopTrace, each marked block also becomes an
+ event in a Chrome trace-event JSON file, which chrome://tracing and
+ Perfetto display as a timeline with one track per thread.  Markers
+ made with PROFILE_SCOPE_RANGE, such as those inside parallel_for
+ slices, also record the range of work their block covered, so
+ imbalance between chunks shows up directly.  Each thread buffers its
+ own events, and EndFrame writes them out, so memory stays bounded by
+ one frame of events.
+
+ When USE_PROFILER is 0, PROFILE_SCOPE and PROFILE_SCOPE_RANGE expand
+ to nothing, so marked code carries no cost.
+
+ */
+class Profiler
+{
+public:
+    static const size_t     sMaxSections    = 64 ;          ///< Most distinct sections.  Sections beyond this go unrecorded.
+    static const uint64_t   sNoRange        = UINT64_MAX ;  ///< Range value for blocks that cover no particular range of work
+
+    /// Per-section statistics, in milliseconds
+    struct SectionStats
+    {
+        std::string mName       ;   ///< Name given to PROFILE_SCOPE
+        uint64_t    mCalls      ;   ///< Number of times the section ran, in total
+        double      mLastMs     ;   ///< Time in the most recent frame
+        double      mMeanMs     ;   ///< Mean time per frame over the rolling window
+        double      mMinMs      ;   ///< Least time in a frame over the rolling window
+        double      mMaxMs      ;   ///< Most time in a frame over the rolling window
+        double      mTotalMs    ;   ///< Time over all frames
+    } ;
+
+    /// Return a clock reading, in nanoseconds.
+    static uint64_t Now()
+    {
+        return uint64_t( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count() ) ;
+    }
+
+    /*! \brief Return the index of a section, creating it if it is new
+
+        PROFILE_SCOPE calls this once per marker, when it first runs.
+     */
+    static size_t RegisterSection( const char * name ) ;
+
+    /*! \brief Add time to a section, for the calling thread
+
+        \param start - clock reading when the block began.
+
+        \param end - clock reading when the block ended.
+
+        \param rangeBegin - start of range of work the block covered, or sNoRange.
+
+        \param rangeEnd - end of range of work the block covered.
+     */
+    static void Record( size_t iSection , uint64_t start , uint64_t end , uint64_t rangeBegin = sNoRange , uint64_t rangeEnd = sNoRange ) ;
+
+    /*! \brief Close a frame: compute how long each section took since the previous call
+
+        \param uFrame - frame number, written to the frame log and trace.
+
+        \note When tracing, this must be called while no marked block runs on any thread, for example between simulation updates.
+     */
+    static void EndFrame( uint64_t uFrame ) ;
+
+    /*! \brief Start writing marked blocks as Chrome trace events
+
+        \return true if the file opened.
+     */
+    static bool StartTrace( const std::string & path ) ;
+
+    /*! \brief Write remaining events and close the trace file
+
+        \note Like EndFrame, this must be called while no marked block runs.
+     */
+    static void StopTrace() ;
+    static bool IsTracing() ;
+
+    /// Set number of frames over which rolling statistics are taken.  This restarts the window.
+    static void SetWindow( size_t numFrames ) ;
+
+    /// Return statistics of every section that has run.
+    static void GetStats( std::vector< SectionStats > & stats ) ;
+
+    /*! \brief Start appending each frame's section times to a CSV file, with columns frame,section,ms,calls
+
+        \return true if the file opened.
+     */
+    static bool OpenFrameLog( const std::string & path ) ;
+    static void CloseFrameLog() ;
+    static bool IsFrameLogOpen() ;
+
+    /// Write statistics of every section as CSV, one row per section.  Return true if the file was written.
+    static bool WriteSummaryCsv( const std::string & path ) ;
+
+    /// Write statistics of every section as a JSON object.  Return true if the file was written.
+    static bool WriteSummaryJson( const std::string & path ) ;
+} ;
+
+/*! \brief Time a block of code, adding the time to a Profiler section when the block exits
+ */
+class ProfileScope
+{
+public:
+    explicit ProfileScope( size_t iSection , uint64_t rangeBegin = Profiler::sNoRange , uint64_t rangeEnd = Profiler::sNoRange )
+        : mSection( iSection ) , mRangeBegin( rangeBegin ) , mRangeEnd( rangeEnd ) , mStart( Profiler::Now() ) {}
+    ~ProfileScope() { Profiler::Record( mSection , mStart , Profiler::Now() , mRangeBegin , mRangeEnd ) ; }
+private:
+    ProfileScope( const ProfileScope & ) ;
+    ProfileScope & operator=( const ProfileScope & ) ;
+
+    size_t      mSection    ;   ///< Index of section to which to add time
+    uint64_t    mRangeBegin ;   ///< Start of range of work block covers, for trace events
+    uint64_t    mRangeEnd   ;   ///< End of range of work block covers, for trace events
+    uint64_t    mStart      ;   ///< Clock reading when block entered
+} ;
+
+#define PROFILE_CONCATENATE_IMPL( a , b ) a ## b
+#define PROFILE_CONCATENATE( a , b ) PROFILE_CONCATENATE_IMPL( a , b )
+
+#if USE_PROFILER
+    /// Time the rest of the enclosing block as the section called name.
+    #define PROFILE_SCOPE( name ) PROFILE_SCOPE_RANGE( name , Profiler::sNoRange , Profiler::sNoRange )
+
+    /// Time the rest of the enclosing block as the section called name, which covers work items [ rangeBegin , rangeEnd ).
+    #define PROFILE_SCOPE_RANGE( name , rangeBegin , rangeEnd )                                                                 \
+        static const size_t PROFILE_CONCATENATE( sProfileSection , __LINE__ ) = Profiler::RegisterSection( #name ) ;           \
+        const ProfileScope PROFILE_CONCATENATE( profileScope , __LINE__ )( PROFILE_CONCATENATE( sProfileSection , __LINE__ ) , rangeBegin , rangeEnd )
+#else
+    #define PROFILE_SCOPE( name )
+    #define PROFILE_SCOPE_RANGE( name , rangeBegin , rangeEnd )
+#endif
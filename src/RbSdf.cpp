@@ -0,0 +1,97 @@
+#include "RbSdf.hpp"
+#include <algorithm>
+#include <thread>
+#include <cmath>
+#include "math_helper.hpp"
+#include "TBB_Settings.hpp"
+
+namespace {
+
+/*! \brief Rotate a vector about an axis, using Rodrigues' formula
+
+    \param vVec - vector to rotate.
+
+    \param vAxisAngle - rotation, in axis-angle form: direction is the axis, length is the angle in radians.
+*/
+Vec3 RotateAxisAngle( const Vec3 & vVec , const Vec3 & vAxisAngle )
+{
+    const float angle = vAxisAngle.length() ;
+    if( angle < FLT_EPSILON ) return vVec ;
+    const Vec3      vAxis   = vAxisAngle / angle ;
+    const float     cosA    = cosf( angle ) ;
+    const float     sinA    = sinf( angle ) ;
+    return vVec * cosA + ( vAxis ^ vVec ) * sinA + vAxis * ( vAxis.dot( vVec ) * ( 1.0f - cosA ) ) ;
+}
+
+} // namespace
+
+#if USE_TBB
+/*! \brief Function object to update signed-distance-field bodies using Threading Building Blocks
+ */
+class RbSdf_UpdateSystem_TBB
+{
+    std::vector< RbSdf > &  mBodies     ;   ///< Bodies to update
+    const float &           mTimeStep   ;   ///< Change in virtual time since last update
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Update subset of bodies.
+        for( size_t uBody = r.begin() ; uBody < r.end() ; ++ uBody )
+        {
+            mBodies[ uBody ].Update( mTimeStep ) ;
+        }
+    }
+    RbSdf_UpdateSystem_TBB( std::vector< RbSdf > & bodies , const float & timeStep )
+    : mBodies( bodies )
+    , mTimeStep( timeStep )
+    {}
+} ;
+#endif
+
+RbSdf::RbSdf() :
+RigidBody()
+{}
+
+RbSdf::RbSdf( const Vec3 & vPos , const Vec3 & vVelocity , const float & fMass , const std::shared_ptr< const SignedDistanceField > & pShape ) :
+RigidBody(vPos, vVelocity, fMass), mShape(pShape)
+{
+    // RigidBody::Update treats the inertia tensor as fixed in world space,
+    // so use principal moments only, which is exact for shapes symmetric
+    // about the body axes, and a plausible approximation otherwise.
+    const Vec3 vMoments = mShape->ComputeMomentsOfInertia( fMass ) ;
+    for( size_t i = 0 ; i < 3 ; ++ i )
+    {
+        if( vMoments[ i ] > 0.0f )
+        {
+            mInertiaInv( i , i ) = 1.0f / vMoments[ i ] ;
+        }
+    }
+}
+
+bool RbSdf::QuerySurface( float & distance , Vec3 & vNormal , const Vec3 & vPosition ) const
+{
+    // Transform query point into body space.
+    const Vec3 vPosBody = RotateAxisAngle( vPosition - mPosition , - mOrientation ) ;
+    SdfSample sample ;
+    if( ! mShape->Query( sample , vPosBody ) )
+    {   // Query point lies beyond the sampled margin, so it is farther than the margin from the surface.
+        return false ;
+    }
+    distance    = sample.mDistance ;
+    // Transform gradient back into world space.
+    vNormal     = RotateAxisAngle( sample.mGradient , mOrientation ).getNormalized() ;
+    return true ;
+}
+
+/* static */void RbSdf::UpdateSystem(std::vector<RbSdf> &rbSdfs, float timeStep, size_t uFrame) {
+    (void) uFrame ;
+    // Each body updates independently, so bodies can update concurrently.
+#if USE_TBB
+    const size_t numBodies = rbSdfs.size() ;
+    // Estimate grain size based on size of problem and number of processors.
+    const size_t grainSize = std::max( size_t( 1 ) , numBodies / std::thread::hardware_concurrency() ) ;
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numBodies , grainSize ) , RbSdf_UpdateSystem_TBB( rbSdfs , timeStep ) ) ;
+#else
+    for(auto & aBody: rbSdfs)
+        aBody.Update(timeStep);
+#endif
+}
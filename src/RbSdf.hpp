@@ -0,0 +1,29 @@
+#pragma once
+#include <memory>
+#include "RigidBody.hpp"
+#include "SignedDistanceField.hpp"
+
+/*! \brief Rigid body whose shape is given by a signed distance field
+
+ Fluid interacts with this body through QuerySurface, which costs
+ one interpolation of the field regardless of the shape, so this
+ supports boxes, capsules, meshes, or anything else that has a
+ signed distance function.
+
+ */
+class RbSdf: public RigidBody {
+public:
+    RbSdf();
+    RbSdf( const Vec3 & vPos , const Vec3 & vVelocity , const float & fMass , const std::shared_ptr< const SignedDistanceField > & pShape );
+
+    static void UpdateSystem( std::vector< RbSdf > & rbSdfs , float timeStep , size_t uFrame ) ;
+
+    bool QuerySurface( float & distance , Vec3 & vNormal , const Vec3 & vPosition ) const override ;
+
+    float GetBoundingRadius() const override { return mShape ? mShape->GetBoundingRadius() : 0.0f ; }
+
+    const std::shared_ptr< const SignedDistanceField > & GetShape() const { return mShape ; }
+
+private:
+    std::shared_ptr< const SignedDistanceField > mShape ;   ///< Shape of this body, in body space
+};
@@ -1,10 +1,35 @@
 #include "RbSphere.hpp"
+#include <algorithm>
+#include <thread>
+#include "TBB_Settings.hpp"
+
+#if USE_TBB
+/*! \brief Function object to update rigid spheres using Threading Building Blocks
+ */
+class RbSphere_UpdateSystem_TBB
+{
+    std::vector< RbSphere > &   mSpheres    ;   ///< Spheres to update
+    const float &               mTimeStep   ;   ///< Change in virtual time since last update
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Update subset of spheres.
+        for( size_t uSphere = r.begin() ; uSphere < r.end() ; ++ uSphere )
+        {
+            mSpheres[ uSphere ].Update( mTimeStep ) ;
+        }
+    }
+    RbSphere_UpdateSystem_TBB( std::vector< RbSphere > & spheres , const float & timeStep )
+    : mSpheres( spheres )
+    , mTimeStep( timeStep )
+    {}
+} ;
+#endif
 
 RbSphere::RbSphere() :
 RigidBody(), mRadius(0.f)
 {}
 
-RbSphere::RbSphere( const ofVec3f & vPos , const ofVec3f & vVelocity , const float & fMass , const float & fRadius ) :
+RbSphere::RbSphere( const Vec3 & vPos , const Vec3 & vVelocity , const float & fMass , const float & fRadius ) :
 RigidBody(vPos, vVelocity, fMass), mRadius(fRadius)
 {
     // Moments of inertia for a sphere are 2 M R^2 / 5.
@@ -12,7 +37,15 @@ RigidBody(vPos, vVelocity, fMass), mRadius(fRadius)
 }
 
 /* static */void RbSphere::UpdateSystem(std::vector<RbSphere> &rbSpheres, float timeStep, size_t uFrame) {
+    // Each sphere updates independently, so spheres can update concurrently.
+#if USE_TBB
+    const size_t numSpheres = rbSpheres.size() ;
+    // Estimate grain size based on size of problem and number of processors.
+    const size_t grainSize = std::max( size_t( 1 ) , numSpheres / std::thread::hardware_concurrency() ) ;
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numSpheres , grainSize ) , RbSphere_UpdateSystem_TBB( rbSpheres , timeStep ) ) ;
+#else
     for(auto & aSphere: rbSpheres)
         aSphere.Update(timeStep);
+#endif
 }
 
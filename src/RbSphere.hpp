@@ -4,9 +4,20 @@
 class RbSphere: public RigidBody {
 public:
     RbSphere();
-    RbSphere( const ofVec3f & vPos , const ofVec3f & vVelocity , const float & fMass , const float & fRadius );
+    RbSphere( const Vec3 & vPos , const Vec3 & vVelocity , const float & fMass , const float & fRadius );
     
     static void UpdateSystem( std::vector< RbSphere > & rbSpheres , float timeStep , size_t uFrame ) ;
 
+    bool QuerySurface( float & distance , Vec3 & vNormal , const Vec3 & vPosition ) const override
+    {
+        const Vec3      vCenterToPos    = vPosition - mPosition ;
+        const float     centerToPos     = vCenterToPos.length() ;
+        distance    = centerToPos - mRadius ;
+        vNormal     = vCenterToPos / centerToPos ;
+        return true ;
+    }
+
+    float GetBoundingRadius() const override { return mRadius ; }
+
     float mRadius;
 };
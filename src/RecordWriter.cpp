@@ -0,0 +1,93 @@
+#include "RecordWriter.hpp"
+#include <algorithm>
+
+RecordWriter::RecordWriter()
+    : mFile( nullptr )
+    , mMaxQueuedRecords( 0 )
+    , mClosing( false )
+    , mWriteFailed( false )
+{
+}
+
+bool RecordWriter::Open( const std::string & path , size_t maxQueuedRecords )
+{
+    Close() ;
+    mFile = fopen( path.c_str() , "wb" ) ;
+    if( ! mFile ) return false ;
+    mMaxQueuedRecords   = std::max( size_t( 1 ) , maxQueuedRecords ) ;
+    mClosing            = false ;
+    mWriteFailed        = false ;
+    mThread = std::thread( & RecordWriter::WriteQueuedRecords , this ) ;
+    return true ;
+}
+
+bool RecordWriter::Reserve( std::vector< char > & buffer , bool bWait )
+{
+    if( ! mFile ) return false ;
+    std::unique_lock< std::mutex > lock( mMutex ) ;
+    if( bWait )
+    {
+        mQueueChanged.wait( lock , [ this ]() { return mWriteFailed || ( mQueue.size() < mMaxQueuedRecords ) ; } ) ;
+    }
+    if( mWriteFailed || ( mQueue.size() >= mMaxQueuedRecords ) ) return false ;
+    // Only the calling thread adds to the queue, so it still has room when Push runs.
+    buffer.clear() ;
+    if( ! mSpareBuffers.empty() )
+    {
+        buffer.swap( mSpareBuffers.back() ) ;
+        mSpareBuffers.pop_back() ;
+        buffer.clear() ;
+    }
+    return true ;
+}
+
+void RecordWriter::Push( std::vector< char > & buffer )
+{
+    {
+        std::lock_guard< std::mutex > lock( mMutex ) ;
+        mQueue.push_back( std::move( buffer ) ) ;
+    }
+    buffer = std::vector< char >() ;
+    mQueueChanged.notify_all() ;
+}
+
+void RecordWriter::WriteQueuedRecords()
+{
+    std::unique_lock< std::mutex > lock( mMutex ) ;
+    for( ;; )
+    {
+        mQueueChanged.wait( lock , [ this ]() { return mClosing || ! mQueue.empty() ; } ) ;
+        if( mQueue.empty() )
+        {   // Closing and nothing left to write.
+            return ;
+        }
+        std::vector< char > record( std::move( mQueue.front() ) ) ;
+
+        // Write without holding the lock, so the producer can queue more records meanwhile.
+        // Only this thread sets mWriteFailed, so reading it here without the lock is safe.
+        lock.unlock() ;
+        const bool bWritten = mWriteFailed || ( fwrite( record.data() , 1 , record.size() , mFile ) == record.size() ) ;
+        lock.lock() ;
+
+        mQueue.pop_front() ;   // Pop only after writing, so Reserve( , true ) waits for the disk, not just the hand-off.
+        mWriteFailed = mWriteFailed || ! bWritten ;
+        mSpareBuffers.push_back( std::move( record ) ) ;
+        mQueueChanged.notify_all() ;
+    }
+}
+
+bool RecordWriter::Close()
+{
+    if( ! mFile ) return ! mWriteFailed ;
+    {
+        std::lock_guard< std::mutex > lock( mMutex ) ;
+        mClosing = true ;
+    }
+    mQueueChanged.notify_all() ;
+    mThread.join() ;
+    const bool bClosed = 0 == fclose( mFile ) ;
+    mFile = nullptr ;
+    mQueue.clear() ;
+    mWriteFailed = mWriteFailed || ! bClosed ;
+    return ! mWriteFailed ;
+}
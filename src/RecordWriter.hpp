@@ -0,0 +1,77 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*! \brief Append records to a file on a background thread
+
+ The producer gets a buffer with Reserve, fills it, and hands it over
+ with Push.  A writer thread writes queued buffers in order, then
+ returns them for reuse, so steady-state output allocates nothing.
+
+ The queue is bounded.  Reserve can either fail when the queue is
+ full, so a simulation can drop output rather than wait on the disk,
+ or wait for room, for records that must not be lost.
+
+ Reserve and Push must be called from a single thread.
+
+ */
+class RecordWriter
+{
+public:
+    RecordWriter() ;
+    ~RecordWriter() { Close() ; }
+    RecordWriter( const RecordWriter & ) = delete ;
+    RecordWriter & operator=( const RecordWriter & ) = delete ;
+
+    /*! \brief Create a file and start its writer thread
+
+        \param path - file to create.  Any existing file gets replaced.
+
+        \param maxQueuedRecords - number of records that can wait to be written.
+
+        \return true if the file was created.
+    */
+    bool Open( const std::string & path , size_t maxQueuedRecords ) ;
+
+    /*! \brief Get an empty buffer for the next record, if the queue has room
+
+        \param buffer - (output) empty buffer, which may have capacity from a previous record.
+
+        \param bWait - whether to wait for room if the queue is full.
+
+        \return true if the caller may fill buffer and Push it, false if
+                the queue is full (and bWait is false), a write failed,
+                or no file is open.
+    */
+    bool Reserve( std::vector< char > & buffer , bool bWait ) ;
+
+    /// Queue a buffer, obtained from Reserve, to be written.
+    void Push( std::vector< char > & buffer ) ;
+
+    /*! \brief Write queued records, then close the file
+
+        \return true if every record was written.
+    */
+    bool Close() ;
+
+    bool IsOpen() const { return nullptr != mFile ; }
+
+private:
+    void WriteQueuedRecords() ;
+
+    FILE *                              mFile               ;   ///< File being written, or nullptr when closed
+    std::thread                         mThread             ;   ///< Thread writing queued records
+    std::mutex                          mMutex              ;   ///< Guards members below
+    std::condition_variable             mQueueChanged       ;   ///< Signals records queued, records written, or closing
+    std::deque< std::vector< char > >   mQueue              ;   ///< Records waiting to be written
+    std::vector< std::vector< char > >  mSpareBuffers       ;   ///< Written buffers, for reuse
+    size_t                              mMaxQueuedRecords   ;   ///< Capacity of mQueue
+    bool                                mClosing            ;   ///< Whether Close asked the writer thread to finish
+    bool                                mWriteFailed        ;   ///< Whether a write failed
+} ;
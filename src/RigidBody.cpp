@@ -13,7 +13,7 @@ RigidBody::RigidBody()
 , mAngMomentum( 0.0f , 0.0f , 0.0f )
 {}
 
-RigidBody::RigidBody( const ofVec3f & vPos , const ofVec3f & vVelocity , const float & fMass )
+RigidBody::RigidBody( const Vec3 & vPos , const Vec3 & vVelocity , const float & fMass )
 : mPosition( vPos )
 , mVelocity( vVelocity )
 , mOrientation( 0.0f , 0.0f , 0.0f )
@@ -27,27 +27,27 @@ RigidBody::RigidBody( const ofVec3f & vPos , const ofVec3f & vVelocity , const f
 {
 }
 
-void RigidBody::ApplyForce( const ofVec3f & vForce , const ofVec3f & vPosition) {
+void RigidBody::ApplyForce( const Vec3 & vForce , const Vec3 & vPosition) {
     mForce += vForce ;                  // Accumulate forces
-    const ofVec3f vPosRelBody = vPosition - mPosition ;
+    const Vec3 vPosRelBody = vPosition - mPosition ;
     mTorque += vPosRelBody.getCrossed(vForce) ;   // Accumulate torques
 }
 
-void RigidBody::ApplyImpulse( const ofVec3f & vImpulse )
+void RigidBody::ApplyImpulse( const Vec3 & vImpulse )
 {
     mMomentum  += vImpulse ;                    // Apply impulse
     mVelocity   = mInverseMass * mMomentum ;    // Update linear velocity accordingly
 }
 
-void RigidBody::ApplyImpulse( const ofVec3f & vImpulse , const ofVec3f & vPosition )
+void RigidBody::ApplyImpulse( const Vec3 & vImpulse , const Vec3 & vPosition )
 {
     mMomentum += vImpulse ;                         // Apply impulse
     mVelocity   = mInverseMass * mMomentum ;        // Update linear velocity accordingly
-    const ofVec3f vPosRelBody = vPosition - mPosition ;
+    const Vec3 vPosRelBody = vPosition - mPosition ;
     ApplyImpulsiveTorque( vPosRelBody.getCrossed(vImpulse) ) ;
 }
 
-void RigidBody::ApplyImpulsiveTorque( const ofVec3f & vImpulsiveTorque )
+void RigidBody::ApplyImpulsiveTorque( const Vec3 & vImpulsiveTorque )
 {
     mAngMomentum += vImpulsiveTorque ;          // Apply impulsive torque
     mAngVelocity = mInertiaInv * mAngMomentum ; // Update angular velocity accordingly
@@ -82,7 +82,7 @@ void RigidBody::Update( const float & timeStep )
     mOrientation += mAngVelocity * timeStep ; // This is a weird hack but it serves our purpose for this situation.
     
     // Zero out force and torque accumulators, for next update.
-    mForce = mTorque = ofVec3f( 0.0f , 0.0f , 0.0f ) ;
+    mForce = mTorque = Vec3( 0.0f , 0.0f , 0.0f ) ;
 }
 
 void RigidBody::UpdateSystem( std::vector< RigidBody > & rigidBodies , float timeStep) {
@@ -1,33 +1,56 @@
 #pragma once
 #include <vector>
 
-#include "ofVec3f.h"
+#include "Vec3.hpp"
 #include "Mat3.hpp"
 
 class RigidBody{
 public:
     RigidBody();
-    RigidBody( const ofVec3f & vPos , const ofVec3f & vVelocity , const float & fMass );
+    RigidBody( const Vec3 & vPos , const Vec3 & vVelocity , const float & fMass );
+    virtual ~RigidBody() {}
     
-    ofVec3f     mPosition       ;   ///< Position (in world units) of center of vortex particle
-    ofVec3f     mVelocity       ;   ///< Linear velocity of sphere
-    ofVec3f     mOrientation    ;   ///< Orientation of sphere in axis-angle form
-    ofVec3f     mAngVelocity    ;   ///< Angular velocity of sphere
+    Vec3        mPosition       ;   ///< Position (in world units) of center of vortex particle
+    Vec3        mVelocity       ;   ///< Linear velocity of sphere
+    Vec3        mOrientation    ;   ///< Orientation of sphere in axis-angle form
+    Vec3        mAngVelocity    ;   ///< Angular velocity of sphere
     
+    const float & GetInverseMass() const { return mInverseMass ; }
+
+    /*! \brief Find distance from body surface to a point, and surface normal nearest that point
+
+        \param distance - (output) signed distance from surface to vPosition: negative inside the body.
+
+        \param vNormal - (output) unit outward surface normal nearest vPosition, in world space.
+
+        \param vPosition - query point, in world space.
+
+        \return false if vPosition lies too far from the body for this query to know the answer,
+                in which case outputs are not assigned.
+     */
+    virtual bool QuerySurface( float & distance , Vec3 & vNormal , const Vec3 & vPosition ) const
+    {
+        (void) distance ; (void) vNormal ; (void) vPosition ;
+        return false ;
+    }
+
+    /// Return radius of sphere, centered on mPosition, that encloses this body
+    virtual float GetBoundingRadius() const { return 0.0f ; }
+
     /// Apply a force to a rigid body at a given location
-    void ApplyForce( const ofVec3f & vForce , const ofVec3f & vPosition );
+    void ApplyForce( const Vec3 & vForce , const Vec3 & vPosition );
     
     
     /// Apply an impulse to a rigid body through its center-of-mass (i.e. without applying a torque
-    void ApplyImpulse( const ofVec3f & vImpulse );
+    void ApplyImpulse( const Vec3 & vImpulse );
     
     
     /// Apply an impulse to a rigid body at a given location
-    void ApplyImpulse( const ofVec3f & vImpulse , const ofVec3f & vPosition );
+    void ApplyImpulse( const Vec3 & vImpulse , const Vec3 & vPosition );
     
     
     /// Apply an impulsive torque to a rigid body
-    void ApplyImpulsiveTorque( const ofVec3f & vImpulsiveTorque );
+    void ApplyImpulsiveTorque( const Vec3 & vImpulsiveTorque );
     
     /*! \brief Update a rigid body from the previous to the next moment in time.
      
@@ -43,9 +66,11 @@ protected:
     Mat3        mInertiaInv     ;   ///< Inverse of inertial tensor
     
 private:
-    ofVec3f     mForce          ;   ///< Total force applied to this body for a single frame.
-    ofVec3f     mTorque         ;   ///< Total torque applied to this body for a single frame.
-    ofVec3f     mMomentum       ;   ///< Linear momentum of sphere
-    ofVec3f     mAngMomentum    ;   ///< Angular momentum of sphere
+    friend class Checkpoint ;
+
+    Vec3        mForce          ;   ///< Total force applied to this body for a single frame.
+    Vec3        mTorque         ;   ///< Total torque applied to this body for a single frame.
+    Vec3        mMomentum       ;   ///< Linear momentum of sphere
+    Vec3        mAngMomentum    ;   ///< Angular momentum of sphere
     
 };
@@ -0,0 +1,88 @@
+#include "SignedDistanceField.hpp"
+#include <cmath>
+#include <algorithm>
+#include "UniformGridMath.hpp"
+
+/* static */ std::shared_ptr< SignedDistanceField > SignedDistanceField::MakeBox( const Vec3 & vHalfExtent , float margin , size_t numCells )
+{
+    std::shared_ptr< SignedDistanceField > pField = std::make_shared< SignedDistanceField >() ;
+    pField->Build( [ & ]( const Vec3 & vPos )
+    {   // Exact signed distance to a box.
+        const Vec3 vQ( fabsf( vPos.x ) - vHalfExtent.x , fabsf( vPos.y ) - vHalfExtent.y , fabsf( vPos.z ) - vHalfExtent.z ) ;
+        const Vec3 vOutside( std::max( vQ.x , 0.0f ) , std::max( vQ.y , 0.0f ) , std::max( vQ.z , 0.0f ) ) ;
+        return vOutside.length() + std::min( std::max( vQ.x , std::max( vQ.y , vQ.z ) ) , 0.0f ) ;
+    } , vHalfExtent , margin , numCells ) ;
+    return pField ;
+}
+
+/* static */ std::shared_ptr< SignedDistanceField > SignedDistanceField::MakeSphere( float radius , float margin , size_t numCells )
+{
+    std::shared_ptr< SignedDistanceField > pField = std::make_shared< SignedDistanceField >() ;
+    pField->Build( [ & ]( const Vec3 & vPos ) { return vPos.length() - radius ; } , Vec3( radius , radius , radius ) , margin , numCells ) ;
+    pField->mBoundingRadius = radius ;
+    return pField ;
+}
+
+/*! \brief Compute gradient of distance and pack it with distance, for Query
+
+    The gradient of an exact signed distance field has unit length,
+    except where the nearest surface point changes abruptly (for example,
+    along the medial axis of a box), so normalize it.  Query interpolates
+    these, so the interpolated gradient is close to, but not exactly, unit length.
+*/
+void SignedDistanceField::PackSamples()
+{
+    UniformGrid< Vec3 > gradient( mDistance ) ;
+    gradient.Init() ;
+    UniformGridMath::ComputeGradient( gradient , mDistance ) ;
+
+    mSamples.CopyShape( mDistance ) ;
+    mSamples.Init() ;
+    const size_t numPoints = mDistance.GetGridCapacity() ;
+    for( size_t offset = 0 ; offset < numPoints ; ++ offset )
+    {
+        SdfSample & rSample = mSamples[ offset ] ;
+        rSample.mDistance = mDistance[ offset ] ;
+        const float gradMag = gradient[ offset ].length() ;
+        rSample.mGradient = ( gradMag > FLT_EPSILON ) ? gradient[ offset ] / gradMag : Vec3( 0.0f , 0.0f , 0.0f ) ;
+    }
+}
+
+bool SignedDistanceField::Query( SdfSample & sample , const Vec3 & vPosBody ) const
+{
+    if( ! mSamples.Encloses( vPosBody ) )
+    {   // Query point lies outside sampled region, so it is farther than the margin from the surface.
+        return false ;
+    }
+    mSamples.Interpolate( sample , vPosBody ) ;
+    return true ;
+}
+
+Vec3 SignedDistanceField::ComputeMomentsOfInertia( float mass ) const
+{
+    const Vec3 & vMinCorner  = mDistance.GetMinCorner() ;
+    const Vec3 & vSpacing    = mDistance.GetCellSpacing() ;
+    const size_t    dims[3]     = { mDistance.GetNumPoints( 0 ) , mDistance.GetNumPoints( 1 ) , mDistance.GetNumPoints( 2 ) } ;
+    Vec3 vSecondMoments( 0.0f , 0.0f , 0.0f ) ;  // Sums of x^2, y^2, z^2 over interior gridpoints
+    size_t  numInside = 0 ;
+    size_t  offset = 0 ;
+    for( size_t iz = 0 ; iz < dims[2] ; ++ iz )
+    for( size_t iy = 0 ; iy < dims[1] ; ++ iy )
+    for( size_t ix = 0 ; ix < dims[0] ; ++ ix )
+    {   // For each gridpoint...
+        if( mDistance[ offset ++ ] < 0.0f )
+        {   // Gridpoint lies inside shape.
+            const Vec3 vPos( vMinCorner.x + float( ix ) * vSpacing.x
+                              , vMinCorner.y + float( iy ) * vSpacing.y
+                              , vMinCorner.z + float( iz ) * vSpacing.z ) ;
+            vSecondMoments += Vec3( vPos.x * vPos.x , vPos.y * vPos.y , vPos.z * vPos.z ) ;
+            ++ numInside ;
+        }
+    }
+    if( 0 == numInside )
+    {
+        return Vec3( 0.0f , 0.0f , 0.0f ) ;
+    }
+    const Vec3 vMean( vSecondMoments / float( numInside ) ) ;
+    return Vec3( vMean.y + vMean.z , vMean.z + vMean.x , vMean.x + vMean.y ) * mass ;
+}
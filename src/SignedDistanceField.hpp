@@ -0,0 +1,119 @@
+#pragma once
+
+#include <memory>
+#include "Vec3.hpp"
+#include "UniformGrid.hpp"
+
+/*! \brief Signed distance and its gradient at a point
+
+    Packing both into one value lets a single trilinear interpolation
+    (UniformGrid::Interpolate) yield distance and surface normal together.
+*/
+struct SdfSample
+{
+    Vec3 mGradient   ;   ///< Gradient of signed distance, which points away from the surface, outward
+    float   mDistance   ;   ///< Signed distance to surface: negative inside, positive outside
+} ;
+
+inline SdfSample operator+( const SdfSample & a , const SdfSample & b )
+{
+    SdfSample result ;
+    result.mGradient = a.mGradient + b.mGradient ;
+    result.mDistance = a.mDistance + b.mDistance ;
+    return result ;
+}
+
+inline SdfSample operator*( float scale , const SdfSample & sample )
+{
+    SdfSample result ;
+    result.mGradient = sample.mGradient * scale ;
+    result.mDistance = sample.mDistance * scale ;
+    return result ;
+}
+
+/*! \brief Shape of a rigid body, represented as a signed distance field sampled on a grid
+
+ The grid lies in body space, centered on the body origin, and extends
+ some margin beyond the shape, so points within that margin of the
+ surface get valid distances.  Querying a point costs one trilinear
+ interpolation no matter how complicated the shape is, so any shape
+ which has a signed distance function (analytic primitives, or
+ distances precomputed from a mesh) costs the same at run time.
+
+ Many bodies can share one field, so bodies refer to it through a shared pointer.
+
+ */
+class SignedDistanceField
+{
+public:
+    /*! \brief Sample a signed distance function onto a grid
+
+        \param signedDistance - function, called as signedDistance( const Vec3 & vPosBody ),
+                returning signed distance from the shape surface, negative inside.
+
+        \param vHalfExtent - half the size of the box, centered on the body origin, that encloses the shape.
+
+        \param margin - distance beyond vHalfExtent to sample.  Must be at least as thick as any
+                boundary layer that queries this field.
+
+        \param numCells - approximate number of grid cells to use.
+     */
+    template< class DistanceFuncT >
+    void Build( const DistanceFuncT & signedDistance , const Vec3 & vHalfExtent , float margin , size_t numCells )
+    {
+        const Vec3 vMargin( margin , margin , margin ) ;
+        mDistance.DefineShape( numCells , - vHalfExtent - vMargin , vHalfExtent + vMargin , false ) ;
+        mDistance.Init() ;
+        const Vec3 & vMinCorner  = mDistance.GetMinCorner() ;
+        const Vec3 & vSpacing    = mDistance.GetCellSpacing() ;
+        const size_t    dims[3]     = { mDistance.GetNumPoints( 0 ) , mDistance.GetNumPoints( 1 ) , mDistance.GetNumPoints( 2 ) } ;
+        size_t offset = 0 ;
+        for( size_t iz = 0 ; iz < dims[2] ; ++ iz )
+        for( size_t iy = 0 ; iy < dims[1] ; ++ iy )
+        for( size_t ix = 0 ; ix < dims[0] ; ++ ix )
+        {   // For each gridpoint...
+            const Vec3 vPosition( vMinCorner.x + float( ix ) * vSpacing.x
+                                   , vMinCorner.y + float( iy ) * vSpacing.y
+                                   , vMinCorner.z + float( iz ) * vSpacing.z ) ;
+            mDistance[ offset ++ ] = signedDistance( vPosition ) ;
+        }
+        mBoundingRadius = vHalfExtent.length() ;
+        PackSamples() ;
+    }
+
+    /// Make a field for a box with the given half-extents
+    static std::shared_ptr< SignedDistanceField > MakeBox( const Vec3 & vHalfExtent , float margin , size_t numCells = 32768 ) ;
+
+    /// Make a field for a sphere with the given radius
+    static std::shared_ptr< SignedDistanceField > MakeSphere( float radius , float margin , size_t numCells = 32768 ) ;
+
+    /*! \brief Query signed distance and its gradient at a point in body space
+
+        \param sample - (output) interpolated distance and gradient.
+
+        \param vPosBody - position, in body space, to query.
+
+        \return false if vPosBody lies outside the sampled region, in which case sample is not assigned.
+     */
+    bool Query( SdfSample & sample , const Vec3 & vPosBody ) const ;
+
+    /// Return radius of sphere, centered on body origin, which encloses the shape (not including margin)
+    float GetBoundingRadius() const { return mBoundingRadius ; }
+
+    const UniformGrid< float > & GetDistanceGrid() const { return mDistance ; }
+
+    /*! \brief Compute principal moments of inertia of the shape, treating it as uniformly dense
+
+        \param mass - mass of the body.
+
+        \return moments of inertia about the body-space x, y and z axes through the origin.
+     */
+    Vec3 ComputeMomentsOfInertia( float mass ) const ;
+
+private:
+    void PackSamples() ;
+
+    UniformGrid< float >        mDistance       ;   ///< Signed distance at each gridpoint, in body space
+    UniformGrid< SdfSample >    mSamples        ;   ///< Signed distance and its gradient at each gridpoint
+    float                       mBoundingRadius ;   ///< Radius of sphere enclosing shape
+} ;
@@ -0,0 +1,373 @@
+#include "StreamlineTracer.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if USE_TBB
+
+/*! \brief Function object to trace blocks of seeds using Threading Building Blocks
+ */
+class StreamlineTracer_TraceBlocks_TBB
+{
+    StreamlineTracer * mTracer ;    ///< Address of StreamlineTracer object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Trace subset of blocks.
+        mTracer->TraceBlocksSlice( r.begin() , r.end() ) ;
+    }
+    StreamlineTracer_TraceBlocks_TBB( StreamlineTracer * pTracer )
+    : mTracer( pTracer ) {}
+} ;
+
+/*! \brief Function object to gather vertices of blocks into one array using Threading Building Blocks
+ */
+class StreamlineTracer_CopyBlocks_TBB
+{
+    StreamlineTracer * mTracer ;    ///< Address of StreamlineTracer object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Copy subset of blocks.
+        mTracer->CopyBlocksSlice( r.begin() , r.end() ) ;
+    }
+    StreamlineTracer_CopyBlocks_TBB( StreamlineTracer * pTracer )
+    : mTracer( pTracer ) {}
+} ;
+#endif
+
+/*! \brief Return smallest cell spacing of a grid
+ */
+static float MinCellSpacing( const UniformGridGeometry & grid )
+{
+    const Vec3 & vSpacing = grid.GetCellSpacing() ;
+    return std::min( std::min( vSpacing.x , vSpacing.y ) , vSpacing.z ) ;
+}
+
+/*! \brief Unit tangent of streamlines through one velocity grid, parameterized by arc length
+ */
+struct SteadyField
+{
+    SteadyField( const UniformGrid< Vec3 > & velGrid , float sign ) : mVelGrid( velGrid ) , mSign( sign ) {}
+
+    bool operator() ( Vec3 & vTangent , const Vec3 & vPosition , float /* arcLength */ ) const
+    {
+        if( ! mVelGrid.Encloses( vPosition ) ) return false ;
+        mVelGrid.Interpolate( vTangent , vPosition ) ;
+        const float speedSq = vTangent.lengthSquared() ;
+        if( speedSq < FLT_MIN ) return false ;
+        vTangent *= mSign / sqrtf( speedSq ) ;
+        return true ;
+    }
+
+    const UniformGrid< Vec3 > & mVelGrid ;  ///< Velocity grid
+    float                       mSign    ;  ///< 1 to run downstream, -1 to run upstream
+} ;
+
+/*! \brief Velocity interpolated linearly in time between a series of velocity grids
+ */
+struct UnsteadyField
+{
+    UnsteadyField( const UniformGrid< Vec3 > * const * velGrids , const float * times , size_t numGrids )
+        : mVelGrids( velGrids ) , mTimes( times ) , mNumGrids( numGrids ) {}
+
+    bool operator() ( Vec3 & vVelocity , const Vec3 & vPosition , float time ) const
+    {
+        if( 1 == mNumGrids )
+        {   // Only one grid, so treat velocity as constant in time.
+            if( ! mVelGrids[ 0 ]->Encloses( vPosition ) ) return false ;
+            mVelGrids[ 0 ]->Interpolate( vVelocity , vPosition ) ;
+            return true ;
+        }
+        if( ( time < mTimes[ 0 ] ) || ( time > mTimes[ mNumGrids - 1 ] ) ) return false ;
+        // Find interval [ mTimes[ i1 - 1 ] , mTimes[ i1 ] ] containing time.
+        size_t i1 = std::upper_bound( mTimes + 1 , mTimes + mNumGrids , time ) - mTimes ;
+        i1 = std::min( i1 , mNumGrids - 1 ) ;
+        const size_t    i0          = i1 - 1 ;
+        const float     interval    = mTimes[ i1 ] - mTimes[ i0 ] ;
+        const float     weight1     = ( interval > 0.0f ) ? ( time - mTimes[ i0 ] ) / interval : 1.0f ;
+        vVelocity = Vec3( 0.0f , 0.0f , 0.0f ) ;
+        if( weight1 < 1.0f )
+        {
+            if( ! mVelGrids[ i0 ]->Encloses( vPosition ) ) return false ;
+            Vec3 vVelocity0 ;
+            mVelGrids[ i0 ]->Interpolate( vVelocity0 , vPosition ) ;
+            vVelocity += vVelocity0 * ( 1.0f - weight1 ) ;
+        }
+        if( weight1 > 0.0f )
+        {
+            if( ! mVelGrids[ i1 ]->Encloses( vPosition ) ) return false ;
+            Vec3 vVelocity1 ;
+            mVelGrids[ i1 ]->Interpolate( vVelocity1 , vPosition ) ;
+            vVelocity += vVelocity1 * weight1 ;
+        }
+        return true ;
+    }
+
+    const UniformGrid< Vec3 > * const * mVelGrids   ;   ///< Velocity grids, in increasing order of time
+    const float *                       mTimes      ;   ///< Time of each grid
+    size_t                              mNumGrids   ;   ///< Number of grids
+} ;
+
+/*! \brief Integrate dx/dp = field( x , p ) with the Dormand-Prince Runge-Kutta 4(5) pair, appending each accepted position
+
+    \param vertices - array to which to append positions after vPosition.  vPosition itself is not appended.
+
+    \param field - function object that computes the derivative, or returns false where it is undefined.
+
+    \param vPosition - starting position.
+
+    \param param - starting value of the parameter: arc length for streamlines, time for pathlines.
+
+    \param paramEnd - value of the parameter at which to stop.  Integration runs backward if this precedes param.
+
+    \param step - magnitude of first trial step.
+
+    \param stepMin - smallest step magnitude.  Steps this small get accepted regardless of error,
+                    and integration stops where the field stays undefined at this step.
+
+    \param stepMax - largest step magnitude.
+
+    \param tolerance - largest position error allowed per step.
+
+    \param maxVertices - most positions to append.
+
+    Each step costs 6 field evaluations, since the last evaluation of one
+    step is the first of the next.  The difference between the embedded
+    4th and 5th order solutions estimates error, which sets the next step.
+*/
+template< class FieldT > static void IntegrateRk45( std::vector< Vec3 > & vertices , const FieldT & field , Vec3 vPosition , float param , float paramEnd
+                                                  , float step , float stepMin , float stepMax , float tolerance , size_t maxVertices )
+{
+    static const float c2 = 1.0f / 5.0f , c3 = 3.0f / 10.0f , c4 = 4.0f / 5.0f , c5 = 8.0f / 9.0f ;
+    static const float a21 = 1.0f / 5.0f ;
+    static const float a31 = 3.0f / 40.0f , a32 = 9.0f / 40.0f ;
+    static const float a41 = 44.0f / 45.0f , a42 = -56.0f / 15.0f , a43 = 32.0f / 9.0f ;
+    static const float a51 = 19372.0f / 6561.0f , a52 = -25360.0f / 2187.0f , a53 = 64448.0f / 6561.0f , a54 = -212.0f / 729.0f ;
+    static const float a61 = 9017.0f / 3168.0f , a62 = -355.0f / 33.0f , a63 = 46732.0f / 5247.0f , a64 = 49.0f / 176.0f , a65 = -5103.0f / 18656.0f ;
+    // 5th-order weights.  The 7th stage, at the new position, has weight 0.
+    static const float b1 = 35.0f / 384.0f , b3 = 500.0f / 1113.0f , b4 = 125.0f / 192.0f , b5 = -2187.0f / 6784.0f , b6 = 11.0f / 84.0f ;
+    // Difference between 5th-order and embedded 4th-order weights.
+    static const float e1 = 71.0f / 57600.0f , e3 = -71.0f / 16695.0f , e4 = 71.0f / 1920.0f , e5 = -17253.0f / 339200.0f , e6 = 22.0f / 525.0f , e7 = -1.0f / 40.0f ;
+
+    const float sign = ( paramEnd >= param ) ? 1.0f : -1.0f ;
+    Vec3 k1 ;
+    if( ! field( k1 , vPosition , param ) ) return ;
+    size_t numVertices = 0 ;
+    while( ( numVertices < maxVertices ) && ( sign * ( paramEnd - param ) > 0.0f ) )
+    {
+        const float h = sign * std::min( step , sign * ( paramEnd - param ) ) ;
+        Vec3 k2 , k3 , k4 , k5 , k6 , k7 ;
+        Vec3 vPositionNew ;
+        const bool bDefined =   field( k2 , vPosition + k1 * ( h * a21 ) , param + c2 * h )
+                            &&  field( k3 , vPosition + ( k1 * a31 + k2 * a32 ) * h , param + c3 * h )
+                            &&  field( k4 , vPosition + ( k1 * a41 + k2 * a42 + k3 * a43 ) * h , param + c4 * h )
+                            &&  field( k5 , vPosition + ( k1 * a51 + k2 * a52 + k3 * a53 + k4 * a54 ) * h , param + c5 * h )
+                            &&  field( k6 , vPosition + ( k1 * a61 + k2 * a62 + k3 * a63 + k4 * a64 + k5 * a65 ) * h , param + h )
+                            &&  field( k7 , vPositionNew = vPosition + ( k1 * b1 + k3 * b3 + k4 * b4 + k5 * b5 + k6 * b6 ) * h , param + h ) ;
+        if( ! bDefined )
+        {   // Step left the region where the field is defined, so approach its border with shorter steps.
+            if( step <= stepMin ) return ;
+            step = std::max( 0.5f * step , stepMin ) ;
+            continue ;
+        }
+
+        const float error = ( ( k1 * e1 + k3 * e3 + k4 * e4 + k5 * e5 + k6 * e6 + k7 * e7 ) * h ).length() ;
+        if( ( error <= tolerance ) || ( step <= stepMin ) )
+        {   // Accept step.
+            vPosition = vPositionNew ;
+            param += h ;
+            k1 = k7 ;
+            vertices.push_back( vPosition ) ;
+            ++ numVertices ;
+        }
+        // Scale step so the next error lands safely below tolerance.
+        const float scale = ( error > 0.0f ) ? 0.9f * powf( tolerance / error , 0.2f ) : 5.0f ;
+        step = std::min( std::max( step * std::min( std::max( scale , 0.2f ) , 5.0f ) , stepMin ) , stepMax ) ;
+    }
+}
+
+StreamlineTracer::StreamlineTracer()
+    : mTolerance( 1.0e-3f )
+    , mMaxLength( FLT_MAX )
+    , mMaxVertices( 1000 )
+    , mDirection( DIRECTION_FORWARD )
+    , mSeeds( nullptr )
+    , mVelGrid( nullptr )
+    , mVelGrids( nullptr )
+    , mTimes( nullptr )
+    , mNumGrids( 0 )
+    , mStartTime( 0.0f )
+    , mEndTime( 0.0f )
+    , mCellSpacing( 0.0f )
+{
+}
+
+void StreamlineTracer::AppendRake( std::vector< Vec3 > & seeds , const Vec3 & vStart , const Vec3 & vEnd , size_t numSeeds )
+{
+    const float denominator = ( numSeeds > 1 ) ? float( numSeeds - 1 ) : 1.0f ;
+    for( size_t iSeed = 0 ; iSeed < numSeeds ; ++ iSeed )
+    {
+        seeds.push_back( vStart + ( vEnd - vStart ) * ( float( iSeed ) / denominator ) ) ;
+    }
+}
+
+void StreamlineTracer::AppendPlane( std::vector< Vec3 > & seeds , const Vec3 & vOrigin , const Vec3 & vAxisU , const Vec3 & vAxisV , size_t numU , size_t numV )
+{
+    for( size_t iv = 0 ; iv < numV ; ++ iv )
+    {
+        const Vec3 vRow( vOrigin + vAxisV * ( ( float( iv ) + 0.5f ) / float( numV ) ) ) ;
+        for( size_t iu = 0 ; iu < numU ; ++ iu )
+        {
+            seeds.push_back( vRow + vAxisU * ( ( float( iu ) + 0.5f ) / float( numU ) ) ) ;
+        }
+    }
+}
+
+/*! \brief Trace lines from seeds in a subset of blocks, into each block's own vertex array
+
+    \param iBlockStart - index of first block to trace
+
+    \param iBlockEnd - index past last block to trace
+
+    This also records the number of vertices in each line, in mLineStarts[ iSeed + 1 ],
+    for TraceBatch to accumulate into offsets.
+*/
+void StreamlineTracer::TraceBlocksSlice( size_t iBlockStart , size_t iBlockEnd )
+{
+    const std::vector< Vec3 > & seeds       = * mSeeds ;
+    const float                 tolerance   = mTolerance * mCellSpacing ;
+    const float                 stepMin     = 1.0e-4f * mCellSpacing ;
+    for( size_t iBlock = iBlockStart ; iBlock < iBlockEnd ; ++ iBlock )
+    {
+        std::vector< Vec3 > &   vertices    = mBlockVertices[ iBlock ] ;
+        const size_t            iSeedEnd    = std::min( ( iBlock + 1 ) * sSeedsPerBlock , seeds.size() ) ;
+        vertices.clear() ;
+        for( size_t iSeed = iBlock * sSeedsPerBlock ; iSeed < iSeedEnd ; ++ iSeed )
+        {
+            const Vec3 &    vSeed       = seeds[ iSeed ] ;
+            const size_t    iLineStart  = vertices.size() ;
+            vertices.push_back( vSeed ) ;
+            if( mVelGrid )
+            {   // Streamline, parameterized by arc length.
+                const float stepMax = mCellSpacing ;
+                if( mDirection != DIRECTION_FORWARD )
+                {
+                    IntegrateRk45( vertices , SteadyField( * mVelGrid , -1.0f ) , vSeed , 0.0f , mMaxLength , 0.5f * mCellSpacing , stepMin , stepMax , tolerance , mMaxVertices ) ;
+                }
+                if( DIRECTION_BOTH == mDirection )
+                {   // Reverse upstream half so the line runs downstream through its seed.
+                    std::reverse( vertices.begin() + iLineStart , vertices.end() ) ;
+                }
+                if( mDirection != DIRECTION_BACKWARD )
+                {
+                    IntegrateRk45( vertices , SteadyField( * mVelGrid , 1.0f ) , vSeed , 0.0f , mMaxLength , 0.5f * mCellSpacing , stepMin , stepMax , tolerance , mMaxVertices ) ;
+                }
+            }
+            else
+            {   // Pathline, parameterized by time.
+                const UnsteadyField field( mVelGrids , mTimes , mNumGrids ) ;
+                Vec3 vVelocity ;
+                if( field( vVelocity , vSeed , mStartTime ) )
+                {   // Size first step to cross about half a cell.
+                    const float duration    = std::fabs( mEndTime - mStartTime ) ;
+                    const float speed       = vVelocity.length() ;
+                    const float stepInit    = ( speed > 0.0f ) ? std::min( 0.5f * mCellSpacing / speed , duration ) : duration ;
+                    IntegrateRk45( vertices , field , vSeed , mStartTime , mEndTime , stepInit , stepMin * stepInit / ( 0.5f * mCellSpacing ) , duration , tolerance , mMaxVertices ) ;
+                }
+            }
+            mLineStarts[ iSeed + 1 ] = vertices.size() - iLineStart ;
+        }
+    }
+}
+
+/*! \brief Copy vertices of a subset of blocks into the flat vertex array
+
+    \param iBlockStart - index of first block to copy
+
+    \param iBlockEnd - index past last block to copy
+*/
+void StreamlineTracer::CopyBlocksSlice( size_t iBlockStart , size_t iBlockEnd )
+{
+    for( size_t iBlock = iBlockStart ; iBlock < iBlockEnd ; ++ iBlock )
+    {
+        const std::vector< Vec3 > & vertices = mBlockVertices[ iBlock ] ;
+        if( vertices.empty() ) continue ;
+        memcpy( static_cast< void * >( & mVertices[ mLineStarts[ iBlock * sSeedsPerBlock ] ] ) , vertices.data() , vertices.size() * sizeof( Vec3 ) ) ;
+    }
+}
+
+/*! \brief Trace lines from seeds in parallel blocks, then gather them into the flat vertex array, in seed order
+ */
+void StreamlineTracer::TraceBatch( const std::vector< Vec3 > & seeds )
+{
+    mSeeds = & seeds ;
+    const size_t numSeeds   = seeds.size() ;
+    const size_t numBlocks  = ( numSeeds + sSeedsPerBlock - 1 ) / sSeedsPerBlock ;
+    if( mBlockVertices.size() < numBlocks ) mBlockVertices.resize( numBlocks ) ;
+    mLineStarts.resize( numSeeds + 1 ) ;
+    mLineStarts[ 0 ] = 0 ;
+
+#if USE_TBB
+    {
+        // Estimate grain size based on size of problem and number of processors.
+        const size_t grainSize = std::max( size_t( 1 ) , numBlocks / std::thread::hardware_concurrency() ) ;
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numBlocks , grainSize ) , StreamlineTracer_TraceBlocks_TBB( this ) ) ;
+    }
+#else
+    TraceBlocksSlice( 0 , numBlocks ) ;
+#endif
+
+    // Turn vertex counts into offsets.
+    for( size_t iSeed = 0 ; iSeed < numSeeds ; ++ iSeed )
+    {
+        mLineStarts[ iSeed + 1 ] += mLineStarts[ iSeed ] ;
+    }
+    mVertices.resize( mLineStarts[ numSeeds ] ) ;
+
+#if USE_TBB
+    {
+        // Estimate grain size based on size of problem and number of processors.
+        const size_t grainSize = std::max( size_t( 1 ) , numBlocks / std::thread::hardware_concurrency() ) ;
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numBlocks , grainSize ) , StreamlineTracer_CopyBlocks_TBB( this ) ) ;
+    }
+#else
+    CopyBlocksSlice( 0 , numBlocks ) ;
+#endif
+    mSeeds = nullptr ;
+}
+
+void StreamlineTracer::TraceStreamlines( const UniformGrid< Vec3 > & velGrid , const std::vector< Vec3 > & seeds )
+{
+    mVelGrid        = & velGrid ;
+    mCellSpacing    = MinCellSpacing( velGrid ) ;
+    TraceBatch( seeds ) ;
+    mVelGrid        = nullptr ;
+}
+
+void StreamlineTracer::TracePathlines( const std::vector< const UniformGrid< Vec3 > * > & velGrids , const std::vector< float > & times
+                                     , const std::vector< Vec3 > & seeds , float startTime , float endTime )
+{
+    mVelGrid    = nullptr ;
+    mVelGrids   = velGrids.data() ;
+    mTimes      = times.data() ;
+    mNumGrids   = std::min( velGrids.size() , times.size() ) ;
+    mStartTime  = startTime ;
+    mEndTime    = endTime ;
+    if( 0 == mNumGrids )
+    {   // No velocity, so each line is just its seed.
+        mLineStarts.resize( seeds.size() + 1 ) ;
+        for( size_t iSeed = 0 ; iSeed <= seeds.size() ; ++ iSeed ) mLineStarts[ iSeed ] = iSeed ;
+        mVertices = seeds ;
+        return ;
+    }
+    mCellSpacing = FLT_MAX ;
+    for( size_t iGrid = 0 ; iGrid < mNumGrids ; ++ iGrid )
+    {
+        mCellSpacing = std::min( mCellSpacing , MinCellSpacing( * velGrids[ iGrid ] ) ) ;
+    }
+    TraceBatch( seeds ) ;
+    mVelGrids   = nullptr ;
+    mTimes      = nullptr ;
+    mNumGrids   = 0 ;
+}
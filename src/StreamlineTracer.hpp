@@ -0,0 +1,123 @@
+#pragma once
+
+#include <vector>
+#include "UniformGrid.hpp"
+#include "TBB_Settings.hpp"
+
+/*! \brief Trace batches of streamlines or pathlines through velocity grids, in parallel
+
+ Integration uses the Dormand-Prince embedded Runge-Kutta 4(5) pair,
+ which adapts its step so the estimated position error per step stays
+ below a tolerance.  Steps lengthen where flow is smooth and shorten
+ where it curves, so lines need far fewer velocity samples than fixed
+ small steps for the same accuracy.
+
+ Streamlines follow the instantaneous velocity of one grid, and are
+ parameterized by arc length.  Pathlines follow a time series of
+ velocity grids, interpolating linearly in time between them, and are
+ parameterized by time.  Lines stop where they leave a grid, where
+ velocity vanishes, or at their length or vertex limit.
+
+ Seeds get divided into fixed blocks traced as parallel tasks.  Output
+ polylines go into one flat vertex array, in seed order, with an array
+ of line start offsets, so line i spans
+ [ GetLineStarts()[i] , GetLineStarts()[i+1] ).  The layout does not
+ depend on the number of threads.  Both arrays, and per-block scratch
+ space, are retained between batches, so tracing does not touch the heap
+ once capacity is reached.
+
+ */
+class StreamlineTracer
+{
+public:
+    enum DirectionE
+    {
+        DIRECTION_FORWARD ,     ///< Trace downstream from each seed
+        DIRECTION_BACKWARD ,    ///< Trace upstream from each seed
+        DIRECTION_BOTH ,        ///< Trace both ways, joined into one line running downstream through the seed
+    } ;
+
+    StreamlineTracer() ;
+
+    /// Append seeds evenly spaced along a line segment, including its ends.
+    static void AppendRake( std::vector< Vec3 > & seeds , const Vec3 & vStart , const Vec3 & vEnd , size_t numSeeds ) ;
+
+    /// Append a lattice of seeds over a parallelogram, at the centers of numU by numV cells.
+    static void AppendPlane( std::vector< Vec3 > & seeds , const Vec3 & vOrigin , const Vec3 & vAxisU , const Vec3 & vAxisV , size_t numU , size_t numV ) ;
+
+    /// Set largest position error allowed per step, as a fraction of the smallest cell spacing of the velocity grid.
+    void        SetTolerance( float tolerance )             { mTolerance = tolerance ; }
+    float       GetTolerance() const                        { return mTolerance ; }
+
+    /// Set longest arc length of a streamline, in each direction.
+    void        SetMaxLength( float maxLength )             { mMaxLength = maxLength ; }
+    float       GetMaxLength() const                        { return mMaxLength ; }
+
+    /// Set most vertices in a line, in each direction.
+    void        SetMaxVertices( size_t maxVertices )        { mMaxVertices = maxVertices ; }
+    size_t      GetMaxVertices() const                      { return mMaxVertices ; }
+
+    /// Set which way streamlines run from their seeds.  Pathlines run from start time toward end time instead.
+    void        SetDirection( DirectionE direction )        { mDirection = direction ; }
+    DirectionE  GetDirection() const                        { return mDirection ; }
+
+    /*! \brief Trace a streamline from each seed
+
+        \param velGrid - velocity grid, for example VortonSim::GetVelocityGrid.
+
+        \param seeds - starting points, one per line.
+    */
+    void TraceStreamlines( const UniformGrid< Vec3 > & velGrid , const std::vector< Vec3 > & seeds ) ;
+
+    /*! \brief Trace a pathline from each seed through a time series of velocity grids
+
+        \param velGrids - velocity grids, in increasing order of time.  Grids may have different shapes.
+
+        \param times - time of each velocity grid.
+
+        \param seeds - starting points, one per line.
+
+        \param startTime - time at which each line leaves its seed.
+
+        \param endTime - time at which lines stop.  Lines run backward in time if this precedes startTime.
+
+        \note Only VortonSim's latest velocity grid lives in memory, so callers keep or reload earlier ones,
+                for example from files written by VolumeExporter.
+    */
+    void TracePathlines( const std::vector< const UniformGrid< Vec3 > * > & velGrids , const std::vector< float > & times
+                       , const std::vector< Vec3 > & seeds , float startTime , float endTime ) ;
+
+    size_t                          GetNumLines() const                         { return mLineStarts.empty() ? 0 : mLineStarts.size() - 1 ; }
+    const std::vector< Vec3 > &     GetVertices() const                         { return mVertices ; }
+    const std::vector< size_t > &   GetLineStarts() const                       { return mLineStarts ; }
+    const Vec3 *                    GetLineVertices( size_t iLine ) const       { return mVertices.data() + mLineStarts[ iLine ] ; }
+    size_t                          GetNumLineVertices( size_t iLine ) const    { return mLineStarts[ iLine + 1 ] - mLineStarts[ iLine ] ; }
+
+private:
+    #if USE_TBB
+        friend class StreamlineTracer_TraceBlocks_TBB ;
+        friend class StreamlineTracer_CopyBlocks_TBB ;
+    #endif
+
+    static const size_t sSeedsPerBlock = 64 ;  ///< Number of seeds traced by one task
+
+    void TraceBatch( const std::vector< Vec3 > & seeds ) ;
+    void TraceBlocksSlice( size_t iBlockStart , size_t iBlockEnd ) ;
+    void CopyBlocksSlice( size_t iBlockStart , size_t iBlockEnd ) ;
+
+    float                                       mTolerance      ;   ///< Largest error per step, as a fraction of cell spacing
+    float                                       mMaxLength      ;   ///< Longest arc length of a streamline in each direction
+    size_t                                      mMaxVertices    ;   ///< Most vertices in a line in each direction
+    DirectionE                                  mDirection      ;   ///< Which way streamlines run from their seeds
+    const std::vector< Vec3 > *                 mSeeds          ;   ///< Seeds being traced
+    const UniformGrid< Vec3 > *                 mVelGrid        ;   ///< Velocity grid for streamlines, or nullptr when tracing pathlines
+    const UniformGrid< Vec3 > * const *         mVelGrids       ;   ///< Velocity grids for pathlines
+    const float *                               mTimes          ;   ///< Time of each grid in mVelGrids
+    size_t                                      mNumGrids       ;   ///< Number of grids in mVelGrids
+    float                                       mStartTime      ;   ///< Time at which pathlines leave seeds
+    float                                       mEndTime        ;   ///< Time at which pathlines stop
+    float                                       mCellSpacing    ;   ///< Smallest cell spacing of velocity grids
+    std::vector< std::vector< Vec3 > >          mBlockVertices  ;   ///< Vertices of lines traced by each block
+    std::vector< size_t >                       mLineStarts     ;   ///< Offset in mVertices of each line, plus one past the last
+    std::vector< Vec3 >                         mVertices       ;   ///< Vertices of all lines
+} ;
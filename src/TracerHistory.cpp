@@ -0,0 +1,58 @@
+#include "TracerHistory.hpp"
+#include <algorithm>
+
+void TracerHistory::SetCapacity( size_t capacity )
+{
+    if( capacity != mSlots.size() )
+    {
+        std::vector< std::vector< Vec3 > >( capacity , std::vector< Vec3 >( mNumTracers ) ).swap( mSlots ) ;
+    }
+    mNewest     = 0 ;
+    mNumFrames  = 0 ;
+}
+
+Vec3 * TracerHistory::BeginFrame( size_t numTracers )
+{
+    if( mSlots.empty() ) return nullptr ;
+    if( numTracers != mNumTracers )
+    {   // Tracers were created or reinitialized, so their history no longer applies.
+        for( size_t iSlot = 0 ; iSlot < mSlots.size() ; ++ iSlot )
+        {
+            mSlots[ iSlot ].resize( numTracers ) ;
+        }
+        mNumTracers = numTracers ;
+        mNumFrames  = 0 ;
+    }
+    mNewest     = ( mNewest + 1 ) % mSlots.size() ;
+    mNumFrames  = std::min( mNumFrames + 1 , mSlots.size() ) ;
+    return mSlots[ mNewest ].data() ;
+}
+
+size_t TracerHistory::ExtractTrail( Vec3 * trail , size_t iTracer , size_t maxFrames ) const
+{
+    const size_t numFrames = std::min( maxFrames , mNumFrames ) ;
+    for( size_t iVertex = 0 ; iVertex < numFrames ; ++ iVertex )
+    {   // Copy oldest position first.
+        trail[ iVertex ] = GetPosition( iTracer , numFrames - 1 - iVertex ) ;
+    }
+    return numFrames ;
+}
+
+void TracerHistory::ExtractTrails( std::vector< Vec3 > & vertices , std::vector< size_t > & lineStarts , size_t maxFrames ) const
+{
+    const size_t numFrames = std::min( maxFrames , mNumFrames ) ;
+    vertices.resize( mNumTracers * numFrames ) ;
+    lineStarts.resize( mNumTracers + 1 ) ;
+    for( size_t iTracer = 0 ; iTracer <= mNumTracers ; ++ iTracer )
+    {
+        lineStarts[ iTracer ] = iTracer * numFrames ;
+    }
+    for( size_t iVertex = 0 ; iVertex < numFrames ; ++ iVertex )
+    {   // Read each slot sequentially, scattering its positions into trails.
+        const std::vector< Vec3 > & slot = GetSlot( numFrames - 1 - iVertex ) ;
+        for( size_t iTracer = 0 ; iTracer < mNumTracers ; ++ iTracer )
+        {
+            vertices[ iTracer * numFrames + iVertex ] = slot[ iTracer ] ;
+        }
+    }
+}
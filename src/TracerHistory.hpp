@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+#include "Vec3.hpp"
+
+/*! \brief Recent positions of each passive tracer, for drawing streaks and motion trails
+
+ History is a ring of slots, one per frame, each holding one contiguous
+ array of positions with one entry per tracer.  Recording a frame
+ therefore writes each tracer's position once, into the newest slot,
+ and every tracer's position at a given age can be read as one array,
+ for example to upload as a vertex buffer.
+
+ Storage is allocated when the capacity or the number of tracers
+ changes, and reused otherwise, so recording does not touch the heap.
+ A history with capacity 0 is disabled, holds no storage, and records
+ nothing.
+
+ Polylines run from oldest to newest position.  ExtractTrails gathers
+ them into one flat vertex array with an array of line start offsets,
+ the same layout StreamlineTracer uses.
+
+ \note Changing the number of tracers other than through Compact, for
+        example by reinitializing them, forgets the history.
+ */
+class TracerHistory
+{
+public:
+    TracerHistory()
+        : mNumTracers( 0 )
+        , mNewest( 0 )
+        , mNumFrames( 0 )
+    {}
+
+    /*! \brief Set most frames to remember, which forgets the history
+
+        \param capacity - number of positions kept per tracer.  0 disables history and frees its storage.
+     */
+    void SetCapacity( size_t capacity ) ;
+
+    size_t  GetCapacity() const     { return mSlots.size() ; }
+    bool    IsEnabled() const       { return ! mSlots.empty() ; }
+
+    /// Forget recorded positions, but keep storage.
+    void    Clear()                 { mNumFrames = 0 ; }
+
+    /*! \brief Advance to the next slot and return it, to be filled with each tracer's position
+
+        \param numTracers - number of tracers to record.  If this changed, the history is forgotten.
+
+        \return address of array with one position per tracer, or nullptr if history is disabled.
+
+        \note This must be called serially.  Tracers can then be written into the slot concurrently.
+     */
+    Vec3 *  BeginFrame( size_t numTracers ) ;
+
+    /// Return the slot most recently returned by BeginFrame, or nullptr if history is disabled.
+    Vec3 *  GetNewestSlot()         { return mSlots.empty() ? nullptr : mSlots[ mNewest ].data() ; }
+
+    /*! \brief Remove positions of tracers removed by the most recent ParticleCompaction::Compact
+
+        \param compaction - object that compacted tracers, as in VortonSim::KillTracers.
+     */
+    template< class CompactionT > void Compact( CompactionT & compaction )
+    {
+        if( mSlots.empty() ) return ;
+        for( size_t iSlot = 0 ; iSlot < mSlots.size() ; ++ iSlot )
+        {
+            compaction.CompactCompanion( mSlots[ iSlot ] , mCompactScratch ) ;
+        }
+        mNumTracers = mSlots[ 0 ].size() ;
+    }
+
+    size_t  GetNumTracers() const   { return mNumTracers ; }
+
+    /// Return number of frames recorded, up to capacity.
+    size_t  GetNumFrames() const    { return mNumFrames ; }
+
+    /*! \brief Return positions of all tracers at a given age
+
+        \param age - number of frames before the newest, in [0,GetNumFrames()).
+     */
+    const std::vector< Vec3 > & GetSlot( size_t age ) const
+    {
+        return mSlots[ ( mNewest + mSlots.size() - age ) % mSlots.size() ] ;
+    }
+
+    const Vec3 & GetPosition( size_t iTracer , size_t age ) const { return GetSlot( age )[ iTracer ] ; }
+
+    /*! \brief Copy one tracer's trail, oldest to newest
+
+        \param trail - array to receive up to maxFrames positions.
+
+        \return number of positions copied, which is the smaller of maxFrames and GetNumFrames.
+     */
+    size_t ExtractTrail( Vec3 * trail , size_t iTracer , size_t maxFrames ) const ;
+
+    /*! \brief Gather trails of all tracers into one flat array
+
+        \param vertices - receives trails, oldest position first, tracer after tracer.
+
+        \param lineStarts - receives offset in vertices of each trail, plus one past the last,
+                so tracer i's trail spans [ lineStarts[i] , lineStarts[i+1] ).
+
+        \param maxFrames - most positions per trail.
+     */
+    void ExtractTrails( std::vector< Vec3 > & vertices , std::vector< size_t > & lineStarts , size_t maxFrames ) const ;
+
+private:
+    std::vector< std::vector< Vec3 > >  mSlots          ;   ///< Ring of slots, each with one position per tracer
+    size_t                              mNumTracers     ;   ///< Number of tracers in each slot
+    size_t                              mNewest         ;   ///< Index of most recently recorded slot
+    size_t                              mNumFrames      ;   ///< Number of slots recorded, up to capacity
+    std::vector< Vec3 >                 mCompactScratch ;   ///< Storage Compact swaps with each slot, so removing tracers does not allocate
+} ;
@@ -0,0 +1,511 @@
+#include "TracerStream.hpp"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+const char sStreamMagic[ 8 ] = { 'V' , 'O' , 'R' , 'T' , 'T' , 'R' , 'C' , 'S' } ;
+const uint32_t sStreamVersion = 1 ;
+
+/// Leading part of a tracer stream file
+struct StreamHeader
+{
+    char        mMagic[ 8 ]         ;   ///< Identifies file as a tracer stream
+    uint32_t    mVersion            ;   ///< sStreamVersion of the writer
+    uint32_t    mNumChannels        ;   ///< 1 for positions only, 2 for positions and velocities
+} ;
+
+const uint32_t sKeyFrame = 1 ;  ///< FrameHeader flag: frame does not depend on its predecessor
+
+/*! \brief Leading part of each record made by TracerEncoder
+
+    The header is followed by a table of uint64_t, one per block, giving
+    the offset of the end of that block relative to the end of the table,
+    then the encoded blocks.
+*/
+struct FrameHeader
+{
+    uint64_t    mRecordSize     ;   ///< Size of this record, including header, in bytes
+    uint64_t    mFrame          ;   ///< Frame counter
+    uint64_t    mNumTracers     ;   ///< Number of tracers
+    uint32_t    mNumChannels    ;   ///< 1 for positions only, 2 for positions and velocities
+    uint32_t    mFlags          ;   ///< Combination of sKeyFrame
+    Vec3        mMin[ 2 ]       ;   ///< Minimal corner of bounding box, for positions and velocities
+    Vec3        mMax[ 2 ]       ;   ///< Maximal corner of bounding box
+} ;
+
+size_t GetNumBlocks( size_t numTracers )
+{
+    return ( numTracers + TracerEncoder::sBlockSize - 1 ) / TracerEncoder::sBlockSize ;
+}
+
+/// Map signed to unsigned integers so values near zero, of either sign, become small.
+inline uint32_t ZigZag( int32_t value )
+{
+    return ( uint32_t( value ) << 1 ) ^ uint32_t( value >> 31 ) ;
+}
+
+inline int32_t UnZigZag( uint32_t code )
+{
+    return int32_t( code >> 1 ) ^ - int32_t( code & 1 ) ;
+}
+
+/// Append value using 7 bits per byte, low bits first, with the high bit set on all but the last byte.
+inline void PutVarint( std::vector< char > & bytes , uint32_t value )
+{
+    while( value >= 0x80 )
+    {
+        bytes.push_back( char( ( value & 0x7f ) | 0x80 ) ) ;
+        value >>= 7 ;
+    }
+    bytes.push_back( char( value ) ) ;
+}
+
+/// Read value written by PutVarint, or return false if it would run past pEnd or does not fit 32 bits.
+inline bool GetVarint( uint32_t & value , const unsigned char * & pBytes , const unsigned char * pEnd )
+{
+    value = 0 ;
+    for( unsigned shift = 0 ; shift < 32 ; shift += 7 )
+    {
+        if( pBytes >= pEnd ) return false ;
+        const unsigned char byte = * pBytes ++ ;
+        value |= uint32_t( byte & 0x7f ) << shift ;
+        if( 0 == ( byte & 0x80 ) ) return true ;
+    }
+    return false ;
+}
+
+/// Level that predicts a component in the current frame, from its level in the previous frame.
+inline int32_t Predict( const TracerQuantizer & current , const TracerQuantizer & previous , uint16_t previousLevel , int axis )
+{
+    return current.Quantize( previous.Dequantize( previousLevel , axis ) , axis ) ;
+}
+
+} // namespace
+
+#if USE_TBB
+/*! \brief Function object to compute per-block bounding boxes of tracers using Threading Building Blocks
+ */
+class TracerEncoder_ComputeBounds_TBB
+{
+    TracerEncoder * mEncoder ;  ///< Address of TracerEncoder object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Compute bounds of subset of blocks.
+        mEncoder->ComputeBoundsSlice( r.begin() , r.end() ) ;
+    }
+    TracerEncoder_ComputeBounds_TBB( TracerEncoder * pEncoder )
+    : mEncoder( pEncoder ) {}
+} ;
+
+/*! \brief Function object to encode blocks of tracers using Threading Building Blocks
+ */
+class TracerEncoder_EncodeBlocks_TBB
+{
+    TracerEncoder * mEncoder ;  ///< Address of TracerEncoder object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Encode subset of blocks.
+        mEncoder->EncodeBlocksSlice( r.begin() , r.end() ) ;
+    }
+    TracerEncoder_EncodeBlocks_TBB( TracerEncoder * pEncoder )
+    : mEncoder( pEncoder ) {}
+} ;
+
+/*! \brief Function object to decode blocks of tracers using Threading Building Blocks
+ */
+class TracerDecoder_DecodeBlocks_TBB
+{
+    TracerDecoder * mDecoder ;  ///< Address of TracerDecoder object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Decode subset of blocks.
+        mDecoder->DecodeBlocksSlice( r.begin() , r.end() ) ;
+    }
+    TracerDecoder_DecodeBlocks_TBB( TracerDecoder * pDecoder )
+    : mDecoder( pDecoder ) {}
+} ;
+#endif
+
+TracerQuantizer::TracerQuantizer( const Vec3 & vMin , const Vec3 & vMax )
+    : mMin( vMin )
+{
+    for( int axis = 0 ; axis < 3 ; ++ axis )
+    {
+        const float extent = vMax[ axis ] - vMin[ axis ] ;
+        // A flat box quantizes everything to its minimum.
+        mScale[ axis ]  = ( extent > 0.0f ) ? float( sMaxLevel ) / extent : 0.0f ;
+        mStep[ axis ]   = extent / float( sMaxLevel ) ;
+    }
+}
+
+TracerEncoder::TracerEncoder( bool bVelocities , size_t keyFrameInterval )
+    : mNumChannels( bVelocities ? 2 : 1 )
+    , mKeyFrameInterval( keyFrameInterval )
+    , mFramesSinceKey( 0 )
+    , mHasReference( false )
+    , mIsKeyFrame( true )
+    , mTracers( nullptr )
+{
+}
+
+void TracerEncoder::ComputeBoundsSlice( size_t iBlockStart , size_t iBlockEnd )
+{
+    const std::vector< Particle > & tracers = * mTracers ;
+    for( size_t iBlock = iBlockStart ; iBlock < iBlockEnd ; ++ iBlock )
+    {   // For each block in this slice...
+        const size_t    itBegin = iBlock * sBlockSize ;
+        const size_t    itEnd   = std::min( itBegin + sBlockSize , tracers.size() ) ;
+        Vec3 *          pBounds = & mBlockBounds[ iBlock * 2 * mNumChannels ] ;
+        for( size_t channel = 0 ; channel < mNumChannels ; ++ channel )
+        {
+            pBounds[ 2 * channel ] = pBounds[ 2 * channel + 1 ] = channel ? tracers[ itBegin ].mVelocity : tracers[ itBegin ].mPosition ;
+        }
+        for( size_t it = itBegin + 1 ; it < itEnd ; ++ it )
+        {
+            for( size_t channel = 0 ; channel < mNumChannels ; ++ channel )
+            {
+                const Vec3 & vValue = channel ? tracers[ it ].mVelocity : tracers[ it ].mPosition ;
+                Vec3 & vMin = pBounds[ 2 * channel ] ;
+                Vec3 & vMax = pBounds[ 2 * channel + 1 ] ;
+                vMin = Vec3( std::min( vMin.x , vValue.x ) , std::min( vMin.y , vValue.y ) , std::min( vMin.z , vValue.z ) ) ;
+                vMax = Vec3( std::max( vMax.x , vValue.x ) , std::max( vMax.y , vValue.y ) , std::max( vMax.z , vValue.z ) ) ;
+            }
+        }
+    }
+}
+
+void TracerEncoder::EncodeBlocksSlice( size_t iBlockStart , size_t iBlockEnd )
+{
+    const std::vector< Particle > & tracers     = * mTracers ;
+    const size_t                    numValues   = 3 * mNumChannels ;
+    for( size_t iBlock = iBlockStart ; iBlock < iBlockEnd ; ++ iBlock )
+    {   // For each block in this slice...
+        const size_t            itBegin = iBlock * sBlockSize ;
+        const size_t            itEnd   = std::min( itBegin + sBlockSize , tracers.size() ) ;
+        std::vector< char > &   bytes   = mBlockBytes[ iBlock ] ;
+        bytes.clear() ;
+        int32_t previous[ 6 ] = { 0 , 0 , 0 , 0 , 0 , 0 } ;    // Levels of previous tracer in block, for key frames
+        for( size_t it = itBegin ; it < itEnd ; ++ it )
+        {
+            uint16_t * pReference = & mReference[ it * numValues ] ;
+            for( size_t channel = 0 ; channel < mNumChannels ; ++ channel )
+            {
+                const Vec3 & vValue = channel ? tracers[ it ].mVelocity : tracers[ it ].mPosition ;
+                for( int axis = 0 ; axis < 3 ; ++ axis )
+                {
+                    const size_t    iValue      = 3 * channel + axis ;
+                    const int32_t   level       = mQuantizers[ channel ].Quantize( vValue[ axis ] , axis ) ;
+                    const int32_t   prediction  = mIsKeyFrame ? previous[ iValue ]
+                                                : Predict( mQuantizers[ channel ] , mRefQuantizers[ channel ] , pReference[ iValue ] , axis ) ;
+                    PutVarint( bytes , ZigZag( level - prediction ) ) ;
+                    previous[ iValue ]      = level ;
+                    pReference[ iValue ]    = uint16_t( level ) ;
+                }
+            }
+        }
+    }
+}
+
+void TracerEncoder::Encode( std::vector< char > & record , const std::vector< Particle > & tracers , uint64_t uFrame )
+{
+    const size_t numTracers = tracers.size() ;
+    const size_t numValues  = 3 * mNumChannels ;
+    const size_t numBlocks  = GetNumBlocks( numTracers ) ;
+
+    mIsKeyFrame =   ! mHasReference
+                ||  ( mReference.size() != numTracers * numValues )
+                ||  ( ( mKeyFrameInterval > 0 ) && ( mFramesSinceKey + 1 >= mKeyFrameInterval ) ) ;
+    mTracers = & tracers ;
+
+    FrameHeader header ;
+    memset( static_cast< void * >( & header ) , 0 , sizeof( header ) ) ;  // Zero padding, so files are reproducible.
+    header.mFrame       = uFrame ;
+    header.mNumTracers  = numTracers ;
+    header.mNumChannels = uint32_t( mNumChannels ) ;
+    header.mFlags       = mIsKeyFrame ? sKeyFrame : 0 ;
+
+    // Find bounding box of each channel.
+    mBlockBounds.resize( numBlocks * 2 * mNumChannels ) ;
+#if USE_TBB
+    {
+        const size_t grainSize = std::max( size_t( 1 ) , numBlocks / std::thread::hardware_concurrency() ) ;
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numBlocks , grainSize ) , TracerEncoder_ComputeBounds_TBB( this ) ) ;
+    }
+#else
+    ComputeBoundsSlice( 0 , numBlocks ) ;
+#endif
+    for( size_t channel = 0 ; channel < mNumChannels ; ++ channel )
+    {
+        Vec3 & vMin = header.mMin[ channel ] ;
+        Vec3 & vMax = header.mMax[ channel ] ;
+        for( size_t iBlock = 0 ; iBlock < numBlocks ; ++ iBlock )
+        {
+            const Vec3 & vBlockMin = mBlockBounds[ ( iBlock * mNumChannels + channel ) * 2 ] ;
+            const Vec3 & vBlockMax = mBlockBounds[ ( iBlock * mNumChannels + channel ) * 2 + 1 ] ;
+            if( 0 == iBlock )
+            {
+                vMin = vBlockMin ;
+                vMax = vBlockMax ;
+            }
+            else
+            {
+                vMin = Vec3( std::min( vMin.x , vBlockMin.x ) , std::min( vMin.y , vBlockMin.y ) , std::min( vMin.z , vBlockMin.z ) ) ;
+                vMax = Vec3( std::max( vMax.x , vBlockMax.x ) , std::max( vMax.y , vBlockMax.y ) , std::max( vMax.z , vBlockMax.z ) ) ;
+            }
+        }
+        mQuantizers[ channel ] = TracerQuantizer( vMin , vMax ) ;
+    }
+
+    // Encode blocks.
+    mReference.resize( numTracers * numValues ) ;
+    mBlockBytes.resize( numBlocks ) ;
+#if USE_TBB
+    {
+        const size_t grainSize = std::max( size_t( 1 ) , numBlocks / std::thread::hardware_concurrency() ) ;
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numBlocks , grainSize ) , TracerEncoder_EncodeBlocks_TBB( this ) ) ;
+    }
+#else
+    EncodeBlocksSlice( 0 , numBlocks ) ;
+#endif
+
+    // Assemble record: header, table of block ends, blocks.
+    size_t payloadSize = 0 ;
+    for( const std::vector< char > & bytes : mBlockBytes )
+    {
+        payloadSize += bytes.size() ;
+    }
+    const size_t tableOffset    = sizeof( FrameHeader ) ;
+    const size_t payloadOffset  = tableOffset + numBlocks * sizeof( uint64_t ) ;
+    header.mRecordSize = payloadOffset + payloadSize ;
+    record.resize( size_t( header.mRecordSize ) ) ;
+    memcpy( record.data() , & header , sizeof( header ) ) ;
+    uint64_t blockEnd = 0 ;
+    for( size_t iBlock = 0 ; iBlock < numBlocks ; ++ iBlock )
+    {
+        const std::vector< char > & bytes = mBlockBytes[ iBlock ] ;
+        if( ! bytes.empty() ) memcpy( record.data() + payloadOffset + blockEnd , bytes.data() , bytes.size() ) ;
+        blockEnd += bytes.size() ;
+        memcpy( record.data() + tableOffset + iBlock * sizeof( uint64_t ) , & blockEnd , sizeof( blockEnd ) ) ;
+    }
+
+    for( size_t channel = 0 ; channel < mNumChannels ; ++ channel )
+    {
+        mRefQuantizers[ channel ] = mQuantizers[ channel ] ;
+    }
+    mFramesSinceKey = mIsKeyFrame ? 0 : mFramesSinceKey + 1 ;
+    mHasReference   = true ;
+    mTracers        = nullptr ;
+}
+
+/* static */ uint64_t TracerDecoder::GetRecordSize( const char * pRecord )
+{
+    uint64_t recordSize ;
+    memcpy( & recordSize , pRecord , sizeof( recordSize ) ) ;
+    return recordSize ;
+}
+
+void TracerDecoder::DecodeBlocksSlice( size_t iBlockStart , size_t iBlockEnd )
+{
+    const size_t numValues = 3 * mNumChannels ;
+    for( size_t iBlock = iBlockStart ; iBlock < iBlockEnd ; ++ iBlock )
+    {   // For each block in this slice...
+        uint64_t blockBegin = 0 ;
+        uint64_t blockEnd ;
+        if( iBlock > 0 ) memcpy( & blockBegin , mBlockEnds + ( iBlock - 1 ) * sizeof( uint64_t ) , sizeof( blockBegin ) ) ;
+        memcpy( & blockEnd , mBlockEnds + iBlock * sizeof( uint64_t ) , sizeof( blockEnd ) ) ;
+        const unsigned char *   pBytes  = mPayload + blockBegin ;
+        const unsigned char *   pEnd    = mPayload + blockEnd ;
+        const size_t            itBegin = iBlock * TracerEncoder::sBlockSize ;
+        const size_t            itEnd   = std::min( itBegin + TracerEncoder::sBlockSize , mNumTracers ) ;
+        int32_t previous[ 6 ] = { 0 , 0 , 0 , 0 , 0 , 0 } ;
+        for( size_t it = itBegin ; it < itEnd ; ++ it )
+        {
+            uint16_t * pReference = & mReference[ it * numValues ] ;
+            for( size_t channel = 0 ; channel < mNumChannels ; ++ channel )
+            {
+                Vec3 & vValue = channel ? mFrame->mVelocities[ it ] : mFrame->mPositions[ it ] ;
+                for( int axis = 0 ; axis < 3 ; ++ axis )
+                {
+                    const size_t iValue = 3 * channel + axis ;
+                    uint32_t code ;
+                    if( ! GetVarint( code , pBytes , pEnd ) )
+                    {
+                        mCorrupt = true ;
+                        return ;
+                    }
+                    const int32_t prediction    = mIsKeyFrame ? previous[ iValue ]
+                                                : Predict( mQuantizers[ channel ] , mRefQuantizers[ channel ] , pReference[ iValue ] , axis ) ;
+                    const int32_t level         = prediction + UnZigZag( code ) ;
+                    if( ( level < 0 ) || ( level > TracerQuantizer::sMaxLevel ) )
+                    {
+                        mCorrupt = true ;
+                        return ;
+                    }
+                    vValue[ axis ]          = mQuantizers[ channel ].Dequantize( level , axis ) ;
+                    previous[ iValue ]      = level ;
+                    pReference[ iValue ]    = uint16_t( level ) ;
+                }
+            }
+        }
+        if( pBytes != pEnd )
+        {
+            mCorrupt = true ;
+            return ;
+        }
+    }
+}
+
+bool TracerDecoder::Decode( TracerFrame & frame , const char * pRecord , size_t size )
+{
+    if( size < sizeof( FrameHeader ) ) return false ;
+    FrameHeader header ;
+    memcpy( & header , pRecord , sizeof( header ) ) ;
+    const bool bKeyFrame = 0 != ( header.mFlags & sKeyFrame ) ;
+    if(     ( header.mRecordSize > size )
+        ||  ( ( header.mNumChannels != 1 ) && ( header.mNumChannels != 2 ) ) )
+    {
+        return false ;
+    }
+    const size_t numBlocks      = GetNumBlocks( size_t( header.mNumTracers ) ) ;
+    const size_t tableOffset    = sizeof( FrameHeader ) ;
+    if( numBlocks > ( header.mRecordSize - tableOffset ) / sizeof( uint64_t ) ) return false ;
+    const size_t payloadOffset  = tableOffset + numBlocks * sizeof( uint64_t ) ;
+    const size_t payloadSize    = size_t( header.mRecordSize ) - payloadOffset ;
+    // Validate block table, so decoding cannot read beyond the record.
+    uint64_t blockEndPrev = 0 ;
+    for( size_t iBlock = 0 ; iBlock < numBlocks ; ++ iBlock )
+    {
+        uint64_t blockEnd ;
+        memcpy( & blockEnd , pRecord + tableOffset + iBlock * sizeof( uint64_t ) , sizeof( blockEnd ) ) ;
+        if( ( blockEnd < blockEndPrev ) || ( blockEnd > payloadSize ) ) return false ;
+        blockEndPrev = blockEnd ;
+    }
+    if( blockEndPrev != payloadSize ) return false ;
+
+    const size_t numValues = 3 * header.mNumChannels ;
+    if( ! bKeyFrame && ( ! mHasReference || ( mNumChannels != header.mNumChannels ) || ( mReference.size() != header.mNumTracers * numValues ) ) )
+    {   // Frame depends on a predecessor this decoder does not have.
+        return false ;
+    }
+
+    mNumChannels    = header.mNumChannels ;
+    mIsKeyFrame     = bKeyFrame ;
+    mNumTracers     = size_t( header.mNumTracers ) ;
+    mBlockEnds      = pRecord + tableOffset ;
+    mPayload        = reinterpret_cast< const unsigned char * >( pRecord + payloadOffset ) ;
+    mFrame          = & frame ;
+    mCorrupt        = false ;
+    for( size_t channel = 0 ; channel < mNumChannels ; ++ channel )
+    {
+        mQuantizers[ channel ] = TracerQuantizer( header.mMin[ channel ] , header.mMax[ channel ] ) ;
+    }
+    mReference.resize( mNumTracers * numValues ) ;
+    frame.mFrame        = header.mFrame ;
+    frame.mPositionMin  = header.mMin[ 0 ] ;
+    frame.mPositionMax  = header.mMax[ 0 ] ;
+    frame.mPositions.resize( mNumTracers ) ;
+    frame.mVelocities.resize( ( mNumChannels > 1 ) ? mNumTracers : 0 ) ;
+
+#if USE_TBB
+    {
+        const size_t grainSize = std::max( size_t( 1 ) , numBlocks / std::thread::hardware_concurrency() ) ;
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numBlocks , grainSize ) , TracerDecoder_DecodeBlocks_TBB( this ) ) ;
+    }
+#else
+    DecodeBlocksSlice( 0 , numBlocks ) ;
+#endif
+
+    mFrame = nullptr ;
+    if( mCorrupt )
+    {   // Reference is now partly overwritten.
+        mHasReference = false ;
+        return false ;
+    }
+    for( size_t channel = 0 ; channel < mNumChannels ; ++ channel )
+    {
+        mRefQuantizers[ channel ] = mQuantizers[ channel ] ;
+    }
+    mHasReference = true ;
+    return true ;
+}
+
+bool TracerStreamWriter::Open( const std::string & path , bool bVelocities , size_t maxQueuedFrames , size_t keyFrameInterval )
+{
+    if( ! mWriter.Open( path , maxQueuedFrames ) ) return false ;
+
+    StreamHeader header ;
+    memset( & header , 0 , sizeof( header ) ) ;
+    memcpy( header.mMagic , sStreamMagic , sizeof( sStreamMagic ) ) ;
+    header.mVersion     = sStreamVersion ;
+    header.mNumChannels = bVelocities ? 2 : 1 ;
+    mWriter.Reserve( mRecord , true ) ;
+    mRecord.assign( reinterpret_cast< const char * >( & header ) , reinterpret_cast< const char * >( & header + 1 ) ) ;
+    mWriter.Push( mRecord ) ;
+
+    mEncoder            = TracerEncoder( bVelocities , keyFrameInterval ) ;
+    mNumDroppedFrames   = 0 ;
+    return true ;
+}
+
+bool TracerStreamWriter::Append( const std::vector< Particle > & tracers , uint64_t uFrame )
+{
+    if( ! mWriter.IsOpen() ) return false ;
+    if( ! mWriter.Reserve( mRecord , false ) )
+    {   // Writer has fallen behind, or failed.  Drop this frame rather than wait, and restart prediction.
+        ++ mNumDroppedFrames ;
+        mEncoder.Reset() ;
+        return false ;
+    }
+    mEncoder.Encode( mRecord , tracers , uFrame ) ;
+    mWriter.Push( mRecord ) ;
+    return true ;
+}
+
+bool TracerStreamReader::Open( const std::string & path )
+{
+    Close() ;
+    mFile = fopen( path.c_str() , "rb" ) ;
+    if( ! mFile ) return false ;
+    // Find file size, so ReadFrame can reject record sizes that exceed it.
+    const long fileSize = ( 0 == fseek( mFile , 0 , SEEK_END ) ) ? ftell( mFile ) : -1L ;
+    StreamHeader header ;
+    if(     ( fileSize < long( sizeof( header ) ) )
+        ||  ( 0 != fseek( mFile , 0 , SEEK_SET ) )
+        ||  ( fread( & header , sizeof( header ) , 1 , mFile ) != 1 )
+        ||  ( 0 != memcmp( header.mMagic , sStreamMagic , sizeof( sStreamMagic ) ) )
+        ||  ( header.mVersion != sStreamVersion )
+        ||  ( ( header.mNumChannels != 1 ) && ( header.mNumChannels != 2 ) ) )
+    {
+        Close() ;
+        return false ;
+    }
+    mBytesRemaining = uint64_t( fileSize ) - sizeof( header ) ;
+    mHasVelocities  = header.mNumChannels > 1 ;
+    mDecoder.Reset() ;
+    return true ;
+}
+
+bool TracerStreamReader::ReadFrame( TracerFrame & frame )
+{
+    if( ! mFile ) return false ;
+    char sizeBytes[ sizeof( uint64_t ) ] ;
+    if( fread( sizeBytes , sizeof( sizeBytes ) , 1 , mFile ) != 1 ) return false ;
+    const uint64_t recordSize = TracerDecoder::GetRecordSize( sizeBytes ) ;
+    if( ( recordSize < sizeof( FrameHeader ) ) || ( recordSize > mBytesRemaining ) ) return false ;
+    mBytesRemaining -= recordSize ;
+    mRecord.resize( size_t( recordSize ) ) ;
+    memcpy( mRecord.data() , sizeBytes , sizeof( sizeBytes ) ) ;
+    if( fread( mRecord.data() + sizeof( sizeBytes ) , 1 , mRecord.size() - sizeof( sizeBytes ) , mFile ) != mRecord.size() - sizeof( sizeBytes ) ) return false ;
+    return mDecoder.Decode( frame , mRecord.data() , mRecord.size() ) ;
+}
+
+void TracerStreamReader::Close()
+{
+    if( mFile )
+    {
+        fclose( mFile ) ;
+        mFile = nullptr ;
+    }
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Particle.hpp"
+#include "RecordWriter.hpp"
+#include "TBB_Settings.hpp"
+
+/*! \brief Quantize values of one 3-vector channel relative to a bounding box
+ */
+struct TracerQuantizer
+{
+    static const int32_t sMaxLevel = 65535 ;   ///< Largest quantized value; each component takes 16 bits
+
+    TracerQuantizer() {}
+    TracerQuantizer( const Vec3 & vMin , const Vec3 & vMax ) ;
+
+    /// Return level nearest to value, clamped to [0,sMaxLevel].
+    int32_t Quantize( float value , int axis ) const
+    {
+        const float level = ( value - mMin[ axis ] ) * mScale[ axis ] + 0.5f ;
+        if( ! ( level > 0.0f ) ) return 0 ;  // Also catches NaN.
+        return ( level >= float( sMaxLevel ) ) ? sMaxLevel : int32_t( level ) ;
+    }
+
+    float Dequantize( int32_t level , int axis ) const
+    {
+        return mMin[ axis ] + float( level ) * mStep[ axis ] ;
+    }
+
+    Vec3    mMin    ;   ///< Value that quantizes to 0
+    Vec3    mScale  ;   ///< Levels per unit value
+    Vec3    mStep   ;   ///< Units value per level
+} ;
+
+/*! \brief Tracer data decoded from one frame of a tracer stream
+ */
+struct TracerFrame
+{
+    uint64_t                mFrame          ;   ///< Frame counter passed to FluidSim::Update
+    Vec3                    mPositionMin    ;   ///< Minimal corner of bounding box of positions
+    Vec3                    mPositionMax    ;   ///< Maximal corner of bounding box of positions
+    std::vector< Vec3 >     mPositions      ;   ///< Tracer positions
+    std::vector< Vec3 >     mVelocities     ;   ///< Tracer velocities, or empty if the stream has none
+} ;
+
+/*! \brief Encode tracer positions, and optionally velocities, compactly, one frame at a time
+
+ Each frame quantizes each component to 16 bits relative to the
+ bounding box of that frame, then stores the difference from a
+ prediction as a variable-length integer.  Key frames predict each
+ tracer from the previous tracer in the same block, which exploits
+ the regular initial placement of tracers.  Other frames predict
+ each tracer from its own value in the previous frame, re-quantized
+ to the current bounding box, so tracers that move less than the box
+ typically cost 1 byte per component instead of 4.
+
+ Prediction uses values as the decoder reconstructs them, not the
+ originals, so quantization error does not accumulate over frames.
+ Key frames occur when the number of tracers changes, after Reset,
+ and periodically, so a reader can start part way through and a
+ mismatch in floating-point rounding between writer and reader
+ builds cannot persist.
+
+ Tracers have no identity field.  VortonSim never reorders tracers,
+ and only removes them during FluidSim::Initialize, so the index of a
+ tracer within a frame identifies it across frames.
+
+ Tracers are encoded in fixed-size blocks, in parallel.  Each record
+ holds a table of block sizes, so blocks also decode in parallel.
+
+ */
+class TracerEncoder
+{
+public:
+    static const size_t sBlockSize = 16384 ;   ///< Number of tracers per block
+
+    explicit TracerEncoder( bool bVelocities = false , size_t keyFrameInterval = 64 ) ;
+
+    /*! \brief Encode one frame of tracers into a self-delimiting record
+
+        \param record - (output) encoded frame.  This reuses its capacity.
+
+        \param tracers - tracers to encode.
+
+        \param uFrame - frame counter, stored with the record.
+    */
+    void Encode( std::vector< char > & record , const std::vector< Particle > & tracers , uint64_t uFrame ) ;
+
+    /// Make the next frame a key frame, for example after the previous record was discarded.
+    void Reset() { mHasReference = false ; }
+
+    bool HasVelocities() const { return mNumChannels > 1 ; }
+
+private:
+    #if USE_TBB
+        friend class TracerEncoder_ComputeBounds_TBB ;
+        friend class TracerEncoder_EncodeBlocks_TBB ;
+    #endif
+
+    void ComputeBoundsSlice( size_t iBlockStart , size_t iBlockEnd ) ;
+    void EncodeBlocksSlice( size_t iBlockStart , size_t iBlockEnd ) ;
+
+    size_t                              mNumChannels        ;   ///< 1 for positions only, 2 for positions and velocities
+    size_t                              mKeyFrameInterval   ;   ///< Maximum number of frames between key frames, or 0 for no limit
+    size_t                              mFramesSinceKey     ;   ///< Number of frames encoded since the most recent key frame
+    bool                                mHasReference       ;   ///< Whether mReference holds the previous frame
+    bool                                mIsKeyFrame         ;   ///< Whether frame being encoded is a key frame
+    const std::vector< Particle > *     mTracers            ;   ///< Tracers being encoded
+    TracerQuantizer                     mQuantizers[ 2 ]    ;   ///< Quantizers for current frame, for positions and velocities
+    TracerQuantizer                     mRefQuantizers[ 2 ] ;   ///< Quantizers for previous frame
+    std::vector< uint16_t >             mReference          ;   ///< Quantized values of previous frame, as the decoder has them
+    std::vector< Vec3 >                 mBlockBounds        ;   ///< Per-block minimum and maximum of each channel
+    std::vector< std::vector< char > >  mBlockBytes         ;   ///< Encoded bytes of each block
+} ;
+
+/*! \brief Decode records made by TracerEncoder, in the order they were encoded
+ */
+class TracerDecoder
+{
+public:
+    TracerDecoder() : mNumChannels( 0 ) , mHasReference( false ) , mCorrupt( false ) {}
+
+    /*! \brief Decode one record
+
+        \param frame - (output) decoded tracer data.
+
+        \param pRecord - record made by TracerEncoder::Encode.
+
+        \param size - number of bytes available at pRecord.
+
+        \return true if the record decoded, false if it is corrupt or
+                depends on a previous record that was not decoded.
+    */
+    bool Decode( TracerFrame & frame , const char * pRecord , size_t size ) ;
+
+    /// Return size of record starting at pRecord, given at least 8 bytes.
+    static uint64_t GetRecordSize( const char * pRecord ) ;
+
+    /// Forget previous frame, so the next one decoded must be a key frame.
+    void Reset() { mHasReference = false ; }
+
+private:
+    #if USE_TBB
+        friend class TracerDecoder_DecodeBlocks_TBB ;
+    #endif
+
+    void DecodeBlocksSlice( size_t iBlockStart , size_t iBlockEnd ) ;
+
+    size_t                  mNumChannels        ;   ///< Channels in frame being decoded
+    bool                    mHasReference       ;   ///< Whether mReference holds the previous frame
+    bool                    mIsKeyFrame         ;   ///< Whether frame being decoded is a key frame
+    size_t                  mNumTracers         ;   ///< Number of tracers in frame being decoded
+    const char *            mBlockEnds          ;   ///< Table of offsets of end of each block, relative to mPayload, possibly unaligned
+    const unsigned char *   mPayload            ;   ///< Encoded blocks
+    TracerFrame *           mFrame              ;   ///< Frame being decoded
+    TracerQuantizer         mQuantizers[ 2 ]    ;   ///< Quantizers for current frame
+    TracerQuantizer         mRefQuantizers[ 2 ] ;   ///< Quantizers for previous frame
+    std::vector< uint16_t > mReference          ;   ///< Quantized values of previous frame
+    std::atomic< bool >     mCorrupt            ;   ///< Whether any block of frame being decoded was corrupt
+} ;
+
+/*! \brief Write a tracer stream file on a background thread
+
+ Append encodes tracers on the calling thread, which takes time
+ proportional to the number of tracers but never waits on I/O, then
+ hands the record to a RecordWriter.  If the writer has fallen behind
+ so its queue is full, Append discards the frame, without encoding it,
+ and the next frame becomes a key frame.
+
+ A stream file holds a short header followed by one record per frame.
+
+ */
+class TracerStreamWriter
+{
+public:
+    TracerStreamWriter() : mNumDroppedFrames( 0 ) {}
+    ~TracerStreamWriter() { Close() ; }
+    TracerStreamWriter( const TracerStreamWriter & ) = delete ;
+    TracerStreamWriter & operator=( const TracerStreamWriter & ) = delete ;
+
+    /*! \brief Create a stream file and start its writer thread
+
+        \param path - file to create.  Any existing file gets replaced.
+
+        \param bVelocities - whether to store tracer velocities as well as positions.
+
+        \param maxQueuedFrames - number of encoded frames that can wait to be written.
+
+        \param keyFrameInterval - maximum number of frames between key frames, or 0 for no limit.
+
+        \return true if the file was created.
+    */
+    bool Open( const std::string & path , bool bVelocities = false , size_t maxQueuedFrames = 4 , size_t keyFrameInterval = 64 ) ;
+
+    /*! \brief Encode tracers and queue them to be written
+
+        \return true if the frame was queued, false if it was discarded
+                because the queue was full, a write failed, or no stream is open.
+    */
+    bool Append( const std::vector< Particle > & tracers , uint64_t uFrame ) ;
+
+    /*! \brief Write queued frames, then close the file
+
+        \return true if every queued frame was written.
+    */
+    bool Close() { return mWriter.Close() ; }
+
+    bool    IsOpen() const                  { return mWriter.IsOpen() ; }
+    size_t  GetNumDroppedFrames() const     { return mNumDroppedFrames ; }
+
+private:
+    TracerEncoder       mEncoder            ;   ///< Encodes frames on the calling thread
+    RecordWriter        mWriter             ;   ///< Writes encoded frames on a background thread
+    std::vector< char > mRecord             ;   ///< Buffer for frame being encoded
+    size_t              mNumDroppedFrames   ;   ///< Frames discarded because the queue was full
+} ;
+
+/*! \brief Read a tracer stream file, one frame at a time, from its start
+ */
+class TracerStreamReader
+{
+public:
+    TracerStreamReader() : mFile( nullptr ) , mBytesRemaining( 0 ) , mHasVelocities( false ) {}
+    ~TracerStreamReader() { Close() ; }
+    TracerStreamReader( const TracerStreamReader & ) = delete ;
+    TracerStreamReader & operator=( const TracerStreamReader & ) = delete ;
+
+    /// Open a stream file and validate its header.
+    bool Open( const std::string & path ) ;
+
+    /*! \brief Read and decode the next frame
+
+        \return true if a frame was read, false at end of file or if the file is corrupt.
+    */
+    bool ReadFrame( TracerFrame & frame ) ;
+
+    void Close() ;
+
+    bool HasVelocities() const { return mHasVelocities ; }
+
+private:
+    FILE *              mFile           ;   ///< Stream file, or nullptr when closed
+    uint64_t            mBytesRemaining ;   ///< Bytes of mFile not yet read, which bounds the size of the next record
+    bool                mHasVelocities  ;   ///< Whether frames hold velocities
+    TracerDecoder       mDecoder        ;   ///< Decoder, which remembers the previous frame
+    std::vector< char > mRecord         ;   ///< Buffer for most recently read record
+} ;
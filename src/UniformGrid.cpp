@@ -2,16 +2,16 @@
 #include "math_helper.hpp"
 #include <cassert>
 
-/// Explicit template instantiation for scalar float type.
-void UniformGrid<ofVec3f>::Interpolate(ofVec3f & vResult, const ofVec3f & vPosition) const {
+/// Explicit specialization for Vec3, which uses SIMD.
+template<> void UniformGrid<Vec3>::Interpolate(Vec3 & vResult, const Vec3 & vPosition) const {
 	size_t        indices[3]; // Indices of grid cell containing position.
 	Parent::IndicesOfPosition(indices, vPosition);
-	ofVec3f            vMinCorner;
+	Vec3          vMinCorner;
 	Parent::PositionFromIndices(vMinCorner, indices);
 	const size_t  offsetX0Y0Z0 = OffsetFromIndices(indices);
-	const ofVec3f      vDiff = vPosition - vMinCorner; // Relative location of position within its containing grid cell.
-	const ofVec3f      tween = ofVec3f(vDiff.x * GetCellsPerExtent().x, vDiff.y * GetCellsPerExtent().y, vDiff.z * GetCellsPerExtent().z);
-	const ofVec3f      oneMinusTween = ofVec3f(1.0f, 1.0f, 1.0f) - tween;
+	const Vec3    vDiff = vPosition - vMinCorner; // Relative location of position within its containing grid cell.
+	const Vec3    tween = Vec3(vDiff.x * GetCellsPerExtent().x, vDiff.y * GetCellsPerExtent().y, vDiff.z * GetCellsPerExtent().z);
+	const Vec3    oneMinusTween = Vec3(1.0f, 1.0f, 1.0f) - tween;
 	const size_t  numXY = GetNumPoints(0) * GetNumPoints(1);
 	const size_t  offsetX1Y0Z0 = offsetX0Y0Z0 + 1;
 	const size_t  offsetX0Y1Z0 = offsetX0Y0Z0 + GetNumPoints(0);
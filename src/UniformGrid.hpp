@@ -1,6 +1,6 @@
 #pragma once
 
-#include "ofVec3f.h"
+#include "Vec3.hpp"
 #include "UniformGridGeometry.hpp"
 #include <vector>
 
@@ -15,7 +15,7 @@ public:
 	/*! \brief Construct a uniform grid container that fits the given geometry.
 		\see Initialize
 	*/
-	UniformGrid(size_t uNumElements, const ofVec3f & vMin, const ofVec3f & vMax, bool bPowerOf2 = true)
+	UniformGrid(size_t uNumElements, const Vec3 & vMin, const Vec3 & vMax, bool bPowerOf2 = true)
 		: UniformGridGeometry(uNumElements, vMin, vMax, bPowerOf2) {}
 
 	/// Copy shape from given uniform grid
@@ -45,12 +45,12 @@ public:
 
 	TypeT & 	operator[](const size_t & offset) { return mContents.at(offset); }
 	const TypeT & 	operator[](const size_t & offset) const { return mContents.at(offset); }
-	TypeT &			operator[](const ofVec3f & pos) { return mContents.at(OffsetOfPosition(pos)); }
+	TypeT &			operator[](const Vec3 & pos) { return mContents.at(OffsetOfPosition(pos)); }
 
 	/// Initialize contents to whatever default ctor provides
 	void Init() { mContents.resize(GetGridCapacity()); }
 
-	virtual void DefineShape(size_t uNumElements, const ofVec3f & vMin, const ofVec3f & vMax, bool bPowerOf2) override {
+	virtual void DefineShape(size_t uNumElements, const Vec3 & vMin, const Vec3 & vMax, bool bPowerOf2) override {
 		mContents.clear();
 		Parent::DefineShape(uNumElements, vMin, vMax, bPowerOf2);
 	}
@@ -81,18 +81,18 @@ public:
 		\return Interpolated value corresponding to value of grid contents at vPosition.
 
 	*/
-	void Interpolate(TypeT &vResult, const ofVec3f &vPosition) const;
+	void Interpolate(TypeT &vResult, const Vec3 &vPosition) const;
 
 	/// Insert given value into grid at given position
-	void Insert(const ofVec3f & vPosition, const TypeT & item) {
+	void Insert(const Vec3 & vPosition, const TypeT & item) {
 		size_t        indices[3]; // Indices of grid cell containing position.
 		Parent::IndicesOfPosition(indices, vPosition);
-		ofVec3f            vMinCorner;
+		Vec3          vMinCorner;
 		Parent::PositionFromIndices(vMinCorner, indices);
 		const size_t  offsetX0Y0Z0 = OffsetFromIndices(indices);
-		const ofVec3f      vDiff = vPosition - vMinCorner; // Relative location of position within its containing grid cell.
-		const ofVec3f      tween = ofVec3f(vDiff.x * GetCellsPerExtent().x, vDiff.y * GetCellsPerExtent().y, vDiff.z * GetCellsPerExtent().z);
-		const ofVec3f      oneMinusTween = ofVec3f(1.0f, 1.0f, 1.0f) - tween;
+		const Vec3    vDiff = vPosition - vMinCorner; // Relative location of position within its containing grid cell.
+		const Vec3    tween = Vec3(vDiff.x * GetCellsPerExtent().x, vDiff.y * GetCellsPerExtent().y, vDiff.z * GetCellsPerExtent().z);
+		const Vec3    oneMinusTween = Vec3(1.0f, 1.0f, 1.0f) - tween;
 		const size_t  numXY = GetNumPoints(0) * GetNumPoints(1);
 		const size_t  offsetX1Y0Z0 = offsetX0Y0Z0 + 1;
 		const size_t  offsetX0Y1Z0 = offsetX0Y0Z0 + GetNumPoints(0);
@@ -121,20 +121,20 @@ private:
 	std::vector<TypeT> mContents;
 };
 
-/// Explicit template instantiation for ofVec3f.
+/// Explicit template instantiation for Vec3.
 /// \see UniformGrid.cpp
-extern template void UniformGrid<ofVec3f>::Interpolate(ofVec3f & result, const ofVec3f & vPosition) const;
+template<> void UniformGrid<Vec3>::Interpolate(Vec3 & result, const Vec3 & vPosition) const;
 
 template <class TypeT>
-void UniformGrid<TypeT>::Interpolate(TypeT &vResult, const ofVec3f &vPosition) const {
+void UniformGrid<TypeT>::Interpolate(TypeT &vResult, const Vec3 &vPosition) const {
 	size_t        indices[3]; // Indices of grid cell containing position.
 	Parent::IndicesOfPosition(indices, vPosition);
-	ofVec3f            vMinCorner;
+	Vec3          vMinCorner;
 	Parent::PositionFromIndices(vMinCorner, indices);
 	const size_t  offsetX0Y0Z0 = OffsetFromIndices(indices);
-	const ofVec3f      vDiff = vPosition - vMinCorner; // Relative location of position within its containing grid cell.
-	const ofVec3f      tween = ofVec3f(vDiff.x * GetCellsPerExtent().x, vDiff.y * GetCellsPerExtent().y, vDiff.z * GetCellsPerExtent().z);
-	const ofVec3f      oneMinusTween = ofVec3f(1.0f, 1.0f, 1.0f) - tween;
+	const Vec3    vDiff = vPosition - vMinCorner; // Relative location of position within its containing grid cell.
+	const Vec3    tween = Vec3(vDiff.x * GetCellsPerExtent().x, vDiff.y * GetCellsPerExtent().y, vDiff.z * GetCellsPerExtent().z);
+	const Vec3    oneMinusTween = Vec3(1.0f, 1.0f, 1.0f) - tween;
 	const size_t  numXY = GetNumPoints(0) * GetNumPoints(1);
 	const size_t  offsetX1Y0Z0 = offsetX0Y0Z0 + 1;
 	const size_t  offsetX0Y1Z0 = offsetX0Y0Z0 + GetNumPoints(0);
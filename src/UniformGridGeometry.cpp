@@ -3,13 +3,13 @@
 #include "UniformGridGeometry.hpp"
 #include "math_helper.hpp"
 
-void UniformGridGeometry::DefineShape(size_t uNumElements, const ofVec3f & vMin, const ofVec3f & vMax, bool bPowerOf2)
+void UniformGridGeometry::DefineShape(size_t uNumElements, const Vec3 & vMin, const Vec3 & vMax, bool bPowerOf2)
 {
 	mMinCorner = vMin;
 	static const float Nudge = 1.0f + FLT_EPSILON;  // slightly expand size to ensure robust containment even with roundoff
 	mGridExtent = (vMax - vMin) * Nudge;
 
-	ofVec3f vSizeEffective(GetExtent());
+	Vec3 vSizeEffective(GetExtent());
 	int numDims = 3;   // Number of dimensions to region.
 	if (0.0f == vSizeEffective.x)
 	{   // X size is zero so reduce dimensionality
@@ -93,27 +93,27 @@ void UniformGridGeometry::Decimate(const UniformGridGeometry & src, int iDecimat
 	PrecomputeSpacing();
 }
 
-void UniformGridGeometry::IndicesOfPosition(size_t indices[3], const ofVec3f & vPosition) const
+void UniformGridGeometry::IndicesOfPosition(size_t indices[3], const Vec3 & vPosition) const
 {
 	// Notice the peculiar test here.  vPosition may lie slightly outside of the extent give by vMax.
 	// Review the geometry described in the class header comment.
-	ofVec3f vPosRel(vPosition - GetMinCorner());   // position of given point relative to container region
-	ofVec3f vIdx(vPosRel.x * GetCellsPerExtent().x, vPosRel.y * GetCellsPerExtent().y, vPosRel.z * GetCellsPerExtent().z);
+	Vec3 vPosRel(vPosition - GetMinCorner());   // position of given point relative to container region
+	Vec3 vIdx(vPosRel.x * GetCellsPerExtent().x, vPosRel.y * GetCellsPerExtent().y, vPosRel.z * GetCellsPerExtent().z);
 	indices[0] = unsigned(vIdx.x);
 	indices[1] = unsigned(vIdx.y);
 	indices[2] = unsigned(vIdx.z);
 }
 
-size_t UniformGridGeometry::OffsetOfPosition(const ofVec3f & vPosition) {
+size_t UniformGridGeometry::OffsetOfPosition(const Vec3 & vPosition) {
 	size_t indices[3];
 	IndicesOfPosition(indices, vPosition);
 	const size_t offset = indices[0] + GetNumPoints(0) * (indices[1] + GetNumPoints(1) * indices[2]);
 	return offset;
 }
 
-void UniformGridGeometry::PositionFromIndices(ofVec3f & vPosition, const size_t indices[3]) const
+void UniformGridGeometry::PositionFromIndices(Vec3 & vPosition, const size_t indices[3]) const
 {
-    ofVec3f indexFloats(indices[0], indices[1], indices[2]);
+    Vec3 indexFloats(indices[0], indices[1], indices[2]);
     vPosition = GetMinCorner() + (indexFloats * GetCellSpacing());
 }
 
@@ -124,10 +124,10 @@ void UniformGridGeometry::IndicesFromOffset(size_t indices[3], const size_t & of
 	indices[0] = offset - GetNumPoints(0) * (indices[1] + GetNumPoints(1) * indices[2]);
 }
 
-void UniformGridGeometry::PositionFromOffset(ofVec3f & vPos, const size_t & offset)
+void UniformGridGeometry::PositionFromOffset(Vec3 & vPos, const size_t & offset)
 {
 	size_t indices[3];
 	IndicesFromOffset(indices, offset);
-    ofVec3f indexVec(indices[0], indices[1], indices[2]);
+    Vec3 indexVec(indices[0], indices[1], indices[2]);
     vPos = GetMinCorner() + (indexVec * GetCellSpacing());
 }
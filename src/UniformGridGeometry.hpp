@@ -1,5 +1,5 @@
 #pragma once
-#include "ofVectorMath.h"
+#include "Vec3.hpp"
 
 /*! \brief Base class for uniform grid.
 
@@ -70,7 +70,7 @@ public:
 
 	 \see Clear, DefineShape
 	 */
-	UniformGridGeometry(size_t uNumElements, const ofVec3f & vMin, const ofVec3f & vMax, bool bPowerOf2 = true)
+	UniformGridGeometry(size_t uNumElements, const Vec3 & vMin, const Vec3 & vMax, bool bPowerOf2 = true)
 	{
 		DefineShape(uNumElements, vMin, vMax, bPowerOf2);
 	}
@@ -96,7 +96,7 @@ public:
 	 (2,3,0) then this class considers the region to have 2 dimensions
 	 (x and y) since the z size is zero.
 	 */
-	virtual void DefineShape(size_t uNumElements, const ofVec3f & vMin, const ofVec3f & vMax, bool bPowerOf2);
+	virtual void DefineShape(size_t uNumElements, const Vec3 & vMin, const Vec3 & vMax, bool bPowerOf2);
 
 	/*! \brief Create a lower-resolution uniform grid based on another
 
@@ -121,7 +121,7 @@ public:
 	\note Derived class defines the actual contents array.
 
 	*/
-	virtual void IndicesOfPosition(size_t indices[3], const ofVec3f & vPosition) const;
+	virtual void IndicesOfPosition(size_t indices[3], const Vec3 & vPosition) const;
 
 	/*! \brief Compute offset into contents array of a point at a given position
 
@@ -134,7 +134,24 @@ public:
 	\note Derived class defines the actual contents array.
 
 	*/
-	virtual size_t OffsetOfPosition(const ofVec3f & vPosition);
+	virtual size_t OffsetOfPosition(const Vec3 & vPosition);
+
+	/*! \brief Return whether a position lies strictly inside a grid cell, where Interpolate can sample it
+
+	\param vPosition - position of a point.
+
+	\note Interpolate reads the gridpoint above the query point, so this excludes the maximal faces.
+	It computes cell coordinates the same way IndicesOfPosition does, since rounding can put
+	a point just inside a maximal face onto the last gridpoint.
+
+	*/
+	bool Encloses(const Vec3 & vPosition) const
+	{
+		const Vec3 vIdx((vPosition - GetMinCorner()) * GetCellsPerExtent());
+		return      (vIdx.x >= 0.0f) && (vIdx.x < float(GetNumCells(0)))
+			&&  (vIdx.y >= 0.0f) && (vIdx.y < float(GetNumCells(1)))
+			&&  (vIdx.z >= 0.0f) && (vIdx.z < float(GetNumCells(2)));
+	}
 
 	/*! \brief Compute position of minimal corner of grid cell with given indices
 
@@ -149,7 +166,7 @@ public:
 	GetCellSpacing instead of computing it each iteration.
 
 	*/
-	virtual void PositionFromIndices(ofVec3f & vPosition, const size_t indices[3]) const;
+	virtual void PositionFromIndices(Vec3 & vPosition, const size_t indices[3]) const;
 
 	/*! \brief Compute X,Y,Z grid cell indices from offset into contents array.
 
@@ -173,11 +190,11 @@ public:
 	\note Derived class provides actual contents array.
 
 	*/
-	virtual void    PositionFromOffset(ofVec3f & vPos, const size_t & offset);
+	virtual void    PositionFromOffset(Vec3 & vPos, const size_t & offset);
 
 	//Getters and Setters
-	ofVec3f & GetExtent() { return mGridExtent; }
-	const ofVec3f & GetExtent() const { return mGridExtent; }
+	Vec3 & GetExtent() { return mGridExtent; }
+	const Vec3 & GetExtent() const { return mGridExtent; }
 
 	/// Get number of grid cells along the given dimension
 	size_t GetNumCells(const size_t & index) const {
@@ -189,13 +206,13 @@ public:
 		return mNumPoints[index];
 	}
 
-	const ofVec3f & GetMinCorner() const { return mMinCorner; }
-	ofVec3f & GetMinCorner() { return mMinCorner; }
-	const ofVec3f & GetCellsPerExtent() const { return mCellsPerExtent; }
-	ofVec3f & GetCellsPerExtent() { return mCellsPerExtent; }
+	const Vec3 & GetMinCorner() const { return mMinCorner; }
+	Vec3 & GetMinCorner() { return mMinCorner; }
+	const Vec3 & GetCellsPerExtent() const { return mCellsPerExtent; }
+	Vec3 & GetCellsPerExtent() { return mCellsPerExtent; }
 	size_t GetGridCapacity() const { return GetNumPoints(0) * GetNumPoints(1) * GetNumPoints(2); }
-	const ofVec3f & GetCellSpacing() const { return mCellExtent; }
-	ofVec3f & GetCellSpacing() { return mCellExtent; }
+	const Vec3 & GetCellSpacing() const { return mCellExtent; }
+	Vec3 & GetCellSpacing() { return mCellExtent; }
 
 	virtual void CopyShape(const UniformGridGeometry & src) { Decimate(src, 1); }
 
@@ -231,13 +248,13 @@ protected:
 		mMinCorner =
 			mGridExtent =
 			mCellExtent =
-			mCellsPerExtent = ofVec3f(0.0f, 0.0f, 0.0f);
+			mCellsPerExtent = Vec3(0.0f, 0.0f, 0.0f);
 		mNumPoints[0] = mNumPoints[1] = mNumPoints[2] = 0;
 	}
 
-	ofVec3f        mMinCorner;   ///< Minimum position (in world units) of grid in X, Y and Z directions.
-	ofVec3f        mGridExtent;   ///< Size (in world units) of grid in X, Y and Z directions.
-	ofVec3f        mCellExtent;   ///< Size (in world units) of a cell.
-	ofVec3f        mCellsPerExtent;   ///< Reciprocal of cell size (precomputed once to avoid excess divides).
+	Vec3                mMinCorner;   ///< Minimum position (in world units) of grid in X, Y and Z directions.
+	Vec3                mGridExtent;   ///< Size (in world units) of grid in X, Y and Z directions.
+	Vec3                mCellExtent;   ///< Size (in world units) of a cell.
+	Vec3                mCellsPerExtent;   ///< Reciprocal of cell size (precomputed once to avoid excess divides).
 	size_t              mNumPoints[3];   ///< Number of gridpoints along X, Y and Z directions.
 };
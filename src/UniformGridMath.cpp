@@ -1,195 +1,352 @@
 #include "UniformGridMath.hpp"
+#include <thread>
 
-void UniformGridMath::ComputeJacobian( UniformGrid< Mat3 > & jacobian , const UniformGrid< ofVec3f > & vec ) {
-    const ofVec3f      spacing                 = vec.GetCellSpacing() ;
-    // Avoid divide-by-zero when z size is effectively 0 (for 2D domains)
-    const ofVec3f      reciprocalSpacing( 1.0f / spacing.x , 1.0f / spacing.y , spacing.z > FLT_EPSILON ? 1.0f / spacing.z : 0.0f ) ;
-    const ofVec3f      halfReciprocalSpacing( 0.5f * reciprocalSpacing ) ;
-    const size_t  dims[3]                 = { vec.GetNumPoints( 0 )   , vec.GetNumPoints( 1 )   , vec.GetNumPoints( 2 )   } ;
-    const size_t  dimsMinus1[3]           = { vec.GetNumPoints( 0 )-1 , vec.GetNumPoints( 1 )-1 , vec.GetNumPoints( 2 )-1 } ;
-    const size_t  numXY                   = dims[0] * dims[1] ;
-    size_t        index[3] ;
-
-// Reusable vars declared as macros to keep code compact
-// TODO: Reuse vars, as it is more space-efficient.
-#define ASSIGN_Z_OFFSETS                                    \
-    const size_t offsetZM = numXY * ( index[2] - 1 ) ;    \
-    const size_t offsetZ0 = numXY *   index[2]       ;    \
-    const size_t offsetZP = numXY * ( index[2] + 1 ) ;
-
-#define ASSIGN_YZ_OFFSETS                                                   \
-    const size_t offsetYMZ0 = dims[ 0 ] * ( index[1] - 1 ) + offsetZ0 ;   \
-    const size_t offsetY0Z0 = dims[ 0 ] *   index[1]       + offsetZ0 ;   \
-    const size_t offsetYPZ0 = dims[ 0 ] * ( index[1] + 1 ) + offsetZ0 ;   \
-    const size_t offsetY0ZM = dims[ 0 ] *   index[1]       + offsetZM ;   \
-    const size_t offsetY0ZP = dims[ 0 ] *   index[1]       + offsetZP ;
-
-#define ASSIGN_XYZ_OFFSETS                                      \
-    const size_t offsetX0Y0Z0 = index[0]     + offsetY0Z0 ;   \
-    const size_t offsetXMY0Z0 = index[0] - 1 + offsetY0Z0 ;   \
-    const size_t offsetXPY0Z0 = index[0] + 1 + offsetY0Z0 ;   \
-    const size_t offsetX0YMZ0 = index[0]     + offsetYMZ0 ;   \
-    const size_t offsetX0YPZ0 = index[0]     + offsetYPZ0 ;   \
-    const size_t offsetX0Y0ZM = index[0]     + offsetY0ZM ;   \
-    const size_t offsetX0Y0ZP = index[0]     + offsetY0ZP ;
-
-    // Compute derivatives for interior (i.e. away from boundaries).
-    for( index[2] = 1 ; index[2] < dimsMinus1[2] ; ++ index[2] )
-    {
-        ASSIGN_Z_OFFSETS ;
-        for( index[1] = 1 ; index[1] < dimsMinus1[1] ; ++ index[1] )
-        {
-            ASSIGN_YZ_OFFSETS ;
-            for( index[0] = 1 ; index[0] < dimsMinus1[0] ; ++ index[0] )
-            {
-                ASSIGN_XYZ_OFFSETS ;
-
-                Mat3 & rMatrix = jacobian[ offsetX0Y0Z0 ] ;
-                /// Compute d/dx
-                rMatrix[0] = ( vec[ offsetXPY0Z0 ] - vec[ offsetXMY0Z0 ] ) * halfReciprocalSpacing.x ;
-                /// Compute d/dy
-                rMatrix[1] = ( vec[ offsetX0YPZ0 ] - vec[ offsetX0YMZ0 ] ) * halfReciprocalSpacing.y ;
-                /// Compute d/dz
-                rMatrix[2] = ( vec[ offsetX0Y0ZP ] - vec[ offsetX0Y0ZM ] ) * halfReciprocalSpacing.z ;
-            }
-        }
+#if USE_TBB
+
+/*! \brief Function object to compute Jacobian of a vector field using Threading Building Blocks
+ */
+class UniformGridMath_ComputeJacobian_TBB
+{
+    UniformGrid< Mat3 >             & mJacobian ;   ///< Output grid of matrices
+    const UniformGrid< Vec3 >       & mVec      ;   ///< Input grid of vectors
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Compute subset of Jacobian grid.
+        UniformGridMath::ComputeJacobianSlice( mJacobian , mVec , r.begin() , r.end() ) ;
     }
+    UniformGridMath_ComputeJacobian_TBB( UniformGrid< Mat3 > & jacobian , const UniformGrid< Vec3 > & vec )
+    : mJacobian( jacobian )
+    , mVec( vec )
+    {}
+} ;
 
-// Reusable code block
-// Compute derivatives for boundaries: 6 faces of box.
-// In some situations, these macros compute extraneous data.
-#define COMPUTE_FINITE_DIFF                                                                                                              \
-    Mat3 & rMatrix = jacobian[ offsetX0Y0Z0 ] ;                                                                                     \
-    if( index[0] == 0 )                     { rMatrix[0] = ( vec[ offsetXPY0Z0 ] - vec[ offsetX0Y0Z0 ] ) * reciprocalSpacing.x ;     }   \
-    else if( index[0] == dimsMinus1[0] )    { rMatrix[0] = ( vec[ offsetX0Y0Z0 ] - vec[ offsetXMY0Z0 ] ) * reciprocalSpacing.x ;     }   \
-    else                                    { rMatrix[0] = ( vec[ offsetXPY0Z0 ] - vec[ offsetXMY0Z0 ] ) * halfReciprocalSpacing.x ; }   \
-    if( index[1] == 0 )                     { rMatrix[1] = ( vec[ offsetX0YPZ0 ] - vec[ offsetX0Y0Z0 ] ) * reciprocalSpacing.y ;     }   \
-    else if( index[1] == dimsMinus1[1] )    { rMatrix[1] = ( vec[ offsetX0Y0Z0 ] - vec[ offsetX0YMZ0 ] ) * reciprocalSpacing.y ;     }   \
-    else                                    { rMatrix[1] = ( vec[ offsetX0YPZ0 ] - vec[ offsetX0YMZ0 ] ) * halfReciprocalSpacing.y ; }   \
-    if( index[2] == 0 )                     { rMatrix[2] = ( vec[ offsetX0Y0ZP ] - vec[ offsetX0Y0Z0 ] ) * reciprocalSpacing.z ;     }   \
-    else if( index[2] == dimsMinus1[2] )    { rMatrix[2] = ( vec[ offsetX0Y0Z0 ] - vec[ offsetX0Y0ZM ] ) * reciprocalSpacing.z ;     }   \
-    else                                    { rMatrix[2] = ( vec[ offsetX0Y0ZP ] - vec[ offsetX0Y0ZM ] ) * halfReciprocalSpacing.z ; }
-
-        // Compute derivatives for -X boundary.
-    index[0] = 0 ;
-    for( index[2] = 0 ; index[2] < dims[2] ; ++ index[2] )
-    {
-        ASSIGN_Z_OFFSETS ;
-        for( index[1] = 0 ; index[1] < dims[1] ; ++ index[1] )
-        {
-            ASSIGN_YZ_OFFSETS ;
-            {
-                ASSIGN_XYZ_OFFSETS ;
-                COMPUTE_FINITE_DIFF ;
-            }
-        }
+/*! \brief Function object to compute curl from Jacobian using Threading Building Blocks
+ */
+class UniformGridMath_ComputeCurlFromJacobian_TBB
+{
+    UniformGrid< Vec3 >             & mCurl     ;   ///< Output grid of vectors
+    const UniformGrid< Mat3 >       & mJacobian ;   ///< Input grid of matrices
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Compute subset of curl grid.
+        UniformGridMath::ComputeCurlFromJacobianSlice( mCurl , mJacobian , r.begin() , r.end() ) ;
+    }
+    UniformGridMath_ComputeCurlFromJacobian_TBB( UniformGrid< Vec3 > & curl , const UniformGrid< Mat3 > & jacobian )
+    : mCurl( curl )
+    , mJacobian( jacobian )
+    {}
+} ;
+
+/*! \brief Function object to compute curl directly from a vector field using Threading Building Blocks
+ */
+class UniformGridMath_ComputeCurl_TBB
+{
+    UniformGrid< Vec3 >             & mCurl     ;   ///< Output grid of vectors
+    const UniformGrid< Vec3 >       & mVec      ;   ///< Input grid of vectors
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Compute subset of curl grid.
+        UniformGridMath::ComputeCurlSlice( mCurl , mVec , r.begin() , r.end() ) ;
+    }
+    UniformGridMath_ComputeCurl_TBB( UniformGrid< Vec3 > & curl , const UniformGrid< Vec3 > & vec )
+    : mCurl( curl )
+    , mVec( vec )
+    {}
+} ;
+
+/*! \brief Function object to compute gradient of a scalar field using Threading Building Blocks
+ */
+class UniformGridMath_ComputeGradient_TBB
+{
+    UniformGrid< Vec3 >             & mGradient ;   ///< Output grid of vectors
+    const UniformGrid< float >      & mScalar   ;   ///< Input grid of scalars
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Compute subset of gradient grid.
+        UniformGridMath::ComputeGradientSlice( mGradient , mScalar , r.begin() , r.end() ) ;
     }
+    UniformGridMath_ComputeGradient_TBB( UniformGrid< Vec3 > & gradient , const UniformGrid< float > & scalar )
+    : mGradient( gradient )
+    , mScalar( scalar )
+    {}
+} ;
+#endif
 
-    // Compute derivatives for -Y boundary.
-    index[1] = 0 ;
-    for( index[2] = 0 ; index[2] < dims[2] ; ++ index[2] )
+namespace {
+
+/*! \brief Finite-difference stencil along a single axis
+
+    Interior points use central differences.  Points on the minimal
+    and maximal faces use one-sided differences.  Computing this once
+    per row (for y) or per slab (for z) keeps the innermost x loop
+    free of branches, so the compiler can vectorize it.
+*/
+struct FiniteDiffStencil
+{
+    size_t  mOffsetMinus    ;   ///< Offset of the "minus" sample, i.e. index * stride of the lesser neighbor
+    size_t  mOffsetPlus     ;   ///< Offset of the "plus" sample
+    float   mScale          ;   ///< Reciprocal of the distance between the two samples
+
+    FiniteDiffStencil( size_t index , size_t dimMinus1 , size_t stride , float reciprocalSpacing )
     {
-        ASSIGN_Z_OFFSETS ;
-        {
-            ASSIGN_YZ_OFFSETS ;
-            for( index[0] = 0 ; index[0] < dims[0] ; ++ index[0] )
-            {
-                ASSIGN_XYZ_OFFSETS ;
-                COMPUTE_FINITE_DIFF ;
-            }
+        if( 0 == index )
+        {   // Minimal face: forward difference.
+            mOffsetMinus    = index * stride ;
+            mOffsetPlus     = ( index + 1 ) * stride ;
+            mScale          = reciprocalSpacing ;
+        }
+        else if( dimMinus1 == index )
+        {   // Maximal face: backward difference.
+            mOffsetMinus    = ( index - 1 ) * stride ;
+            mOffsetPlus     = index * stride ;
+            mScale          = reciprocalSpacing ;
+        }
+        else
+        {   // Interior: central difference.
+            mOffsetMinus    = ( index - 1 ) * stride ;
+            mOffsetPlus     = ( index + 1 ) * stride ;
+            mScale          = 0.5f * reciprocalSpacing ;
         }
     }
+} ;
+
+/// Reciprocal of grid spacing, avoiding divide-by-zero when z size is effectively 0 (for 2D domains)
+inline Vec3 ReciprocalSpacing( const UniformGridGeometry & grid )
+{
+    const Vec3 & spacing = grid.GetCellSpacing() ;
+    return Vec3( 1.0f / spacing.x , 1.0f / spacing.y , spacing.z > FLT_EPSILON ? 1.0f / spacing.z : 0.0f ) ;
+}
+
+/// Estimate grain size based on size of problem and number of processors.
+inline size_t GrainSizeForSlabs( size_t numZ )
+{
+    return std::max( size_t( 1 ) , numZ / std::thread::hardware_concurrency() ) ;
+}
+
+/*! \brief Compute curl from partial derivatives of a vector field
+
+    \param ddx - partial derivative of each component with respect to x, i.e. j[0]
+
+    \param ddy - partial derivative of each component with respect to y, i.e. j[1]
+
+    \param ddz - partial derivative of each component with respect to z, i.e. j[2]
+
+*/
+inline Vec3 CurlFromPartials( const Vec3 & ddx , const Vec3 & ddy , const Vec3 & ddz )
+{
+    return Vec3( ddy.z - ddz.y , ddz.x - ddx.z , ddx.y - ddy.x ) ;
+}
+
+}
+
+void UniformGridMath::ComputeJacobian( UniformGrid< Mat3 > & jacobian , const UniformGrid< Vec3 > & vec ) {
+    const size_t numZ = vec.GetNumPoints( 2 ) ;
+#if USE_TBB
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numZ , GrainSizeForSlabs( numZ ) ) , UniformGridMath_ComputeJacobian_TBB( jacobian , vec ) ) ;
+#else
+    ComputeJacobianSlice( jacobian , vec , 0 , numZ ) ;
+#endif
+}
+
+/*! \brief Compute Jacobian of a vector field, for a subset of z-slabs
+
+    \param izStart - starting value for z index
+
+    \param izEnd - ending value for z index
 
-    // Compute derivatives for -Z boundary.
-    index[2] = 0 ;
+    \note Each slab only writes to its own gridpoints, and reads neighboring
+            slabs, so slabs can be processed concurrently without contention.
+
+    \see ComputeJacobian
+*/
+void UniformGridMath::ComputeJacobianSlice( UniformGrid< Mat3 > & jacobian , const UniformGrid< Vec3 > & vec , size_t izStart , size_t izEnd ) {
+    const Vec3          reciprocalSpacing       = ReciprocalSpacing( vec ) ;
+    const float         halfReciprocalSpacingX  = 0.5f * reciprocalSpacing.x ;
+    const size_t        dims[3]                 = { vec.GetNumPoints( 0 )   , vec.GetNumPoints( 1 )   , vec.GetNumPoints( 2 )   } ;
+    const size_t        dimsMinus1[3]           = { vec.GetNumPoints( 0 )-1 , vec.GetNumPoints( 1 )-1 , vec.GetNumPoints( 2 )-1 } ;
+    const size_t        numXY                   = dims[0] * dims[1] ;
+    const Vec3 *        pVec                    = vec.mContents.data() ;
+    Mat3 *              pJac                    = jacobian.mContents.data() ;
+
+    for( size_t iz = izStart ; iz < izEnd ; ++ iz )
     {
-        ASSIGN_Z_OFFSETS ;
-        for( index[1] = 0 ; index[1] < dims[1] ; ++ index[1] )
+        const FiniteDiffStencil stencilZ( iz , dimsMinus1[2] , numXY , reciprocalSpacing.z ) ;
+        const size_t offsetZ0 = numXY * iz ;
+        for( size_t iy = 0 ; iy < dims[1] ; ++ iy )
         {
-            ASSIGN_YZ_OFFSETS ;
-            for( index[0] = 0 ; index[0] < dims[0] ; ++ index[0] )
+            const FiniteDiffStencil stencilY( iy , dimsMinus1[1] , dims[0] , reciprocalSpacing.y ) ;
+            const size_t    offsetY    = dims[0] * iy ;
+            const Vec3 * pRow       = pVec + offsetY + offsetZ0 ;
+            const Vec3 * pRowYM     = pVec + stencilY.mOffsetMinus + offsetZ0 ;
+            const Vec3 * pRowYP     = pVec + stencilY.mOffsetPlus  + offsetZ0 ;
+            const Vec3 * pRowZM     = pVec + offsetY + stencilZ.mOffsetMinus ;
+            const Vec3 * pRowZP     = pVec + offsetY + stencilZ.mOffsetPlus ;
+            Mat3 *          pJacRow    = pJac + offsetY + offsetZ0 ;
+
+            for( size_t ix = 0 ; ix < dims[0] ; ++ ix )
+            {   // Compute d/dy and d/dz along entire row.
+                Mat3 & rMatrix = pJacRow[ ix ] ;
+                rMatrix[1] = ( pRowYP[ ix ] - pRowYM[ ix ] ) * stencilY.mScale ;
+                rMatrix[2] = ( pRowZP[ ix ] - pRowZM[ ix ] ) * stencilZ.mScale ;
+            }
+
+            // Compute d/dx: one-sided at the ends of the row, central in between.
+            pJacRow[ 0 ][0] = ( pRow[ 1 ] - pRow[ 0 ] ) * reciprocalSpacing.x ;
+            for( size_t ix = 1 ; ix < dimsMinus1[0] ; ++ ix )
             {
-                ASSIGN_XYZ_OFFSETS ;
-                COMPUTE_FINITE_DIFF ;
+                pJacRow[ ix ][0] = ( pRow[ ix + 1 ] - pRow[ ix - 1 ] ) * halfReciprocalSpacingX ;
             }
+            pJacRow[ dimsMinus1[0] ][0] = ( pRow[ dimsMinus1[0] ] - pRow[ dimsMinus1[0] - 1 ] ) * reciprocalSpacing.x ;
         }
     }
+}
+
+void UniformGridMath::ComputeCurlFromJacobian( UniformGrid< Vec3 > & curl , const UniformGrid< Mat3 > & jacobian ) {
+    const size_t numZ = jacobian.GetNumPoints( 2 ) ;
+#if USE_TBB
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numZ , GrainSizeForSlabs( numZ ) ) , UniformGridMath_ComputeCurlFromJacobian_TBB( curl , jacobian ) ) ;
+#else
+    ComputeCurlFromJacobianSlice( curl , jacobian , 0 , numZ ) ;
+#endif
+}
+
+/*! \brief Compute curl from Jacobian, for a subset of z-slabs
+
+    \param izStart - starting value for z index
 
-    // Compute derivatives for +X boundary.
-    index[0] = dimsMinus1[0] ;
-    for( index[2] = 0 ; index[2] < dims[2] ; ++ index[2] )
+    \param izEnd - ending value for z index
+
+    \see ComputeCurlFromJacobian
+*/
+void UniformGridMath::ComputeCurlFromJacobianSlice( UniformGrid< Vec3 > & curl , const UniformGrid< Mat3 > & jacobian , size_t izStart , size_t izEnd ) {
+    const size_t    numXY   = jacobian.GetNumPoints( 0 ) * jacobian.GetNumPoints( 1 ) ;
+    const Mat3 *    pJac    = jacobian.mContents.data() + numXY * izStart ;
+    Vec3 *          pCurl   = curl.mContents.data() + numXY * izStart ;
+    const size_t    count   = numXY * ( izEnd - izStart ) ;
+
+    // Slabs are contiguous so this needs only a single flat loop.
+    for( size_t offset = 0 ; offset < count ; ++ offset )
     {
-        ASSIGN_Z_OFFSETS ;
-        for( index[1] = 0 ; index[1] < dims[1] ; ++ index[1] )
-        {
-            ASSIGN_YZ_OFFSETS ;
-            {
-                ASSIGN_XYZ_OFFSETS ;
-                COMPUTE_FINITE_DIFF ;
-            }
-        }
+        const Mat3 & j = pJac[ offset ] ;
+        // Meaning of j[i][k] is the derivative of the kth component with respect to i, i.e. di/dk.
+        pCurl[ offset ] = CurlFromPartials( j[0] , j[1] , j[2] ) ;
     }
+}
+
+void UniformGridMath::ComputeCurl( UniformGrid< Vec3 > & curl , const UniformGrid< Vec3 > & vec ) {
+    const size_t numZ = vec.GetNumPoints( 2 ) ;
+#if USE_TBB
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numZ , GrainSizeForSlabs( numZ ) ) , UniformGridMath_ComputeCurl_TBB( curl , vec ) ) ;
+#else
+    ComputeCurlSlice( curl , vec , 0 , numZ ) ;
+#endif
+}
+
+/*! \brief Compute curl of a vector field directly, for a subset of z-slabs
 
+    \param izStart - starting value for z index
 
-    // Compute derivatives for +Y boundary.
-    index[1] = dimsMinus1[1] ;
-    for( index[2] = 0 ; index[2] < dims[2] ; ++ index[2] )
+    \param izEnd - ending value for z index
+
+    \see ComputeCurl, ComputeJacobianSlice
+*/
+void UniformGridMath::ComputeCurlSlice( UniformGrid< Vec3 > & curl , const UniformGrid< Vec3 > & vec , size_t izStart , size_t izEnd ) {
+    const Vec3          reciprocalSpacing       = ReciprocalSpacing( vec ) ;
+    const float         halfReciprocalSpacingX  = 0.5f * reciprocalSpacing.x ;
+    const size_t        dims[3]                 = { vec.GetNumPoints( 0 )   , vec.GetNumPoints( 1 )   , vec.GetNumPoints( 2 )   } ;
+    const size_t        dimsMinus1[3]           = { vec.GetNumPoints( 0 )-1 , vec.GetNumPoints( 1 )-1 , vec.GetNumPoints( 2 )-1 } ;
+    const size_t        numXY                   = dims[0] * dims[1] ;
+    const Vec3 *        pVec                    = vec.mContents.data() ;
+    Vec3 *              pCurl                   = curl.mContents.data() ;
+
+    for( size_t iz = izStart ; iz < izEnd ; ++ iz )
     {
-        ASSIGN_Z_OFFSETS ;
+        const FiniteDiffStencil stencilZ( iz , dimsMinus1[2] , numXY , reciprocalSpacing.z ) ;
+        const size_t offsetZ0 = numXY * iz ;
+        for( size_t iy = 0 ; iy < dims[1] ; ++ iy )
         {
-            ASSIGN_YZ_OFFSETS ;
-            for( index[0] = 0 ; index[0] < dims[0] ; ++ index[0] )
+            const FiniteDiffStencil stencilY( iy , dimsMinus1[1] , dims[0] , reciprocalSpacing.y ) ;
+            const size_t    offsetY    = dims[0] * iy ;
+            const Vec3 * pRow       = pVec + offsetY + offsetZ0 ;
+            const Vec3 * pRowYM     = pVec + stencilY.mOffsetMinus + offsetZ0 ;
+            const Vec3 * pRowYP     = pVec + stencilY.mOffsetPlus  + offsetZ0 ;
+            const Vec3 * pRowZM     = pVec + offsetY + stencilZ.mOffsetMinus ;
+            const Vec3 * pRowZP     = pVec + offsetY + stencilZ.mOffsetPlus ;
+            Vec3 *          pCurlRow   = pCurl + offsetY + offsetZ0 ;
+
+#define COMPUTE_CURL_AT( ix , ddx )                                                 \
+            {                                                                       \
+                const Vec3 ddy = ( pRowYP[ ix ] - pRowYM[ ix ] ) * stencilY.mScale ; \
+                const Vec3 ddz = ( pRowZP[ ix ] - pRowZM[ ix ] ) * stencilZ.mScale ; \
+                pCurlRow[ ix ] = CurlFromPartials( ddx , ddy , ddz ) ;              \
+            }
+
+            COMPUTE_CURL_AT( 0 , ( pRow[ 1 ] - pRow[ 0 ] ) * reciprocalSpacing.x ) ;
+            for( size_t ix = 1 ; ix < dimsMinus1[0] ; ++ ix )
             {
-                ASSIGN_XYZ_OFFSETS ;
-                COMPUTE_FINITE_DIFF ;
+                COMPUTE_CURL_AT( ix , ( pRow[ ix + 1 ] - pRow[ ix - 1 ] ) * halfReciprocalSpacingX ) ;
             }
+            COMPUTE_CURL_AT( dimsMinus1[0] , ( pRow[ dimsMinus1[0] ] - pRow[ dimsMinus1[0] - 1 ] ) * reciprocalSpacing.x ) ;
+
+#undef COMPUTE_CURL_AT
         }
     }
+}
+
+void UniformGridMath::ComputeGradient( UniformGrid< Vec3 > & gradient , const UniformGrid< float > & scalar ) {
+    const size_t numZ = scalar.GetNumPoints( 2 ) ;
+#if USE_TBB
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numZ , GrainSizeForSlabs( numZ ) ) , UniformGridMath_ComputeGradient_TBB( gradient , scalar ) ) ;
+#else
+    ComputeGradientSlice( gradient , scalar , 0 , numZ ) ;
+#endif
+}
+
+/*! \brief Compute gradient of a scalar field, for a subset of z-slabs
 
-    // Compute derivatives for +Z boundary.
-    index[2] = dimsMinus1[2] ;
+    \param izStart - starting value for z index
+
+    \param izEnd - ending value for z index
+
+    \see ComputeGradient
+*/
+void UniformGridMath::ComputeGradientSlice( UniformGrid< Vec3 > & gradient , const UniformGrid< float > & scalar , size_t izStart , size_t izEnd ) {
+    const Vec3          reciprocalSpacing       = ReciprocalSpacing( scalar ) ;
+    const float         halfReciprocalSpacingX  = 0.5f * reciprocalSpacing.x ;
+    const size_t        dims[3]                 = { scalar.GetNumPoints( 0 )   , scalar.GetNumPoints( 1 )   , scalar.GetNumPoints( 2 )   } ;
+    const size_t        dimsMinus1[3]           = { scalar.GetNumPoints( 0 )-1 , scalar.GetNumPoints( 1 )-1 , scalar.GetNumPoints( 2 )-1 } ;
+    const size_t        numXY                   = dims[0] * dims[1] ;
+    const float *       pScalar                 = scalar.mContents.data() ;
+    Vec3 *              pGrad                   = gradient.mContents.data() ;
+
+    for( size_t iz = izStart ; iz < izEnd ; ++ iz )
     {
-        ASSIGN_Z_OFFSETS ;
-        for( index[1] = 0 ; index[1] < dims[1] ; ++ index[1] )
+        const FiniteDiffStencil stencilZ( iz , dimsMinus1[2] , numXY , reciprocalSpacing.z ) ;
+        const size_t offsetZ0 = numXY * iz ;
+        for( size_t iy = 0 ; iy < dims[1] ; ++ iy )
         {
-            ASSIGN_YZ_OFFSETS ;
-            for( index[0] = 0 ; index[0] < dims[0] ; ++ index[0] )
+            const FiniteDiffStencil stencilY( iy , dimsMinus1[1] , dims[0] , reciprocalSpacing.y ) ;
+            const size_t    offsetY    = dims[0] * iy ;
+            const float *   pRow       = pScalar + offsetY + offsetZ0 ;
+            const float *   pRowYM     = pScalar + stencilY.mOffsetMinus + offsetZ0 ;
+            const float *   pRowYP     = pScalar + stencilY.mOffsetPlus  + offsetZ0 ;
+            const float *   pRowZM     = pScalar + offsetY + stencilZ.mOffsetMinus ;
+            const float *   pRowZP     = pScalar + offsetY + stencilZ.mOffsetPlus ;
+            Vec3 *          pGradRow   = pGrad + offsetY + offsetZ0 ;
+
+            for( size_t ix = 0 ; ix < dims[0] ; ++ ix )
+            {   // Compute d/dy and d/dz along entire row.
+                pGradRow[ ix ].y = ( pRowYP[ ix ] - pRowYM[ ix ] ) * stencilY.mScale ;
+                pGradRow[ ix ].z = ( pRowZP[ ix ] - pRowZM[ ix ] ) * stencilZ.mScale ;
+            }
+
+            // Compute d/dx: one-sided at the ends of the row, central in between.
+            pGradRow[ 0 ].x = ( pRow[ 1 ] - pRow[ 0 ] ) * reciprocalSpacing.x ;
+            for( size_t ix = 1 ; ix < dimsMinus1[0] ; ++ ix )
             {
-                ASSIGN_XYZ_OFFSETS ;
-                COMPUTE_FINITE_DIFF ;
+                pGradRow[ ix ].x = ( pRow[ ix + 1 ] - pRow[ ix - 1 ] ) * halfReciprocalSpacingX ;
             }
+            pGradRow[ dimsMinus1[0] ].x = ( pRow[ dimsMinus1[0] ] - pRow[ dimsMinus1[0] - 1 ] ) * reciprocalSpacing.x ;
         }
     }
-
-#undef COMPUTE_FINITE_DIFF
-#undef ASSIGN_XYZ_OFFSETS
-#undef ASSIGN_YZ_OFFSETS
-#undef ASSIGN_Z_OFFSETS
-
-}
-
-void UniformGridMath::ComputeCurlFromJacobian( UniformGrid< ofVec3f > & curl , const UniformGrid< Mat3 > & jacobian ) {
-	const size_t  dims[3]     = { jacobian.GetNumPoints( 0 ) , jacobian.GetNumPoints( 1 ) , jacobian.GetNumPoints( 2 ) } ;
-	const size_t  numXY       = dims[0] * dims[1] ;
-	size_t        index[3] ;
-
-    // Compute curl from Jacobian
-	for( index[2] = 0 ; index[2] < dims[2] ; ++ index[2] )
-	{
-		const size_t offsetZ = numXY * index[2]       ;
-		for( index[1] = 0 ; index[1] < dims[1] ; ++ index[1] )
-		{
-			const size_t offsetYZ = dims[ 0 ] * index[1] + offsetZ ;
-			for( index[0] = 0 ; index[0] < dims[0] ; ++ index[0] )
-			{
-				const size_t offsetXYZ = index[0] + offsetYZ ;
-				const Mat3 & j     = jacobian[ offsetXYZ ] ;
-				ofVec3f        & rCurl = curl[ offsetXYZ ] ;
-                // Meaning of j[i][k] is the derivative of the kth component with respect to i, i.e. di/dk.
-				// rCurl = ofVec3f( j.y.z - j.z.y , j.z.x - j.x.z , j.x.y - j.y.x ) ;
-				rCurl = ofVec3f( j[1][2] - j[2][1] , j[2][0] - j[0][2] , j[0][1] - j[1][0] ) ;
-
-			}
-		}
-	}
 }
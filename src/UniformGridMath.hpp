@@ -1,8 +1,9 @@
 #pragma once
 
-#include "ofVec3f.h"
+#include "Vec3.hpp"
 #include "Mat3.hpp" // Use my custom vector type.
 #include "UniformGrid.hpp"
+#include "TBB_Settings.hpp"
 
 /// Mathematical routines for UniformGrids of vectors or matrices
 class UniformGridMath
@@ -21,7 +22,7 @@ public:
 	    \param vec - UniformGrid of 3-vector values
 
 	*/
-	static void ComputeJacobian( UniformGrid< Mat3 > & jacobian , const UniformGrid< ofVec3f > & vec ) ;
+	static void ComputeJacobian( UniformGrid< Mat3 > & jacobian , const UniformGrid< Vec3 > & vec ) ;
 
 	/*! \brief Compute curl of a vector field, from its Jacobian
 
@@ -32,9 +33,42 @@ public:
 	    \see ComputeJacobian.
 
 	*/
-	static void ComputeCurlFromJacobian( UniformGrid< ofVec3f > & curl , const UniformGrid< Mat3 > & jacobian ) ;
+	static void ComputeCurlFromJacobian( UniformGrid< Vec3 > & curl , const UniformGrid< Mat3 > & jacobian ) ;
+
+	/*! \brief Compute curl of a vector field directly, without materializing its Jacobian
+
+	    \param curl - (output) UniformGrid of 3-vector values.
+
+	    \param vec - UniformGrid of 3-vector values
+
+	    \note This yields the same values as ComputeJacobian followed by
+	            ComputeCurlFromJacobian, but only reads the 6 off-diagonal
+	            partial derivatives and never stores a grid of matrices.
+
+	*/
+	static void ComputeCurl( UniformGrid< Vec3 > & curl , const UniformGrid< Vec3 > & vec ) ;
+
+	/*! \brief Compute gradient of a scalar field
+
+	    \param gradient - (output) UniformGrid of 3-vector values.
+
+	    \param scalar - UniformGrid of scalar values
+
+	*/
+	static void ComputeGradient( UniformGrid< Vec3 > & gradient , const UniformGrid< float > & scalar ) ;
 
 private:
 	UniformGridMath(); // Non-instantiable class.
-	
+
+	static void ComputeJacobianSlice( UniformGrid< Mat3 > & jacobian , const UniformGrid< Vec3 > & vec , size_t izStart , size_t izEnd ) ;
+	static void ComputeCurlFromJacobianSlice( UniformGrid< Vec3 > & curl , const UniformGrid< Mat3 > & jacobian , size_t izStart , size_t izEnd ) ;
+	static void ComputeCurlSlice( UniformGrid< Vec3 > & curl , const UniformGrid< Vec3 > & vec , size_t izStart , size_t izEnd ) ;
+	static void ComputeGradientSlice( UniformGrid< Vec3 > & gradient , const UniformGrid< float > & scalar , size_t izStart , size_t izEnd ) ;
+
+#if USE_TBB
+	friend class UniformGridMath_ComputeJacobian_TBB ;
+	friend class UniformGridMath_ComputeCurlFromJacobian_TBB ;
+	friend class UniformGridMath_ComputeCurl_TBB ;
+	friend class UniformGridMath_ComputeGradient_TBB ;
+#endif
 };
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cmath>
+#include <cfloat>
+
+// Constants guarded the same way openFrameworks guards them, so either header may come first.
+#ifndef PI
+#define PI 3.14159265358979323846
+#endif
+#ifndef TWO_PI
+#define TWO_PI 6.28318530717958647693
+#endif
+#ifndef FOUR_PI
+#define FOUR_PI 12.56637061435917295385
+#endif
+#ifndef HALF_PI
+#define HALF_PI 1.57079632679489661923
+#endif
+
+class Vec3;
+
+/*! \brief 2D vector of floats
+ */
+class Vec2 {
+public:
+	Vec2() : x(0.f), y(0.f) {}
+	explicit Vec2(float scalar) : x(scalar), y(scalar) {}
+	Vec2(float _x, float _y) : x(_x), y(_y) {}
+	/// Drops z, like ofVec2f.
+	Vec2(const Vec3 & vec);
+
+	Vec2 operator+(const Vec2 & v) const { return Vec2(x + v.x, y + v.y); }
+	Vec2 operator-(const Vec2 & v) const { return Vec2(x - v.x, y - v.y); }
+	Vec2 operator*(float s) const { return Vec2(x * s, y * s); }
+
+	float x, y;
+};
+
+/*! \brief 3D vector of floats, padded and aligned to 16 bytes
+
+	The simulation core uses this instead of ofVec3f so that it does not
+	depend on openFrameworks.  The interface mirrors the subset of ofVec3f
+	the core uses.
+
+	Alignment lets LoadVec3 and StoreVec3 move a vector into or out of a
+	SIMD register with a single aligned instruction, and keeps vectors
+	from straddling cache lines.  The padding float is always zero.
+ */
+class alignas(16) Vec3 {
+public:
+	Vec3() : x(0.f), y(0.f), z(0.f), mPad(0.f) {}
+	explicit Vec3(float scalar) : x(scalar), y(scalar), z(scalar), mPad(0.f) {}
+	Vec3(float _x, float _y, float _z = 0.f) : x(_x), y(_y), z(_z), mPad(0.f) {}
+	Vec3(const Vec2 & vec) : x(vec.x), y(vec.y), z(0.f), mPad(0.f) {}
+
+	float & operator[](int i) { return (&x)[i]; }
+	const float & operator[](int i) const { return (&x)[i]; }
+	float * getPtr() { return &x; }
+	const float * getPtr() const { return &x; }
+
+	Vec3 operator+(const Vec3 & v) const { return Vec3(x + v.x, y + v.y, z + v.z); }
+	Vec3 operator-(const Vec3 & v) const { return Vec3(x - v.x, y - v.y, z - v.z); }
+	Vec3 operator*(const Vec3 & v) const { return Vec3(x * v.x, y * v.y, z * v.z); }
+	Vec3 operator/(const Vec3 & v) const { return Vec3(x / v.x, y / v.y, z / v.z); }
+	Vec3 operator+(float s) const { return Vec3(x + s, y + s, z + s); }
+	Vec3 operator-(float s) const { return Vec3(x - s, y - s, z - s); }
+	Vec3 operator*(float s) const { return Vec3(x * s, y * s, z * s); }
+	Vec3 operator/(float s) const { return Vec3(x / s, y / s, z / s); }
+	Vec3 operator-() const { return Vec3(-x, -y, -z); }
+
+	Vec3 & operator+=(const Vec3 & v) { x += v.x; y += v.y; z += v.z; return *this; }
+	Vec3 & operator-=(const Vec3 & v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+	Vec3 & operator*=(const Vec3 & v) { x *= v.x; y *= v.y; z *= v.z; return *this; }
+	Vec3 & operator/=(const Vec3 & v) { x /= v.x; y /= v.y; z /= v.z; return *this; }
+	Vec3 & operator*=(float s) { x *= s; y *= s; z *= s; return *this; }
+	Vec3 & operator/=(float s) { x /= s; y /= s; z /= s; return *this; }
+
+	bool operator==(const Vec3 & v) const { return (x == v.x) && (y == v.y) && (z == v.z); }
+	bool operator!=(const Vec3 & v) const { return !(*this == v); }
+
+	float length() const { return sqrtf(x * x + y * y + z * z); }
+	float lengthSquared() const { return x * x + y * y + z * z; }
+	float distance(const Vec3 & v) const { return (*this - v).length(); }
+	float squareDistance(const Vec3 & v) const { return (*this - v).lengthSquared(); }
+	float dot(const Vec3 & v) const { return x * v.x + y * v.y + z * v.z; }
+
+	Vec3 getCrossed(const Vec3 & v) const { return Vec3(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x); }
+	Vec3 & cross(const Vec3 & v) { *this = getCrossed(v); return *this; }
+
+	/// Return this vector scaled to unit length, or unchanged if it has zero length.
+	Vec3 getNormalized() const {
+		const float len = length();
+		return (len > 0.f) ? Vec3(x / len, y / len, z / len) : *this;
+	}
+	Vec3 & normalize() { *this = getNormalized(); return *this; }
+
+	float x, y, z;
+
+private:
+	float mPad; ///< Fourth SIMD lane.  Always zero.
+};
+
+inline Vec3 operator*(float s, const Vec3 & v) { return v * s; }
+inline Vec3 operator/(float s, const Vec3 & v) { return Vec3(s / v.x, s / v.y, s / v.z); }
+
+inline Vec2::Vec2(const Vec3 & vec) : x(vec.x), y(vec.y) {}
@@ -0,0 +1,282 @@
+#include "VolumeExport.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "MappedFile.hpp"
+#include "TracerStream.hpp"
+#include "UniformGridMath.hpp"
+
+namespace {
+
+const char sVolumeMagic[ 8 ] = { 'V' , 'O' , 'R' , 'T' , 'V' , 'O' , 'L' , 'M' } ;
+const uint32_t sVolumeVersion = 1 ;
+
+/*! \brief Leading part of a volume file
+
+    Plain floats and integers, rather than Vec3, so tools in other
+    languages can read it as a flat record of 88 bytes.
+*/
+struct VolumeHeader
+{
+    char        mMagic[ 8 ]         ;   ///< Identifies file as a volume
+    uint32_t    mVersion            ;   ///< sVolumeVersion of the writer
+    uint32_t    mEncoding           ;   ///< VolumeExporter::EncodingE
+    uint64_t    mFrame              ;   ///< Frame counter
+    uint32_t    mNumPoints[ 3 ]     ;   ///< Number of gridpoints along x, y and z
+    uint32_t    mNumComponents      ;   ///< Number of values per gridpoint; always 3
+    float       mMinCorner[ 3 ]     ;   ///< Position of first gridpoint
+    float       mSpacing[ 3 ]       ;   ///< Distance between adjacent gridpoints along x, y and z
+    float       mRangeMin[ 3 ]      ;   ///< Minimum of each component over the grid
+    float       mRangeMax[ 3 ]      ;   ///< Maximum of each component over the grid
+} ;
+
+size_t GetValueSize( uint32_t encoding )
+{
+    return ( VolumeExporter::ENCODING_QUANTIZED_16 == encoding ) ? sizeof( uint16_t ) : sizeof( float ) ;
+}
+
+} // namespace
+
+VolumeExporter::VolumeExporter()
+    : mEncoding( ENCODING_FLOAT32 )
+    , mNumDroppedFrames( 0 )
+    , mStopping( false )
+    , mWriteFailed( false )
+{
+}
+
+void VolumeExporter::Start( const std::string & pathPrefix , EncodingE encoding )
+{
+    Stop() ;
+    mPathPrefix         = pathPrefix ;
+    mEncoding           = encoding ;
+    mNumDroppedFrames   = 0 ;
+    mStopping           = false ;
+    mWriteFailed        = false ;
+    mThread = std::thread( & VolumeExporter::ExportQueuedFrames , this ) ;
+}
+
+bool VolumeExporter::Export( const UniformGrid< Vec3 > & velGrid , uint64_t uFrame )
+{
+    if( ! IsStarted() || ( 0 == velGrid.Size() ) ) return false ;
+
+    Slot * pSlot = nullptr ;
+    {
+        std::lock_guard< std::mutex > lock( mMutex ) ;
+        for( Slot & rSlot : mSlots )
+        {
+            if( SLOT_FREE == rSlot.mState )
+            {
+                pSlot = & rSlot ;
+                break ;
+            }
+        }
+        if( nullptr == pSlot )
+        {   // Background thread has fallen behind.  Drop this frame rather than wait.
+            ++ mNumDroppedFrames ;
+            return false ;
+        }
+        pSlot->mState = SLOT_BUSY ;
+    }
+
+    // Copy grid without holding the lock, so the background thread can carry on with the other slot.
+    pSlot->mVelocity.CopyShape( velGrid ) ;
+    pSlot->mVelocity.Init() ;
+    const size_t numPoints = velGrid.GetGridCapacity() ;
+    for( size_t offset = 0 ; offset < numPoints ; ++ offset )
+    {
+        pSlot->mVelocity[ offset ] = velGrid[ offset ] ;
+    }
+    pSlot->mFrame = uFrame ;
+
+    {
+        std::lock_guard< std::mutex > lock( mMutex ) ;
+        pSlot->mState = SLOT_QUEUED ;
+    }
+    mSlotQueued.notify_one() ;
+    return true ;
+}
+
+void VolumeExporter::ExportQueuedFrames()
+{
+    std::unique_lock< std::mutex > lock( mMutex ) ;
+    for( ;; )
+    {
+        Slot * pSlot = nullptr ;
+        mSlotQueued.wait( lock , [ & ]()
+        {   // Find earliest queued frame.
+            for( Slot & rSlot : mSlots )
+            {
+                if( ( SLOT_QUEUED == rSlot.mState ) && ( ( nullptr == pSlot ) || ( rSlot.mFrame < pSlot->mFrame ) ) )
+                {
+                    pSlot = & rSlot ;
+                }
+            }
+            return mStopping || ( nullptr != pSlot ) ;
+        } ) ;
+        if( nullptr == pSlot )
+        {   // Stopping and nothing left to export.
+            return ;
+        }
+        pSlot->mState = SLOT_BUSY ;
+        lock.unlock() ;
+
+        char frameSuffix[ 32 ] ;
+        snprintf( frameSuffix , sizeof( frameSuffix ) , "_%06llu.vol" , static_cast< unsigned long long >( pSlot->mFrame ) ) ;
+        // ComputeCurl yields the same values as ComputeJacobian followed by ComputeCurlFromJacobian, without a grid of matrices.
+        mVorticity.CopyShape( pSlot->mVelocity ) ;
+        mVorticity.Init() ;
+        UniformGridMath::ComputeCurl( mVorticity , pSlot->mVelocity ) ;
+        const bool bWritten =   WriteVolume( mPathPrefix + "_velocity" + frameSuffix , pSlot->mVelocity , mEncoding , pSlot->mFrame )
+                            &&  WriteVolume( mPathPrefix + "_vorticity" + frameSuffix , mVorticity , mEncoding , pSlot->mFrame ) ;
+
+        lock.lock() ;
+        mWriteFailed = mWriteFailed || ! bWritten ;
+        pSlot->mState = SLOT_FREE ;
+    }
+}
+
+bool VolumeExporter::Stop()
+{
+    if( ! IsStarted() ) return ! mWriteFailed ;
+    {
+        std::lock_guard< std::mutex > lock( mMutex ) ;
+        mStopping = true ;
+    }
+    mSlotQueued.notify_one() ;
+    mThread.join() ;
+    return ! mWriteFailed ;
+}
+
+/* static */ bool VolumeExporter::WriteVolume( const std::string & path , const UniformGrid< Vec3 > & grid , EncodingE encoding , uint64_t uFrame )
+{
+    const size_t numPoints = grid.GetGridCapacity() ;
+    if( ( 0 == numPoints ) || ( grid.Size() != numPoints ) ) return false ;
+
+    VolumeHeader header ;
+    memset( & header , 0 , sizeof( header ) ) ;
+    memcpy( header.mMagic , sVolumeMagic , sizeof( sVolumeMagic ) ) ;
+    header.mVersion         = sVolumeVersion ;
+    header.mEncoding        = uint32_t( encoding ) ;
+    header.mFrame           = uFrame ;
+    header.mNumComponents   = 3 ;
+    Vec3 vMin( grid[ 0 ] ) ;
+    Vec3 vMax( grid[ 0 ] ) ;
+    for( size_t offset = 1 ; offset < numPoints ; ++ offset )
+    {
+        const Vec3 & vValue = grid[ offset ] ;
+        vMin = Vec3( std::min( vMin.x , vValue.x ) , std::min( vMin.y , vValue.y ) , std::min( vMin.z , vValue.z ) ) ;
+        vMax = Vec3( std::max( vMax.x , vValue.x ) , std::max( vMax.y , vValue.y ) , std::max( vMax.z , vValue.z ) ) ;
+    }
+    for( int axis = 0 ; axis < 3 ; ++ axis )
+    {
+        header.mNumPoints[ axis ]   = uint32_t( grid.GetNumPoints( axis ) ) ;
+        header.mMinCorner[ axis ]   = grid.GetMinCorner()[ axis ] ;
+        header.mSpacing[ axis ]     = grid.GetCellSpacing()[ axis ] ;
+        header.mRangeMin[ axis ]    = vMin[ axis ] ;
+        header.mRangeMax[ axis ]    = vMax[ axis ] ;
+    }
+
+    // Encode whole volume, then write it with one call.
+    std::vector< char > data( 3 * numPoints * GetValueSize( encoding ) ) ;
+    if( ENCODING_QUANTIZED_16 == encoding )
+    {
+        const TracerQuantizer   quantizer( vMin , vMax ) ;
+        uint16_t *              pLevels = reinterpret_cast< uint16_t * >( data.data() ) ;
+        for( size_t offset = 0 ; offset < numPoints ; ++ offset )
+        {
+            const Vec3 & vValue = grid[ offset ] ;
+            for( int axis = 0 ; axis < 3 ; ++ axis )
+            {
+                * pLevels ++ = uint16_t( quantizer.Quantize( vValue[ axis ] , axis ) ) ;
+            }
+        }
+    }
+    else
+    {   // Drop padding of Vec3.
+        float * pFloats = reinterpret_cast< float * >( data.data() ) ;
+        for( size_t offset = 0 ; offset < numPoints ; ++ offset )
+        {
+            const Vec3 & vValue = grid[ offset ] ;
+            * pFloats ++ = vValue.x ;
+            * pFloats ++ = vValue.y ;
+            * pFloats ++ = vValue.z ;
+        }
+    }
+
+    const std::string pathTemp = path + ".tmp" ;
+    FILE * pFile = fopen( pathTemp.c_str() , "wb" ) ;
+    if( ! pFile ) return false ;
+    const bool bWritten =   ( fwrite( & header , sizeof( header ) , 1 , pFile ) == 1 )
+                        &&  ( fwrite( data.data() , 1 , data.size() , pFile ) == data.size() ) ;
+    const bool bClosed  = 0 == fclose( pFile ) ;
+    if( ! ( bWritten && bClosed ) )
+    {
+        remove( pathTemp.c_str() ) ;
+        return false ;
+    }
+#if defined( _WIN32 )
+    remove( path.c_str() ) ;    // rename does not replace existing files on Windows.
+#endif
+    return 0 == rename( pathTemp.c_str() , path.c_str() ) ;
+}
+
+/* static */ bool VolumeExporter::ReadVolume( UniformGrid< Vec3 > & grid , uint64_t & uFrame , const std::string & path )
+{
+    MappedFile file( path ) ;
+    const char * pFile = file.GetData() ;
+    if( ( nullptr == pFile ) || ( file.GetSize() < sizeof( VolumeHeader ) ) ) return false ;
+
+    VolumeHeader header ;
+    memcpy( & header , pFile , sizeof( header ) ) ;
+    const uint64_t numPoints = uint64_t( header.mNumPoints[ 0 ] ) * header.mNumPoints[ 1 ] * header.mNumPoints[ 2 ] ;
+    if(     ( 0 != memcmp( header.mMagic , sVolumeMagic , sizeof( sVolumeMagic ) ) )
+        ||  ( header.mVersion != sVolumeVersion )
+        ||  ( ( header.mEncoding != ENCODING_FLOAT32 ) && ( header.mEncoding != ENCODING_QUANTIZED_16 ) )
+        ||  ( header.mNumComponents != 3 )
+        ||  ( header.mNumPoints[ 0 ] < 2 ) || ( header.mNumPoints[ 1 ] < 2 ) || ( header.mNumPoints[ 2 ] < 2 )
+        ||  ( file.GetSize() != sizeof( header ) + 3 * numPoints * GetValueSize( header.mEncoding ) ) )
+    {
+        return false ;
+    }
+
+    // Define shape from gridpoint counts, with one cell per element, then set corner and spacing exactly.
+    const Vec3 vMinCorner( header.mMinCorner[ 0 ] , header.mMinCorner[ 1 ] , header.mMinCorner[ 2 ] ) ;
+    const Vec3 vSpacing( header.mSpacing[ 0 ] , header.mSpacing[ 1 ] , header.mSpacing[ 2 ] ) ;
+    const Vec3 vNumCells( float( header.mNumPoints[ 0 ] - 1 ) , float( header.mNumPoints[ 1 ] - 1 ) , float( header.mNumPoints[ 2 ] - 1 ) ) ;
+    grid.DefineShape( size_t( vNumCells.x * vNumCells.y * vNumCells.z ) , Vec3( 0.0f , 0.0f , 0.0f ) , vNumCells , false ) ;
+    if(     ( grid.GetNumPoints( 0 ) != header.mNumPoints[ 0 ] )
+        ||  ( grid.GetNumPoints( 1 ) != header.mNumPoints[ 1 ] )
+        ||  ( grid.GetNumPoints( 2 ) != header.mNumPoints[ 2 ] ) )
+    {
+        return false ;
+    }
+    grid.GetMinCorner()         = vMinCorner ;
+    grid.GetExtent()            = vSpacing * vNumCells ;
+    grid.GetCellSpacing()       = vSpacing ;
+    grid.GetCellsPerExtent()    = Vec3( 1.0f / vSpacing.x , 1.0f / vSpacing.y , 1.0f / vSpacing.z ) ;
+    grid.Init() ;
+
+    const char * pData = pFile + sizeof( header ) ;
+    if( ENCODING_QUANTIZED_16 == header.mEncoding )
+    {
+        const TracerQuantizer quantizer( Vec3( header.mRangeMin[ 0 ] , header.mRangeMin[ 1 ] , header.mRangeMin[ 2 ] )
+                                       , Vec3( header.mRangeMax[ 0 ] , header.mRangeMax[ 1 ] , header.mRangeMax[ 2 ] ) ) ;
+        const uint16_t * pLevels = reinterpret_cast< const uint16_t * >( pData ) ;
+        for( size_t offset = 0 ; offset < numPoints ; ++ offset , pLevels += 3 )
+        {
+            grid[ offset ] = Vec3( quantizer.Dequantize( pLevels[ 0 ] , 0 ) , quantizer.Dequantize( pLevels[ 1 ] , 1 ) , quantizer.Dequantize( pLevels[ 2 ] , 2 ) ) ;
+        }
+    }
+    else
+    {
+        const float * pFloats = reinterpret_cast< const float * >( pData ) ;
+        for( size_t offset = 0 ; offset < numPoints ; ++ offset , pFloats += 3 )
+        {
+            grid[ offset ] = Vec3( pFloats[ 0 ] , pFloats[ 1 ] , pFloats[ 2 ] ) ;
+        }
+    }
+    uFrame = header.mFrame ;
+    return true ;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "UniformGrid.hpp"
+
+/*! \brief Write velocity and vorticity grids to volume files, on a background thread
+
+ Each call to Export copies the velocity grid into one of two buffers
+ and returns.  A background thread computes vorticity from the copy,
+ then writes one file per field:
+
+    <prefix>_velocity_<frame>.vol
+    <prefix>_vorticity_<frame>.vol
+
+ While the background thread works on one buffer, the next Export fills
+ the other.  If both are busy, Export drops the frame instead of waiting,
+ so exporting never stalls the simulation.
+
+ Each file holds a small header followed by gridpoint values, x varying
+ fastest, then y, then z, the same layout as UniformGrid.  Values are
+ either raw floats or 16-bit integers quantized over the range of each
+ component.  Both keep a fixed size per gridpoint, so volume renderers
+ can map the file and index it directly.
+
+ Files are written to a temporary name then renamed, so tools that poll
+ for new frames never see a partial file.
+
+ */
+class VolumeExporter
+{
+public:
+    enum EncodingE
+    {
+        ENCODING_FLOAT32 ,          ///< 3 floats per gridpoint
+        ENCODING_QUANTIZED_16 ,     ///< 3 uint16_t per gridpoint, mapped linearly onto the range in the header
+    } ;
+
+    VolumeExporter() ;
+    ~VolumeExporter() { Stop() ; }
+    VolumeExporter( const VolumeExporter & ) = delete ;
+    VolumeExporter & operator=( const VolumeExporter & ) = delete ;
+
+    /*! \brief Start background thread
+
+        \param pathPrefix - start of each file path, possibly including a directory, which must exist.
+
+        \param encoding - how to store gridpoint values.
+    */
+    void Start( const std::string & pathPrefix , EncodingE encoding = ENCODING_FLOAT32 ) ;
+
+    /*! \brief Copy velocity grid and queue it to be exported
+
+        \param velGrid - velocity grid, for example VortonSim::GetVelocityGrid.
+
+        \param uFrame - frame counter, used in file names.
+
+        \return true if the frame was queued, false if it was dropped because both
+                buffers were busy, the grid is empty, or the exporter is not started.
+    */
+    bool Export( const UniformGrid< Vec3 > & velGrid , uint64_t uFrame ) ;
+
+    /*! \brief Finish queued exports and stop background thread
+
+        \return true if every file was written.
+    */
+    bool Stop() ;
+
+    bool    IsStarted() const               { return mThread.joinable() ; }
+    size_t  GetNumDroppedFrames() const     { return mNumDroppedFrames ; }
+
+    /*! \brief Write a grid of vectors to a volume file, on the calling thread
+
+        \return true if the file was written.
+    */
+    static bool WriteVolume( const std::string & path , const UniformGrid< Vec3 > & grid , EncodingE encoding , uint64_t uFrame ) ;
+
+    /*! \brief Read a volume file written by WriteVolume
+
+        \param grid - (output) grid with the shape and values from the file.
+
+        \param uFrame - (output) frame counter stored in the file.
+
+        \return true if the file was read, false if it could not be read or is not a volume file.
+    */
+    static bool ReadVolume( UniformGrid< Vec3 > & grid , uint64_t & uFrame , const std::string & path ) ;
+
+private:
+    enum SlotStateE
+    {
+        SLOT_FREE ,     ///< Available to Export
+        SLOT_QUEUED ,   ///< Holds a frame waiting to be exported
+        SLOT_BUSY ,     ///< Owned by one thread, which is filling or exporting it
+    } ;
+
+    /// Copy of a velocity grid, and which frame it came from
+    struct Slot
+    {
+        Slot() : mFrame( 0 ) , mState( SLOT_FREE ) {}
+        UniformGrid< Vec3 > mVelocity   ;
+        uint64_t            mFrame      ;
+        SlotStateE          mState      ;
+    } ;
+
+    void ExportQueuedFrames() ;
+
+    std::string                 mPathPrefix         ;   ///< Start of each file path
+    EncodingE                   mEncoding           ;   ///< How to store gridpoint values
+    Slot                        mSlots[ 2 ]         ;   ///< Double buffer of velocity grids
+    UniformGrid< Vec3 >         mVorticity          ;   ///< Vorticity computed by background thread
+    std::thread                 mThread             ;   ///< Thread computing vorticity and writing files
+    std::mutex                  mMutex              ;   ///< Guards slot states and members below
+    std::condition_variable     mSlotQueued         ;   ///< Signals a slot was queued, or stopping
+    size_t                      mNumDroppedFrames   ;   ///< Frames dropped because both slots were busy
+    bool                        mStopping           ;   ///< Whether Stop asked the background thread to finish
+    bool                        mWriteFailed        ;   ///< Whether any write failed
+} ;
@@ -0,0 +1,225 @@
+#include "VolumeLineIntegralConvolution.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <thread>
+#include "UniformGridMath.hpp"
+
+#if USE_TBB
+
+/*! \brief Function object to find voxels where vorticity exceeds threshold using Threading Building Blocks
+ */
+class VolumeLineIntegralConvolution_ClassifyVoxels_TBB
+{
+    VolumeLineIntegralConvolution * mLic ;  ///< Address of VolumeLineIntegralConvolution object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Classify subset of z-layers.
+        mLic->ClassifyVoxelsSlice( r.begin() , r.end() ) ;
+    }
+    VolumeLineIntegralConvolution_ClassifyVoxels_TBB( VolumeLineIntegralConvolution * pLic )
+    : mLic( pLic ) {}
+} ;
+
+/*! \brief Function object to convolve active voxels using Threading Building Blocks
+ */
+class VolumeLineIntegralConvolution_ConvolveVoxels_TBB
+{
+    VolumeLineIntegralConvolution * mLic ;  ///< Address of VolumeLineIntegralConvolution object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Convolve subset of active voxels.
+        mLic->ConvolveVoxelsSlice( r.begin() , r.end() ) ;
+    }
+    VolumeLineIntegralConvolution_ConvolveVoxels_TBB( VolumeLineIntegralConvolution * pLic )
+    : mLic( pLic ) {}
+} ;
+#endif
+
+/*! \brief Return noise in [0,1) that depends only on a seed and a voxel
+
+    This lets threads evaluate noise anywhere without storing or sharing it.
+*/
+static float HashNoise( uint32_t seed , size_t offset )
+{   // Mix bits with the SplitMix64 finalizer.
+    uint64_t bits = uint64_t( seed ) * 0x9E3779B97F4A7C15ull + offset ;
+    bits = ( bits ^ ( bits >> 30 ) ) * 0xBF58476D1CE4E5B9ull ;
+    bits = ( bits ^ ( bits >> 27 ) ) * 0x94D049BB133111EBull ;
+    bits = bits ^ ( bits >> 31 ) ;
+    return float( bits >> 40 ) * ( 1.0f / float( 1 << 24 ) ) ;
+}
+
+VolumeLineIntegralConvolution::VolumeLineIntegralConvolution( uint32_t noiseSeed )
+    : mNoiseSeed( noiseSeed )
+    , mKernelLength( 8.0f )
+    , mStepSize( 0.5f )
+    , mNoiseDensity( 0.05f )
+    , mVorticityThreshold( 0.0f )
+    , mStepLength( 0.0f )
+    , mVelGrid( nullptr )
+{
+}
+
+/*! \brief Compute unit direction of velocity at a position
+
+    \return false if the position lies outside the velocity grid or velocity vanishes there.
+*/
+bool VolumeLineIntegralConvolution::ComputeDirection( Vec3 & vDirection , const Vec3 & vPosition ) const
+{
+    if( ! mVelGrid->Encloses( vPosition ) ) return false ;
+    mVelGrid->Interpolate( vDirection , vPosition ) ;
+    const float speedSq = vDirection.lengthSquared() ;
+    if( speedSq < FLT_MIN ) return false ;
+    vDirection *= 1.0f / sqrtf( speedSq ) ;
+    return true ;
+}
+
+/*! \brief Advance a position along its streamline using the midpoint rule
+
+    \param step - signed distance, in world units, to advance.  Negative steps trace upstream.
+
+    \return false if the streamline ended, in which case vPosition is unspecified.
+*/
+bool VolumeLineIntegralConvolution::StepStreamline( Vec3 & vPosition , float step ) const
+{
+    Vec3 vDirection ;
+    if( ! ComputeDirection( vDirection , vPosition ) ) return false ;
+    Vec3 vDirectionMid ;
+    if( ! ComputeDirection( vDirectionMid , vPosition + vDirection * ( 0.5f * step ) ) ) return false ;
+    vPosition += vDirectionMid * step ;
+    return mVolume.Encloses( vPosition ) ;
+}
+
+/*! \brief Return sparse noise, 0 or 1, at the voxel nearest a position
+ */
+float VolumeLineIntegralConvolution::Noise( const Vec3 & vPosition ) const
+{
+    const Vec3 vIdx( ( vPosition - mVolume.GetMinCorner() ) * mVolume.GetCellsPerExtent() ) ;
+    size_t indices[ 3 ] ;
+    for( int axis = 0 ; axis < 3 ; ++ axis )
+    {
+        indices[ axis ] = std::min( size_t( std::max( vIdx[ axis ] + 0.5f , 0.0f ) ) , mVolume.GetNumPoints( axis ) - 1 ) ;
+    }
+    const size_t offset = indices[ 0 ] + mVolume.GetNumPoints( 0 ) * ( indices[ 1 ] + mVolume.GetNumPoints( 1 ) * indices[ 2 ] ) ;
+    return ( HashNoise( mNoiseSeed , offset ) < mNoiseDensity ) ? 1.0f : 0.0f ;
+}
+
+/*! \brief Find voxels, in a subset of z-layers, where vorticity exceeds threshold
+
+    \param izStart - index of first z-layer to classify
+
+    \param izEnd - index past last z-layer to classify
+*/
+void VolumeLineIntegralConvolution::ClassifyVoxelsSlice( size_t izStart , size_t izEnd )
+{
+    const size_t    numXY           = mVolume.GetNumPoints( 0 ) * mVolume.GetNumPoints( 1 ) ;
+    const float     thresholdSq     = mVorticityThreshold * std::fabs( mVorticityThreshold ) ;
+    size_t          indices[ 3 ] ;
+    for( indices[ 2 ] = izStart ; indices[ 2 ] < izEnd ; ++ indices[ 2 ] )
+    {
+        for( indices[ 1 ] = 0 ; indices[ 1 ] < mVolume.GetNumPoints( 1 ) ; ++ indices[ 1 ] )
+        {
+            for( indices[ 0 ] = 0 ; indices[ 0 ] < mVolume.GetNumPoints( 0 ) ; ++ indices[ 0 ] )
+            {
+                const size_t offset = indices[ 0 ] + mVolume.GetNumPoints( 0 ) * indices[ 1 ] + numXY * indices[ 2 ] ;
+                Vec3 vPosition ;
+                mVolume.PositionFromIndices( vPosition , indices ) ;
+                bool bActive = false ;
+                if( mVorticity.Encloses( vPosition ) )
+                {
+                    Vec3 vorticity ;
+                    mVorticity.Interpolate( vorticity , vPosition ) ;
+                    bActive = vorticity.lengthSquared() > thresholdSq ;
+                }
+                mIsActive[ offset ] = bActive ;
+            }
+        }
+    }
+}
+
+/*! \brief Average sparse noise along streamlines through a subset of active voxels
+
+    \param iActiveStart - index into mActiveVoxels of first voxel to convolve
+
+    \param iActiveEnd - index into mActiveVoxels past last voxel to convolve
+*/
+void VolumeLineIntegralConvolution::ConvolveVoxelsSlice( size_t iActiveStart , size_t iActiveEnd )
+{
+    const int numSteps = std::max( 1 , int( mKernelLength / mStepSize + 0.5f ) ) ;
+    for( size_t iActive = iActiveStart ; iActive < iActiveEnd ; ++ iActive )
+    {
+        const size_t offset = mActiveVoxels[ iActive ] ;
+        size_t indices[ 3 ] ;
+        mVolume.IndicesFromOffset( indices , offset ) ;
+        Vec3 vCenter ;
+        mVolume.PositionFromIndices( vCenter , indices ) ;
+
+        float   sum         = HashNoise( mNoiseSeed , offset ) < mNoiseDensity ? 1.0f : 0.0f ;
+        int     numSamples  = 1 ;
+        for( float step : { mStepLength , - mStepLength } )
+        {   // Trace downstream then upstream.
+            Vec3 vPosition( vCenter ) ;
+            for( int iStep = 0 ; ( iStep < numSteps ) && StepStreamline( vPosition , step ) ; ++ iStep )
+            {
+                sum += Noise( vPosition ) ;
+                ++ numSamples ;
+            }
+        }
+        mVolume[ offset ] = sum / float( numSamples ) ;
+    }
+}
+
+void VolumeLineIntegralConvolution::Render( const UniformGrid< Vec3 > & velGrid , size_t numVoxels )
+{
+    mVelGrid = & velGrid ;
+    mActiveVoxels.clear() ;
+    if( ( 0 == velGrid.Size() ) || ( 0 == numVoxels ) )
+    {
+        mVolume.Clear() ;
+        return ;
+    }
+
+    // Span velocity grid, shrunk slightly so DefineShape, which nudges its extent outward, stays inside.
+    const Vec3 & vMin = velGrid.GetMinCorner() ;
+    mVolume.DefineShape( numVoxels , vMin , vMin + velGrid.GetExtent() * ( 1.0f - 4.0f * FLT_EPSILON ) , false ) ;
+    mVolume.Init() ;
+    const size_t numPoints = mVolume.GetGridCapacity() ;
+    for( size_t offset = 0 ; offset < numPoints ; ++ offset )
+    {   // Voxels outside vortical region stay zero.
+        mVolume[ offset ] = 0.0f ;
+    }
+    const Vec3 & vSpacing = mVolume.GetCellSpacing() ;
+    mStepLength = mStepSize * std::min( std::min( vSpacing.x , vSpacing.y ) , vSpacing.z ) ;
+
+    mVorticity.CopyShape( velGrid ) ;
+    mVorticity.Init() ;
+    UniformGridMath::ComputeCurl( mVorticity , velGrid ) ;
+
+    // Find voxels where vorticity exceeds threshold, in parallel, then gather them in order.
+    const size_t numZ = mVolume.GetNumPoints( 2 ) ;
+    mIsActive.resize( numPoints ) ;
+#if USE_TBB
+    {
+        // Estimate grain size based on size of problem and number of processors.
+        const size_t grainSize = std::max( size_t( 1 ) , numZ / std::thread::hardware_concurrency() ) ;
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numZ , grainSize ) , VolumeLineIntegralConvolution_ClassifyVoxels_TBB( this ) ) ;
+    }
+#else
+    ClassifyVoxelsSlice( 0 , numZ ) ;
+#endif
+    for( size_t offset = 0 ; offset < mIsActive.size() ; ++ offset )
+    {
+        if( mIsActive[ offset ] ) mActiveVoxels.push_back( offset ) ;
+    }
+
+    const size_t numActive = mActiveVoxels.size() ;
+#if USE_TBB
+    {
+        // Estimate grain size based on size of problem and number of processors.
+        const size_t grainSize = std::max( size_t( 1 ) , numActive / std::thread::hardware_concurrency() ) ;
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0 , numActive , grainSize ) , VolumeLineIntegralConvolution_ConvolveVoxels_TBB( this ) ) ;
+    }
+#else
+    ConvolveVoxelsSlice( 0 , numActive ) ;
+#endif
+}
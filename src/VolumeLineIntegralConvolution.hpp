@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "UniformGrid.hpp"
+#include "TBB_Settings.hpp"
+
+/*! \brief Compute a 3D Line Integral Convolution volume of a velocity grid, where vorticity is strong
+
+ Each output voxel averages a sparse noise field along the 3D streamline
+ through it.  Sparse noise, where only a small fraction of voxels are
+ lit, convolves into isolated streaks that stay legible when volume
+ rendered, whereas dense noise would fill the volume with fog.
+
+ Most of a vortex simulation's bounding box holds nearly irrotational
+ flow.  Before convolving, this computes vorticity from the velocity
+ grid with UniformGridMath::ComputeCurl, then convolves only voxels
+ where vorticity magnitude exceeds a threshold.  Other voxels come out
+ 0.  Cost therefore scales with the vortical region, not the box.
+
+ The output volume spans the velocity grid at a resolution chosen by
+ the caller, typically much finer than the velocity grid.  Streamlines
+ step with the midpoint rule through velocity sampled by
+ UniformGrid::Interpolate, and stop at the grid border or where
+ velocity vanishes.  Active voxels are convolved in parallel.
+
+ */
+class VolumeLineIntegralConvolution
+{
+public:
+    /*! \brief Initialize volume LIC
+
+        \param noiseSeed - seed for sparse noise, so volumes are reproducible.
+    */
+    VolumeLineIntegralConvolution( uint32_t noiseSeed = 1 ) ;
+
+    /// Set half-length, in voxels, of the streamline segment averaged for each voxel.
+    void    SetKernelLength( float kernelLength )           { mKernelLength = kernelLength ; }
+    float   GetKernelLength() const                         { return mKernelLength ; }
+
+    /// Set distance, in voxels, between consecutive streamline samples.
+    void    SetStepSize( float stepSize )                   { mStepSize = stepSize ; }
+    float   GetStepSize() const                             { return mStepSize ; }
+
+    /// Set fraction, in (0,1], of voxels lit in sparse noise.
+    void    SetNoiseDensity( float noiseDensity )           { mNoiseDensity = noiseDensity ; }
+    float   GetNoiseDensity() const                         { return mNoiseDensity ; }
+
+    /// Set vorticity magnitude a voxel must exceed to be convolved.
+    void    SetVorticityThreshold( float threshold )        { mVorticityThreshold = threshold ; }
+    float   GetVorticityThreshold() const                   { return mVorticityThreshold ; }
+
+    /*! \brief Compute LIC volume
+
+        \param velGrid - velocity grid, for example VortonSim::GetVelocityGrid.
+
+        \param numVoxels - approximate number of voxels in output volume.
+    */
+    void Render( const UniformGrid< Vec3 > & velGrid , size_t numVoxels ) ;
+
+    /// Return LIC volume, whose values lie in [0,1], with 0 outside the vortical region.
+    const UniformGrid< float > &    GetVolume() const               { return mVolume ; }
+
+    /// Return number of voxels convolved by the latest Render.
+    size_t                          GetNumActiveVoxels() const      { return mActiveVoxels.size() ; }
+
+private:
+    #if USE_TBB
+        friend class VolumeLineIntegralConvolution_ClassifyVoxels_TBB ;
+        friend class VolumeLineIntegralConvolution_ConvolveVoxels_TBB ;
+    #endif
+
+    bool    ComputeDirection( Vec3 & vDirection , const Vec3 & vPosition ) const ;
+    bool    StepStreamline( Vec3 & vPosition , float step ) const ;
+    float   Noise( const Vec3 & vPosition ) const ;
+    void    ClassifyVoxelsSlice( size_t izStart , size_t izEnd ) ;
+    void    ConvolveVoxelsSlice( size_t iActiveStart , size_t iActiveEnd ) ;
+
+    uint32_t                    mNoiseSeed          ;   ///< Seed for sparse noise
+    float                       mKernelLength       ;   ///< Half-length, in voxels, of convolution kernel
+    float                       mStepSize           ;   ///< Distance, in voxels, between streamline samples
+    float                       mNoiseDensity       ;   ///< Fraction of voxels lit in sparse noise
+    float                       mVorticityThreshold ;   ///< Vorticity magnitude a voxel must exceed to be convolved
+    float                       mStepLength         ;   ///< Distance, in world units, between streamline samples
+    UniformGrid< float >        mVolume             ;   ///< LIC volume
+    UniformGrid< Vec3 >         mVorticity          ;   ///< Vorticity computed from velocity grid
+    std::vector< uint8_t >      mIsActive           ;   ///< Whether each voxel lies where vorticity exceeds threshold
+    std::vector< size_t >       mActiveVoxels       ;   ///< Offsets of voxels to convolve
+    const UniformGrid< Vec3 > * mVelGrid            ;   ///< Velocity grid being convolved
+} ;
@@ -1,11 +1,11 @@
 #include "VorticityDistribution.hpp"
-#include "ofConstants.h"
+#include "Vec3.hpp"
 #include "math_helper.hpp"
 
 /// \brief A very small number, between FLT_EPSILON and FLT_MIN.
 static const float sTiny = expf( 0.5f * ( logf( FLT_EPSILON ) + logf( FLT_MIN ) ) ) ;
 
-void VortexSheet::AssignVorticity(ofVec3f &vorticity, const ofVec3f &position, const ofVec3f &vCenter) const {
+void VortexSheet::AssignVorticity(Vec3 &vorticity, const Vec3 &position, const Vec3 &vCenter) const {
     const float yOverWidth = position.y / mWidth ;
     const float d = 1.0f - 0.5f * mVariation * ( cosf( TWO_PI * yOverWidth ) - 1.0f ) ;
     const float zOverD = position.z / d ;
@@ -16,19 +16,19 @@ void VortexSheet::AssignVorticity(ofVec3f &vorticity, const ofVec3f &position, c
     vorticity.z = t * t * PI * mVariation * zOverD / ( mWidth * d ) * sinf( TWO_PI * yOverWidth ) ;
     if( vorticity.lengthSquared() < 0.01f ) {
         // When vorticity is small, force it to zero, to keep number of vortons down.
-        vorticity = ofVec3f( 0.0f , 0.0f , 0.0f ) ;
+        vorticity = Vec3( 0.0f , 0.0f , 0.0f ) ;
     }
 }
 
 
 void AssignVorticity( std::vector<Vorton> & vortons , float fMagnitude , size_t numVortonsMax , const VorticityDistribution & vorticityDistribution ){
     const static size_t one = 1;
-    const ofVec3f          vDimensions     = vorticityDistribution.GetDomainSize() ;       // length of each side of grid box
-    const ofVec3f          vCenter         ( 0.0f , 0.0f , 0.0f ) ;                        // Center of vorticity distribution
-    const ofVec3f          vMin            ( vCenter - 0.5f * vDimensions ) ;              // Minimum corner of box containing vortons
-    const ofVec3f          vMax            ( vMin + vDimensions ) ;                        // Maximum corner of box containing vortons
+    const Vec3          vDimensions     = vorticityDistribution.GetDomainSize() ;       // length of each side of grid box
+    const Vec3          vCenter         ( 0.0f , 0.0f , 0.0f ) ;                        // Center of vorticity distribution
+    const Vec3          vMin            ( vCenter - 0.5f * vDimensions ) ;              // Minimum corner of box containing vortons
+    const Vec3          vMax            ( vMin + vDimensions ) ;                        // Maximum corner of box containing vortons
     UniformGridGeometry skeleton        ( numVortonsMax , vMin , vMax , true ) ;
-    size_t            numCells[3]     = {     std::max( one , skeleton.GetNumCells(0))
+    size_t              numCells[3]   = {     std::max( one , skeleton.GetNumCells(0))
         ,   std::max( one , skeleton.GetNumCells(1))
         ,   std::max( one , skeleton.GetNumCells(2)) } ;  // number of grid cells in each direction of virtual uniform grid
     
@@ -45,15 +45,15 @@ void AssignVorticity( std::vector<Vorton> & vortons , float fMagnitude , size_t
     }
     
     const float     oneOverN[3]     = { 1.0f / float( numCells[0] ) , 1.0f / float( numCells[1] ) , 1.0f / float( numCells[2] ) } ;
-    const ofVec3f   gridCellSize    ( vDimensions.x * oneOverN[0] , vDimensions.y * oneOverN[1] , vDimensions.z * oneOverN[2] ) ;
+    const Vec3      gridCellSize    ( vDimensions.x * oneOverN[0] , vDimensions.y * oneOverN[1] , vDimensions.z * oneOverN[2] ) ;
     float           vortonRadius    = powf( gridCellSize.x * gridCellSize.y * gridCellSize.z , 1.0f / 3.0f ) * 0.5f ;
     if( 0.0f == vDimensions.z ) {
         // z size is zero, so domain is 2D.
         vortonRadius = powf( gridCellSize.x * gridCellSize.y , 0.5f ) * 0.5f ;
     }
-    const ofVec3f  vNoise          ( 0.0f * gridCellSize ) ;
+    const Vec3      vNoise         ( 0.0f * gridCellSize ) ;
     
-    ofVec3f position = ofVec3f( 0.0f , 0.0f , 0.0f ) ; // vorton position
+    Vec3 position = Vec3( 0.0f , 0.0f , 0.0f ) ; // vorton position
     size_t index[3];   // index of each position visited
                        // Iterate through each point in a uniform grid.
                        // If probe position is inside vortex core, add a vorton there.
@@ -69,7 +69,7 @@ void AssignVorticity( std::vector<Vorton> & vortons , float fMagnitude , size_t
             {   // For each x-coordinate...
                 position.x = ( float( index[0] ) + 0.25f ) * gridCellSize.x + vMin.x ;
                 position += RandomSpread( vNoise ) ;
-                ofVec3f vorticity ;
+                Vec3 vorticity ;
                 vorticityDistribution.AssignVorticity( vorticity , position , vCenter ) ;
                 Vorton vorton( position , vorticity * fMagnitude , vortonRadius ) ;
                 if( vorticity.lengthSquared() > sTiny )
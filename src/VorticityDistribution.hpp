@@ -2,15 +2,15 @@
 #include <vector>
 #include <algorithm>
 
-#include "ofVec3f.h"
+#include "Vec3.hpp"
 #include "Vorton.hpp"
 #include "UniformGrid.hpp"
 
 /// \brief Abstract base class for various vortex distros
 class VorticityDistribution {
 public:
-	virtual ofVec3f GetDomainSize() const = 0;
-	virtual void AssignVorticity(ofVec3f & vorticity, const ofVec3f & position, const ofVec3f & vCenter) const = 0;
+	virtual Vec3 GetDomainSize() const = 0;
+	virtual void AssignVorticity(Vec3 & vorticity, const Vec3 & position, const Vec3 & vCenter) const = 0;
 	virtual ~VorticityDistribution() {}
 };
 
@@ -30,11 +30,11 @@ public:
 		: mThickness(fThickness), mVariation(fVariation), mWidth(fWidth)
 	{}
 
-	virtual ofVec3f GetDomainSize() const override {
-		return ofVec3f(14.0f * mThickness, mWidth, 14.0f * mThickness);
+	virtual Vec3 GetDomainSize() const override {
+		return Vec3(14.0f * mThickness, mWidth, 14.0f * mThickness);
 	}
 
-	virtual void AssignVorticity(ofVec3f & vorticity, const ofVec3f & position, const ofVec3f & vCenter) const override;
+	virtual void AssignVorticity(Vec3 & vorticity, const Vec3 & position, const Vec3 & vCenter) const override;
 
 	float   mThickness;
 	float   mVariation;
@@ -66,7 +66,7 @@ public:
 	\param fSpeed   - speed of slug
 
 	*/
-	JetRing(const float & fRadiusSlug, const float & fThickness, const ofVec3f & vDirection)
+	JetRing(const float & fRadiusSlug, const float & fThickness, const Vec3 & vDirection)
 		: mRadiusSlug(fRadiusSlug)
 		, mThickness(fThickness)
 		, mRadiusOuter(mRadiusSlug + mThickness)
@@ -74,18 +74,18 @@ public:
 	{
 	}
 
-	virtual ofVec3f GetDomainSize(void) const
+	virtual Vec3 GetDomainSize(void) const
 	{
 		const float boxSideLength = 2.f * (mRadiusOuter);    // length of side of virtual cube
-		return ofVec3f(1.0f, 1.0f, 1.0f) * boxSideLength;
+		return Vec3(1.0f, 1.0f, 1.0f) * boxSideLength;
 	}
 
-	virtual void AssignVorticity(ofVec3f & vorticity, const ofVec3f & position, const ofVec3f & vCenter) const
+	virtual void AssignVorticity(Vec3 & vorticity, const Vec3 & position, const Vec3 & vCenter) const
 	{
-		const  ofVec3f     vFromCenter = position - vCenter;              // displacement from ring center to vorton position
+		const  Vec3     vFromCenter = position - vCenter;              // displacement from ring center to vorton position
 		const  float    tween = vFromCenter.dot(mDirection);        // projection of position onto axis
-		const  ofVec3f     vPtOnLine = vCenter + mDirection * tween;    // closest point on axis to vorton position
-		ofVec3f            vRho = position - vPtOnLine;            // direction radially outward from annulus core
+		const  Vec3     vPtOnLine = vCenter + mDirection * tween;    // closest point on axis to vorton position
+		Vec3            vRho = position - vPtOnLine;            // direction radially outward from annulus core
 		const  float    rho = vRho.length();                // distance from axis
 		const  float    distAlongDir = mDirection.dot(vFromCenter);        // distance along axis of vorton position
 		if ((rho < mRadiusOuter) && (rho > mRadiusSlug))
@@ -93,21 +93,21 @@ public:
 			const  float    streamwiseProfile = (fabsf(distAlongDir) < mRadiusSlug) ? 0.5f * (cos(PI* distAlongDir / mRadiusSlug) + 1.0f) : 0.0f;
 			const  float    radialProfile = sin(PI * (rho - mRadiusSlug) / mThickness);
 			const  float    vortPhi = streamwiseProfile * radialProfile * PI / mThickness;
-			ofVec3f            rhoHat = vRho;                    // direction radially away from annular core
+			Vec3            rhoHat = vRho;                    // direction radially away from annular core
 			rhoHat.normalize();
-			ofVec3f            phiHat = mDirection ^ rhoHat;  // direction along annular core
+			Vec3            phiHat = mDirection ^ rhoHat;  // direction along annular core
 			vorticity = vortPhi * phiHat;
 		}
 		else
 		{
-			vorticity = ofVec3f(0.0f, 0.0f, 0.0f);
+			vorticity = Vec3(0.0f, 0.0f, 0.0f);
 		}
 	}
 
 	float   mRadiusSlug;   ///< Radius of central region of jet, where velocity is uniform.
 	float   mThickness;   ///< Thickness of region outside central jet, where velocity decays gradually
 	float   mRadiusOuter;   ///< Radius of jet, including central region and gradial falloff.
-	ofVec3f    mDirection;   ///< Direction of jet.
+	Vec3    mDirection;   ///< Direction of jet.
 };
 
 /*! \brief Specify a random field of vorticity
@@ -125,29 +125,29 @@ public:
 	\param shape - dimensions of box with noisy vorticity
 
 	*/
-	VortexNoise(const ofVec3f & vBox)
+	VortexNoise(const Vec3 & vBox)
 		: mBox(vBox)
 		, mAmplitude(1.0f, 1.0f, 1.0f)
 	{
 		if (0.0f == vBox.z)
 		{   // Domain is 2D (in XY plane).
 			// Make vorticity purely vertical.
-			mAmplitude = ofVec3f(0.0f, 0.0f, 1.0f);
+			mAmplitude = Vec3(0.0f, 0.0f, 1.0f);
 		}
 	}
 
-	virtual ofVec3f GetDomainSize(void) const
+	virtual Vec3 GetDomainSize(void) const
 	{
 		return mBox;
 	}
 
-	virtual void AssignVorticity(ofVec3f & vorticity, const ofVec3f & position, const ofVec3f & vCenter) const
+	virtual void AssignVorticity(Vec3 & vorticity, const Vec3 & position, const Vec3 & vCenter) const
 	{
 		vorticity = RandomSpread(mAmplitude);
 	}
 
-	ofVec3f    mBox;
-	ofVec3f    mAmplitude;
+	Vec3       mBox;
+	Vec3       mAmplitude;
 };
 
 /*! \brief Specify vorticity in the shape of a vortex tube.
@@ -181,59 +181,59 @@ public:
 	{
 	}
 
-	virtual ofVec3f GetDomainSize(void) const
+	virtual Vec3 GetDomainSize(void) const
 	{
-		return ofVec3f(8.0f * mRadius, mWidth, 8.0f * mRadius);
+		return Vec3(8.0f * mRadius, mWidth, 8.0f * mRadius);
 	}
 
-	virtual void AssignVorticity(ofVec3f & vorticity, const ofVec3f & position, const ofVec3f & vCenter) const
+	virtual void AssignVorticity(Vec3 & vorticity, const Vec3 & position, const Vec3 & vCenter) const
 	{
 		if (0 == mLocation)
 		{
-			const ofVec3f  posRel = position - vCenter;
+			const Vec3     posRel = position - vCenter;
 			const float rho = sqrtf((posRel.x * posRel.x) + (posRel.z * posRel.z));
 			const float modulation = 1.0f - mVariation * (cosf(TWO_PI * mWavenumber * posRel.y / mWidth) - 1.0f);
 			const float radiusLocal = mRadius * modulation;
 			if (rho < radiusLocal)
 			{   // Position is inside vortex tube.
 				const float vortY = 0.5f * (cosf(PI * rho / radiusLocal) + 1);
-				vorticity = ofVec3f(0.0f, vortY, 0.0f);
+				vorticity = Vec3(0.0f, vortY, 0.0f);
 			}
 			else
 			{   // Position is outside vortex tube.
-				vorticity = ofVec3f(0.0f, 0.0f, 0.0f);
+				vorticity = Vec3(0.0f, 0.0f, 0.0f);
 			}
 		}
 		else if (1 == mLocation)
 		{
-			const ofVec3f  posRel = position - vCenter - ofVec3f(0.0f, 0.0f, 1.0f * mRadius);
+			const Vec3     posRel = position - vCenter - Vec3(0.0f, 0.0f, 1.0f * mRadius);
 			const float rho = sqrtf((posRel.x * posRel.x) + (posRel.z * posRel.z));
 			const float modulation = 1.0f - mVariation * (cosf(TWO_PI * mWavenumber * posRel.y / mWidth) - 1.0f);
 			const float radiusLocal = mRadius * modulation;
 			if (rho < radiusLocal)
 			{   // Position is inside vortex tube.
 				const float vortY = 0.5f * (cosf(PI * rho / radiusLocal) + 1);
-				vorticity = ofVec3f(0.0f, vortY, 0.0f);
+				vorticity = Vec3(0.0f, vortY, 0.0f);
 			}
 			else
 			{   // Position is outside vortex tube.
-				vorticity = ofVec3f(0.0f, 0.0f, 0.0f);
+				vorticity = Vec3(0.0f, 0.0f, 0.0f);
 			}
 		}
 		else if (-1 == mLocation)
 		{
-			const ofVec3f  posRel = position - vCenter - ofVec3f(0.0f, 0.0f, -1.0f * mRadius);
+			const Vec3     posRel = position - vCenter - Vec3(0.0f, 0.0f, -1.0f * mRadius);
 			const float rho = sqrtf((posRel.y * posRel.y) + (posRel.z * posRel.z));
 			const float modulation = 1.0f - mVariation * (cosf(TWO_PI * mWavenumber * posRel.x / mWidth) - 1.0f);
 			const float radiusLocal = mRadius * modulation;
 			if (rho < radiusLocal)
 			{   // Position is inside vortex tube.
 				const float vortX = 0.5f * (cosf(PI * rho / radiusLocal) + 1);
-				vorticity = ofVec3f(vortX, 0.0f, 0.0f);
+				vorticity = Vec3(vortX, 0.0f, 0.0f);
 			}
 			else
 			{   // Position is outside vortex tube.
-				vorticity = ofVec3f(0.0f, 0.0f, 0.0f);
+				vorticity = Vec3(0.0f, 0.0f, 0.0f);
 			}
 		}
 	}
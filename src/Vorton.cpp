@@ -8,23 +8,17 @@ Vorton::Vorton() :
 {
 }
 
-Vorton::Vorton(ofVec3f pos, ofVec3f vorticity, float rad, ofVec2f velocity) :
+Vorton::Vorton(Vec3 pos, Vec3 vorticity, float rad, Vec2 velocity) :
 	mPosition(pos), mVorticity(vorticity), mRadius(rad), mVelocity(velocity)
 {
 }
 
-Vorton::Vorton(const Vorton & other) :
-	mPosition(other.mPosition), mVorticity(other.mVorticity),
-	mRadius(other.mRadius), mVelocity(other.mVelocity)
-{
-}
-
-void Vorton::AccumulateVelocity(ofVec3f & velocityOut, const ofVec3f &posQuery) {
+void Vorton::AccumulateVelocity(Vec3 & velocityOut, const Vec3 &posQuery) {
 	VORTON_ACCUMULATE_VELOCITY_private(velocityOut, posQuery, mPosition, mVorticity, mRadius);
 }
 
-void Vorton::AssignByVelocity(const ofVec3f &queryPosition, const ofVec3f velocity) {
-	const ofVec3f  posRelative = queryPosition - mPosition;
+void Vorton::AssignByVelocity(const Vec3 &queryPosition, const Vec3 velocity) {
+	const Vec3     posRelative = queryPosition - mPosition;
 	const float dist = posRelative.length();
 
 	mVorticity = (FOUR_PI * dist * posRelative).getCrossed(velocity) / (8.0f * mRadius * mRadius * mRadius);
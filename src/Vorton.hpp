@@ -1,17 +1,16 @@
 #pragma once
 
-#include "ofVec3f.h"
-#include "ofVec2f.h"
+#include "Vec3.hpp"
 #include "math_helper.hpp"
 
 #define VORTON_ACCUMULATE_VELOCITY_private( vVelocity , vPosQuery , mPosition , mVorticity , mRadius )      \
 {                                                                                                           \
     const static float OneOverFourPi = 1.f / FOUR_PI;                                                       \
-	const ofVec3f       vNeighborToSelf     = vPosQuery - mPosition ;                                       \
+	const Vec3          vNeighborToSelf     = vPosQuery - mPosition ;                                       \
     const float         radius2             = mRadius * mRadius ;                                           \
     const float         dist2               = vNeighborToSelf.lengthSquared() + Vorton::sAvoidSingularity ; \
     const float         oneOverDist         = finvsqrtf( dist2 ) ;                                          \
-    const ofVec3f       vNeighborToSelfDir  = vNeighborToSelf * oneOverDist ;                               \
+    const Vec3          vNeighborToSelfDir  = vNeighborToSelf * oneOverDist ;                               \
     /* If the reciprocal law is used everywhere then when 2 vortices get close, they tend to jettison. */   \
     /* Mitigate this by using a linear law when 2 vortices get close to each other. */                      \
     const float         distLaw             = ( dist2 < radius2 )                                           \
@@ -28,8 +27,8 @@ class Vorton
 {
 public:
 	Vorton();
-	Vorton(ofVec3f pos, ofVec3f vorticity, float radius = 1.f, ofVec2f velocity = ofVec2f(0));
-	Vorton(const Vorton & other);
+	Vorton(Vec3 pos, Vec3 vorticity, float radius = 1.f, Vec2 velocity = Vec2(0));
+	Vorton(const Vorton & other) = default;
 
 	/*! \brief Computes the velocity induced by this tiny vortex element.
 		\param velocityOut var in which to accumulate the velocity
@@ -42,7 +41,7 @@ public:
 		volume element, used to compute a contribution
 		to a velocity field.
 	*/
-	void AccumulateVelocity(ofVec3f & velocityOut, const ofVec3f & posQuery);
+	void AccumulateVelocity(Vec3 & velocityOut, const Vec3 & posQuery);
 
 	/*! \brief Computes the voriticty required to obtain a given velocity.
 
@@ -63,11 +62,11 @@ public:
 		This assumes v and r are orthogonal, so this is a very special-purpose
 		routine. This routine also assumes this vorton's position and radius are where they need to be.
 	 */
-	void AssignByVelocity(const ofVec3f & queryPosition, const ofVec3f velocity);
+	void AssignByVelocity(const Vec3 & queryPosition, const Vec3 velocity);
 
-	ofVec3f mPosition;
-	ofVec3f mVorticity;
+	Vec3 mPosition;
+	Vec3 mVorticity;
 	float mRadius;
-	ofVec2f mVelocity;
+	Vec2 mVelocity;
 	static const float sAvoidSingularity;
 };
\ No newline at end of file
@@ -2,7 +2,9 @@
 #include "VortonClusterAux.hpp"
 #include"UniformGridMath.hpp"
 #include "Mat3.hpp"
+#include "Profiler.hpp"
 #include <thread>
+#include <cassert>
 
 #define VELOCITY_FROM_TREE 1
 
@@ -40,6 +42,56 @@ public:
     , mFrame( uFrame )
     {}
 } ;
+
+/*! \brief Function object to diffuse vorticity using Threading Building Blocks
+ */
+class VortonSim_DiffuseVorticityPSE_TBB
+{
+    VortonSim * mVortonSim ;    ///< Address of VortonSim object
+    const float & mTimeStep ;
+    const CellList & mVortonCells ;    ///< Spatial partition of vortons
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Compute vorticity exchange for subset of cells.
+        mVortonSim->DiffuseVorticityPSESlice( mTimeStep , mVortonCells , r.begin() , r.end() ) ;
+    }
+    VortonSim_DiffuseVorticityPSE_TBB( VortonSim * pVortonSim , const float & timeStep , const CellList & vortonCells )
+    : mVortonSim( pVortonSim )
+    , mTimeStep( timeStep )
+    , mVortonCells( vortonCells )
+    {}
+} ;
+
+/*! \brief Function object to interpolate vorticity onto a remeshing grid using Threading Building Blocks
+ */
+class VortonSim_RemeshVortons_TBB
+{
+    VortonSim * mVortonSim ;    ///< Address of VortonSim object
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Interpolate vorticity onto subset of grid.
+        mVortonSim->RemeshVorticitySlice( r.begin() , r.end() ) ;
+    }
+    VortonSim_RemeshVortons_TBB( VortonSim * pVortonSim )
+    : mVortonSim( pVortonSim ) {}
+} ;
+
+/*! \brief Function object to merge weak vortons using Threading Building Blocks
+ */
+class VortonSim_MergeVortons_TBB
+{
+    VortonSim * mVortonSim ;    ///< Address of VortonSim object
+    const float & mWeakCirculation ;
+public:
+    void operator() ( const tbb::blocked_range<size_t> & r ) const
+    {   // Merge weak vortons in subset of cells.
+        mVortonSim->MergeVortonsSlice( mWeakCirculation , r.begin() , r.end() ) ;
+    }
+    VortonSim_MergeVortons_TBB( VortonSim * pVortonSim , const float & weakCirculation )
+    : mVortonSim( pVortonSim )
+    , mWeakCirculation( weakCirculation )
+    {}
+} ;
 #endif
 
 
@@ -52,7 +104,7 @@ public:
  \param vPoint - point to include in bounding box
 
  */
-void UpdateBoundingBox(ofVec3f & vMinCorner, ofVec3f & vMaxCorner, const ofVec3f & vPoint) {
+void UpdateBoundingBox(Vec3 & vMinCorner, Vec3 & vMaxCorner, const Vec3 & vPoint) {
 	vMinCorner.x = std::min(vPoint.x, vMinCorner.x);
 	vMinCorner.y = std::min(vPoint.y, vMinCorner.y);
 	vMinCorner.z = std::min(vPoint.z, vMinCorner.z);
@@ -83,23 +135,25 @@ void VortonSim::Initialize(size_t numTracersPerCellCubeRoot) {
 
  \param vortGrid - uniform grid of vorticity values
 
+ \param minVorticity2 - square of smallest vorticity magnitude for which to create a vorton
+
  */
-void VortonSim::AssignVortonsFromVorticity(UniformGrid< ofVec3f > & vortGrid) {
+void VortonSim::AssignVortonsFromVorticity(UniformGrid< Vec3 > & vortGrid, float minVorticity2) {
 	mVortons.clear(); // Empty out any existing vortons.
 
 	// Obtain characteristic size of each grid cell.
 
 	const UniformGridGeometry & ug = vortGrid;
-	const float     fVortonRadius = powf(ug.GetCellSpacing().x * ug.GetCellSpacing().y  * ug.GetCellSpacing().z, 1.0f / 3.0f) * 0.5f;
-	const ofVec3f      Nudge(ug.GetExtent() * FLT_EPSILON * 4.0f);
-	const ofVec3f      vMin(ug.GetMinCorner() + Nudge);
-	const ofVec3f      vSpacing(ug.GetCellSpacing() * (1.0f - 0.0f * FLT_EPSILON));
+	const float   fVortonRadius = powf(ug.GetCellSpacing().x * ug.GetCellSpacing().y  * ug.GetCellSpacing().z, 1.0f / 3.0f) * 0.5f;
+	const Vec3    Nudge(ug.GetExtent() * FLT_EPSILON * 4.0f);
+	const Vec3    vMin(ug.GetMinCorner() + Nudge);
+	const Vec3    vSpacing(ug.GetCellSpacing() * (1.0f - 0.0f * FLT_EPSILON));
 	const size_t  numPoints[3] = { ug.GetNumPoints(0) , ug.GetNumPoints(1) , ug.GetNumPoints(2) };
 	const size_t  numXY = numPoints[0] * numPoints[1];
 	size_t idx[3];
 	for (idx[2] = 0; idx[2] < numPoints[2]; ++idx[2])
 	{
-		ofVec3f vPositionOfGridCellCenter;
+		Vec3 vPositionOfGridCellCenter;
 		vPositionOfGridCellCenter.z = vMin.z + float(idx[2]) * vSpacing.z;
 		const size_t offsetZ = idx[2] * numXY;
 		for (idx[1] = 0; idx[1] < numPoints[1]; ++idx[1])
@@ -110,8 +164,8 @@ void VortonSim::AssignVortonsFromVorticity(UniformGrid< ofVec3f > & vortGrid) {
 			{
 				vPositionOfGridCellCenter.x = vMin.x + float(idx[0]) * vSpacing.x;
 				const size_t offsetXYZ = idx[0] + offsetYZ;
-				const ofVec3f & rVort = vortGrid[offsetXYZ];
-				if (rVort.lengthSquared() > FLT_EPSILON)
+				const Vec3 & rVort = vortGrid[offsetXYZ];
+				if (rVort.lengthSquared() > minVorticity2)
 				{   // This grid cell contains significant vorticity.
 					mVortons.emplace_back(vPositionOfGridCellCenter, rVort, fVortonRadius);
 				}
@@ -127,9 +181,9 @@ void VortonSim::AssignVortonsFromVorticity(UniformGrid< ofVec3f > & vortGrid) {
  \param vLinearImpulse - Volume integral of circulation weighted by position, computed by this routine.
 
  */
-void    VortonSim::ConservedQuantities(ofVec3f & vCirculation, ofVec3f & vLinearImpulse) const {
+void    VortonSim::ConservedQuantities(Vec3 & vCirculation, Vec3 & vLinearImpulse) const {
 	// Zero accumulators.
-	vCirculation = vLinearImpulse = ofVec3f(0.0f, 0.0f, 0.0f);
+	vCirculation = vLinearImpulse = Vec3(0.0f, 0.0f, 0.0f);
 	const size_t numVortons = mVortons.size();
 	for (size_t iVorton = 0; iVorton < numVortons; ++iVorton)
 	{   // For each vorton in this simulation...
@@ -150,7 +204,7 @@ void    VortonSim::ConservedQuantities(ofVec3f & vCirculation, ofVec3f & vLinear
  */
 void VortonSim::ComputeAverageVorticity() {
 	// Zero accumulators.
-	mAverageVorticity = ofVec3f(0.0f, 0.0f, 0.0f);
+	mAverageVorticity = Vec3(0.0f, 0.0f, 0.0f);
 	const size_t numVortons = mVortons.size();
 	for (size_t iVorton = 0; iVorton < numVortons; ++iVorton)
 	{   // For each vorton in this simulation...
@@ -163,31 +217,33 @@ void VortonSim::ComputeAverageVorticity() {
 /// Find axis-aligned bounding box for all vortons in this simulation.
 void VortonSim::FindBoundingBox()
 {
-	//    QUERY_PERFORMANCE_ENTER ;
-	const size_t numVortons = mVortons.size();
 	mMinCorner.x = mMinCorner.y = mMinCorner.z = FLT_MAX;
 	mMaxCorner = -mMinCorner;
-	for (size_t iVorton = 0; iVorton < numVortons; ++iVorton)
-	{   // For each vorton in this simulation...
-		const Vorton & rVorton = mVortons[iVorton];
-		// Find corners of axis-aligned bounding box.
-		UpdateBoundingBox(mMinCorner, mMaxCorner, rVorton.mPosition);
+	{
+		PROFILE_SCOPE(VortonSim_CreateInfluenceTree_FindBoundingBox_Vortons);
+		const size_t numVortons = mVortons.size();
+		for (size_t iVorton = 0; iVorton < numVortons; ++iVorton)
+		{   // For each vorton in this simulation...
+			const Vorton & rVorton = mVortons[iVorton];
+			// Find corners of axis-aligned bounding box.
+			UpdateBoundingBox(mMinCorner, mMaxCorner, rVorton.mPosition);
+		}
 	}
-	//    QUERY_PERFORMANCE_EXIT( VortonSim_CreateInfluenceTree_FindBoundingBox_Vortons ) ;
 
-	//    QUERY_PERFORMANCE_ENTER ;
-	const size_t numTracers = mTracers.size();
-	for (size_t iTracer = 0; iTracer < numTracers; ++iTracer)
-	{   // For each passive tracer particle in this simulation...
-		const Particle & rTracer = mTracers[iTracer];
-		// Find corners of axis-aligned bounding box.
-		UpdateBoundingBox(mMinCorner, mMaxCorner, rTracer.mPosition);
+	{
+		PROFILE_SCOPE(VortonSim_CreateInfluenceTree_FindBoundingBox_Tracers);
+		const size_t numTracers = mTracers.size();
+		for (size_t iTracer = 0; iTracer < numTracers; ++iTracer)
+		{   // For each passive tracer particle in this simulation...
+			const Particle & rTracer = mTracers[iTracer];
+			// Find corners of axis-aligned bounding box.
+			UpdateBoundingBox(mMinCorner, mMaxCorner, rTracer.mPosition);
+		}
 	}
-	//    QUERY_PERFORMANCE_EXIT( VortonSim_CreateInfluenceTree_FindBoundingBox_Tracers ) ;
 
 		// Slightly enlarge bounding box to allow for round-off errors.
-	const ofVec3f extent(mMaxCorner - mMinCorner);
-	const ofVec3f nudge(extent * FLT_EPSILON);
+	const Vec3 extent(mMaxCorner - mMinCorner);
+	const Vec3 nudge(extent * FLT_EPSILON);
 	mMinCorner -= nudge;
 	mMaxCorner += nudge;
 }
@@ -229,8 +285,8 @@ void VortonSim::MakeBaseVortonGrid(void)
 	for (size_t uVorton = 0; uVorton < numVortons; ++uVorton)
 	{   // For each vorton in this simulation...
 		const Vorton     &  rVorton = mVortons[uVorton];
-		const ofVec3f    &  rPosition = rVorton.mPosition;
-		const size_t      uOffset = mInfluenceTree[0].OffsetOfPosition(rPosition);
+		const Vec3       &  rPosition = rVorton.mPosition;
+		const size_t        uOffset = mInfluenceTree[0].OffsetOfPosition(rPosition);
 		Vorton           &  rVortonCell = mInfluenceTree[0][uOffset];
 		VortonClusterAux &  rVortonAux = ugAux[uOffset];
 		const float         vortMag = rVorton.mVorticity.length();
@@ -375,9 +431,10 @@ void VortonSim::AggregateClusters(size_t uParentLayer)
  */
 void VortonSim::CreateInfluenceTree(void)
 {
-	//    QUERY_PERFORMANCE_ENTER ;
-	FindBoundingBox(); // Find axis-aligned bounding box that encloses all vortons.
-//    QUERY_PERFORMANCE_EXIT( VortonSim_CreateInfluenceTree_FindBoundingBox ) ;
+	{
+		PROFILE_SCOPE(VortonSim_CreateInfluenceTree_FindBoundingBox);
+		FindBoundingBox(); // Find axis-aligned bounding box that encloses all vortons.
+	}
 
 	// Create skeletal nested grid for influence tree.
 	const size_t numVortons = mVortons.size();
@@ -387,17 +444,26 @@ void VortonSim::CreateInfluenceTree(void)
 		mInfluenceTree.Initialize(ugSkeleton); // Create skeleton of influence tree.
 	}
 
-	//    QUERY_PERFORMANCE_ENTER ;
-	MakeBaseVortonGrid();
-	//    QUERY_PERFORMANCE_EXIT( VortonSim_CreateInfluenceTree_MakeBaseVortonGrid ) ;
+	{
+		PROFILE_SCOPE(VortonSim_CreateInfluenceTree_MakeBaseVortonGrid);
+		MakeBaseVortonGrid();
+	}
 
-	//    QUERY_PERFORMANCE_ENTER ;
-	const size_t numLayers = mInfluenceTree.GetDepth();
-	for (size_t uParentLayer = 1; uParentLayer < numLayers; ++uParentLayer)
-	{   // For each layer in the influence tree...
-		AggregateClusters(uParentLayer);
+	{
+		PROFILE_SCOPE(VortonSim_CreateInfluenceTree_PartitionVortons);
+		// Partition vortons by base layer cell, for phases that need vortons by cell.
+		// This remains valid until vortons move, i.e. until AdvectVortons.
+		mVortonCells.Build(mInfluenceTree[0], mVortons);
+	}
+
+	{
+		PROFILE_SCOPE(VortonSim_CreateInfluenceTree_AggregateClusters);
+		const size_t numLayers = mInfluenceTree.GetDepth();
+		for (size_t uParentLayer = 1; uParentLayer < numLayers; ++uParentLayer)
+		{   // For each layer in the influence tree...
+			AggregateClusters(uParentLayer);
+		}
 	}
-	//    QUERY_PERFORMANCE_EXIT( VortonSim_CreateInfluenceTree_AggregateClusters ) ;
 }
 
 /*! \brief Compute velocity at a given point in space, due to influence of vortons
@@ -414,19 +480,19 @@ void VortonSim::CreateInfluenceTree(void)
  The outermost caller should pass in mInfluenceTree.GetDepth().
 
  */
-ofVec3f VortonSim::ComputeVelocity(const ofVec3f & vPosition, const size_t indices[3], size_t iLayer)
+Vec3 VortonSim::ComputeVelocity(const Vec3 & vPosition, const size_t indices[3], size_t iLayer)
 {
 	UniformGrid< Vorton > & rChildLayer = mInfluenceTree[iLayer - 1];
 	size_t                clusterMinIndices[3];
 	const size_t *        pClusterDims = mInfluenceTree.GetDecimations(iLayer);
 	mInfluenceTree.GetChildClusterMinCornerIndex(clusterMinIndices, pClusterDims, indices);
 
-	const ofVec3f &            vGridMinCorner = rChildLayer.GetMinCorner();
-	const ofVec3f              vSpacing = rChildLayer.GetCellSpacing();
+	const Vec3 &          vGridMinCorner = rChildLayer.GetMinCorner();
+	const Vec3            vSpacing = rChildLayer.GetCellSpacing();
 	size_t                increment[3];
 	const size_t &        numXchild = rChildLayer.GetNumPoints(0);
 	const size_t          numXYchild = numXchild * rChildLayer.GetNumPoints(1);
-	ofVec3f                    velocityAccumulator(0.0f, 0.0f, 0.0f);
+	Vec3                  velocityAccumulator(0.0f, 0.0f, 0.0f);
 
 	// The larger this is, the more accurate (and slower) the evaluation.
 	// Reasonable values lie in [0.00001,4.0].
@@ -435,14 +501,14 @@ ofVec3f VortonSim::ComputeVelocity(const ofVec3f & vPosition, const size_t indic
 	// cluster subdivisions to visit.
 	static const float  marginFactor = 0.0001f; // 0.4f ; // ship with this number: 0.0001f ; test with 0.4
 													// When domain is 2D in XY plane, min.z==max.z so vPos.z test below would fail unless margin.z!=0.
-	const ofVec3f          margin = marginFactor * vSpacing + (0.0f == vSpacing.z ? ofVec3f(0, 0, FLT_MIN) : ofVec3f(0, 0, 0));
+	const Vec3          margin = marginFactor * vSpacing + (0.0f == vSpacing.z ? Vec3(0, 0, FLT_MIN) : Vec3(0, 0, 0));
 
 	// For each cell of child layer in this grid cluster...
 	for (increment[2] = 0; increment[2] < pClusterDims[2]; ++increment[2])
 	{
 		size_t idxChild[3];
 		idxChild[2] = clusterMinIndices[2] + increment[2];
-		ofVec3f vCellMinCorner, vCellMaxCorner;
+		Vec3 vCellMinCorner, vCellMaxCorner;
 		vCellMinCorner.z = vGridMinCorner.z + float(idxChild[2]) * vSpacing.z;
 		vCellMaxCorner.z = vGridMinCorner.z + float(idxChild[2] + 1) * vSpacing.z;
 		const size_t offsetZ = idxChild[2] * numXYchild;
@@ -495,10 +561,10 @@ where N is the number of vortons.  This is too slow
 for regular use but it is useful for comparisons.
 
 */
-ofVec3f VortonSim::ComputeVelocityBruteForce(const ofVec3f & vPosition)
+Vec3 VortonSim::ComputeVelocityBruteForce(const Vec3 & vPosition)
 {
 	const size_t  numVortons = mVortons.size();
-	ofVec3f            velocityAccumulator(0.0f, 0.0f, 0.0f);
+	Vec3          velocityAccumulator(0.0f, 0.0f, 0.0f);
 
 	for (size_t iVorton = 0; iVorton < numVortons; ++iVorton)
 	{   // For each vorton...
@@ -523,21 +589,23 @@ and that the velocity grid has been allocated.
 */
 void VortonSim::ComputeVelocityGridSlice(size_t izStart, size_t izEnd)
 {
+	PROFILE_SCOPE_RANGE(VortonSim_ComputeVelocityGridSlice, izStart, izEnd);
+
 #if VELOCITY_FROM_TREE
 	const size_t        numLayers = mInfluenceTree.GetDepth();
 #endif
 
-	const ofVec3f &        vMinCorner = mVelGrid.GetMinCorner();
+	const Vec3 &        vMinCorner = mVelGrid.GetMinCorner();
 	static const float  nudge = 1.0f - 2.0f * FLT_EPSILON;
-	const ofVec3f          vSpacing = mVelGrid.GetCellSpacing() * nudge;
-	const size_t      dims[3] = { mVelGrid.GetNumPoints(0)
+	const Vec3          vSpacing = mVelGrid.GetCellSpacing() * nudge;
+	const size_t        dims[3] = { mVelGrid.GetNumPoints(0)
 		, mVelGrid.GetNumPoints(1)
 		, mVelGrid.GetNumPoints(2) };
 	const size_t      numXY = dims[0] * dims[1];
 	size_t            idx[3];
 	for (idx[2] = izStart; idx[2] < izEnd; ++idx[2])
 	{   // For subset of z index values...
-		ofVec3f vPosition;
+		Vec3 vPosition;
 		// Compute the z-coordinate of the world-space position of this gridpoint.
 		vPosition.z = vMinCorner.z + float(idx[2]) * vSpacing.z;
 		// Precompute the z contribution to the offset into the velocity grid.
@@ -610,8 +678,14 @@ void VortonSim::StretchAndTiltVortons(const float & timeStep, const size_t & uFr
 {
 	// Compute all gradients of all components of velocity.
 	UniformGrid< Mat3 > velocityJacobianGrid(mVelGrid);
-	velocityJacobianGrid.Init();
-	UniformGridMath::ComputeJacobian(velocityJacobianGrid, mVelGrid);
+	{
+		PROFILE_SCOPE(VortonSim_StretchAndTiltVortons_ComputeJacobian);
+		velocityJacobianGrid.Init();
+		UniformGridMath::ComputeJacobian(velocityJacobianGrid, mVelGrid);
+	}
+
+	const size_t numVortons = mVortons.size();
+	mStretchRates.assign(numVortons, 0.0f);
 
 	if ((0.0f == mVelGrid.GetExtent().x)
 		|| (0.0f == mVelGrid.GetExtent().y)
@@ -620,14 +694,17 @@ void VortonSim::StretchAndTiltVortons(const float & timeStep, const size_t & uFr
 		return;
 	}
 
-	const size_t numVortons = mVortons.size();
-
 	for (size_t offset = 0; offset < numVortons; ++offset)
 	{   // For each vorton...
 		Vorton &    rVorton = mVortons[offset];
 		Mat3       velJac;
 		velocityJacobianGrid.Interpolate(velJac, rVorton.mPosition);
-		const ofVec3f  stretchTilt = velJac * rVorton.mVorticity;    // Usual way to compute stretching & tilting
+		const Vec3     stretchTilt = velJac * rVorton.mVorticity;    // Usual way to compute stretching & tilting
+		const float    vortMag2 = rVorton.mVorticity.lengthSquared();
+		if (vortMag2 > FLT_MIN)
+		{   // Record rate at which vorton stretches along its vorticity, for AdaptVortonPopulation.
+			mStretchRates[offset] = stretchTilt.dot(rVorton.mVorticity) / vortMag2;
+		}
 		rVorton.mVorticity += /* fudge factor for stability */ 0.5f * stretchTilt * timeStep;
 	}
 }
@@ -647,15 +724,15 @@ This uses an extremely crude approximation of viscous diffusion
 */
 void VortonSim::DiffuseVorticityGlobally(const float & timeStep, const size_t & uFrame)
 {
-	const ofVec3f vAvgVorticity = mAverageVorticity;
-	mAverageVorticity = ofVec3f(0.0f, 0.0f, 0.0f); // Zero this, which will be used as an accumulator.
+	const Vec3 vAvgVorticity = mAverageVorticity;
+	mAverageVorticity = Vec3(0.0f, 0.0f, 0.0f); // Zero this, which will be used as an accumulator.
 
 	const size_t numVortons = mVortons.size();
 
 	for (size_t offset = 0 /* Start at 0th vorton */; offset < numVortons; ++offset)
 	{   // For each vorton...
 		Vorton &    rVorton = mVortons[offset];
-		ofVec3f &      rVorticitySelf = rVorton.mVorticity;
+		Vec3 &      rVorticitySelf = rVorton.mVorticity;
 		// Recompute average vorticity, by summing here, then dividing after loop.
 		mAverageVorticity += rVorticitySelf;
 		// Bring this vorton's vorticity closer to the average.
@@ -665,8 +742,8 @@ void VortonSim::DiffuseVorticityGlobally(const float & timeStep, const size_t &
 		// A more realistic diffusion would exchange vorticity between
 		// physically adjacent vortices in proportion to their separation.
 		// But this scheme will diffuse vorticity, and this routine does not require adjacency information.
-		const ofVec3f  vortDiff = rVorticitySelf - vAvgVorticity;
-		const ofVec3f  exchange = mViscosity * timeStep * vortDiff;    // Amount of vorticity to exchange between particles.
+		const Vec3     vortDiff = rVorticitySelf - vAvgVorticity;
+		const Vec3     exchange = mViscosity * timeStep * vortDiff;    // Amount of vorticity to exchange between particles.
 		rVorticitySelf -= exchange;    // Make "self" vorticity a little closer to "prev".
 	}
 
@@ -675,33 +752,48 @@ void VortonSim::DiffuseVorticityGlobally(const float & timeStep, const size_t &
 
 /*! \brief Diffuse vorticity using a particle strength exchange method.
 
-This routine partitions space into cells using the same grid
-as the "base vorton" grid.  Each vorton gets assigned to the
-cell that contains it.  Then, each vorton exchanges some
-of its vorticity with its neighbors in adjacent cells.
+Particle strength exchange (PSE) approximates the Laplacian of vorticity
+by an integral operator, which each vorton evaluates as a sum over its
+neighbors:
 
-This routine makes some simplifying assumptions to speed execution:
+	d w_i / dt = nu / eps^2 * Sum_j V_j ( w_j - w_i ) eta_eps( x_i - x_j )
 
--   Distance does not influence the amount of vorticity exchanged,
-except in as much as only vortons within a certain region of
-each other exchange vorticity.  This amounts to saying our kernel,
-eta, is a top-hat function.
+where V_j is the volume element of vorton j and eta_eps is a Gaussian
+kernel with core size eps:
 
--   Theoretically, if an adjacent cell contains no vortons
-then this simulation should generate vorticity within
-that cell, e.g. by creating a new vorton in the adjacent cell.
+	eta_eps( r ) = 4 / ( pi^(3/2) eps^3 ) exp( -r^2 / eps^2 )
 
--   This simulation reduces the vorticity of each vorton, alleging
-that this vorticity is dissipated analogously to how energy
-dissipates at Kolmogorov microscales.  This treatment is not
-realistic but it retains qualitative characteristics that we
-want, e.g. that the flow dissipates at a rate related to viscosity.
-Dissipation in real flows is a more complicated phenomenon.
+This kernel is normalized so that its second moment is 2 (as PSE requires)
+and it is symmetric, so vorticity lost by one vorton is gained by its
+neighbor, which conserves circulation.  Each pair of vortons uses
+eps = r_i + r_j, so vortons of differing size still exchange symmetrically.
+The kernel is truncated beyond sPseCutoff core sizes, where it is
+negligible.
+
+Neighbors are found using the cell list of vortons that CreateInfluenceTree
+builds.  Vortons are copied, in cell order, into a structure-of-arrays
+so that the vortons in a row of neighboring cells are contiguous, and
+the innermost loop is a branch-free sweep that the compiler can vectorize.
+
+The exchange is computed in two phases: first each vorton gathers
+the vorticity it would exchange with its neighbors, reading only
+vorticity from before this step, then all vortons take their new
+vorticity at once.  That avoids write conflicts between threads and
+makes the result independent of thread count.
+
+\note Theoretically, if a region near a vorton contains no vortons
+then this simulation should generate vorticity within that region,
+e.g. by creating a new vorton there.  This routine does not do that.
+
+\note The kernel normalization assumes a 3D domain.  2D domains still
+diffuse, but at a rate that differs by a constant factor.
 
 \see Degond & Mas-Gallic (1989): The weighted particle method for
 convection-diffusion equations, part 1: the case of an isotropic viscosity.
 Math. Comput., v. 53, n. 188, pp. 485-507, October.
 
+\see Cottet & Koumoutsakos (2000): Vortex Methods: Theory and Practice.
+
 \param timeStep - amount of time by which to advance simulation
 
 \param uFrame - frame counter
@@ -713,109 +805,150 @@ Math. Comput., v. 53, n. 188, pp. 485-507, October.
 */
 void VortonSim::DiffuseVorticityPSE(const float & timeStep, const size_t & uFrame)
 {
-	// Phase 1: Partition vortons
+	// Vortons were partitioned into cells of the base layer of the influence tree by CreateInfluenceTree.
+	const CellList & vortonCells = mVortonCells;
+	const size_t numVortons = mVortons.size();
+	if (0 == numVortons) return;
+
+	// Phase 1: Copy vortons, in cell order, into structure-of-arrays.
+	VortonsByCell & rByCell = mVortonsByCell;
+	rByCell.Resize(numVortons);
+	rByCell.mMaxRadius = 0.0f;
+	for (size_t k = 0; k < numVortons; ++k)
+	{   // For each vorton, in cell order...
+		const Vorton & rVorton = mVortons[vortonCells.GetIndex(k)];
+		rByCell.mPosX[k] = rVorton.mPosition.x;
+		rByCell.mPosY[k] = rVorton.mPosition.y;
+		rByCell.mPosZ[k] = rVorton.mPosition.z;
+		rByCell.mVortX[k] = rVorton.mVorticity.x;
+		rByCell.mVortY[k] = rVorton.mVorticity.y;
+		rByCell.mVortZ[k] = rVorton.mVorticity.z;
+		rByCell.mRadius[k] = rVorton.mRadius;
+		rByCell.mVolume[k] = 8.0f * rVorton.mRadius * rVorton.mRadius * rVorton.mRadius;
+		rByCell.mMaxRadius = std::max(rByCell.mMaxRadius, rVorton.mRadius);
+	}
 
-	// Create a spatial partition for the vortons.
-	// Each cell contains a dynamic array of integers
-	// whose values are offsets into mVortons.
-	UniformGrid< std::vector< size_t > > ugVortRef(mInfluenceTree[0]);
-	ugVortRef.Init();
+	// Phase 2: Compute exchange of vorticity with neighbors.
+	// Each vorton gathers from its neighbors and writes only its own
+	// entry of mVorticityScratch, so cells can be processed concurrently.
+	mVorticityScratch.resize(numVortons);
+	const size_t numZ = vortonCells.GetGeometry().GetNumPoints(2);
 
-	const size_t numVortons = mVortons.size();
+#if USE_TBB
+	// Estimate grain size based on size of problem and number of processors.
+	const size_t grainSize = std::max(size_t(1), numZ / std::thread::hardware_concurrency());
+	// Compute vorticity exchange using multiple threads.
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, numZ, grainSize), VortonSim_DiffuseVorticityPSE_TBB(this, timeStep, vortonCells));
+#else
+	DiffuseVorticityPSESlice(timeStep, vortonCells, 0, numZ);
+#endif
 
-	for (size_t offset = 0 /* Start at 0th vorton */; offset < numVortons; ++offset)
+	// Phase 3: Apply exchanged vorticity.
+	for (size_t offset = 0; offset < numVortons; ++offset)
 	{   // For each vorton...
-		Vorton &    rVorton = mVortons[offset];
-		// Insert the vorton's offset into the spatial partition.
-		ugVortRef[rVorton.mPosition].push_back(offset);
+		mVortons[offset].mVorticity = mVorticityScratch[offset];
 	}
+}
 
-	// Phase 2: Exchange vorticity with nearest neighbors
+/*! \brief Compute vorticity exchanged by particle strength exchange, for a subset of cells
 
-	const size_t & nx = ugVortRef.GetNumPoints(0);
-	const size_t   nxm1 = nx - 1;
-	const size_t & ny = ugVortRef.GetNumPoints(1);
-	const size_t   nym1 = ny - 1;
-	const size_t   nxy = nx * ny;
-	const size_t & nz = ugVortRef.GetNumPoints(2);
-	const size_t   nzm1 = nz - 1;
-	size_t idx[3];
+Each vorton exchanges vorticity with every vorton within the kernel cutoff
+radius.  Exchanges read only the vorticity from before this diffusion step
+(i.e. this is a Jacobi-style update) and each vorton visits its neighbors
+in a fixed order, so the result does not depend on the order in which
+cells are visited, and so does not depend on the number of threads.
 
-	for (idx[2] = 0; idx[2] < nzm1; ++idx[2])
-	{   // For all points along z except the last...
-		const size_t offsetZ0 = idx[2] * nxy;
-		const size_t offsetZp = (idx[2] + 1) * nxy;
-		for (idx[1] = 0; idx[1] < nym1; ++idx[1])
-		{   // For all points along y except the last...
-			const size_t offsetY0Z0 = idx[1] * nx + offsetZ0;
-			const size_t offsetYpZ0 = (idx[1] + 1) * nx + offsetZ0;
-			const size_t offsetY0Zp = idx[1] * nx + offsetZp;
-			for (idx[0] = 0; idx[0] < nxm1; ++idx[0])
-			{   // For all points along x except the last...
-				const size_t offsetX0Y0Z0 = idx[0] + offsetY0Z0;
-				for (size_t ivHere = 0; ivHere < ugVortRef[offsetX0Y0Z0].size(); ++ivHere)
-				{   // For each vorton in this gridcell...
-					const size_t &    rVortIdxHere = ugVortRef[offsetX0Y0Z0][ivHere];
-					Vorton &            rVortonHere = mVortons[rVortIdxHere];
-					ofVec3f &              rVorticityHere = rVortonHere.mVorticity;
-
-					// Diffuse vorticity with other vortons in this same cell:
-					for (size_t ivThere = ivHere + 1; ivThere < ugVortRef[offsetX0Y0Z0].size(); ++ivThere)
-					{   // For each OTHER vorton within this same cell...
-						const size_t &    rVortIdxThere = ugVortRef[offsetX0Y0Z0][ivThere];
-						Vorton &            rVortonThere = mVortons[rVortIdxThere];
-						ofVec3f &              rVorticityThere = rVortonThere.mVorticity;
-						const ofVec3f          vortDiff = rVorticityHere - rVorticityThere;
-						const ofVec3f          exchange = 2.0f * mViscosity * timeStep * vortDiff;    // Amount of vorticity to exchange between particles.
-						rVorticityHere -= exchange;   // Make "here" vorticity a little closer to "there".
-						rVorticityThere += exchange;   // Make "there" vorticity a little closer to "here".
-					}
+\param timeStep - amount of time by which to advance simulation
 
-					// Diffuse vorticity with vortons in adjacent cells:
-					{
-						const size_t offsetXpY0Z0 = idx[0] + 1 + offsetY0Z0; // offset of adjacent cell in +X direction
-						for (size_t ivThere = 0; ivThere < ugVortRef[offsetXpY0Z0].size(); ++ivThere)
-						{   // For each vorton in the adjacent cell in +X direction...
-							const size_t &    rVortIdxThere = ugVortRef[offsetXpY0Z0][ivThere];
-							Vorton &            rVortonThere = mVortons[rVortIdxThere];
-							ofVec3f &              rVorticityThere = rVortonThere.mVorticity;
-							const ofVec3f          vortDiff = rVorticityHere - rVorticityThere;
-							const ofVec3f          exchange = mViscosity * timeStep * vortDiff;    // Amount of vorticity to exchange between particles.
-							rVorticityHere -= exchange;   // Make "here" vorticity a little closer to "there".
-							rVorticityThere += exchange;   // Make "there" vorticity a little closer to "here".
-						}
-					}
+\param vortonCells - spatial partition of vortons
 
-					{
-						const size_t offsetX0YpZ0 = idx[0] + offsetYpZ0; // offset of adjacent cell in +Y direction
-						for (size_t ivThere = 0; ivThere < ugVortRef[offsetX0YpZ0].size(); ++ivThere)
-						{   // For each vorton in the adjacent cell in +Y direction...
-							const size_t &    rVortIdxThere = ugVortRef[offsetX0YpZ0][ivThere];
-							Vorton &            rVortonThere = mVortons[rVortIdxThere];
-							ofVec3f &              rVorticityThere = rVortonThere.mVorticity;
-							const ofVec3f          vortDiff = rVorticityHere - rVorticityThere;
-							const ofVec3f          exchange = mViscosity * timeStep * vortDiff;    // Amount of vorticity to exchange between particles.
-							rVorticityHere -= exchange;   // Make "here" vorticity a little closer to "there".
-							rVorticityThere += exchange;   // Make "there" vorticity a little closer to "here".
-						}
-					}
+\param izStart - starting value for z index
+
+\param izEnd - ending value for z index
 
+\see DiffuseVorticityPSE
+
+*/
+void VortonSim::DiffuseVorticityPSESlice(const float & timeStep, const CellList & vortonCells, size_t izStart, size_t izEnd)
+{
+	// Kernel is truncated beyond this many core sizes.  exp(-sPseCutoff^2) is the relative weight at the cutoff.
+	static const float sPseCutoff = 2.0f;
+	static const float sPseCutoff2 = sPseCutoff * sPseCutoff;
+	// Normalization of Gaussian PSE kernel in 3D: 4 / pi^(3/2).
+	static const float sPseNormalization = 4.0f / powf(PI, 1.5f);
+
+	const UniformGridGeometry & grid = vortonCells.GetGeometry();
+	const size_t   dims[3] = { grid.GetNumPoints(0) , grid.GetNumPoints(1) , grid.GetNumPoints(2) };
+	const size_t   nxy = dims[0] * dims[1];
+	const VortonsByCell & rByCell = mVortonsByCell;
+	const float    exchangeRate = mViscosity * timeStep * sPseNormalization;
+
+	// Number of cells to search, in each direction, to find all neighbors within the largest cutoff radius.
+	const float    cutoffMax = sPseCutoff * 2.0f * rByCell.mMaxRadius;
+	size_t         span[3];
+	for (size_t axis = 0; axis < 3; ++axis)
+	{   // For each axis...  (Clamp before converting; 2D domains have enormous cells-per-extent along z.)
+		span[axis] = size_t(std::min(ceilf(cutoffMax * grid.GetCellsPerExtent()[axis]), float(dims[axis])));
+	}
+
+	size_t idx[3];
+	for (idx[2] = izStart; idx[2] < izEnd; ++idx[2])
+	{   // For subset of z index values...
+		const size_t izMin = idx[2] > span[2] ? idx[2] - span[2] : 0;
+		const size_t izMax = std::min(idx[2] + span[2], dims[2] - 1);
+		for (idx[1] = 0; idx[1] < dims[1]; ++idx[1])
+		{
+			const size_t iyMin = idx[1] > span[1] ? idx[1] - span[1] : 0;
+			const size_t iyMax = std::min(idx[1] + span[1], dims[1] - 1);
+			for (idx[0] = 0; idx[0] < dims[0]; ++idx[0])
+			{
+				const size_t offsetXYZ = idx[0] + idx[1] * dims[0] + idx[2] * nxy;
+				const size_t ixMin = idx[0] > span[0] ? idx[0] - span[0] : 0;
+				const size_t ixMax = std::min(idx[0] + span[0], dims[0] - 1);
+				for (uint32_t kHere = vortonCells.GetCellBegin(offsetXYZ); kHere < vortonCells.GetCellEnd(offsetXYZ); ++kHere)
+				{   // For each vorton in this gridcell...
+					const float xHere = rByCell.mPosX[kHere];
+					const float yHere = rByCell.mPosY[kHere];
+					const float zHere = rByCell.mPosZ[kHere];
+					const float wxHere = rByCell.mVortX[kHere];
+					const float wyHere = rByCell.mVortY[kHere];
+					const float wzHere = rByCell.mVortZ[kHere];
+					const float radiusHere = rByCell.mRadius[kHere];
+					float exchangeX = 0.0f;
+					float exchangeY = 0.0f;
+					float exchangeZ = 0.0f;
+
+					for (size_t iz = izMin; iz <= izMax; ++iz)
 					{
-						const size_t offsetX0Y0Zp = idx[0] + offsetY0Zp; // offset of adjacent cell in +Z direction
-						for (size_t ivThere = 0; ivThere < ugVortRef[offsetX0Y0Zp].size(); ++ivThere)
-						{   // For each vorton in the adjacent cell in +Z direction...
-							const size_t &    rVortIdxThere = ugVortRef[offsetX0Y0Zp][ivThere];
-							Vorton &            rVortonThere = mVortons[rVortIdxThere];
-							ofVec3f &              rVorticityThere = rVortonThere.mVorticity;
-							const ofVec3f          vortDiff = rVorticityHere - rVorticityThere;
-							const ofVec3f          exchange = mViscosity * timeStep * vortDiff;    // Amount of vorticity to exchange between particles.
-							rVorticityHere -= exchange;   // Make "here" vorticity a little closer to "there".
-							rVorticityThere += exchange;   // Make "there" vorticity a little closer to "here".
+						for (size_t iy = iyMin; iy <= iyMax; ++iy)
+						{   // For each row of neighboring cells...
+							// Cells along x are consecutive, so the vortons they contain are contiguous.
+							const size_t   offsetYZ = iy * dims[0] + iz * nxy;
+							const uint32_t kBegin = vortonCells.GetCellBegin(ixMin + offsetYZ);
+							const uint32_t kEnd = vortonCells.GetCellEnd(ixMax + offsetYZ);
+							for (uint32_t kThere = kBegin; kThere < kEnd; ++kThere)
+							{   // For each vorton in this row (including self, which contributes zero)...
+								const float dx = rByCell.mPosX[kThere] - xHere;
+								const float dy = rByCell.mPosY[kThere] - yHere;
+								const float dz = rByCell.mPosZ[kThere] - zHere;
+								const float dist2 = dx * dx + dy * dy + dz * dz;
+								const float eps = radiusHere + rByCell.mRadius[kThere];
+								const float oneOverEps2 = 1.0f / (eps * eps);
+								// eta_eps / eps^2, sans normalization constant, truncated at cutoff:
+								const float weight = (dist2 < sPseCutoff2 * eps * eps ? 1.0f : 0.0f)
+									* rByCell.mVolume[kThere] * oneOverEps2 * oneOverEps2 * sqrtf(oneOverEps2)
+									* expf(-dist2 * oneOverEps2);
+								exchangeX += weight * (rByCell.mVortX[kThere] - wxHere);
+								exchangeY += weight * (rByCell.mVortY[kThere] - wyHere);
+								exchangeZ += weight * (rByCell.mVortZ[kThere] - wzHere);
+							}
 						}
 					}
 
-					// Dissipate vorticity.  See notes in header comment.
-					rVorticityHere -= mViscosity * timeStep * rVorticityHere;   // Reduce "here" vorticity.
+					mVorticityScratch[vortonCells.GetIndex(kHere)] = Vec3(
+						wxHere + exchangeRate * exchangeX,
+						wyHere + exchangeRate * exchangeY,
+						wzHere + exchangeRate * exchangeZ);
 				}
 			}
 		}
@@ -836,7 +969,7 @@ void VortonSim::AdvectVortons(const float & timeStep)
 	for (int offset = 0; offset < numVortons; ++offset)
 	{   // For each vorton...
 		Vorton & rVorton = mVortons[offset];
-		ofVec3f velocity;
+		Vec3 velocity;
 		mVelGrid.Interpolate(velocity, rVorton.mPosition);
 		rVorton.mPosition += velocity * timeStep;
 		rVorton.mVelocity = velocity;  // Cache this for use in collisions with rigid bodies.
@@ -858,13 +991,16 @@ void VortonSim::AdvectVortons(const float & timeStep)
  */
 void VortonSim::AdvectTracersSlice(const float & timeStep, const size_t & uFrame, size_t itStart, size_t itEnd)
 {
+	PROFILE_SCOPE_RANGE(VortonSim_AdvectTracersSlice, itStart, itEnd);
+	Vec3 * const pHistory = mTracerHistory.GetNewestSlot(); // nullptr when history is disabled
 	for (size_t offset = itStart; offset < itEnd; ++offset)
 	{   // For each passive tracer in this slice...
 		Particle & rTracer = mTracers.at(offset);
-		ofVec3f velocity;
+		Vec3 velocity;
 		mVelGrid.Interpolate(velocity, rTracer.mPosition);
 		rTracer.mPosition += velocity * timeStep;
 		rTracer.mVelocity = velocity; // Cache for use in collisions
+		if (pHistory) pHistory[offset] = rTracer.mPosition;
 	}
 }
 
@@ -874,12 +1010,17 @@ void VortonSim::AdvectTracersSlice(const float & timeStep, const size_t & uFrame
 
  \param uFrame - frame counter
 
- \see AdvectVortons
+ When tracer history is enabled, this also records each tracer's new
+ position in the history.
+
+ \see AdvectVortons, SetTracerHistoryCapacity
 
  */
 void VortonSim::AdvectTracers(const float & timeStep, const size_t & uFrame)
 {
 	const size_t numTracers = mTracers.size();
+	// Advance tracer history, if enabled, to the slot AdvectTracersSlice fills.
+	mTracerHistory.BeginFrame(numTracers);
 
 #if USE_TBB
 	// Estimate grain size based on size of problem and number of processors.
@@ -891,6 +1032,380 @@ void VortonSim::AdvectTracers(const float & timeStep, const size_t & uFrame)
 #endif
 }
 
+/*! \brief Merge weak vortons and split strongly stretched vortons
+
+ Many vortons carry so little circulation that they barely influence
+ the flow, yet each costs as much as any other vorton.  Meanwhile,
+ vortex stretching concentrates vorticity into fewer, stronger
+ vortons, which under-resolves those regions.  This routine:
+
+ -  Merges, within each cell of the base grid, all vortons whose
+    circulation magnitude is below mMergeFraction of the largest,
+    into a single vorton.  See MergeVortonsSlice.
+
+ -  Splits vortons whose stretching rate exceeds mSplitStretchRate
+    into two, most strongly stretched first, while the number of
+    vortons remains below mTargetNumVortons.
+
+ Both operations conserve circulation and linear impulse.
+
+ \note This routine assumes vortons have moved since CreateInfluenceTree,
+        so it repartitions them.
+
+ \see SetPopulationControl, ConservedQuantities
+
+ */
+void VortonSim::AdaptVortonPopulation(void)
+{
+	const size_t numVortons = mVortons.size();
+	if (0 == numVortons) return;
+
+#if defined( _DEBUG )
+	Vec3 vCirculationBefore, vLinearImpulseBefore;
+	ConservedQuantities(vCirculationBefore, vLinearImpulseBefore);
+#endif
+
+	// Phase 1: Merge weak vortons within each cell.
+	float circulationMax = 0.0f;
+	for (size_t iVorton = 0; iVorton < numVortons; ++iVorton)
+	{   // For each vorton in this simulation...
+		const Vorton & rVorton = mVortons[iVorton];
+		const float    volumeElement = 8.0f * rVorton.mRadius * rVorton.mRadius * rVorton.mRadius;
+		circulationMax = std::max(circulationMax, rVorton.mVorticity.length() * volumeElement);
+	}
+	const float weakCirculation = mMergeFraction * circulationMax;
+
+	mVortonCells.Build(mInfluenceTree[0], mVortons);
+	mVortonMerged.assign(numVortons, 0);
+	const size_t numZ = mVortonCells.GetGeometry().GetNumPoints(2);
+#if USE_TBB
+	// Estimate grain size based on size of problem and number of processors.
+	const size_t grainSize = std::max(size_t(1), numZ / std::thread::hardware_concurrency());
+	// Merge vortons using multiple threads.
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, numZ, grainSize), VortonSim_MergeVortons_TBB(this, weakCirculation));
+#else
+	MergeVortonsSlice(weakCirculation, 0, numZ);
+#endif
+
+	// Remove vortons that were merged into others.
+	// KillVortons also removes their stretch rates, so splitting can use the rest.
+	const Vorton * const pVortons = mVortons.data();
+	KillVortons([this, pVortons](const Vorton & rVorton) { return 0 != mVortonMerged[&rVorton - pVortons]; });
+	const size_t numKept = mVortons.size();
+
+	// Phase 2: Split strongly stretched vortons, strongest first, within budget.
+	if ((mSplitStretchRate > 0.0f) && (numKept < mTargetNumVortons))
+	{
+		std::vector< uint32_t > candidates;
+		for (size_t iVorton = 0; iVorton < numKept; ++iVorton)
+		{
+			if (mStretchRates[iVorton] > mSplitStretchRate)
+			{
+				candidates.push_back(uint32_t(iVorton));
+			}
+		}
+		const size_t numSplits = std::min(candidates.size(), mTargetNumVortons - numKept);
+		// Order by decreasing stretch rate, breaking ties by index so the result is deterministic.
+		std::partial_sort(candidates.begin(), candidates.begin() + numSplits, candidates.end(),
+			[this](uint32_t a, uint32_t b) { return (mStretchRates[a] > mStretchRates[b]) || ((mStretchRates[a] == mStretchRates[b]) && (a < b)); });
+		static const float sOneOverCubeRootOfTwo = powf(0.5f, 1.0f / 3.0f);
+		mVortons.reserve(numKept + numSplits);
+		for (size_t iSplit = 0; iSplit < numSplits; ++iSplit)
+		{   // For each vorton to split...
+			Vorton & rParent = mVortons[candidates[iSplit]];
+			// Stretching elongates a vorton along its vorticity, so place children along that axis.
+			// Each child has half the volume and the same vorticity, so half the circulation.
+			// Children are symmetric about the parent, and displaced parallel to
+			// their circulation, so together they retain its linear impulse.
+			const Vec3 vAxis = rParent.mVorticity.getNormalized();
+			rParent.mRadius *= sOneOverCubeRootOfTwo;
+			const Vec3 vDisplacement = vAxis * rParent.mRadius;
+			Vorton child(rParent);
+			rParent.mPosition -= vDisplacement;
+			child.mPosition += vDisplacement;
+			mVortons.push_back(child);
+		}
+	}
+
+#if defined( _DEBUG )
+	Vec3 vCirculationAfter, vLinearImpulseAfter;
+	ConservedQuantities(vCirculationAfter, vLinearImpulseAfter);
+	assert((vCirculationAfter - vCirculationBefore).length() <= 1.0e-3f * (vCirculationBefore.length() + circulationMax));
+	// Splitting preserves linear impulse.  Each merge changes it by at most the cell diagonal times the
+	// circulation merged, and merging n vortons removes n-1 >= n/2 of them, so at most 2 (numVortons-numKept) were merged.
+	const float maxMergeDefect = mVortonCells.GetGeometry().GetCellSpacing().length() * weakCirculation * 2.0f * float(numVortons - numKept);
+	assert((vLinearImpulseAfter - vLinearImpulseBefore).length() <= maxMergeDefect + 1.0e-3f * (vLinearImpulseBefore.length() + circulationMax * mInfluenceTree[0].GetExtent().length()));
+#endif
+}
+
+/*! \brief Merge weak vortons within each of a subset of cells
+
+ All weak vortons in a cell get replaced by one vorton with their
+ total volume and circulation.  The merged vorton is placed to
+ reproduce their linear impulse I = Sum x_i ^ C_i for total
+ circulation C:  The position x = ( C ^ I ) / |C|^2 satisfies
+ x ^ C = I exactly when I is perpendicular to C.  Any position along
+ C also satisfies that, so among those, choose the one nearest the
+ circulation-weighted centroid of the merged vortons.  (The component
+ of I parallel to C cannot be represented by a single vorton.)
+
+ That position grows like |I| / |C|, so when the merged circulations
+ nearly cancel, it can lie arbitrarily far away.  So when |C| is small
+ compared to Sum |C_i|, the merged vorton goes at the centroid instead,
+ and otherwise it gets clamped to the cell.  Either way it stays in the
+ cell, so the linear impulse changes by at most the cell diagonal times
+ Sum |C_i|.
+
+ The merged vorton overwrites the first weak vorton in the cell
+ and the others get flagged in mVortonMerged, so each cell only
+ writes its own vortons.
+
+ \param weakCirculation - vortons with circulation magnitude below this are weak
+
+ \param izStart - starting value for z index
+
+ \param izEnd - ending value for z index
+
+ \see AdaptVortonPopulation
+
+ */
+void VortonSim::MergeVortonsSlice(const float & weakCirculation, size_t izStart, size_t izEnd)
+{
+	// Fraction of Sum |C_i| below which net circulation is too small to place the merged vorton by its linear impulse.
+	static const float sMinNetCirculationFraction = 0.1f;
+	const UniformGridGeometry & grid = mVortonCells.GetGeometry();
+	const size_t numXY = grid.GetNumPoints(0) * grid.GetNumPoints(1);
+	const size_t cellBegin = izStart * numXY;
+	const size_t cellEnd = izEnd * numXY;
+
+	for (size_t uCell = cellBegin; uCell < cellEnd; ++uCell)
+	{   // For each cell in this slice...
+		const uint32_t kBegin = mVortonCells.GetCellBegin(uCell);
+		const uint32_t kEnd = mVortonCells.GetCellEnd(uCell);
+		if (kEnd - kBegin < 2) continue; // Nothing to merge.
+
+		size_t  numWeak = 0;
+		size_t  iSurvivor = 0;
+		float   volumeSum = 0.0f;
+		float   weightSum = 0.0f;
+		Vec3 vCirculation(0.0f, 0.0f, 0.0f);
+		Vec3 vLinearImpulse(0.0f, 0.0f, 0.0f);
+		Vec3 vCentroid(0.0f, 0.0f, 0.0f);
+		for (uint32_t k = kBegin; k < kEnd; ++k)
+		{   // For each vorton in this cell...
+			const uint32_t iVorton = mVortonCells.GetIndex(k);
+			const Vorton & rVorton = mVortons[iVorton];
+			const float    volumeElement = 8.0f * rVorton.mRadius * rVorton.mRadius * rVorton.mRadius;
+			const Vec3     vVortonCirculation = rVorton.mVorticity * volumeElement;
+			const float    circulationMag = vVortonCirculation.length();
+			if (circulationMag >= weakCirculation) continue;
+			if (0 == numWeak) iSurvivor = iVorton;
+			++numWeak;
+			volumeSum += volumeElement;
+			vCirculation += vVortonCirculation;
+			vLinearImpulse += rVorton.mPosition.getCrossed(vVortonCirculation);
+			vCentroid += rVorton.mPosition * (circulationMag + FLT_MIN);
+			weightSum += circulationMag + FLT_MIN;
+		}
+		if (numWeak < 2) continue; // Nothing to merge.
+
+		vCentroid /= weightSum;
+		Vec3 vPosition(vCentroid);
+		const float circulationMag2 = vCirculation.lengthSquared();
+		const float minNetCirculation = sMinNetCirculationFraction * weightSum;
+		if ((circulationMag2 > FLT_MIN) && (circulationMag2 >= minNetCirculation * minNetCirculation))
+		{   // Place merged vorton to reproduce linear impulse.
+			const Vec3 vImpulsePosition = vCirculation.getCrossed(vLinearImpulse) / circulationMag2;
+			vPosition = vImpulsePosition + vCirculation * ((vCentroid - vImpulsePosition).dot(vCirculation) / circulationMag2);
+			// Keep merged vorton inside the cell of the vortons it replaces.
+			const size_t idxCell[3] = { uCell % grid.GetNumPoints(0) , (uCell / grid.GetNumPoints(0)) % grid.GetNumPoints(1) , uCell / numXY };
+			Vec3 vCellMin;
+			grid.PositionFromIndices(vCellMin, idxCell);
+			const Vec3 vCellMax(vCellMin + grid.GetCellSpacing());
+			vPosition.x = std::min(std::max(vPosition.x, vCellMin.x), vCellMax.x);
+			vPosition.y = std::min(std::max(vPosition.y, vCellMin.y), vCellMax.y);
+			vPosition.z = std::min(std::max(vPosition.z, vCellMin.z), vCellMax.z);
+		}
+
+		for (uint32_t k = kBegin; k < kEnd; ++k)
+		{   // For each vorton in this cell...
+			const uint32_t iVorton = mVortonCells.GetIndex(k);
+			Vorton & rVorton = mVortons[iVorton];
+			const float volumeElement = 8.0f * rVorton.mRadius * rVorton.mRadius * rVorton.mRadius;
+			if ((rVorton.mVorticity * volumeElement).length() >= weakCirculation) continue;
+			if (iVorton != iSurvivor)
+			{
+				mVortonMerged[iVorton] = 1;
+			}
+		}
+		Vorton & rMerged = mVortons[iSurvivor];
+		rMerged.mRadius = 0.5f * powf(volumeSum, 1.0f / 3.0f);
+		rMerged.mPosition = vPosition;
+		rMerged.mVorticity = vCirculation / volumeSum;
+		mStretchRates[iSurvivor] = 0.0f;    // Merged vorton should not immediately split.
+	}
+}
+
+/*! \brief Evaluate the M4' interpolation kernel
+
+ \param x - distance, in units of grid spacing
+
+ \see Monaghan (1985): Extrapolating B splines for interpolation.
+ J. Comput. Phys., v. 60, n. 2, pp. 253-262.
+
+ */
+static inline float M4Prime(float x)
+{
+	x = fabsf(x);
+	if (x < 1.0f)
+	{
+		return 1.0f - 2.5f * x * x + 1.5f * x * x * x;
+	}
+	else if (x < 2.0f)
+	{
+		return 0.5f * (2.0f - x) * (2.0f - x) * (1.0f - x);
+	}
+	return 0.0f;
+}
+
+/*! \brief Replace vortons with new vortons on a regular grid
+
+ Stretching and advection make vortons cluster in some places and
+ spread apart in others, which degrades accuracy of the velocity
+ and diffusion calculations, and makes the influence tree less
+ balanced.  Remeshing restores a regular particle distribution:
+
+ -  Interpolate vorticity from vortons onto a uniform grid whose
+    spacing matches the average vorton size, using the M4' kernel.
+    M4' conserves circulation and linear impulse.
+
+ -  Create a new vorton at each gridpoint whose vorticity exceeds
+    a threshold, using AssignVortonsFromVorticity.
+
+ The threshold also culls vortons whose vorticity has diffused away,
+ so remeshing bounds the vorton count.
+
+ \note This routine does not remesh 2D domains.
+
+ \see SetRemeshPeriod
+
+ */
+void VortonSim::RemeshVortons(void)
+{
+	const size_t numVortons = mVortons.size();
+	if (0 == numVortons) return;
+
+	// Find extent of vortons and their average volume.
+	Vec3 vMinCorner(FLT_MAX, FLT_MAX, FLT_MAX);
+	Vec3 vMaxCorner(-vMinCorner);
+	float   volumeSum = 0.0f;
+	float   vortMag2Max = 0.0f;
+	for (size_t iVorton = 0; iVorton < numVortons; ++iVorton)
+	{   // For each vorton in this simulation...
+		const Vorton & rVorton = mVortons[iVorton];
+		UpdateBoundingBox(vMinCorner, vMaxCorner, rVorton.mPosition);
+		volumeSum += 8.0f * rVorton.mRadius * rVorton.mRadius * rVorton.mRadius;
+		vortMag2Max = std::max(vortMag2Max, rVorton.mVorticity.lengthSquared());
+	}
+	const Vec3 vExtent(vMaxCorner - vMinCorner);
+	if ((0.0f == vExtent.x) || (0.0f == vExtent.y) || (0.0f == vExtent.z))
+	{   // Domain is 2D.
+		return;
+	}
+
+	// Grid spacing matches average vorton size.  Pad grid by the M4' kernel support (2 cells) on each side.
+	const float   spacing = powf(volumeSum / float(numVortons), 1.0f / 3.0f);
+	const Vec3 vPad(2.0f * spacing, 2.0f * spacing, 2.0f * spacing);
+	const Vec3 vGridMin(vMinCorner - vPad);
+	const Vec3 vGridMax(vMaxCorner + vPad);
+	const Vec3 vGridExtent(vGridMax - vGridMin);
+	const size_t  numCells = size_t(vGridExtent.x * vGridExtent.y * vGridExtent.z / (spacing * spacing * spacing)) + 1;
+	mRemeshGrid.DefineShape(numCells, vGridMin, vGridMax, false);
+	mRemeshGrid.Init();
+
+	// Partition vortons by cell of remeshing grid.
+	mRemeshCells.Build(mRemeshGrid, mVortons);
+
+	// Interpolate vorticity onto grid.
+	const size_t numZ = mRemeshGrid.GetNumPoints(2);
+#if USE_TBB
+	// Estimate grain size based on size of problem and number of processors.
+	const size_t grainSize = std::max(size_t(1), numZ / std::thread::hardware_concurrency());
+	// Interpolate using multiple threads.
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, numZ, grainSize), VortonSim_RemeshVortons_TBB(this));
+#else
+	RemeshVorticitySlice(0, numZ);
+#endif
+
+	// Create vortons from gridded vorticity.
+	AssignVortonsFromVorticity(mRemeshGrid, mRemeshThreshold * mRemeshThreshold * vortMag2Max);
+}
+
+/*! \brief Interpolate vorticity from vortons onto remeshing grid, for a subset of gridpoints
+
+ Each gridpoint gathers from vortons in the 4x4x4 block of cells
+ within the support of the M4' kernel, so gridpoints can be
+ computed concurrently and in a fixed order.
+
+ \param izStart - starting value for z index
+
+ \param izEnd - ending value for z index
+
+ \see RemeshVortons
+
+ */
+void VortonSim::RemeshVorticitySlice(size_t izStart, size_t izEnd)
+{
+	const Vec3 &     vMinCorner = mRemeshGrid.GetMinCorner();
+	const Vec3 &     vSpacing = mRemeshGrid.GetCellSpacing();
+	const Vec3 &     vCellsPerExtent = mRemeshGrid.GetCellsPerExtent();
+	const float      oneOverCellVolume = vCellsPerExtent.x * vCellsPerExtent.y * vCellsPerExtent.z;
+	const size_t     dims[3] = { mRemeshGrid.GetNumPoints(0) , mRemeshGrid.GetNumPoints(1) , mRemeshGrid.GetNumPoints(2) };
+	const size_t     numXY = dims[0] * dims[1];
+	size_t idx[3];
+
+	for (idx[2] = izStart; idx[2] < izEnd; ++idx[2])
+	{   // For subset of z index values...
+		const float  zNode = vMinCorner.z + float(idx[2]) * vSpacing.z;
+		// Vortons in cell c influence gridpoints c-1 through c+2.
+		const size_t izMin = idx[2] > 2 ? idx[2] - 2 : 0;
+		const size_t izMax = std::min(idx[2] + 1, dims[2] - 1);
+		for (idx[1] = 0; idx[1] < dims[1]; ++idx[1])
+		{
+			const float  yNode = vMinCorner.y + float(idx[1]) * vSpacing.y;
+			const size_t iyMin = idx[1] > 2 ? idx[1] - 2 : 0;
+			const size_t iyMax = std::min(idx[1] + 1, dims[1] - 1);
+			for (idx[0] = 0; idx[0] < dims[0]; ++idx[0])
+			{
+				const float  xNode = vMinCorner.x + float(idx[0]) * vSpacing.x;
+				const size_t ixMin = idx[0] > 2 ? idx[0] - 2 : 0;
+				const size_t ixMax = std::min(idx[0] + 1, dims[0] - 1);
+				Vec3 vorticity(0.0f, 0.0f, 0.0f);
+				for (size_t iz = izMin; iz <= izMax; ++iz)
+				{
+					for (size_t iy = iyMin; iy <= iyMax; ++iy)
+					{   // For each row of cells within kernel support...
+						const size_t   offsetYZ = iy * dims[0] + iz * numXY;
+						const uint32_t kBegin = mRemeshCells.GetCellBegin(ixMin + offsetYZ);
+						const uint32_t kEnd = mRemeshCells.GetCellEnd(ixMax + offsetYZ);
+						for (uint32_t k = kBegin; k < kEnd; ++k)
+						{   // For each vorton in this row of cells...
+							const Vorton & rVorton = mVortons[mRemeshCells.GetIndex(k)];
+							const float    volumeElement = 8.0f * rVorton.mRadius * rVorton.mRadius * rVorton.mRadius;
+							const float    weight = M4Prime((rVorton.mPosition.x - xNode) * vCellsPerExtent.x)
+								* M4Prime((rVorton.mPosition.y - yNode) * vCellsPerExtent.y)
+								* M4Prime((rVorton.mPosition.z - zNode) * vCellsPerExtent.z);
+							vorticity += rVorton.mVorticity * (weight * volumeElement);
+						}
+					}
+				}
+				// Convert circulation to vorticity, using the volume of the new vorton.
+				mRemeshGrid[idx[0] + idx[1] * dims[0] + idx[2] * numXY] = vorticity * oneOverCellVolume;
+			}
+		}
+	}
+}
+
 /*! \brief Update vortex particle fluid simulation to next time.
 
  \param timeStep - incremental amount of time to step forward
@@ -900,29 +1415,49 @@ void VortonSim::AdvectTracers(const float & timeStep, const size_t & uFrame)
  */
 void VortonSim::Update(float timeStep, size_t uFrame)
 {
-	//    QUERY_PERFORMANCE_ENTER ;
-	CreateInfluenceTree();
-	//    QUERY_PERFORMANCE_EXIT( VortonSim_CreateInfluenceTree ) ;
+	PROFILE_SCOPE(VortonSim_Update);
 
-	//    QUERY_PERFORMANCE_ENTER ;
-	ComputeVelocityGrid();
-	//    QUERY_PERFORMANCE_EXIT( VortonSim_ComputeVelocityGrid ) ;
+	{
+		PROFILE_SCOPE(VortonSim_CreateInfluenceTree);
+		CreateInfluenceTree();
+	}
 
-	//    QUERY_PERFORMANCE_ENTER ;
-	StretchAndTiltVortons(timeStep, uFrame);
-	//    QUERY_PERFORMANCE_EXIT( VortonSim_StretchAndTiltVortons ) ;
+	{
+		PROFILE_SCOPE(VortonSim_ComputeVelocityGrid);
+		ComputeVelocityGrid();
+	}
+
+	{
+		PROFILE_SCOPE(VortonSim_StretchAndTiltVortons);
+		StretchAndTiltVortons(timeStep, uFrame);
+	}
+
+	{
+		PROFILE_SCOPE(VortonSim_DiffuseVorticityPSE);
+		DiffuseVorticityPSE(timeStep, uFrame);
+	}
 
-	//    QUERY_PERFORMANCE_ENTER ;
-	DiffuseVorticityPSE(timeStep, uFrame);
-	//    QUERY_PERFORMANCE_EXIT( VortonSim_DiffuseVorticityPSE ) ;
+	{
+		PROFILE_SCOPE(VortonSim_AdvectVortons);
+		AdvectVortons(timeStep);
+	}
 
-	//    QUERY_PERFORMANCE_ENTER ;
-	AdvectVortons(timeStep);
-	//    QUERY_PERFORMANCE_EXIT( VortonSim_AdvectVortons ) ;
+	{
+		PROFILE_SCOPE(VortonSim_AdvectTracers);
+		AdvectTracers(timeStep, uFrame);
+	}
 
-	//    QUERY_PERFORMANCE_ENTER ;
-	AdvectTracers(timeStep, uFrame);
-	//    QUERY_PERFORMANCE_EXIT( VortonSim_AdvectTracers ) ;
+	if (mTargetNumVortons != 0)
+	{   // Merge weak vortons and split strong ones.
+		PROFILE_SCOPE(VortonSim_AdaptVortonPopulation);
+		AdaptVortonPopulation();
+	}
+
+	if ((mRemeshPeriod != 0) && (uFrame % mRemeshPeriod == mRemeshPeriod - 1))
+	{   // Periodically restore regular vorton distribution.
+		PROFILE_SCOPE(VortonSim_RemeshVortons);
+		RemeshVortons();
+	}
 }
 
 /*! \brief Initialize passive tracers
@@ -933,7 +1468,8 @@ void VortonSim::Update(float timeStep, size_t uFrame)
  */
 void VortonSim::InitializePassiveTracers(size_t multiplier)
 {
-	const ofVec3f vSpacing = mInfluenceTree[0].GetCellSpacing();
+	mTracerHistory.Clear(); // New tracers have no history.
+	const Vec3 vSpacing = mInfluenceTree[0].GetCellSpacing();
 	// Must keep tracers away from maximal boundary by at least cell.  Note the +vHalfSpacing in loop.
 	const size_t begin[3] = {
 		1 * mInfluenceTree[0].GetNumCells(0) / 8 ,
@@ -946,7 +1482,7 @@ void VortonSim::InitializePassiveTracers(size_t multiplier)
 		7 * mInfluenceTree[0].GetNumCells(2) / 8
 	};
 	const float pclSize = 2.0f * powf(vSpacing.x * vSpacing.y * vSpacing.z, 2.0f / 3.0f) / float(multiplier);
-	const ofVec3f noise = vSpacing / float(multiplier);
+	const Vec3 noise = vSpacing / float(multiplier);
 	size_t idx[3];
 
 	const size_t nt[3] = { multiplier , multiplier , multiplier };
@@ -955,12 +1491,12 @@ void VortonSim::InitializePassiveTracers(size_t multiplier)
 		for (idx[1] = begin[1]; idx[1] <= end[1]; ++idx[1])
 			for (idx[0] = begin[0]; idx[0] <= end[0]; ++idx[0])
 			{   // For each interior grid cell...
-				ofVec3f vPosMinCorner;
+				Vec3 vPosMinCorner;
 				mInfluenceTree[0].PositionFromIndices(vPosMinCorner, idx);
 				Particle pcl;
-				pcl.mVelocity = ofVec3f(0.0f, 0.0f, 0.0f);
-				pcl.mOrientation = ofVec3f(0.0f, 0.0f, 0.0f);
-				pcl.mAngularVelocity = ofVec3f(0.0f, 0.0f, 0.0f);
+				pcl.mVelocity = Vec3(0.0f, 0.0f, 0.0f);
+				pcl.mOrientation = Vec3(0.0f, 0.0f, 0.0f);
+				pcl.mAngularVelocity = Vec3(0.0f, 0.0f, 0.0f);
 				pcl.mMass = 1.0f;
 				pcl.mSize = pclSize;
 				pcl.mBirthTime = 0;
@@ -970,7 +1506,7 @@ void VortonSim::InitializePassiveTracers(size_t multiplier)
 					for (it[1] = 0; it[1] < nt[1]; ++it[1])
 						for (it[0] = 0; it[0] < nt[0]; ++it[0])
 						{
-							ofVec3f vShift(float(it[0]) / float(nt[0]) * vSpacing.x,
+							Vec3 vShift(float(it[0]) / float(nt[0]) * vSpacing.x,
 								float(it[1]) / float(nt[1]) * vSpacing.y,
 								float(it[2]) / float(nt[2]) * vSpacing.z);
 							pcl.mPosition = vPosMinCorner + vShift + RandomSpread(noise);
@@ -979,9 +1515,9 @@ void VortonSim::InitializePassiveTracers(size_t multiplier)
 			}
 }
 
-const ofVec3f VortonSim::GetTracerCenterOfMass() const
+const Vec3 VortonSim::GetTracerCenterOfMass() const
 {
-	ofVec3f vCoM(0.0f, 0.0f, 0.0f);
+	Vec3 vCoM(0.0f, 0.0f, 0.0f);
 	const size_t & numTracers = mTracers.size();
 	for (size_t iTracer = 0; iTracer < numTracers; ++iTracer)
 	{
@@ -5,7 +5,10 @@
 #include "NestedGrid.hpp"
 #include "UniformGrid.hpp"
 #include "Particle.hpp"
-#include "ofVec3f.h"
+#include "CellList.hpp"
+#include "ParticleCompaction.hpp"
+#include "TracerHistory.hpp"
+#include "Vec3.hpp"
 #include "TBB_Settings.hpp"
 
 class VortonSim {
@@ -21,6 +24,11 @@ public:
     , mAverageVorticity( 0.0f , 0.0f , 0.0f )
     , mFluidDensity( density )
     , mMassPerParticle( 0.0f )
+    , mRemeshPeriod( 0 )
+    , mRemeshThreshold( 0.01f )
+    , mTargetNumVortons( 0 )
+    , mMergeFraction( 0.0f )
+    , mSplitStretchRate( 0.0f )
     {}
     
     /*! \brief Initialize a vortex particle fluid simulation
@@ -31,16 +39,106 @@ public:
      */
     void Initialize( size_t numTracersPerCellCubeRoot ) ;
 
-    /*! \brief Kill the tracer at the given index
+    /*! \brief Remove vortons for which a predicate returns true
+
+        \param isDead - predicate, called as isDead( const Vorton & ), possibly concurrently.
+
+        \param bStable - whether to preserve the order of surviving vortons.
+                Unstable removal moves fewer vortons.
+
+        \return number of vortons removed.
+
+        \see ParticleCompaction
+     */
+    template< class PredicateT > size_t KillVortons( const PredicateT & isDead , bool bStable = true )
+    {
+        const size_t numVortons = mVortons.size() ;
+        const size_t numDead    = mVortonCompaction.MarkIf( mVortons , isDead ) ;
+        mVortonCompaction.Compact( mVortons , bStable ) ;
+        if( mStretchRates.size() == numVortons )
+        {   // Keep per-vorton stretching rates aligned with vortons.
+            mVortonCompaction.CompactCompanion( mStretchRates , mStretchRateScratch ) ;
+        }
+        return numDead ;
+    }
+
+    /*! \brief Remove tracers for which a predicate returns true
+
+        \param isDead - predicate, called as isDead( const Particle & ), possibly concurrently.
+
+        \param bStable - whether to preserve the order of surviving tracers.
+
+        \return number of tracers removed.
      */
-    void KillTracer( size_t iTracer ) {
-        mTracers.at(iTracer) = mTracers.at( mTracers.size() - 1 ) ;
-        mTracers.pop_back() ;
+    template< class PredicateT > size_t KillTracers( const PredicateT & isDead , bool bStable = true )
+    {
+        const size_t numTracers = mTracers.size() ;
+        const size_t numDead    = mTracerCompaction.MarkIf( mTracers , isDead ) ;
+        mTracerCompaction.Compact( mTracers , bStable ) ;
+        if( mTracerHistory.IsEnabled() && ( mTracerHistory.GetNumTracers() == numTracers ) )
+        {   // Keep tracer history aligned with tracers.
+            mTracerHistory.Compact( mTracerCompaction ) ;
+        }
+        return numDead ;
+    }
+
+    /// Remove vortons and tracers for which the given predicates return true
+    template< class VortonPredicateT , class TracerPredicateT >
+    void KillParticles( const VortonPredicateT & isVortonDead , const TracerPredicateT & isTracerDead , bool bStable = true )
+    {
+        KillVortons( isVortonDead , bStable ) ;
+        KillTracers( isTracerDead , bStable ) ;
     }
     
-    const ofVec3f GetTracerCenterOfMass( void ) const ;
+    const Vec3 GetTracerCenterOfMass( void ) const ;
     
-    const UniformGrid< ofVec3f > & GetVelocityGrid() const       { return mVelGrid ; }
+    /*! \brief Set how often to remesh vortons
+
+        \param framesPerRemesh - number of frames between remeshing.  0 disables remeshing.
+
+        \param threshold - vortons are only created where vorticity magnitude exceeds
+                this fraction of the largest vorton vorticity magnitude.
+
+        \see RemeshVortons
+     */
+    void SetRemeshPeriod( size_t framesPerRemesh , float threshold = 0.01f )
+    {
+        mRemeshPeriod       = framesPerRemesh ;
+        mRemeshThreshold    = threshold ;
+    }
+
+    /*! \brief Enable adaptive merging and splitting of vortons
+
+        \param targetNumVortons - splitting stops when the number of vortons reaches this.
+                0 disables merging and splitting.
+
+        \param mergeFraction - vortons whose circulation magnitude is below this fraction
+                of the largest get merged with other such vortons in the same cell.
+
+        \param splitStretchRate - vortons stretching faster than this rate (per unit time) get split.
+                0 disables splitting.
+
+        \see AdaptVortonPopulation
+     */
+    void SetPopulationControl( size_t targetNumVortons , float mergeFraction = 0.01f , float splitStretchRate = 0.0f )
+    {
+        mTargetNumVortons   = targetNumVortons ;
+        mMergeFraction      = mergeFraction ;
+        mSplitStretchRate   = splitStretchRate ;
+    }
+
+    /*! \brief Set how many recent positions to remember for each tracer
+
+        \param numFrames - number of positions kept per tracer, recorded by AdvectTracers.
+                0 disables history, so advection records nothing.
+
+        \see TracerHistory
+     */
+    void SetTracerHistoryCapacity( size_t numFrames )   { mTracerHistory.SetCapacity( numFrames ) ; }
+    const TracerHistory & GetTracerHistory() const      { return mTracerHistory ; }
+
+    const UniformGrid< Vec3 > & GetVelocityGrid() const       { return mVelGrid ; }
+    const CellList & GetVortonCells() const     { return mVortonCells ; }
     const float & GetMassPerParticle() const    { return mMassPerParticle ; }
     void Update( float timeStep , size_t uFrame ) ;
     void Clear() {
@@ -48,6 +146,8 @@ public:
         mInfluenceTree.Clear() ;
         mVelGrid.Clear() ;
         mTracers.clear() ;
+        mTracerHistory.Clear() ;
+        mVortonCells.Clear() ;
     }
     
     std::vector< Vorton > & GetVortons() { return mVortons; }
@@ -56,21 +156,47 @@ public:
     const std::vector<Particle> & GetTracers() const { return mTracers; }
     
 private:
-    void    AssignVortonsFromVorticity( UniformGrid< ofVec3f > & vortGrid ) ;
-    void    ConservedQuantities( ofVec3f & vCirculation , ofVec3f & vLinearImpulse ) const ;
+    /*! \brief Structure-of-arrays copy of vortons, in cell order
+
+        DiffuseVorticityPSE copies vortons into these arrays so that
+        the vortons of neighboring cells are contiguous in memory and
+        their pairwise interactions vectorize.
+     */
+    struct VortonsByCell
+    {
+        void Resize( size_t numVortons )
+        {
+            mPosX.resize( numVortons ) ;  mPosY.resize( numVortons ) ;  mPosZ.resize( numVortons ) ;
+            mVortX.resize( numVortons ) ; mVortY.resize( numVortons ) ; mVortZ.resize( numVortons ) ;
+            mRadius.resize( numVortons ) ; mVolume.resize( numVortons ) ;
+        }
+        std::vector< float >    mPosX , mPosY , mPosZ ;     ///< Position components
+        std::vector< float >    mVortX , mVortY , mVortZ ;  ///< Vorticity components
+        std::vector< float >    mRadius ;                   ///< Vorton radius
+        std::vector< float >    mVolume ;                   ///< Volume element, i.e. (2 * radius)^3
+        float                   mMaxRadius ;                ///< Largest vorton radius
+    } ;
+
+    void    AssignVortonsFromVorticity( UniformGrid< Vec3 > & vortGrid , float minVorticity2 = FLT_EPSILON ) ;
+    void    ConservedQuantities( Vec3 & vCirculation , Vec3 & vLinearImpulse ) const ;
     void    FindBoundingBox( void ) ;
     void    MakeBaseVortonGrid( void ) ;
     void    AggregateClusters( size_t uParentLayer ) ;
     void    CreateInfluenceTree( void ) ;
-    ofVec3f ComputeVelocity( const ofVec3f & vPosition , const size_t idxParent[3] , size_t iLayer ) ;
-    ofVec3f ComputeVelocityBruteForce( const ofVec3f & vPosition ) ;
+    Vec3 ComputeVelocity( const Vec3 & vPosition , const size_t idxParent[3] , size_t iLayer ) ;
+    Vec3 ComputeVelocityBruteForce( const Vec3 & vPosition ) ;
     void    ComputeVelocityGridSlice( size_t izStart , size_t izEnd ) ;
     void    ComputeVelocityGrid( void ) ;
     void    StretchAndTiltVortons( const float & timeStep , const size_t & uFrame ) ;
     void    ComputeAverageVorticity( void ) ;
     void    DiffuseVorticityGlobally( const float & timeStep , const size_t & uFrame ) ;
     void    DiffuseVorticityPSE( const float & timeStep , const size_t & uFrame ) ;
+    void    DiffuseVorticityPSESlice( const float & timeStep , const CellList & vortonCells , size_t izStart , size_t izEnd ) ;
     void    AdvectVortons( const float & timeStep ) ;
+    void    AdaptVortonPopulation( void ) ;
+    void    MergeVortonsSlice( const float & weakCirculation , size_t izStart , size_t izEnd ) ;
+    void    RemeshVortons( void ) ;
+    void    RemeshVorticitySlice( size_t izStart , size_t izEnd ) ;
     
     void    InitializePassiveTracers( size_t multiplier ) ;
     void    AdvectTracersSlice( const float & timeStep , const size_t & uFrame , size_t izStart , size_t izEnd ) ;
@@ -78,19 +204,40 @@ private:
     
     std::vector< Vorton >   mVortons                ;   ///< Dynamic array of tiny vortex elements
     NestedGrid< Vorton >    mInfluenceTree          ;   ///< Influence tree
-    UniformGrid< ofVec3f >  mVelGrid                ;   ///< Uniform grid of velocity values
-    ofVec3f                 mMinCorner              ;   ///< Minimal corner of axis-aligned bounding box
-    ofVec3f                 mMaxCorner              ;   ///< Maximal corner of axis-aligned bounding box
+    UniformGrid< Vec3 >     mVelGrid                ;   ///< Uniform grid of velocity values
+    Vec3                    mMinCorner              ;   ///< Minimal corner of axis-aligned bounding box
+    Vec3                    mMaxCorner              ;   ///< Maximal corner of axis-aligned bounding box
     float                   mViscosity              ;   ///< Viscosity. Used to compute viscous diffusion.
-    ofVec3f                 mCirculationInitial     ;   ///< Initial circulation, which should be conserved when viscosity is zero.
-    ofVec3f                 mLinearImpulseInitial   ;   ///< Initial linear impulse, which should be conserved when viscosity is zero.
-    ofVec3f                 mAverageVorticity       ;   ///< Hack, average vorticity used to compute a kind of viscous vortex diffusion.
+    Vec3                    mCirculationInitial     ;   ///< Initial circulation, which should be conserved when viscosity is zero.
+    Vec3                    mLinearImpulseInitial   ;   ///< Initial linear impulse, which should be conserved when viscosity is zero.
+    Vec3                    mAverageVorticity       ;   ///< Hack, average vorticity used to compute a kind of viscous vortex diffusion.
     float                   mFluidDensity           ;   ///< Uniform density of fluid.
     float                   mMassPerParticle        ;   ///< Mass of each fluid particle (vorton or tracer).
     std::vector< Particle > mTracers                ;   ///< Passive tracer particles
+    TracerHistory           mTracerHistory          ;   ///< Recent positions of each tracer, when enabled
+    CellList                mVortonCells            ;   ///< Vortons partitioned by cell of base layer of influence tree
+    VortonsByCell           mVortonsByCell          ;   ///< Vortons in cell order, used by DiffuseVorticityPSE
+    std::vector< Vec3 >     mVorticityScratch       ;   ///< Per-vorton vorticity computed by DiffuseVorticityPSE, before it gets applied
+    size_t                  mRemeshPeriod           ;   ///< Number of frames between remeshing vortons.  0 means never.
+    float                   mRemeshThreshold        ;   ///< Fraction of largest vorticity magnitude below which remeshing creates no vorton
+    UniformGrid< Vec3 >     mRemeshGrid             ;   ///< Vorticity interpolated from vortons, used by RemeshVortons
+    CellList                mRemeshCells            ;   ///< Vortons partitioned by cell of mRemeshGrid
+    size_t                  mTargetNumVortons       ;   ///< Budget for splitting vortons.  0 disables AdaptVortonPopulation.
+    float                   mMergeFraction          ;   ///< Fraction of largest circulation below which vortons merge
+    float                   mSplitStretchRate       ;   ///< Stretching rate above which vortons split
+    std::vector< float >    mStretchRates           ;   ///< Per-vorton stretching rate along vorticity, computed by StretchAndTiltVortons
+    std::vector< float >    mStretchRateScratch     ;   ///< Reusable buffer for compacting mStretchRates alongside vortons
+    std::vector< char >     mVortonMerged           ;   ///< Per-vorton flag set when AdaptVortonPopulation merged it into another
+    ParticleCompaction< Vorton >    mVortonCompaction   ;   ///< Reusable buffers for removing vortons
+    ParticleCompaction< Particle >  mTracerCompaction   ;   ///< Reusable buffers for removing tracers
     
+    friend class Checkpoint ;
+    friend class VortonSimBenchmark ;   // Times private kernels in isolation.  See benchmarks/VortonSimBenchmark.cpp.
 #if USE_TBB
     friend class VortonSim_ComputeVelocityGrid_TBB;
     friend class VortonSim_AdvectTracers_TBB;
+    friend class VortonSim_DiffuseVorticityPSE_TBB;
+    friend class VortonSim_RemeshVortons_TBB;
+    friend class VortonSim_MergeVortons_TBB;
 #endif
 };
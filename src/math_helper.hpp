@@ -1,8 +1,9 @@
 #pragma once
 #include <array>
+#include <cstdint>
+#include <cstring>
 #include "Rand.hpp"
-#include "ofVec3f.h"
-#include "ofVec4f.h"
+#include "Vec3.hpp"
 #include "xmmintrin.h"
 #include "pmmintrin.h"
 
@@ -20,9 +21,11 @@
  \see Chris Lomont: Fast inverse square root
  */
 inline float finvsqrtf(const float & val) {
-	long    i = (long&)val;             // Exploit IEEE 754 inner workings.
+	int32_t i;                          // Must be exactly as wide as float; "long" is 64 bits on LP64 platforms.
+	memcpy(&i, &val, sizeof(i));        // Exploit IEEE 754 inner workings.
 	i = 0x5f3759df - (i >> 1);          // From Taylor's theorem and IEEE 754 format.
-	float   y = (float&)i;              // Estimate of 1/sqrt(val) close enough for convergence using Newton's method.
+	float   y;                          // Estimate of 1/sqrt(val) close enough for convergence using Newton's method.
+	memcpy(&y, &i, sizeof(y));
 	static const float  f = 1.5f;        // Derived from Newton's method.
 	const float         x = val * 0.5f;  // Derived from Newton's method.
 	y = y * (f - (x * y * y));        // Newton's method for 1/sqrt(val)
@@ -45,9 +48,11 @@ inline float finvsqrtf(const float & val) {
  */
 inline float fsqrtf(const float & val)
 {
-	long    i = (long&)val;             // Exploit IEEE 754 inner workings.
+	int32_t i;                          // Must be exactly as wide as float; "long" is 64 bits on LP64 platforms.
+	memcpy(&i, &val, sizeof(i));        // Exploit IEEE 754 inner workings.
 	i = 0x5f3759df - (i >> 1);          // From Taylor's theorem and IEEE 754 format.
-	float   y = (float&)i;              // Estimate of 1/sqrt(val) close enough for convergence using Newton's method.
+	float   y;                          // Estimate of 1/sqrt(val) close enough for convergence using Newton's method.
+	memcpy(&y, &i, sizeof(y));
 	static const float  f = 1.5f;        // Derived from Newton's method.
 	const float         x = val * 0.5f;  // Derived from Newton's method.
 	y = y * (f - (x * y * y));        // Newton's method for 1/sqrt(val)
@@ -78,8 +83,8 @@ inline unsigned int NearestPowerOfTwo(unsigned int iVal)
 
 	\note range components must be positive.
  */
-inline ofVec3f RandomSpread(ofVec3f range) {
-	return ofVec3f(
+inline Vec3 RandomSpread(Vec3 range) {
+	return Vec3(
 		Rand::randFloat(-range.x / 2.f, range.x / 2.f),
 		Rand::randFloat(-range.y / 2.f, range.y / 2.f),
 		Rand::randFloat(-range.z / 2.f, range.z / 2.f)
@@ -87,7 +92,7 @@ inline ofVec3f RandomSpread(ofVec3f range) {
 }
 
 /// \brief Helper function to compute cross product of two vectors
-inline ofVec3f operator^(const ofVec3f & lhs, const ofVec3f & rhs) {
+inline Vec3 operator^(const Vec3 & lhs, const Vec3 & rhs) {
 	return lhs.getCrossed(rhs);
 }
 
@@ -95,27 +100,23 @@ inline ofVec3f operator^(const ofVec3f & lhs, const ofVec3f & rhs) {
 inline float sechf(const float & x) { return 1.0f / coshf(x); }
 
 /// \brief Horizontally add a vector
-inline float hAdd(const ofVec3f & vec) {
+inline float hAdd(const Vec3 & vec) {
 	return vec.x + vec.y + vec.z;
 }
 
 /// \brief Horizontally multiply a vector
-inline float hMultiply(const ofVec3f & vec) {
+inline float hMultiply(const Vec3 & vec) {
 	return vec.x * vec.y * vec.z;
 }
 
-/// \brief Load a 3D vector into a 4-float SIMD reg.
-inline __m128 LoadVec3(const ofVec3f & value) {
-	__m128 x = _mm_load_ss(&value.x);
-	__m128 y = _mm_load_ss(&value.y);
-	__m128 z = _mm_load_ss(&value.z);
-	__m128 xy = _mm_movelh_ps(x, y);
-	return _mm_shuffle_ps(xy, z, _MM_SHUFFLE(2, 0, 2, 0));
+/// \brief Load a 3D vector into a 4-float SIMD reg.  The fourth component is Vec3 padding, which is zero.
+inline __m128 LoadVec3(const Vec3 & value) {
+	return _mm_load_ps(value.getPtr()); // Vec3 is 16-byte aligned.
 }
 
-/// \brief Store a SIMD reg into a 3D vector. The fourth component (bits[31:0]) in the vector is ignored.
-inline ofVec3f StoreVec3(const __m128 & value) {
-	ofVec4f vec;
-	_mm_storeu_ps(vec.getPtr(), value);
-	return ofVec3f(vec);
+/// \brief Store a SIMD reg into a 3D vector. The fourth component (bits[127:96]) in the register is ignored.
+inline Vec3 StoreVec3(const __m128 & value) {
+	alignas(16) float vec[4];
+	_mm_store_ps(vec, value);
+	return Vec3(vec[0], vec[1], vec[2]);
 }
\ No newline at end of file